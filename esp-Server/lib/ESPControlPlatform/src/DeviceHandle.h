@@ -0,0 +1,17 @@
+#ifndef DEVICE_HANDLE_H
+#define DEVICE_HANDLE_H
+
+#include <Arduino.h>
+
+// --- Device Handles ---
+
+// A handle names one registry slot plus the generation of the device living
+// in it, so a handle kept after its device was deleted never resolves to the
+// device that later reuses the slot.
+typedef uint32_t DeviceHandle;
+
+#define INVALID_DEVICE_HANDLE 0xFFFFFFFFUL
+
+inline uint16_t deviceHandleSlot(DeviceHandle handle) { return handle & 0xFFFF; }
+
+#endif  // DEVICE_HANDLE_H
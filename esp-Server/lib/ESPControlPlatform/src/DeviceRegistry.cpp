@@ -0,0 +1,234 @@
+#include "DeviceRegistry.h"
+#include "ESPControlPlatform.h"
+
+static const size_t INITIAL_INDEX_SIZE = 16;
+
+DeviceRegistry::DeviceRegistry()
+  : count(0), tombstones(0), currentGeneration(0), horizon(0),
+    deletionHead(0), deletionsStored(0) {}
+
+DeviceRegistry::~DeviceRegistry() {
+  for (auto &entry : slots) {
+    delete entry.device;
+  }
+}
+
+// FNV-1a over the id bytes
+uint32_t DeviceRegistry::hashId(const char *id, size_t length) {
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)id[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+// Position of the id in the hash table, or index.size() if absent
+size_t DeviceRegistry::findIndexPos(const char *id, size_t length) const {
+  if (index.empty()) return 0;
+
+  size_t mask = index.size() - 1;
+  size_t pos = hashId(id, length) & mask;
+  while (index[pos] != EMPTY) {
+    if (index[pos] != TOMBSTONE) {
+      const String &candidate = slots[index[pos]].device->id;
+      if (candidate.length() == length && memcmp(candidate.c_str(), id, length) == 0) return pos;
+    }
+    pos = (pos + 1) & mask;
+  }
+  return index.size();
+}
+
+void DeviceRegistry::rehash(size_t tableSize) {
+  index.assign(tableSize, EMPTY);
+  tombstones = 0;
+
+  size_t mask = tableSize - 1;
+  for (size_t slot = 0; slot < slots.size(); slot++) {
+    if (!slots[slot].device) continue;
+    const String &id = slots[slot].device->id;
+    size_t pos = hashId(id.c_str(), id.length()) & mask;
+    while (index[pos] != EMPTY) pos = (pos + 1) & mask;
+    index[pos] = slot;
+  }
+}
+
+DeviceHandle DeviceRegistry::add(const Device &device) {
+  if (find(device.id)) return INVALID_DEVICE_HANDLE;
+
+  // Keep the table at most half full, counting tombstones
+  size_t tableSize = index.empty() ? INITIAL_INDEX_SIZE : index.size();
+  while ((count + 1) * 2 > tableSize) tableSize *= 2;
+  if (tableSize != index.size() || (count + tombstones + 1) * 2 > tableSize) {
+    rehash(tableSize);
+  }
+
+  uint16_t slot;
+  if (!freeSlots.empty()) {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  } else {
+    if (slots.size() >= TOMBSTONE) return INVALID_DEVICE_HANDLE;
+    slot = slots.size();
+    slots.push_back({nullptr, 0, 0});
+  }
+
+  Slot &entry = slots[slot];
+  entry.device = new Device(device);
+  DeviceHandle handle = ((DeviceHandle)entry.generation << 16) | slot;
+  entry.device->handle = handle;
+  entry.changedAt = ++currentGeneration;
+  pinOwners.claim(entry.device->pins, handle);
+
+  size_t mask = index.size() - 1;
+  size_t pos = hashId(device.id.c_str(), device.id.length()) & mask;
+  while (index[pos] != EMPTY && index[pos] != TOMBSTONE) pos = (pos + 1) & mask;
+  if (index[pos] == TOMBSTONE) tombstones--;
+  index[pos] = slot;
+
+  count++;
+  return handle;
+}
+
+Device* DeviceRegistry::get(DeviceHandle handle) {
+  return const_cast<Device*>(static_cast<const DeviceRegistry*>(this)->get(handle));
+}
+
+const Device* DeviceRegistry::get(DeviceHandle handle) const {
+  uint16_t slot = deviceHandleSlot(handle);
+  if (slot >= slots.size()) return nullptr;
+
+  const Slot &entry = slots[slot];
+  if (!entry.device || entry.generation != (handle >> 16)) return nullptr;
+  return entry.device;
+}
+
+Device* DeviceRegistry::find(const String &id) {
+  return const_cast<Device*>(static_cast<const DeviceRegistry*>(this)->find(id));
+}
+
+const Device* DeviceRegistry::find(const String &id) const {
+  size_t pos = findIndexPos(id);
+  if (pos >= index.size()) return nullptr;
+  return slots[index[pos]].device;
+}
+
+Device* DeviceRegistry::find(const char *id) {
+  return const_cast<Device*>(static_cast<const DeviceRegistry*>(this)->find(id));
+}
+
+const Device* DeviceRegistry::find(const char *id) const {
+  size_t pos = findIndexPos(id, strlen(id));
+  if (pos >= index.size()) return nullptr;
+  return slots[index[pos]].device;
+}
+
+DeviceHandle DeviceRegistry::findHandle(const String &id) const {
+  const Device *device = find(id);
+  return device ? device->handle : INVALID_DEVICE_HANDLE;
+}
+
+bool DeviceRegistry::setPins(DeviceHandle handle, const std::vector<int> &pins) {
+  Device *device = get(handle);
+  if (!device) return false;
+
+  pinOwners.release(device->pins, handle);
+  device->pins = pins;
+  pinOwners.claim(device->pins, handle);
+  return true;
+}
+
+void DeviceRegistry::releaseSlot(uint16_t slot) {
+  Slot &entry = slots[slot];
+  pinOwners.release(entry.device->pins, entry.device->handle);
+  delete entry.device;
+  entry.device = nullptr;
+  entry.generation++;
+  freeSlots.push_back(slot);
+  count--;
+}
+
+bool DeviceRegistry::remove(const String &id) {
+  size_t pos = findIndexPos(id);
+  if (pos >= index.size()) return false;
+
+  uint16_t slot = index[pos];
+  index[pos] = TOMBSTONE;
+  tombstones++;
+  logDeletion(id);
+  releaseSlot(slot);
+  return true;
+}
+
+bool DeviceRegistry::remove(DeviceHandle handle) {
+  const Device *device = get(handle);
+  if (!device) return false;
+  return remove(String(device->id));
+}
+
+void DeviceRegistry::clear() {
+  // Keep the slots so handles issued before the clear stay invalid
+  freeSlots.clear();
+  for (size_t slot = slots.size(); slot-- > 0;) {
+    Slot &entry = slots[slot];
+    if (entry.device) {
+      delete entry.device;
+      entry.device = nullptr;
+      entry.generation++;
+    }
+    freeSlots.push_back(slot);
+  }
+  index.clear();
+  pinOwners.clear();
+  count = 0;
+  tombstones = 0;
+
+  // Too many deletions to log one by one; earlier clients must resync
+  horizon = ++currentGeneration;
+  deletionHead = 0;
+  deletionsStored = 0;
+}
+
+// --- Change tracking ---
+
+void DeviceRegistry::seedGeneration(uint32_t base) {
+  currentGeneration = base;
+  horizon = base;
+  deletionHead = 0;
+  deletionsStored = 0;
+  for (auto &entry : slots) {
+    entry.changedAt = base;
+  }
+}
+
+void DeviceRegistry::touch(DeviceHandle handle) {
+  if (!get(handle)) return;
+  slots[deviceHandleSlot(handle)].changedAt = ++currentGeneration;
+}
+
+uint32_t DeviceRegistry::changedAt(const Device &device) const {
+  if (get(device.handle) != &device) return currentGeneration;
+  return slots[deviceHandleSlot(device.handle)].changedAt;
+}
+
+bool DeviceRegistry::canDiffSince(uint32_t since) const {
+  return since >= horizon && since <= currentGeneration;
+}
+
+const DeviceRegistry::Deletion &DeviceRegistry::deletion(size_t i) const {
+  size_t oldest = (deletionHead + DEVICE_DELETION_LOG_SIZE - deletionsStored) % DEVICE_DELETION_LOG_SIZE;
+  return deletionLog[(oldest + i) % DEVICE_DELETION_LOG_SIZE];
+}
+
+void DeviceRegistry::logDeletion(const String &id) {
+  Deletion &entry = deletionLog[deletionHead];
+  if (deletionsStored == DEVICE_DELETION_LOG_SIZE) {
+    // Clients older than the evicted deletion can no longer be diffed
+    horizon = entry.generation;
+  } else {
+    deletionsStored++;
+  }
+  entry.id = id;
+  entry.generation = ++currentGeneration;
+  deletionHead = (deletionHead + 1) % DEVICE_DELETION_LOG_SIZE;
+}
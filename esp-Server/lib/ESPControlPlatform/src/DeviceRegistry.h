@@ -0,0 +1,151 @@
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <Arduino.h>
+#include <vector>
+#include "DeviceHandle.h"
+#include "PinMap.h"
+
+struct Device;
+
+// Deletions remembered for delta queries; older ones force a full resync
+#define DEVICE_DELETION_LOG_SIZE 32
+
+// --- Device Registry ---
+
+// Devices live in stable slots; an open-addressing (linear probing) hash
+// table over the ids maps an id to its slot, so lookups by id, handle and
+// deletions all cost O(1) regardless of how many devices are registered.
+class DeviceRegistry {
+public:
+  DeviceRegistry();
+
+  // Adds a copy of the device and returns its handle, or
+  // INVALID_DEVICE_HANDLE if a device with the same id already exists.
+  DeviceHandle add(const Device &device);
+
+  // Lookups return nullptr when nothing matches. Devices never move, so a
+  // returned pointer stays valid until that device is removed.
+  Device* get(DeviceHandle handle);
+  const Device* get(DeviceHandle handle) const;
+  Device* find(const String &id);
+  const Device* find(const String &id) const;
+  DeviceHandle findHandle(const String &id) const;
+
+  // Same lookup for ids that are not Strings yet (e.g. straight from a parsed
+  // message), without allocating one
+  Device* find(const char *id);
+  const Device* find(const char *id) const;
+
+  bool remove(const String &id);
+  bool remove(DeviceHandle handle);
+  void clear();
+
+  size_t size() const { return count; }
+  size_t slotCount() const { return slots.size(); }
+
+  // --- Pin ownership ---
+
+  // Devices claim their free pins when added and give them back when
+  // removed. A pin already held by another device (e.g. from a file saved
+  // before pins were checked) stays with its first owner.
+
+  // Replaces a device's pin list, moving its claims along
+  bool setPins(DeviceHandle handle, const std::vector<int> &pins);
+
+  // Device driving a GPIO, or INVALID_DEVICE_HANDLE
+  DeviceHandle pinOwner(int pin) const { return pinOwners.owner(pin); }
+  const PinMap &pinMap() const { return pinOwners; }
+
+  // --- Change tracking ---
+
+  // The generation grows by one on every add, remove, clear and touch, so a
+  // client that remembers it can ask for just the changes made since.
+  uint32_t generation() const { return currentGeneration; }
+
+  // Restarts the counter at a new base, forgetting all history. Seed with a
+  // random value at boot so generations from before a reboot are not mistaken
+  // for current ones.
+  void seedGeneration(uint32_t base);
+
+  // Records an in-place change (state, pins) to a device
+  void touch(DeviceHandle handle);
+
+  // Generation at which the device was added or last touched
+  uint32_t changedAt(const Device &device) const;
+
+  // True if changedAt() and the deletion log fully describe everything that
+  // happened after the given generation
+  bool canDiffSince(uint32_t since) const;
+
+  struct Deletion {
+    String id;
+    uint32_t generation;
+  };
+
+  // Remembered deletions, oldest first
+  size_t deletionCount() const { return deletionsStored; }
+  const Deletion &deletion(size_t i) const;
+
+  // Iterates over live devices in slot order
+  template <typename SlotVec, typename Value>
+  class Iterator {
+  public:
+    Iterator(SlotVec &slots, size_t pos) : slots(slots), pos(pos) { skipFree(); }
+    Value &operator*() const { return *slots[pos].device; }
+    Value *operator->() const { return slots[pos].device; }
+    Iterator &operator++() { ++pos; skipFree(); return *this; }
+    bool operator!=(const Iterator &other) const { return pos != other.pos; }
+    bool operator==(const Iterator &other) const { return pos == other.pos; }
+  private:
+    void skipFree() { while (pos < slots.size() && !slots[pos].device) ++pos; }
+    SlotVec &slots;
+    size_t pos;
+  };
+
+  struct Slot {
+    Device *device;       // nullptr when the slot is free
+    uint16_t generation;  // bumped on every reuse, see DeviceHandle
+    uint32_t changedAt;   // registry generation of the last change
+  };
+
+  typedef Iterator<std::vector<Slot>, Device> iterator;
+  typedef Iterator<const std::vector<Slot>, const Device> const_iterator;
+
+  iterator begin() { return iterator(slots, 0); }
+  iterator end() { return iterator(slots, slots.size()); }
+  const_iterator begin() const { return const_iterator(slots, 0); }
+  const_iterator end() const { return const_iterator(slots, slots.size()); }
+
+  ~DeviceRegistry();
+
+private:
+  // Hash table markers; slot numbers stay below both
+  enum : uint16_t { EMPTY = 0xFFFF, TOMBSTONE = 0xFFFE };
+
+  static uint32_t hashId(const char *id, size_t length);
+  size_t findIndexPos(const char *id, size_t length) const;
+  size_t findIndexPos(const String &id) const { return findIndexPos(id.c_str(), id.length()); }
+  void rehash(size_t tableSize);
+  void releaseSlot(uint16_t slot);
+  void logDeletion(const String &id);
+
+  DeviceRegistry(const DeviceRegistry &) = delete;
+  DeviceRegistry &operator=(const DeviceRegistry &) = delete;
+
+  std::vector<Slot> slots;
+  std::vector<uint16_t> freeSlots;
+  std::vector<uint16_t> index;     // hash table of slot numbers, size is a power of two
+  size_t count;
+  size_t tombstones;
+
+  uint32_t currentGeneration;
+  uint32_t horizon;                // oldest generation deltas can start from
+  Deletion deletionLog[DEVICE_DELETION_LOG_SIZE];
+  size_t deletionHead;             // next entry to overwrite
+  size_t deletionsStored;
+
+  PinMap pinOwners;
+};
+
+#endif  // DEVICE_REGISTRY_H
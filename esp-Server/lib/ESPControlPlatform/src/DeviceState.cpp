@@ -0,0 +1,216 @@
+#include "DeviceState.h"
+#include "ESPControlPlatform.h"
+#include <stdlib.h>
+#include <strings.h>
+
+// --- Field Parsers ---
+
+static bool parseLong(const char* text, long &value) {
+  if (!text || !*text) return false;
+  char* end;
+  value = strtol(text, &end, 10);
+  return *end == '\0';
+}
+
+static bool parseSwitch(const char* text, DeviceState &out) {
+  if (strcasecmp(text, "on") == 0 || strcmp(text, "1") == 0 || strcasecmp(text, "true") == 0) {
+    out.kind = STATE_SWITCH;
+    out.on = true;
+    return true;
+  }
+  if (strcasecmp(text, "off") == 0 || strcmp(text, "0") == 0 || strcasecmp(text, "false") == 0) {
+    out.kind = STATE_SWITCH;
+    out.on = false;
+    return true;
+  }
+  return false;
+}
+
+static bool parseAngle(const char* text, DeviceState &out) {
+  long angle;
+  if (!parseLong(text, angle) || angle < 0 || angle > 180) return false;
+  out.kind = STATE_ANGLE;
+  out.angle = angle;
+  return true;
+}
+
+// "off" or "<mode>:<speed>:<direction>", e.g. "on:80:forward"
+static bool parseMotor(const char* text, DeviceState &out) {
+  if (strcasecmp(text, "off") == 0 || strcmp(text, "0") == 0) {
+    out.kind = STATE_SPEED;
+    out.motor.running = false;
+    out.motor.speed = 0;
+    out.motor.direction = MOTOR_FORWARD;
+    return true;
+  }
+
+  const char* firstColon = strchr(text, ':');
+  if (!firstColon) return false;
+  char* end;
+  long speed = strtol(firstColon + 1, &end, 10);
+  if (end == firstColon + 1 || *end != ':' || speed < 0 || speed > 100) return false;
+
+  const char* direction = end + 1;
+  if (strcasecmp(direction, "forward") == 0) out.motor.direction = MOTOR_FORWARD;
+  else if (strcasecmp(direction, "reverse") == 0) out.motor.direction = MOTOR_REVERSE;
+  else return false;
+
+  out.kind = STATE_SPEED;
+  out.motor.running = true;
+  out.motor.speed = speed;
+  return true;
+}
+
+// "#rrggbb", "r,g,b" or "off"
+static bool parseRGB(const char* text, DeviceState &out) {
+  long r = 0, g = 0, b = 0;
+  if (strcasecmp(text, "off") == 0) {
+    // all channels zero
+  } else if (text[0] == '#' && strlen(text) == 7) {
+    char* end;
+    long rgb = strtol(text + 1, &end, 16);
+    if (*end != '\0' || rgb < 0) return false;
+    r = (rgb >> 16) & 0xFF;
+    g = (rgb >> 8) & 0xFF;
+    b = rgb & 0xFF;
+  } else {
+    char* end;
+    r = strtol(text, &end, 10);
+    if (*end != ',') return false;
+    g = strtol(end + 1, &end, 10);
+    if (*end != ',') return false;
+    b = strtol(end + 1, &end, 10);
+    if (*end != '\0') return false;
+    if (r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) return false;
+  }
+  out.kind = STATE_RGB;
+  out.rgb.r = r;
+  out.rgb.g = g;
+  out.rgb.b = b;
+  return true;
+}
+
+static const char* const EFFECT_NAMES[STRIP_EFFECT_COUNT] = {
+  "rainbow", "chase", "breathe", "twinkle"
+};
+
+// A colour as parseRGB accepts it, or "<effect>[:<colour>]", e.g.
+// "rainbow" or "chase:#ff0000". Effects default to white.
+static bool parseStrip(const char* text, DeviceState &out) {
+  if (parseRGB(text, out)) return true;
+
+  const char* colon = strchr(text, ':');
+  size_t nameLength = colon ? (size_t)(colon - text) : strlen(text);
+  for (uint8_t i = 0; i < STRIP_EFFECT_COUNT; i++) {
+    if (strlen(EFFECT_NAMES[i]) != nameLength || strncasecmp(text, EFFECT_NAMES[i], nameLength) != 0) continue;
+
+    DeviceState colour;
+    colour.rgb.r = colour.rgb.g = colour.rgb.b = 0xFF;
+    if (colon && !parseRGB(colon + 1, colour)) return false;
+    out.kind = STATE_EFFECT;
+    out.fx.effect = (StripEffect)i;
+    out.fx.r = colour.rgb.r;
+    out.fx.g = colour.rgb.g;
+    out.fx.b = colour.rgb.b;
+    return true;
+  }
+  return false;
+}
+
+static bool parseSteps(const char* text, DeviceState &out) {
+  long steps;
+  if (!parseLong(text, steps)) return false;
+  out.kind = STATE_STEPS;
+  out.steps = steps;
+  return true;
+}
+
+// Generic devices accept on/off, a number, or a short piece of text
+static bool parseGeneric(const char* text, DeviceState &out) {
+  if (parseSwitch(text, out)) return true;
+
+  char* end;
+  float value = strtof(text, &end);
+  if (*text && *end == '\0') {
+    out.kind = STATE_VALUE;
+    out.value = value;
+    return true;
+  }
+
+  size_t length = strlen(text);
+  if (length > STATE_TEXT_MAX) return false;
+  out.kind = STATE_TEXT;
+  memcpy(out.text, text, length + 1);
+  return true;
+}
+
+// --- Public API ---
+
+bool parseDeviceState(uint8_t kind, const char* text, DeviceState &out) {
+  if (!text) return false;
+
+  switch (kind) {
+    case LED_KIND:
+    case RELAY_KIND:     return parseSwitch(text, out);
+    case SERVO_KIND:     return parseAngle(text, out);
+    case MOTOR_KIND:     return parseMotor(text, out);
+    case LED_STRIP_KIND: return parseStrip(text, out);
+    case STEPPER_KIND:   return parseSteps(text, out);
+    default:             return parseGeneric(text, out);
+  }
+}
+
+size_t formatDeviceState(const DeviceState &state, char* buffer, size_t size) {
+  int written;
+  switch (state.kind) {
+    case STATE_SWITCH:
+      written = snprintf(buffer, size, "%s", state.on ? "on" : "off");
+      break;
+    case STATE_ANGLE:
+      written = snprintf(buffer, size, "%u", state.angle);
+      break;
+    case STATE_SPEED:
+      if (state.motor.running) {
+        written = snprintf(buffer, size, "on:%u:%s", state.motor.speed,
+                           state.motor.direction == MOTOR_REVERSE ? "reverse" : "forward");
+      } else {
+        written = snprintf(buffer, size, "off");
+      }
+      break;
+    case STATE_RGB:
+      written = snprintf(buffer, size, "#%02x%02x%02x", state.rgb.r, state.rgb.g, state.rgb.b);
+      break;
+    case STATE_STEPS:
+      written = snprintf(buffer, size, "%ld", (long)state.steps);
+      break;
+    case STATE_VALUE:
+      written = snprintf(buffer, size, "%g", state.value);
+      break;
+    case STATE_TEXT:
+      written = snprintf(buffer, size, "%s", state.text);
+      break;
+    case STATE_EFFECT:
+      if (state.fx.effect == EFFECT_RAINBOW) {
+        written = snprintf(buffer, size, "%s", stripEffectName(state.fx.effect));
+      } else {
+        written = snprintf(buffer, size, "%s:#%02x%02x%02x", stripEffectName(state.fx.effect),
+                           state.fx.r, state.fx.g, state.fx.b);
+      }
+      break;
+    default:
+      written = snprintf(buffer, size, "unknown");
+      break;
+  }
+  if (written < 0) return 0;
+  return (size_t)written < size ? written : size - 1;
+}
+
+String formatDeviceState(const DeviceState &state) {
+  char buffer[STATE_STRING_MAX];
+  formatDeviceState(state, buffer, sizeof(buffer));
+  return String(buffer);
+}
+
+const char* stripEffectName(StripEffect effect) {
+  return effect < STRIP_EFFECT_COUNT ? EFFECT_NAMES[effect] : "unknown";
+}
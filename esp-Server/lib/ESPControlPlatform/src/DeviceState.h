@@ -0,0 +1,76 @@
+#ifndef DEVICE_STATE_H
+#define DEVICE_STATE_H
+
+#include <Arduino.h>
+
+// --- Typed Device State ---
+
+// A device state is parsed once at the API boundary into this tagged value;
+// drivers read the typed fields directly and never re-parse text.
+enum StateKind : uint8_t {
+  STATE_UNKNOWN,
+  STATE_SWITCH,   // on/off (led, relay)
+  STATE_ANGLE,    // 0-180 degrees (servo)
+  STATE_SPEED,    // speed 0-100 plus direction (motor)
+  STATE_RGB,      // colour (led_strip)
+  STATE_STEPS,    // relative step count (stepper)
+  STATE_VALUE,    // numeric reading (sensor, generic)
+  STATE_TEXT,     // short free-form text (generic)
+  STATE_EFFECT    // animated effect with a colour (led_strip)
+};
+
+enum MotorDirection : uint8_t {
+  MOTOR_FORWARD,
+  MOTOR_REVERSE
+};
+
+// Effects a strip renders on its own, see led_strip.h
+enum StripEffect : uint8_t {
+  EFFECT_RAINBOW,
+  EFFECT_CHASE,
+  EFFECT_BREATHE,
+  EFFECT_TWINKLE,
+  STRIP_EFFECT_COUNT
+};
+
+#define STATE_TEXT_MAX 23
+#define STATE_STRING_MAX 32   // buffer size that fits any formatted state
+
+struct DeviceState {
+  StateKind kind = STATE_UNKNOWN;
+  union {
+    bool on;
+    uint8_t angle;
+    struct {
+      bool running;
+      uint8_t speed;
+      MotorDirection direction;
+    } motor;
+    struct {
+      uint8_t r, g, b;
+    } rgb;
+    struct {
+      StripEffect effect;
+      uint8_t r, g, b;
+    } fx;
+    int32_t steps;
+    float value;
+    char text[STATE_TEXT_MAX + 1];
+  };
+
+  DeviceState() : text{} {}
+};
+
+// Parses state text using the grammar of the given device kind
+// (see DeviceKind). Returns false if the text is malformed or out of range.
+bool parseDeviceState(uint8_t kind, const char* text, DeviceState &out);
+
+// Writes the canonical text form of a state, e.g. "on", "90",
+// "on:80:forward", "#ff8000". Returns the number of characters written.
+size_t formatDeviceState(const DeviceState &state, char* buffer, size_t size);
+String formatDeviceState(const DeviceState &state);
+
+// "rainbow", "chase", "breathe" or "twinkle"
+const char* stripEffectName(StripEffect effect);
+
+#endif  // DEVICE_STATE_H
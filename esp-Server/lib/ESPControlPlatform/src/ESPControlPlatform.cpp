@@ -1,24 +1,164 @@
 #include "ESPControlPlatform.h"
 
-// Define the global devices vector
-std::vector<Device> devices;
+// Define the global device registry
+DeviceRegistry devices;
+
+// --- Name Tables ---
+
+struct NameEntry {
+  const char* name;
+  uint8_t length;
+  uint8_t value;
+};
+
+static constexpr NameEntry INTERFACE_NAMES[] = {
+  {"digital", 7, DIGITAL_IF},
+  {"analog",  6, ANALOG_IF},
+  {"pwm",     3, PWM_IF},
+  {"i2c",     3, I2C_IF},
+  {"spi",     3, SPI_IF},
+};
+
+static constexpr NameEntry DIRECTION_NAMES[] = {
+  {"input",         5,  INPUT_DEVICE},
+  {"output",        6,  OUTPUT_DEVICE},
+  {"bidirectional", 13, BIDIRECTIONAL},
+};
+
+// Built-in kinds occupy the first BUILTIN_KIND_COUNT entries, in enum order
+static const char* kindNames[MAX_DEVICE_KINDS] = {
+  "led", "servo", "stepper", "motor", "relay", "led_strip", "sensor", "generic"
+};
+static uint8_t kindCount = BUILTIN_KIND_COUNT;
+
+// Length is compared first so most mismatches never touch the characters
+template <size_t N>
+static int lookupName(const NameEntry (&table)[N], const String &str) {
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].length == str.length() && strcasecmp(table[i].name, str.c_str()) == 0) {
+      return table[i].value;
+    }
+  }
+  return -1;
+}
+
+template <size_t N>
+static const char* nameOf(const NameEntry (&table)[N], int value) {
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].value == value) return table[i].name;
+  }
+  return "unknown";
+}
 
 // --- Helper Function Definitions ---
 
 InterfaceType parseInterfaceType(const String &typeStr) {
-  if (typeStr.equalsIgnoreCase("digital")) return DIGITAL_IF;
-  else if (typeStr.equalsIgnoreCase("analog")) return ANALOG_IF;
-  else if (typeStr.equalsIgnoreCase("pwm")) return PWM_IF;
-  else if (typeStr.equalsIgnoreCase("i2c")) return I2C_IF;
-  else if (typeStr.equalsIgnoreCase("spi")) return SPI_IF;
-  else return UNKNOWN_INTERFACE;
+  int value = lookupName(INTERFACE_NAMES, typeStr);
+  return value < 0 ? UNKNOWN_INTERFACE : (InterfaceType)value;
 }
 
 DeviceDirection parseDeviceDirection(const String &dirStr) {
-  if (dirStr.equalsIgnoreCase("input")) return INPUT_DEVICE;
-  else if (dirStr.equalsIgnoreCase("output")) return OUTPUT_DEVICE;
-  else if (dirStr.equalsIgnoreCase("bidirectional")) return BIDIRECTIONAL;
-  else return UNKNOWN_DIRECTION;
+  int value = lookupName(DIRECTION_NAMES, dirStr);
+  return value < 0 ? UNKNOWN_DIRECTION : (DeviceDirection)value;
+}
+
+const char* interfaceTypeName(InterfaceType interface) {
+  return nameOf(INTERFACE_NAMES, interface);
+}
+
+const char* deviceDirectionName(DeviceDirection direction) {
+  return nameOf(DIRECTION_NAMES, direction);
+}
+
+DeviceKind parseDeviceKind(const String &typeStr) {
+  for (uint8_t kind = 0; kind < kindCount; kind++) {
+    if (typeStr == kindNames[kind]) return kind;
+  }
+  return GENERIC_KIND;
+}
+
+DeviceKind registerDeviceKind(const char* typeName) {
+  DeviceKind existing = parseDeviceKind(typeName);
+  if (existing != GENERIC_KIND || strcmp(typeName, kindNames[GENERIC_KIND]) == 0) {
+    return existing;
+  }
+  if (kindCount >= MAX_DEVICE_KINDS) return GENERIC_KIND;
+
+  kindNames[kindCount] = typeName;
+  return kindCount++;
+}
+
+const char* deviceKindName(DeviceKind kind) {
+  return kind < kindCount ? kindNames[kind] : kindNames[GENERIC_KIND];
+}
+
+// --- Pin Validation ---
+
+uint8_t minimumPinCount(DeviceKind kind) {
+  switch (kind) {
+    case LED_KIND:
+    case SERVO_KIND:
+    case RELAY_KIND:
+    case LED_STRIP_KIND:
+    case SENSOR_KIND:    return 1;
+    case STEPPER_KIND:   return 2;   // step, direction
+    case MOTOR_KIND:     return 3;   // in1, in2, enable (PWM)
+    default:             return 0;
+  }
+}
+
+bool deviceKeepsState(DeviceKind kind) {
+  return kind != STEPPER_KIND;
+}
+
+uint16_t requiredPinCapabilities(const Device &device, size_t position) {
+  uint16_t required = 0;
+  switch (device.kind) {
+    case SERVO_KIND:
+      required |= PIN_CAP_OUTPUT | PIN_CAP_LEDC;
+      break;
+    case MOTOR_KIND:
+      required |= PIN_CAP_OUTPUT;
+      if (position == 2) required |= PIN_CAP_LEDC;
+      break;
+    case LED_KIND:
+    case STEPPER_KIND:
+    case RELAY_KIND:
+    case LED_STRIP_KIND:
+      required |= PIN_CAP_OUTPUT;
+      break;
+    default:
+      break;
+  }
+
+  if (device.direction == OUTPUT_DEVICE || device.direction == BIDIRECTIONAL) required |= PIN_CAP_OUTPUT;
+  if (device.interface == PWM_IF) required |= PIN_CAP_OUTPUT | PIN_CAP_LEDC;
+  if (device.interface == ANALOG_IF && device.direction == INPUT_DEVICE && position == 0) {
+    required |= PIN_CAP_ADC1;
+  }
+  return required;
+}
+
+PinError checkDevicePins(const Device &device, const std::vector<int> &pins, int &badPin, uint64_t taken) {
+  badPin = -1;
+  if (pins.size() < minimumPinCount(device.kind)) return PIN_ERR_TOO_FEW;
+
+  const PinMap &map = devices.pinMap();
+  uint64_t seen = 0;
+  for (size_t i = 0; i < pins.size(); i++) {
+    int pin = pins[i];
+    PinError error = map.check(pin, requiredPinCapabilities(device, i), device.handle);
+    if (error == PIN_ERR_NONE) {
+      if ((seen >> pin) & 1) error = PIN_ERR_DUPLICATE;
+      else if ((taken >> pin) & 1) error = PIN_ERR_IN_USE;
+    }
+    if (error != PIN_ERR_NONE) {
+      badPin = pin;
+      return error;
+    }
+    seen |= 1ULL << pin;
+  }
+  return PIN_ERR_NONE;
 }
 
 std::vector<int> parsePins(const String &pinsStr) {
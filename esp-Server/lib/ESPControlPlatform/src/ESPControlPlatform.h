@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <vector>
+#include "DeviceRegistry.h"
+#include "DeviceState.h"
+#include "PinMap.h"
 
 // --- Enums ---
 
@@ -22,24 +25,87 @@ enum DeviceDirection {
   UNKNOWN_DIRECTION
 };
 
+// Device types are interned into a small id when a device is created or
+// loaded. Built-in kinds come first; drivers registered at runtime get the
+// ids after BUILTIN_KIND_COUNT.
+enum BuiltinDeviceKind {
+  LED_KIND,
+  SERVO_KIND,
+  STEPPER_KIND,
+  MOTOR_KIND,
+  RELAY_KIND,
+  LED_STRIP_KIND,
+  SENSOR_KIND,
+  GENERIC_KIND,
+  BUILTIN_KIND_COUNT
+};
+
+typedef uint8_t DeviceKind;
+
+#define MAX_DEVICE_KINDS 16
+
 // --- Helper Function Declarations ---
 
 InterfaceType parseInterfaceType(const String &typeStr);
 DeviceDirection parseDeviceDirection(const String &dirStr);
 std::vector<int> parsePins(const String &pinsStr);
 
+const char* interfaceTypeName(InterfaceType interface);
+const char* deviceDirectionName(DeviceDirection direction);
+
+// Maps a type string ("led", "servo", ...) to its kind; unknown types are GENERIC_KIND
+DeviceKind parseDeviceKind(const String &typeStr);
+
+// Adds a new type name and returns its kind, or the existing kind if the
+// name is already known. Returns GENERIC_KIND once MAX_DEVICE_KINDS is reached.
+// The name is not copied and must stay valid (e.g. a string literal).
+DeviceKind registerDeviceKind(const char* typeName);
+
+// Type name of a kind, or the generic name for unknown kinds
+const char* deviceKindName(DeviceKind kind);
+
 // --- Device Structure ---
 
 struct Device {
   String id;
   String type;                   // e.g., "sensor", "actuator"
+  DeviceKind kind = GENERIC_KIND;  // interned from type, see parseDeviceKind
   std::vector<int> pins;         // supports one or more pins
-  String state;                  // e.g., sensor reading or actuator state
+  DeviceState state;             // e.g., sensor reading or actuator state
   InterfaceType interface;       // e.g., DIGITAL_IF, ANALOG_IF, etc.
   DeviceDirection direction;     // e.g., INPUT_DEVICE, OUTPUT_DEVICE, etc.
+  uint16_t sampleIntervalMs = 0; // input devices only; 0 uses the sampler default
+  uint32_t pwmFrequency = 0;     // PWM outputs only, in Hz; 0 uses the default for the kind
+  uint8_t pwmResolution = 0;     // PWM duty resolution in bits; 0 uses the default
+  uint16_t maxSpeed = 0;         // steppers, in steps/s; 0 uses the default
+  uint16_t acceleration = 0;     // steppers, in steps/s^2; 0 uses the default
+  uint8_t motionProfile = 0;     // steppers, see MotionProfile (trapezoid by default)
+  int32_t position = 0;          // steppers, absolute steps; kept by the stepper engine, read-only
+  uint16_t ledCount = 0;         // LED strips, in pixels; 0 uses the default
+  DeviceHandle handle = INVALID_DEVICE_HANDLE;  // assigned by DeviceRegistry::add
 };
 
-// Global container for devices.  
-extern std::vector<Device> devices;
+// Global registry of devices, indexed by id.
+extern DeviceRegistry devices;
+
+// False for kinds whose state is a command rather than a setting: a
+// stepper's state is a relative move, so its Device::state stays
+// STATE_UNKNOWN and only its position is kept.
+bool deviceKeepsState(DeviceKind kind);
+
+// --- Pin Validation ---
+
+// Pins a device of this kind drives at least, e.g. in1, in2 and enable for
+// a motor. Drivers index up to this count without checking.
+uint8_t minimumPinCount(DeviceKind kind);
+
+// Capabilities the device needs from its pin at the given position
+uint16_t requiredPinCapabilities(const Device &device, size_t position);
+
+// Checks a proposed pin list for the device against devices.pinMap() in
+// O(pins): count, existence, capabilities and ownership. Pins set in taken
+// count as owned by another device (e.g. claimed earlier in the same
+// batch). On failure badPin is the offending pin, or -1.
+PinError checkDevicePins(const Device &device, const std::vector<int> &pins, int &badPin, uint64_t taken = 0);
 
 #endif  // ESPCONTROLPLATFORM_H
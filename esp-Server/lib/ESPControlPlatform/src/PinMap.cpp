@@ -0,0 +1,119 @@
+#include "PinMap.h"
+
+// --- Capability Table ---
+
+#define IO    (PIN_CAP_EXISTS | PIN_CAP_OUTPUT | PIN_CAP_LEDC)
+#define IN    PIN_CAP_EXISTS
+
+// ESP32 (WROOM/WROVER) GPIO matrix, indexed by GPIO number
+static constexpr uint16_t PIN_CAPABILITIES[PIN_COUNT] = {
+  IO | PIN_CAP_ADC2 | PIN_CAP_STRAPPING,   // 0
+  IO | PIN_CAP_RESERVED,                   // 1  UART0 TX
+  IO | PIN_CAP_ADC2 | PIN_CAP_STRAPPING,   // 2
+  IO | PIN_CAP_RESERVED,                   // 3  UART0 RX
+  IO | PIN_CAP_ADC2,                       // 4
+  IO | PIN_CAP_STRAPPING,                  // 5
+  IN | PIN_CAP_RESERVED,                   // 6  SPI flash
+  IN | PIN_CAP_RESERVED,                   // 7
+  IN | PIN_CAP_RESERVED,                   // 8
+  IN | PIN_CAP_RESERVED,                   // 9
+  IN | PIN_CAP_RESERVED,                   // 10
+  IN | PIN_CAP_RESERVED,                   // 11
+  IO | PIN_CAP_ADC2 | PIN_CAP_STRAPPING,   // 12
+  IO | PIN_CAP_ADC2,                       // 13
+  IO | PIN_CAP_ADC2,                       // 14
+  IO | PIN_CAP_ADC2 | PIN_CAP_STRAPPING,   // 15
+  IO,                                      // 16
+  IO,                                      // 17
+  IO,                                      // 18
+  IO,                                      // 19
+  0,                                       // 20
+  IO,                                      // 21
+  IO,                                      // 22
+  IO,                                      // 23
+  0,                                       // 24
+  IO | PIN_CAP_ADC2 | PIN_CAP_DAC,         // 25
+  IO | PIN_CAP_ADC2 | PIN_CAP_DAC,         // 26
+  IO | PIN_CAP_ADC2,                       // 27
+  0, 0, 0, 0,                              // 28-31
+  IO | PIN_CAP_ADC1,                       // 32
+  IO | PIN_CAP_ADC1,                       // 33
+  IN | PIN_CAP_ADC1,                       // 34
+  IN | PIN_CAP_ADC1,                       // 35
+  IN | PIN_CAP_ADC1,                       // 36
+  IN | PIN_CAP_ADC1,                       // 37
+  IN | PIN_CAP_ADC1,                       // 38
+  IN | PIN_CAP_ADC1,                       // 39
+};
+
+#undef IO
+#undef IN
+
+uint16_t pinCapabilities(int pin) {
+  return pin >= 0 && pin < PIN_COUNT ? PIN_CAPABILITIES[pin] : 0;
+}
+
+const char* pinErrorMessage(PinError error) {
+  switch (error) {
+    case PIN_ERR_NONE:        return "OK";
+    case PIN_ERR_TOO_FEW:     return "Not enough pins for this device type";
+    case PIN_ERR_NO_SUCH_PIN: return "Pin is not a GPIO";
+    case PIN_ERR_RESERVED:    return "Pin is reserved for flash or the serial console";
+    case PIN_ERR_DUPLICATE:   return "Pin listed twice";
+    case PIN_ERR_INPUT_ONLY:  return "Pin is input-only";
+    case PIN_ERR_NO_ADC1:     return "Pin has no ADC1 channel (ADC2 is unusable with WiFi)";
+    case PIN_ERR_IN_USE:      return "Pin is used by another device";
+  }
+  return "Invalid pin";
+}
+
+// --- Pin Map ---
+
+PinMap::PinMap() {
+  clear();
+}
+
+PinError PinMap::check(int pin, uint16_t required, DeviceHandle self) const {
+  uint16_t caps = pinCapabilities(pin);
+  if (!(caps & PIN_CAP_EXISTS)) return PIN_ERR_NO_SUCH_PIN;
+  if (caps & PIN_CAP_RESERVED) return PIN_ERR_RESERVED;
+  if ((required & PIN_CAP_OUTPUT) && !(caps & PIN_CAP_OUTPUT)) return PIN_ERR_INPUT_ONLY;
+  if ((required & PIN_CAP_LEDC) && !(caps & PIN_CAP_LEDC)) return PIN_ERR_INPUT_ONLY;
+  if ((required & PIN_CAP_ADC1) && !(caps & PIN_CAP_ADC1)) return PIN_ERR_NO_ADC1;
+  if ((used >> pin) & 1 && owners[pin] != self) return PIN_ERR_IN_USE;
+  return PIN_ERR_NONE;
+}
+
+size_t PinMap::claim(const std::vector<int> &pins, DeviceHandle owner) {
+  size_t skipped = 0;
+  for (int pin : pins) {
+    if (pin < 0 || pin >= PIN_COUNT) {
+      skipped++;
+    } else if ((used >> pin) & 1) {
+      if (owners[pin] != owner) skipped++;
+    } else {
+      owners[pin] = owner;
+      used |= 1ULL << pin;
+    }
+  }
+  return skipped;
+}
+
+void PinMap::release(const std::vector<int> &pins, DeviceHandle owner) {
+  for (int pin : pins) {
+    if (pin < 0 || pin >= PIN_COUNT || owners[pin] != owner) continue;
+    owners[pin] = INVALID_DEVICE_HANDLE;
+    used &= ~(1ULL << pin);
+  }
+}
+
+void PinMap::clear() {
+  used = 0;
+  for (auto &owner : owners) {
+    owner = INVALID_DEVICE_HANDLE;
+  }
+}
+
+DeviceHandle PinMap::owner(int pin) const {
+  return pin >= 0 && pin < PIN_COUNT ? owners[pin] : INVALID_DEVICE_HANDLE;
+}
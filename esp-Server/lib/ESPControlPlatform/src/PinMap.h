@@ -0,0 +1,70 @@
+#ifndef PIN_MAP_H
+#define PIN_MAP_H
+
+#include <Arduino.h>
+#include <vector>
+#include "DeviceHandle.h"
+
+// --- Pin Capabilities ---
+
+// GPIO numbers on the ESP32 run from 0 to 39, with gaps
+#define PIN_COUNT 40
+
+enum PinCapability : uint16_t {
+  PIN_CAP_EXISTS    = 1 << 0,
+  PIN_CAP_OUTPUT    = 1 << 1,   // 34-39 are input-only
+  PIN_CAP_LEDC      = 1 << 2,   // can be routed to an LEDC (PWM) channel
+  PIN_CAP_ADC1      = 1 << 3,
+  PIN_CAP_ADC2      = 1 << 4,   // not readable while WiFi is running
+  PIN_CAP_DAC       = 1 << 5,
+  PIN_CAP_STRAPPING = 1 << 6,   // sampled at reset; external pulls can block boot
+  PIN_CAP_RESERVED  = 1 << 7    // SPI flash (6-11) or the serial console (1, 3)
+};
+
+// Capability mask of a GPIO, 0 for numbers that are not a GPIO
+uint16_t pinCapabilities(int pin);
+
+enum PinError : uint8_t {
+  PIN_ERR_NONE,
+  PIN_ERR_TOO_FEW,        // fewer pins than the device kind drives
+  PIN_ERR_NO_SUCH_PIN,
+  PIN_ERR_RESERVED,
+  PIN_ERR_DUPLICATE,      // listed twice for the same device
+  PIN_ERR_INPUT_ONLY,
+  PIN_ERR_NO_ADC1,
+  PIN_ERR_IN_USE          // owned by another device
+};
+
+const char* pinErrorMessage(PinError error);
+
+// --- Pin Map ---
+
+// Which device owns each GPIO: a bitmap of claimed pins plus a reverse index
+// from pin to device handle. Checks and claims cost O(pins), and owner() is a
+// single aligned read, so interrupt handlers can map a pin to its device
+// without scanning the registry.
+class PinMap {
+public:
+  PinMap();
+
+  // Checks one pin for a device that needs the given capabilities. Pins
+  // owned by self pass the ownership check.
+  PinError check(int pin, uint16_t required, DeviceHandle self) const;
+
+  // Claims every listed pin that is free. Pins held by another device are
+  // skipped and counted in the return value.
+  size_t claim(const std::vector<int> &pins, DeviceHandle owner);
+
+  // Frees the listed pins that are held by owner
+  void release(const std::vector<int> &pins, DeviceHandle owner);
+  void clear();
+
+  DeviceHandle owner(int pin) const;
+  uint64_t claimed() const { return used; }
+
+private:
+  uint64_t used;
+  DeviceHandle owners[PIN_COUNT];
+};
+
+#endif  // PIN_MAP_H
@@ -1,164 +1,267 @@
 #include "device_controller.h"
-#include <ESP32Servo.h>
 #include <Wire.h>
-#include <map>
+#include <string.h>
+#include "metrics.h"
+#include "log.h"
+#include "adc_source.h"
+#include "pwm.h"
+#include "stepper.h"
+#include "led_strip.h"
 
-// Global map to store Servo instances for each servo pin
-std::map<int, Servo> servoMap;
+void devicePwmSettings(const Device &device, uint32_t &frequency, uint8_t &resolution) {
+    switch (device.kind) {
+        case SERVO_KIND:
+            frequency = PWM_SERVO_FREQUENCY;
+            resolution = PWM_SERVO_RESOLUTION;
+            break;
+        case MOTOR_KIND:
+            frequency = PWM_MOTOR_FREQUENCY;
+            resolution = PWM_MOTOR_RESOLUTION;
+            break;
+        default:
+            frequency = PWM_DEFAULT_FREQUENCY;
+            resolution = PWM_DEFAULT_RESOLUTION;
+            break;
+    }
+    if (device.pwmFrequency) frequency = device.pwmFrequency;
+    if (device.pwmResolution) resolution = device.pwmResolution;
+}
 
 void setupDevicePins() {
     // Initialize all registered devices
     for (auto &device : devices) {
-        // Set pin modes based on device direction
-        for (int pin : device.pins) {
-            switch (device.direction) {
-                case INPUT_DEVICE:
-                    pinMode(pin, INPUT);
-                    break;
-                case OUTPUT_DEVICE:
-                    pinMode(pin, OUTPUT);
-                    break;
-                case BIDIRECTIONAL:
-                    pinMode(pin, INPUT_PULLUP);
-                    break;
-                default:
-                    break;
+        setupDevicePins(device);
+    }
+}
+
+void setupDevicePins(Device &device) {
+    bool pwmBound = false;
+
+    // Set pin modes based on device direction
+    for (size_t i = 0; i < device.pins.size(); i++) {
+        int pin = device.pins[i];
+
+        // A pin that another device already holds is left alone
+        if (devices.pinOwner(pin) != device.handle) {
+            LOG_ERROR("Device %s: pin %d belongs to another device", device.id.c_str(), pin);
+            continue;
+        }
+
+        // The first pin that needs PWM (servo signal, motor enable, PWM
+        // interface) gets an LEDC channel
+        uint16_t required = requiredPinCapabilities(device, i);
+        if ((required & PIN_CAP_LEDC) && !pwmBound) {
+            uint32_t frequency;
+            uint8_t resolution;
+            devicePwmSettings(device, frequency, resolution);
+            pwmBound = pwmAttach(device.handle, pin, frequency, resolution);
+            if (!pwmBound) {
+                LOG_ERROR("Device %s: no PWM channel for pin %d", device.id.c_str(), pin);
             }
+            continue;
+        }
+
+        // A strip's data pin is routed to its RMT channel below; pinMode
+        // would route it back to plain GPIO
+        if (device.kind == LED_STRIP_KIND && i == 0) continue;
+
+        switch (device.direction) {
+            case INPUT_DEVICE:
+                pinMode(pin, INPUT);
+                break;
+            case OUTPUT_DEVICE:
+                pinMode(pin, OUTPUT);
+                break;
+            case BIDIRECTIONAL:
+                pinMode(pin, INPUT_PULLUP);
+                break;
+            default:
+                // Actuator kinds drive their pins whatever the direction says
+                if (required & PIN_CAP_OUTPUT) pinMode(pin, OUTPUT);
+                break;
+        }
+    }
+
+    if (!pwmBound) {
+        pwmDetach(device.handle);
+    }
+
+    // Step and direction pins are driven by the stepper engine
+    if (device.kind == STEPPER_KIND && device.pins.size() >= 2
+        && devices.pinOwner(device.pins[0]) == device.handle
+        && devices.pinOwner(device.pins[1]) == device.handle) {
+        if (!stepperAttach(device)) {
+            LOG_ERROR("Device %s: no stepper motor left", device.id.c_str());
+        }
+    }
+
+    // The strip's data pin is driven by an RMT channel
+    if (device.kind == LED_STRIP_KIND && !device.pins.empty()
+        && devices.pinOwner(device.pins[0]) == device.handle) {
+        if (!ledStripAttach(device)) {
+            LOG_ERROR("Device %s: no LED strip channel left", device.id.c_str());
         }
     }
 }
 
-bool updateDeviceState(Device &device, const String &newState) {
-    bool success = false;
-    
-    // Route state update to appropriate device type handler
-    if (device.type == "led") 
-        success = controlLED(device, newState);
-    else if (device.type == "servo") 
-        success = controlServo(device, newState);
-    else if (device.type == "stepper") 
-        success = controlStepperMotor(device, newState);
-    else if (device.type == "motor") 
-        success = controlMotor(device, newState);
-    else if (device.type == "relay") 
-        success = controlRelay(device, newState);
-    else if (device.type == "led_strip") 
-        success = controlLEDStrip(device, newState);
-    else if (device.type == "sensor") 
-        success = controlSensor(device, newState);
-    else 
-        success = controlGenericDevice(device, newState);
-
-    // Update device state if operation was successful
-    if (success) {
-        device.state = newState;
+void releaseDevicePins(Device &device) {
+    pwmDetach(device.handle);
+    stepperDetach(device.handle);
+    ledStripDetach(device.handle);
+    for (int pin : device.pins) {
+        if (devices.pinOwner(pin) == device.handle) {
+            pinMode(pin, INPUT);
+        }
     }
+}
 
-    return success;
+// Built-in drivers, indexed by BuiltinDeviceKind
+static constexpr DeviceHandler BUILTIN_HANDLERS[BUILTIN_KIND_COUNT] = {
+    controlLED,             // LED_KIND
+    controlServo,           // SERVO_KIND
+    controlStepperMotor,    // STEPPER_KIND
+    controlMotor,           // MOTOR_KIND
+    controlRelay,           // RELAY_KIND
+    controlLEDStrip,        // LED_STRIP_KIND
+    controlSensor,          // SENSOR_KIND
+    controlGenericDevice,   // GENERIC_KIND
+};
+
+// Drivers registered at runtime, indexed by kind - BUILTIN_KIND_COUNT
+static DeviceHandler customHandlers[MAX_DEVICE_KINDS - BUILTIN_KIND_COUNT];
+
+DeviceKind registerDeviceDriver(const char* typeName, DeviceHandler handler) {
+    DeviceKind kind = registerDeviceKind(typeName);
+    if (kind < BUILTIN_KIND_COUNT) return kind;
+
+    customHandlers[kind - BUILTIN_KIND_COUNT] = handler;
+
+    // Re-intern devices loaded before the driver was registered
+    for (auto &device : devices) {
+        if (device.kind == GENERIC_KIND && device.type == typeName) {
+            device.kind = kind;
+        }
+    }
+    return kind;
 }
 
-bool controlLED(Device &device, const String &state) {
-    Serial.println(device.pins[0]);
-    Serial.println(state);
-    pinMode(device.pins[0], OUTPUT);
-    if (state == "on" || state == "1" || state == "true") {
-        digitalWrite(device.pins[0], HIGH);
-        Serial.println("LED Turned ON");
-        return true;
+// Latency histogram per device kind, registered on first use
+static MetricId controlMetric(DeviceKind kind) {
+    static MetricId metrics[MAX_DEVICE_KINDS];
+    static bool initialized = false;
+    if (!initialized) {
+        memset(metrics, INVALID_METRIC, sizeof(metrics));
+        initialized = true;
     }
-    else if (state == "off" || state == "0" || state == "false") {
-        digitalWrite(device.pins[0], LOW);
-        Serial.println("LED Turned OFF");
-        return true;
+    if (kind >= MAX_DEVICE_KINDS) kind = GENERIC_KIND;
+    if (metrics[kind] == INVALID_METRIC) {
+        metrics[kind] = registerHistogram("esp_device_control_duration_us", "kind", deviceKindName(kind));
     }
-    Serial.println("Invalid LED state");
-    return false;
+    return metrics[kind];
 }
 
-bool controlServo(Device &device, const String &state) {
-    int angle = state.toInt();
-    int servoPin = device.pins[0];
-    Serial.print("Servo angle: ");
-    Serial.println(angle);
-    Serial.print("Servo pin: ");
-    Serial.println(servoPin);
+bool updateDeviceState(Device &device, const DeviceState &newState) {
+    ScopedTimer timer(controlMetric(device.kind));
+
+    // Route state update to the handler registered for the device kind
+    DeviceHandler handler = controlGenericDevice;
+    if (device.kind < BUILTIN_KIND_COUNT) {
+        handler = BUILTIN_HANDLERS[device.kind];
+    } else if (device.kind < MAX_DEVICE_KINDS && customHandlers[device.kind - BUILTIN_KIND_COUNT]) {
+        handler = customHandlers[device.kind - BUILTIN_KIND_COUNT];
+    }
+
+    bool success = handler(device, newState);
 
-    // Check if a Servo instance for this pin already exists in the map
-    if (servoMap.find(servoPin) == servoMap.end()) {
-        // Create and attach a new Servo instance if not found
-        servoMap[servoPin] = Servo();
-        servoMap[servoPin].attach(servoPin);
+    // Update device state if operation was successful. A stepper's move is
+    // not kept; handleSteppers() reports its position instead.
+    if (success && deviceKeepsState(device.kind)) {
+        device.state = newState;
     }
 
-    // Write the angle to the servo associated with this pin
-    servoMap[servoPin].write(angle);
+    return success;
+}
+
+bool controlLED(Device &device, const DeviceState &state) {
+    if (state.kind != STATE_SWITCH) {
+        LOG_ERROR("Invalid LED state");
+        return false;
+    }
+    if (pwmAttached(device.handle)) {
+        // Fades in hardware; the duty is clamped to full scale
+        pwmFade(device.handle, state.on ? UINT32_MAX : 0, LED_FADE_MS);
+    } else {
+        pinMode(device.pins[0], OUTPUT);
+        digitalWrite(device.pins[0], state.on ? HIGH : LOW);
+    }
+    LOG_DEBUG("LED %s turned %s", device.id.c_str(), state.on ? "ON" : "OFF");
     return true;
 }
 
-bool controlStepperMotor(Device &device, const String &state) {
-    // Implement stepper motor control logic
-    return false;
+bool controlServo(Device &device, const DeviceState &state) {
+    if (state.kind != STATE_ANGLE) return false;
+
+    LOG_DEBUG("Servo %s on pin %d to %u degrees", device.id.c_str(), device.pins[0], state.angle);
+
+    // Pulse width on the LEDC channel bound to this device
+    uint32_t pulse = map(state.angle, 0, 180, PWM_SERVO_MIN_US, PWM_SERVO_MAX_US);
+    return pwmWriteMicroseconds(device.handle, pulse);
 }
 
-bool controlMotor(Device &device, const String &state) {
-    if (state == "off") {
-        for (int pin : device.pins) {
-            digitalWrite(pin, LOW);
-        }
-        return true;
-    }
-    
-    int firstColon = state.indexOf(':');
-    int secondColon = state.indexOf(':', firstColon + 1);
-    
-    if (firstColon == -1 || secondColon == -1) return false;
-    
-    int speed = state.substring(firstColon + 1, secondColon).toInt();
-    String direction = state.substring(secondColon + 1);
-    
-    if (device.pins.size() >= 2) {
-        if (direction == "forward") {
-            digitalWrite(device.pins[0], HIGH);
-            digitalWrite(device.pins[1], LOW);
-        } else if (direction == "reverse") {
-            digitalWrite(device.pins[0], LOW);
-            digitalWrite(device.pins[1], HIGH);
-        }
-        
-        analogWrite(device.pins[2], map(speed, 0, 100, 0, 255));
-        return true;
-    }
-    
-    return false;
+bool controlStepperMotor(Device &device, const DeviceState &state) {
+    if (state.kind != STATE_STEPS) return false;
+
+    // Queued for the step interrupt; 0 stops along the ramp
+    return stepperMove(device.handle, state.steps);
 }
 
-bool controlRelay(Device &device, const String &state) {
-    if (state == "on" || state == "1") {
-        digitalWrite(device.pins[0], HIGH);
-        return true;
+bool controlMotor(Device &device, const DeviceState &state) {
+    if (state.kind != STATE_SPEED) return false;
+
+    // in1, in2 and the enable pin carrying the speed
+    if (device.pins.size() < 3) return false;
+
+    if (!state.motor.running) {
+        digitalWrite(device.pins[0], LOW);
+        digitalWrite(device.pins[1], LOW);
+        return pwmWrite(device.handle, 0);
     }
-    else if (state == "off" || state == "0") {
+
+    if (state.motor.direction == MOTOR_FORWARD) {
+        digitalWrite(device.pins[0], HIGH);
+        digitalWrite(device.pins[1], LOW);
+    } else {
         digitalWrite(device.pins[0], LOW);
-        return true;
+        digitalWrite(device.pins[1], HIGH);
     }
-    return false;
+
+    return pwmWriteLevel(device.handle, state.motor.speed, 100);
 }
 
-bool controlLEDStrip(Device &device, const String &state) {
-    // Placeholder for LED strip control
-    return false;
+bool controlRelay(Device &device, const DeviceState &state) {
+    if (state.kind != STATE_SWITCH) return false;
+
+    digitalWrite(device.pins[0], state.on ? HIGH : LOW);
+    return true;
+}
+
+bool controlLEDStrip(Device &device, const DeviceState &state) {
+    if (state.kind != STATE_RGB && state.kind != STATE_EFFECT) return false;
+
+    // Drawn into the back frame; handleLedStrips() sends it
+    return ledStripShow(device.handle, state);
 }
 
-bool controlSensor(Device &device, const String &state) {
+bool controlSensor(Device &device, const DeviceState &state) {
     return true;
 }
 
-bool controlGenericDevice(Device &device, const String &state) {
+bool controlGenericDevice(Device &device, const DeviceState &state) {
     return true;
 }
 
 float readAnalogSensor(int pin) {
-    return analogRead(pin) * (3.3 / 4095.0);  // Convert to voltage on ESP32
+    return readAdcVolts(pin);  // oversampled and calibrated, in volts
 }
 
 int readDigitalSensor(int pin) {
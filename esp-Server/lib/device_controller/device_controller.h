@@ -3,25 +3,45 @@
 
 #include <Arduino.h>
 #include <vector>
-#include <ESP32Servo.h>
 #include "ESPControlPlatform.h"  // Use this instead of devices.h
 
-// Global objects for device control
-extern std::vector<Servo> servoControls;
+// On/off transitions of LEDs on a PWM interface fade over this long
+#ifndef LED_FADE_MS
+#define LED_FADE_MS 200
+#endif
+
+// Handler signature shared by every device driver. The state has already
+// been parsed and range-checked for the device kind (see parseDeviceState).
+typedef bool (*DeviceHandler)(Device &device, const DeviceState &state);
 
 // Function prototypes
 void setupDevicePins();
-bool updateDeviceState(Device &device, const String &newState);
+void setupDevicePins(Device &device);
+
+// Frees the device's PWM channel, stepper motor or LED strip and returns
+// its pins to high-impedance inputs. Call before the device is deleted or
+// re-pinned.
+void releaseDevicePins(Device &device);
+
+// LEDC frequency and resolution the device runs at: its own settings, or
+// the defaults for its kind (see pwm.h)
+void devicePwmSettings(const Device &device, uint32_t &frequency, uint8_t &resolution);
+bool updateDeviceState(Device &device, const DeviceState &newState);
+
+// Plugs in a driver for a new device type without touching the built-in
+// dispatch table. Devices already registered with that type pick it up.
+// Returns the interned kind, or GENERIC_KIND if no kind ids are left.
+DeviceKind registerDeviceDriver(const char* typeName, DeviceHandler handler);
 
 // Specific device type control functions
-bool controlLED(Device &device, const String &state);
-bool controlServo(Device &device, const String &state);
-bool controlStepperMotor(Device &device, const String &state);
-bool controlMotor(Device &device, const String &state);
-bool controlRelay(Device &device, const String &state);
-bool controlLEDStrip(Device &device, const String &state);
-bool controlSensor(Device &device, const String &state);
-bool controlGenericDevice(Device &device, const String &state);
+bool controlLED(Device &device, const DeviceState &state);
+bool controlServo(Device &device, const DeviceState &state);
+bool controlStepperMotor(Device &device, const DeviceState &state);
+bool controlMotor(Device &device, const DeviceState &state);
+bool controlRelay(Device &device, const DeviceState &state);
+bool controlLEDStrip(Device &device, const DeviceState &state);
+bool controlSensor(Device &device, const DeviceState &state);
+bool controlGenericDevice(Device &device, const DeviceState &state);
 
 // Utility functions
 float readAnalogSensor(int pin);
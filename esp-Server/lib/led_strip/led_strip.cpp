@@ -0,0 +1,315 @@
+#include "led_strip.h"
+#include "ws2812_encoder.h"
+#include "metrics.h"
+#include "log.h"
+#include <driver/rmt.h>
+#include <esp_intr_alloc.h>
+#include <vector>
+
+// Chase: time the head takes per pixel, and the fading tail behind it
+#define CHASE_STEP_MS 50
+#define CHASE_TAIL 4
+#define BREATHE_PERIOD_MS 2000
+#define RAINBOW_SHIFT_MS 16      // one turn of the colour wheel every ~4 s
+
+// How long detaching waits for a frame still on the wire
+#define DETACH_WAIT_MS 50
+
+struct LedStrip {
+  DeviceHandle owner;           // INVALID_DEVICE_HANDLE when free
+  int8_t pin;
+  uint16_t pixels;
+  std::vector<uint8_t> buffers; // two frames of pixels * 3 bytes, GRB
+  uint8_t front;                // frame the RMT driver is (or was last) sending
+  bool dirty;                   // back frame changed since the last push
+  uint32_t lastFrameAt;         // micros() when the last push started
+  uint32_t frameInterval;       // micros between pushes
+
+  bool animating;
+  StripEffect effect;
+  uint8_t r, g, b;
+  uint32_t renderedAt;          // millis() of the last effect frame
+};
+
+static LedStrip strips[LED_STRIP_MAX];
+static bool stripsInitialized = false;
+static MetricId frameMetric = INVALID_METRIC;
+
+static void initStrips() {
+  if (stripsInitialized) return;
+  for (auto &strip : strips) {
+    strip.owner = INVALID_DEVICE_HANDLE;
+  }
+  frameMetric = registerCounter("esp_led_strip_frames_total");
+  stripsInitialized = true;
+}
+
+static LedStrip* stripFor(DeviceHandle handle) {
+  initStrips();
+  for (auto &strip : strips) {
+    if (strip.owner == handle) return &strip;
+  }
+  return nullptr;
+}
+
+static rmt_channel_t stripChannel(const LedStrip &strip) {
+  return (rmt_channel_t)((&strip - strips) * LED_STRIP_RMT_BLOCKS);
+}
+
+static size_t frameBytes(const LedStrip &strip) {
+  return (size_t)strip.pixels * 3;
+}
+
+static uint8_t* backFrame(LedStrip &strip) {
+  return strip.buffers.data() + (strip.front ^ 1) * frameBytes(strip);
+}
+
+// Called by the RMT driver from its interrupt whenever channel memory frees up
+static void IRAM_ATTR translatePixels(const void* src, rmt_item32_t* dest, size_t srcSize,
+                                      size_t wantedItems, size_t* translatedSize, size_t* itemCount) {
+  ws2812Translate(src, (uint32_t*)dest, srcSize, wantedItems, translatedSize, itemCount);
+}
+
+// --- Drawing ---
+
+static void putPixel(uint8_t* frame, uint16_t index, uint8_t r, uint8_t g, uint8_t b) {
+  uint8_t* pixel = frame + index * 3;
+  pixel[0] = g;
+  pixel[1] = r;
+  pixel[2] = b;
+}
+
+static uint8_t scale(uint8_t value, uint8_t level) {
+  return (value * (level + 1)) >> 8;
+}
+
+// Red -> green -> blue -> red over hue 0-255
+static void colourWheel(uint8_t hue, uint8_t &r, uint8_t &g, uint8_t &b) {
+  uint8_t offset = (hue % 85) * 3;
+  switch (hue / 85) {
+    case 0:  r = 255 - offset; g = offset;       b = 0;            break;
+    case 1:  r = 0;            g = 255 - offset; b = offset;       break;
+    default: r = offset;       g = 0;            b = 255 - offset; break;
+  }
+}
+
+// Draws the effect as it looks at time now (ms) into the back frame, so the
+// animation speed does not depend on the frame rate
+static void renderEffect(LedStrip &strip, uint32_t now) {
+  uint8_t* frame = backFrame(strip);
+
+  switch (strip.effect) {
+    case EFFECT_RAINBOW: {
+      uint8_t shift = now / RAINBOW_SHIFT_MS;
+      for (uint16_t i = 0; i < strip.pixels; i++) {
+        uint8_t r, g, b;
+        colourWheel((uint8_t)(i * 256 / strip.pixels + shift), r, g, b);
+        putPixel(frame, i, r, g, b);
+      }
+      break;
+    }
+    case EFFECT_CHASE: {
+      uint16_t head = (now / CHASE_STEP_MS) % strip.pixels;
+      for (uint16_t i = 0; i < strip.pixels; i++) {
+        uint16_t distance = (head + strip.pixels - i) % strip.pixels;
+        uint8_t level = distance < CHASE_TAIL ? 255 >> (distance * 2) : 0;
+        putPixel(frame, i, scale(strip.r, level), scale(strip.g, level), scale(strip.b, level));
+      }
+      break;
+    }
+    case EFFECT_BREATHE: {
+      // Triangle wave, squared so the fade looks even to the eye
+      uint32_t phase = now % BREATHE_PERIOD_MS;
+      uint32_t half = BREATHE_PERIOD_MS / 2;
+      uint32_t level = (phase < half ? phase : BREATHE_PERIOD_MS - phase) * 255 / half;
+      level = level * level / 255;
+      for (uint16_t i = 0; i < strip.pixels; i++) {
+        putPixel(frame, i, scale(strip.r, level), scale(strip.g, level), scale(strip.b, level));
+      }
+      break;
+    }
+    case EFFECT_TWINKLE: {
+      // Every pixel fades a little each frame while new ones light up
+      for (size_t i = 0; i < frameBytes(strip); i++) {
+        frame[i] = (frame[i] * 7) >> 3;
+      }
+      for (uint16_t n = strip.pixels / 32 + 1; n > 0; n--) {
+        putPixel(frame, esp_random() % strip.pixels, strip.r, strip.g, strip.b);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  strip.renderedAt = now;
+  strip.dirty = true;
+}
+
+// --- Frames ---
+
+// Starts sending the back frame; the RMT driver reads it from its interrupt
+// until the transfer ends, so it becomes the front frame and is left alone.
+// The new back frame starts as a copy so partial updates build on it.
+static void pushFrame(LedStrip &strip, uint32_t now) {
+  strip.front ^= 1;
+  const uint8_t* frame = strip.buffers.data() + strip.front * frameBytes(strip);
+  if (rmt_write_sample(stripChannel(strip), frame, frameBytes(strip), false) != ESP_OK) {
+    LOG_ERROR("LED strip on pin %d: RMT write failed", strip.pin);
+  }
+  memcpy(backFrame(strip), frame, frameBytes(strip));
+
+  strip.dirty = false;
+  strip.lastFrameAt = now;
+  incrementCounter(frameMetric);
+}
+
+// --- Public API ---
+
+bool ledStripAttach(Device &device) {
+  if (device.pins.empty()) return false;
+
+  uint16_t pixels = device.ledCount ? device.ledCount : LED_STRIP_DEFAULT_PIXELS;
+  if (pixels > LED_STRIP_MAX_PIXELS) pixels = LED_STRIP_MAX_PIXELS;
+
+  LedStrip* strip = stripFor(device.handle);
+  if (strip && strip->pin == device.pins[0] && strip->pixels == pixels) return true;
+  if (strip) ledStripDetach(device.handle);
+
+  strip = stripFor(INVALID_DEVICE_HANDLE);
+  if (!strip) {
+    LOG_ERROR("LED strip %s: all %d strips in use", device.id.c_str(), LED_STRIP_MAX);
+    return false;
+  }
+
+  rmt_channel_t channel = stripChannel(*strip);
+  rmt_config_t config = {};
+  config.rmt_mode = RMT_MODE_TX;
+  config.channel = channel;
+  config.gpio_num = (gpio_num_t)device.pins[0];
+  config.clk_div = WS2812_RMT_CLK_DIV;
+  config.mem_block_num = LED_STRIP_RMT_BLOCKS;
+  config.tx_config.idle_output_en = true;
+  config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+  // The translator runs in the driver's interrupt; in IRAM it keeps
+  // refilling the channel while flash writes disable the cache
+  if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel, 0, ESP_INTR_FLAG_IRAM) != ESP_OK) {
+    LOG_ERROR("LED strip %s: unable to set up RMT channel %d", device.id.c_str(), (int)channel);
+    return false;
+  }
+  if (rmt_translator_init(channel, translatePixels) != ESP_OK) {
+    rmt_driver_uninstall(channel);
+    return false;
+  }
+
+  // A frame must be on the wire and latched before the next one starts
+  uint32_t interval = 1000000UL / LED_STRIP_MAX_FPS;
+  uint32_t wireTime = ws2812FrameMicros(pixels);
+  if (wireTime > interval) interval = wireTime;
+
+  strip->pin = device.pins[0];
+  strip->pixels = pixels;
+  strip->buffers.assign((size_t)pixels * 3 * 2, 0);
+  strip->front = 0;
+  strip->dirty = true;
+  strip->lastFrameAt = micros() - interval;
+  strip->frameInterval = interval;
+  strip->animating = false;
+  strip->owner = device.handle;
+
+  // Carry on with the device's state; anything else shows the strip dark
+  ledStripShow(device.handle, device.state);
+
+  LOG_DEBUG("LED strip %s: pin %d, %u pixels, RMT channel %d", device.id.c_str(),
+            device.pins[0], pixels, (int)channel);
+  return true;
+}
+
+void ledStripDetach(DeviceHandle handle) {
+  LedStrip* strip = stripFor(handle);
+  if (!strip) return;
+
+  rmt_channel_t channel = stripChannel(*strip);
+  rmt_wait_tx_done(channel, pdMS_TO_TICKS(DETACH_WAIT_MS));
+  rmt_driver_uninstall(channel);
+
+  std::vector<uint8_t>().swap(strip->buffers);
+  strip->owner = INVALID_DEVICE_HANDLE;
+}
+
+uint16_t ledStripPixelCount(DeviceHandle handle) {
+  LedStrip* strip = stripFor(handle);
+  return strip ? strip->pixels : 0;
+}
+
+bool ledStripShow(DeviceHandle handle, const DeviceState &state) {
+  LedStrip* strip = stripFor(handle);
+  if (!strip) return false;
+
+  if (state.kind == STATE_RGB) {
+    return ledStripFill(handle, 0, strip->pixels, state.rgb.r, state.rgb.g, state.rgb.b);
+  }
+  if (state.kind != STATE_EFFECT || state.fx.effect >= STRIP_EFFECT_COUNT) return false;
+
+  strip->animating = true;
+  strip->effect = state.fx.effect;
+  strip->r = state.fx.r;
+  strip->g = state.fx.g;
+  strip->b = state.fx.b;
+  memset(backFrame(*strip), 0, frameBytes(*strip));
+  renderEffect(*strip, millis());
+  return true;
+}
+
+bool ledStripSetPixels(DeviceHandle handle, uint16_t start, uint16_t count, const uint8_t* rgb) {
+  LedStrip* strip = stripFor(handle);
+  if (!strip || (uint32_t)start + count > strip->pixels) return false;
+
+  uint8_t* frame = backFrame(*strip);
+  for (uint16_t i = 0; i < count; i++, rgb += 3) {
+    putPixel(frame, start + i, rgb[0], rgb[1], rgb[2]);
+  }
+  strip->animating = false;
+  strip->dirty = true;
+  return true;
+}
+
+bool ledStripFill(DeviceHandle handle, uint16_t start, uint16_t count, uint8_t r, uint8_t g, uint8_t b) {
+  LedStrip* strip = stripFor(handle);
+  if (!strip || (uint32_t)start + count > strip->pixels) return false;
+
+  uint8_t* frame = backFrame(*strip);
+  for (uint16_t i = 0; i < count; i++) {
+    putPixel(frame, start + i, r, g, b);
+  }
+  strip->animating = false;
+  strip->dirty = true;
+  return true;
+}
+
+void handleLedStrips() {
+  initStrips();
+  uint32_t nowMs = millis();
+  uint32_t nowUs = micros();
+
+  for (auto &strip : strips) {
+    if (strip.owner == INVALID_DEVICE_HANDLE) continue;
+
+    // Deleted without releaseDevicePins()
+    if (!devices.get(strip.owner)) {
+      ledStripDetach(strip.owner);
+      continue;
+    }
+
+    if (strip.animating && nowMs - strip.renderedAt >= 1000 / LED_STRIP_EFFECT_FPS) {
+      renderEffect(strip, nowMs);
+    }
+
+    if (!strip.dirty || nowUs - strip.lastFrameAt < strip.frameInterval) continue;
+
+    // The previous frame is still going out; try again next pass
+    if (rmt_wait_tx_done(stripChannel(strip), 0) != ESP_OK) continue;
+
+    pushFrame(strip, nowUs);
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef LED_STRIP_H
+#define LED_STRIP_H
+
+#include <Arduino.h>
+#include "ESPControlPlatform.h"
+
+// --- Addressable LED strips ---
+//
+// WS2812-class strips (one data pin, GRB order) driven by the RMT
+// peripheral. Each strip has two pixel buffers: updates and effects draw
+// into the back buffer, and a frame is shown by swapping the buffers and
+// handing the front one to the RMT driver. The driver encodes it into RMT
+// items from its interrupt as the channel memory drains (see
+// ws2812_encoder.h), so loop() only starts the transfer and never waits
+// for the wire. The back buffer is drawn into again while the front one is
+// still going out.
+//
+// Frames are pushed by handleLedStrips() at most LED_STRIP_MAX_FPS times
+// a second and never before the previous one has latched, so any number
+// of updates in between collapse into one frame.
+//
+// A strip's state is a colour ("#ff8000") or an effect rendered on the
+// device ("rainbow", "chase:#ff0000", see DeviceState.h). Pixel updates
+// (ledStripSetPixels, e.g. from binary WebSocket frames) are live output:
+// they pause the effect until the next state change and are not persisted.
+
+#ifndef LED_STRIP_MAX
+#define LED_STRIP_MAX 4
+#endif
+
+#define LED_STRIP_MAX_PIXELS 512
+#define LED_STRIP_DEFAULT_PIXELS 30     // for devices that leave ledCount at 0
+
+// RMT memory blocks per strip (64 items each); strip n uses channel
+// n * LED_STRIP_RMT_BLOCKS. More blocks mean fewer refill interrupts.
+#define LED_STRIP_RMT_BLOCKS 2
+
+#define LED_STRIP_MAX_FPS 60
+#define LED_STRIP_EFFECT_FPS 30
+
+// Binds an RMT channel and pixel buffers to a strip device (re-binding
+// after pin or length changes) and shows its current state. False if all
+// strips are in use or the driver could not be installed.
+bool ledStripAttach(Device &device);
+
+// Waits for the frame on the wire, then frees the channel and buffers
+void ledStripDetach(DeviceHandle handle);
+
+// Pixels of the attached strip, or 0 if the device has none
+uint16_t ledStripPixelCount(DeviceHandle handle);
+
+// Shows a colour (STATE_RGB) or starts an effect (STATE_EFFECT)
+bool ledStripShow(DeviceHandle handle, const DeviceState &state);
+
+// Sets count pixels from start to the RGB triplets in rgb, or all of them
+// to one colour. False if the range does not fit the strip.
+bool ledStripSetPixels(DeviceHandle handle, uint16_t start, uint16_t count, const uint8_t* rgb);
+bool ledStripFill(DeviceHandle handle, uint16_t start, uint16_t count, uint8_t r, uint8_t g, uint8_t b);
+
+// Renders effects and pushes pending frames. Call from loop().
+void handleLedStrips();
+
+#endif // LED_STRIP_H
@@ -0,0 +1,41 @@
+#include "ws2812_encoder.h"
+
+// level0 (bit 15) high, level1 (bit 31) low
+static inline uint32_t IRAM_ATTR makeItem(uint32_t highTicks, uint32_t lowTicks) {
+  return highTicks | (1UL << 15) | (lowTicks << 16);
+}
+
+uint32_t IRAM_ATTR ws2812Item(bool bit) {
+  return bit ? makeItem(WS2812_T1H_TICKS, WS2812_T1L_TICKS)
+             : makeItem(WS2812_T0H_TICKS, WS2812_T0L_TICKS);
+}
+
+uint32_t ws2812FrameMicros(size_t pixels) {
+  const uint32_t bitNs = (WS2812_T0H_TICKS + WS2812_T0L_TICKS) * WS2812_TICK_NS;
+  return (uint32_t)((uint64_t)pixels * WS2812_BITS_PER_PIXEL * bitNs / 1000) + WS2812_RESET_US;
+}
+
+void IRAM_ATTR ws2812Translate(const void* src, uint32_t* dest, size_t srcSize,
+                               size_t wantedItems, size_t* translatedSize, size_t* itemCount) {
+  if (!src || !dest) {
+    *translatedSize = 0;
+    *itemCount = 0;
+    return;
+  }
+
+  const uint32_t zero = ws2812Item(false);
+  const uint32_t one = ws2812Item(true);
+  const uint8_t* bytes = (const uint8_t*)src;
+  size_t used = 0;
+  size_t items = 0;
+
+  while (used < srcSize && items + 8 <= wantedItems) {
+    uint8_t byte = bytes[used++];
+    for (uint8_t mask = 0x80; mask; mask >>= 1) {
+      dest[items++] = (byte & mask) ? one : zero;
+    }
+  }
+
+  *translatedSize = used;
+  *itemCount = items;
+}
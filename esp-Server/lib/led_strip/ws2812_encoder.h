@@ -0,0 +1,46 @@
+#ifndef WS2812_ENCODER_H
+#define WS2812_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- WS2812 bit encoder ---
+//
+// Turns pixel bytes into RMT items, one item per bit, most significant bit
+// first. Each item is a high phase followed by a low phase; a 0 bit has a
+// short high phase and a 1 bit a long one. The RMT channel runs at
+// 80 MHz / WS2812_RMT_CLK_DIV, so durations are in 25 ns ticks.
+//
+// The encoder has no dependency on the RMT driver beyond the item layout
+// (duration0:15, level0:1, duration1:15, level1:1), so the timings can be
+// checked on a host by decoding the items it writes.
+
+#include <esp_attr.h>
+
+#define WS2812_RMT_CLK_DIV 2
+#define WS2812_TICK_NS 25
+
+// Datasheet nominal timings, each within the +-150 ns tolerance
+#define WS2812_T0H_TICKS 16   // 400 ns
+#define WS2812_T0L_TICKS 34   // 850 ns
+#define WS2812_T1H_TICKS 32   // 800 ns
+#define WS2812_T1L_TICKS 18   // 450 ns
+
+// Low time that latches a frame; newer WS2812B parts need 280 us
+#define WS2812_RESET_US 300
+
+#define WS2812_BITS_PER_PIXEL 24
+
+// RMT item for one bit: high for the first duration, low for the second
+uint32_t IRAM_ATTR ws2812Item(bool bit);
+
+// Time on the wire for a frame of pixels, including the reset latch
+uint32_t ws2812FrameMicros(size_t pixels);
+
+// RMT translator (sample_to_rmt_t signature, with dest as raw item words).
+// Encodes whole bytes of src until srcSize bytes or wantedItems items are
+// used up, and reports how many of each it consumed and produced.
+void IRAM_ATTR ws2812Translate(const void* src, uint32_t* dest, size_t srcSize,
+                               size_t wantedItems, size_t* translatedSize, size_t* itemCount);
+
+#endif // WS2812_ENCODER_H
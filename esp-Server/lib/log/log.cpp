@@ -0,0 +1,85 @@
+#include "log.h"
+#include <stdarg.h>
+
+static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0, "LOG_BUFFER_SIZE must be a power of two");
+
+static char ring[LOG_BUFFER_SIZE];
+static uint32_t head = 0;      // bytes ever written
+static uint32_t drained = 0;   // bytes already sent to Serial
+
+// Held only while copying bytes in or out of the ring, never around I/O
+static portMUX_TYPE logLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char* const LEVEL_NAMES[] = {"", "ERROR", "INFO", "DEBUG"};
+
+void logPrintf(uint8_t level, const char* format, ...) {
+  char line[LOG_LINE_MAX];
+  if (level > LOG_LEVEL_DEBUG) level = LOG_LEVEL_DEBUG;
+  int prefix = snprintf(line, sizeof(line), "%lu [%s] ", (unsigned long)millis(), LEVEL_NAMES[level]);
+
+  // Leave room for the newline
+  size_t room = sizeof(line) - 1 - prefix;
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line + prefix, room + 1, format, args);
+  va_end(args);
+  if (length < 0) return;
+
+  size_t total = prefix + ((size_t)length < room ? (size_t)length : room);
+  line[total++] = '\n';
+
+  portENTER_CRITICAL(&logLock);
+  for (size_t i = 0; i < total; i++) {
+    ring[(head + i) & (LOG_BUFFER_SIZE - 1)] = line[i];
+  }
+  head += total;
+  portEXIT_CRITICAL(&logLock);
+}
+
+size_t readLog(uint32_t &position, char* out, size_t size) {
+  portENTER_CRITICAL(&logLock);
+  if (head - position > LOG_BUFFER_SIZE) position = head - LOG_BUFFER_SIZE;
+
+  size_t count = head - position;
+  if (count > size) count = size;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = ring[(position + i) & (LOG_BUFFER_SIZE - 1)];
+  }
+  position += count;
+  portEXIT_CRITICAL(&logLock);
+  return count;
+}
+
+uint32_t logOldestPosition() {
+  portENTER_CRITICAL(&logLock);
+  uint32_t oldest = head > LOG_BUFFER_SIZE ? head - LOG_BUFFER_SIZE : 0;
+  portEXIT_CRITICAL(&logLock);
+  return oldest;
+}
+
+uint32_t logHeadPosition() {
+  portENTER_CRITICAL(&logLock);
+  uint32_t position = head;
+  portEXIT_CRITICAL(&logLock);
+  return position;
+}
+
+void handleLogDrain() {
+#if LOG_TO_SERIAL
+  char chunk[64];
+  int room = Serial.availableForWrite();
+  while (room > 0) {
+    size_t want = (size_t)room < sizeof(chunk) ? room : sizeof(chunk);
+    uint32_t expected = drained;
+    size_t count = readLog(drained, chunk, want);
+
+    // The writer lapped us; say so instead of silently splicing lines
+    uint32_t skipped = (drained - count) - expected;
+    if (skipped) Serial.printf("\n[log: %lu bytes dropped]\n", (unsigned long)skipped);
+
+    if (count == 0) break;
+    Serial.write((const uint8_t*)chunk, count);
+    room -= count;
+  }
+#endif
+}
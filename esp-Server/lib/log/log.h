@@ -0,0 +1,63 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+// --- Levels ---
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+// Messages above this level are compiled out, arguments and formatting
+// included. Set with -DLOG_LEVEL=... in build_flags.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Ring buffer holding the most recent output; must be a power of two
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE 4096
+#endif
+
+// Longer messages are truncated
+#define LOG_LINE_MAX 160
+
+// Set to 0 to keep logs only in the buffer (GET /api/logs)
+#ifndef LOG_TO_SERIAL
+#define LOG_TO_SERIAL 1
+#endif
+
+// --- Logging ---
+
+// Formats one line into the ring buffer and returns without touching the
+// UART; handleLogDrain() writes it out later. Use the LOG_* macros instead
+// of calling this directly.
+void logPrintf(uint8_t level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+// Disabled levels still type-check their arguments, but the call and its
+// arguments are dead code and never evaluated.
+#define LOG_AT(level, ...) \
+  do { if (LOG_LEVEL >= (level)) logPrintf((level), __VA_ARGS__); } while (0)
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// --- Reading ---
+
+// Positions count every byte ever logged. readLog() copies up to size bytes
+// starting at position and advances it; if that part was already
+// overwritten, position first jumps to the oldest byte still buffered.
+size_t readLog(uint32_t &position, char* out, size_t size);
+
+// Position of the oldest buffered byte and one past the newest
+uint32_t logOldestPosition();
+uint32_t logHeadPosition();
+
+// Copies pending log output to Serial, only as much as the UART can take
+// without blocking. Call from loop().
+void handleLogDrain();
+
+#endif // LOG_H
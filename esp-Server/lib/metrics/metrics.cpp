@@ -0,0 +1,301 @@
+#include "metrics.h"
+
+// Upper bounds of the latency buckets, in microseconds
+static const uint32_t BUCKET_BOUNDS[METRICS_BUCKET_COUNT - 1] = {
+  50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000
+};
+
+struct MetricInfo {
+  const char* name;
+  const char* labelName;
+  const char* labelValue;
+};
+
+struct Counter {
+  MetricInfo info;
+  std::atomic<uint32_t> value;
+};
+
+// Sums are kept in 32 bits so recording stays lock-free on the ESP32; the
+// sum of a histogram wraps after about 71 minutes of recorded time, which
+// Prometheus treats as a counter reset.
+struct Histogram {
+  MetricInfo info;
+  std::atomic<uint32_t> buckets[METRICS_BUCKET_COUNT];
+  std::atomic<uint32_t> sum;
+};
+
+// Same layout as a counter, but set rather than incremented
+typedef Counter Gauge;
+
+static Counter counters[METRICS_MAX_COUNTERS];
+static Histogram histograms[METRICS_MAX_HISTOGRAMS];
+static Gauge gauges[METRICS_MAX_GAUGES];
+
+// Published after the entry is filled in, so readers never see a half
+// registered metric
+static std::atomic<uint8_t> counterCount(0);
+static std::atomic<uint8_t> histogramCount(0);
+static std::atomic<uint8_t> gaugeCount(0);
+
+// --- Registration ---
+
+static bool sameMetric(const MetricInfo &info, const char* name, const char* labelName, const char* labelValue) {
+  auto same = [](const char* a, const char* b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+  };
+  return same(info.name, name) && same(info.labelName, labelName) && same(info.labelValue, labelValue);
+}
+
+MetricId registerCounter(const char* name, const char* labelName, const char* labelValue) {
+  uint8_t count = counterCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    if (sameMetric(counters[i].info, name, labelName, labelValue)) return i;
+  }
+  if (count >= METRICS_MAX_COUNTERS) return INVALID_METRIC;
+
+  counters[count].info = {name, labelName, labelValue};
+  counters[count].value.store(0, std::memory_order_relaxed);
+  counterCount.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+MetricId registerHistogram(const char* name, const char* labelName, const char* labelValue) {
+  uint8_t count = histogramCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    if (sameMetric(histograms[i].info, name, labelName, labelValue)) return i;
+  }
+  if (count >= METRICS_MAX_HISTOGRAMS) return INVALID_METRIC;
+
+  Histogram &histogram = histograms[count];
+  histogram.info = {name, labelName, labelValue};
+  for (auto &bucket : histogram.buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  histogram.sum.store(0, std::memory_order_relaxed);
+  histogramCount.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+MetricId registerGauge(const char* name, const char* labelName, const char* labelValue) {
+  uint8_t count = gaugeCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    if (sameMetric(gauges[i].info, name, labelName, labelValue)) return i;
+  }
+  if (count >= METRICS_MAX_GAUGES) return INVALID_METRIC;
+
+  gauges[count].info = {name, labelName, labelValue};
+  gauges[count].value.store(0, std::memory_order_relaxed);
+  gaugeCount.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+// --- Recording ---
+
+void incrementCounter(MetricId id, uint32_t amount) {
+  if (id >= METRICS_MAX_COUNTERS) return;
+  counters[id].value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void recordDuration(MetricId id, uint32_t micros) {
+  if (id >= METRICS_MAX_HISTOGRAMS) return;
+
+  uint8_t bucket = 0;
+  while (bucket < METRICS_BUCKET_COUNT - 1 && micros > BUCKET_BOUNDS[bucket]) bucket++;
+
+  Histogram &histogram = histograms[id];
+  histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  histogram.sum.fetch_add(micros, std::memory_order_relaxed);
+}
+
+void setGauge(MetricId id, uint32_t value) {
+  if (id >= METRICS_MAX_GAUGES) return;
+  gauges[id].value.store(value, std::memory_order_relaxed);
+}
+
+// --- Export ---
+
+// Escapes backslashes, quotes and newlines, which is enough for both
+// Prometheus label values and JSON strings
+static size_t printEscaped(Print &out, const char* text) {
+  size_t written = 0;
+  for (const char* p = text; *p; p++) {
+    if (*p == '\\' || *p == '"') {
+      written += out.write('\\');
+      written += out.write(*p);
+    } else if (*p == '\n') {
+      written += out.print("\\n");
+    } else {
+      written += out.write(*p);
+    }
+  }
+  return written;
+}
+
+// Prometheus wants bare \n line endings; println() would send \r\n
+template <typename T>
+static size_t printLine(Print &out, T value) {
+  size_t written = out.print(value);
+  return written + out.write('\n');
+}
+
+// name{label="value",le="bound"}; extra is the le pair or nullptr
+static size_t printSeries(Print &out, const MetricInfo &info, const char* suffix, const char* extra) {
+  size_t written = out.print(info.name);
+  if (suffix) written += out.print(suffix);
+
+  bool hasLabel = info.labelName && info.labelValue;
+  if (hasLabel || extra) {
+    written += out.write('{');
+    if (hasLabel) {
+      written += out.print(info.labelName);
+      written += out.print("=\"");
+      written += printEscaped(out, info.labelValue);
+      written += out.write('"');
+      if (extra) written += out.write(',');
+    }
+    if (extra) written += out.print(extra);
+    written += out.write('}');
+  }
+  return written + out.write(' ');
+}
+
+// Emits the # TYPE line only for the first metric of each name
+template <typename Metric>
+static size_t printTypeOnce(Print &out, const Metric* metrics, uint8_t index, const char* type) {
+  for (uint8_t i = 0; i < index; i++) {
+    if (strcmp(metrics[i].info.name, metrics[index].info.name) == 0) return 0;
+  }
+  size_t written = out.print("# TYPE ");
+  written += out.print(metrics[index].info.name);
+  written += out.write(' ');
+  written += printLine(out, type);
+  return written;
+}
+
+static size_t printGauge(Print &out, const char* name, uint32_t value) {
+  size_t written = out.print("# TYPE ");
+  written += out.print(name);
+  written += printLine(out, " gauge");
+  written += out.print(name);
+  written += out.write(' ');
+  written += printLine(out, value);
+  return written;
+}
+
+size_t writeMetricsText(Print &out) {
+  size_t written = 0;
+  written += printGauge(out, "esp_heap_free_bytes", ESP.getFreeHeap());
+  written += printGauge(out, "esp_heap_min_free_bytes", ESP.getMinFreeHeap());
+  written += printGauge(out, "esp_heap_largest_free_block_bytes", ESP.getMaxAllocHeap());
+  written += printGauge(out, "esp_uptime_seconds", millis() / 1000);
+
+  uint8_t count = counterCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    written += printTypeOnce(out, counters, i, "counter");
+    written += printSeries(out, counters[i].info, nullptr, nullptr);
+    written += printLine(out, counters[i].value.load(std::memory_order_relaxed));
+  }
+
+  count = gaugeCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    written += printTypeOnce(out, gauges, i, "gauge");
+    written += printSeries(out, gauges[i].info, nullptr, nullptr);
+    written += printLine(out, gauges[i].value.load(std::memory_order_relaxed));
+  }
+
+  count = histogramCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    const Histogram &histogram = histograms[i];
+    written += printTypeOnce(out, histograms, i, "histogram");
+
+    // Prometheus buckets are cumulative
+    uint32_t cumulative = 0;
+    char le[16];
+    for (uint8_t b = 0; b < METRICS_BUCKET_COUNT; b++) {
+      cumulative += histogram.buckets[b].load(std::memory_order_relaxed);
+      if (b < METRICS_BUCKET_COUNT - 1) {
+        snprintf(le, sizeof(le), "le=\"%lu\"", (unsigned long)BUCKET_BOUNDS[b]);
+      } else {
+        strcpy(le, "le=\"+Inf\"");
+      }
+      written += printSeries(out, histogram.info, "_bucket", le);
+      written += printLine(out, cumulative);
+    }
+    written += printSeries(out, histogram.info, "_sum", nullptr);
+    written += printLine(out, histogram.sum.load(std::memory_order_relaxed));
+    written += printSeries(out, histogram.info, "_count", nullptr);
+    written += printLine(out, cumulative);
+  }
+  return written;
+}
+
+static size_t printJsonName(Print &out, const MetricInfo &info) {
+  size_t written = out.print("{\"name\":\"");
+  written += printEscaped(out, info.name);
+  written += out.write('"');
+  if (info.labelName && info.labelValue) {
+    written += out.print(",\"");
+    written += printEscaped(out, info.labelName);
+    written += out.print("\":\"");
+    written += printEscaped(out, info.labelValue);
+    written += out.write('"');
+  }
+  return written;
+}
+
+size_t writeMetricsJson(Print &out) {
+  size_t written = out.print("{\"type\":\"metrics\",\"uptimeMs\":");
+  written += out.print(millis());
+  written += out.print(",\"heap\":{\"free\":");
+  written += out.print(ESP.getFreeHeap());
+  written += out.print(",\"minFree\":");
+  written += out.print(ESP.getMinFreeHeap());
+  written += out.print(",\"largestBlock\":");
+  written += out.print(ESP.getMaxAllocHeap());
+
+  written += out.print("},\"bucketBounds\":[");
+  for (uint8_t b = 0; b < METRICS_BUCKET_COUNT - 1; b++) {
+    if (b) written += out.write(',');
+    written += out.print(BUCKET_BOUNDS[b]);
+  }
+
+  written += out.print("],\"counters\":[");
+  uint8_t count = counterCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    if (i) written += out.write(',');
+    written += printJsonName(out, counters[i].info);
+    written += out.print(",\"value\":");
+    written += out.print(counters[i].value.load(std::memory_order_relaxed));
+    written += out.write('}');
+  }
+
+  written += out.print("],\"gauges\":[");
+  count = gaugeCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    if (i) written += out.write(',');
+    written += printJsonName(out, gauges[i].info);
+    written += out.print(",\"value\":");
+    written += out.print(gauges[i].value.load(std::memory_order_relaxed));
+    written += out.write('}');
+  }
+
+  // Buckets are per bucket here (not cumulative); the last one is overflow
+  written += out.print("],\"histograms\":[");
+  count = histogramCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < count; i++) {
+    const Histogram &histogram = histograms[i];
+    if (i) written += out.write(',');
+    written += printJsonName(out, histogram.info);
+    written += out.print(",\"sum\":");
+    written += out.print(histogram.sum.load(std::memory_order_relaxed));
+    written += out.print(",\"buckets\":[");
+    for (uint8_t b = 0; b < METRICS_BUCKET_COUNT; b++) {
+      if (b) written += out.write(',');
+      written += out.print(histogram.buckets[b].load(std::memory_order_relaxed));
+    }
+    written += out.print("]}");
+  }
+  written += out.print("]}");
+  return written;
+}
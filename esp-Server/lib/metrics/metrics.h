@@ -0,0 +1,66 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// --- Limits ---
+
+#ifndef METRICS_MAX_COUNTERS
+#define METRICS_MAX_COUNTERS 16
+#endif
+
+#ifndef METRICS_MAX_HISTOGRAMS
+#define METRICS_MAX_HISTOGRAMS 40
+#endif
+
+#ifndef METRICS_MAX_GAUGES
+#define METRICS_MAX_GAUGES 8
+#endif
+
+// Latency buckets, the last one catches everything above the largest bound
+#define METRICS_BUCKET_COUNT 12
+
+typedef uint8_t MetricId;
+
+#define INVALID_METRIC 0xFF
+
+// --- Registration ---
+
+// Metrics are registered once (at setup or first use) and then recorded by
+// id. Names and labels are not copied and must stay valid, e.g. string
+// literals. A metric may carry one label: label="value".
+// All return INVALID_METRIC when the table is full; recording to
+// INVALID_METRIC is a no-op.
+MetricId registerCounter(const char* name, const char* labelName = nullptr, const char* labelValue = nullptr);
+MetricId registerHistogram(const char* name, const char* labelName = nullptr, const char* labelValue = nullptr);
+MetricId registerGauge(const char* name, const char* labelName = nullptr, const char* labelValue = nullptr);
+
+// --- Recording ---
+
+// All are a bounds check plus relaxed atomic operations, cheap enough to
+// leave on in production and safe to call from any task.
+void incrementCounter(MetricId id, uint32_t amount = 1);
+void recordDuration(MetricId id, uint32_t micros);
+void setGauge(MetricId id, uint32_t value);
+
+// Records the time from construction to the end of the scope
+class ScopedTimer {
+public:
+  explicit ScopedTimer(MetricId id) : id(id), start(micros()) {}
+  ~ScopedTimer() { recordDuration(id, micros() - start); }
+
+private:
+  MetricId id;
+  uint32_t start;
+};
+
+// --- Export ---
+
+// Prometheus text exposition format, plus heap and uptime gauges
+size_t writeMetricsText(Print &out);
+
+// The same data as one compact JSON object, for WebSocket pushes
+size_t writeMetricsJson(Print &out);
+
+#endif // METRICS_H
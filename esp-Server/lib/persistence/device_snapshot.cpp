@@ -0,0 +1,290 @@
+#include "device_snapshot.h"
+#include "log.h"
+#include <SPIFFS.h>
+#include <memory>
+
+static const char SNAPSHOT_MAGIC[4] = {'D', 'E', 'V', 'B'};
+
+static_assert(sizeof(SnapshotHeader) == 20, "snapshot header layout changed");
+static_assert(sizeof(SnapshotRecord) == 36, "snapshot record layout changed");
+
+// --- Helpers ---
+
+static uint32_t fnv1a(const uint8_t* data, size_t length, uint32_t hash = 2166136261UL) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+// Append-only byte table; strings are stored NUL-terminated
+class StringTable {
+public:
+  bool overflowed = false;
+
+  uint16_t add(const uint8_t* data, size_t length, bool terminate) {
+    size_t offset = bytes.size();
+    if (offset + length + 1 > 0xFFFF) {
+      overflowed = true;
+      return 0;
+    }
+    bytes.insert(bytes.end(), data, data + length);
+    if (terminate) bytes.push_back(0);
+    return offset;
+  }
+
+  uint16_t addString(const String &str) {
+    return add((const uint8_t*)str.c_str(), str.length(), true);
+  }
+
+  // Types repeat across devices, so they are stored once
+  uint16_t addShared(const String &str) {
+    for (size_t i = 0; i < sharedStrings.size(); i++) {
+      if (sharedStrings[i] == str) return sharedOffsets[i];
+    }
+    uint16_t offset = addString(str);
+    sharedStrings.push_back(str);
+    sharedOffsets.push_back(offset);
+    return offset;
+  }
+
+  std::vector<uint8_t> bytes;
+
+private:
+  std::vector<String> sharedStrings;
+  std::vector<uint16_t> sharedOffsets;
+};
+
+// --- State payload ---
+
+uint32_t packStateValue(const DeviceState &state) {
+  uint32_t value = 0;
+  switch (state.kind) {
+    case STATE_SWITCH: value = state.on; break;
+    case STATE_ANGLE:  value = state.angle; break;
+    case STATE_SPEED:
+      value = state.motor.running | (state.motor.speed << 8) | ((uint32_t)state.motor.direction << 16);
+      break;
+    case STATE_RGB:    value = ((uint32_t)state.rgb.r << 16) | (state.rgb.g << 8) | state.rgb.b; break;
+    case STATE_STEPS:  value = (uint32_t)state.steps; break;
+    case STATE_VALUE:  memcpy(&value, &state.value, sizeof(value)); break;
+    case STATE_EFFECT:
+      value = ((uint32_t)state.fx.effect << 24) | ((uint32_t)state.fx.r << 16) | (state.fx.g << 8) | state.fx.b;
+      break;
+    default: break;
+  }
+  return value;
+}
+
+bool unpackStateValue(uint8_t kind, uint32_t value, DeviceState &state) {
+  state = DeviceState();
+  state.kind = (StateKind)kind;
+  switch (state.kind) {
+    case STATE_UNKNOWN: break;
+    case STATE_SWITCH:  state.on = value != 0; break;
+    case STATE_ANGLE:   state.angle = value; break;
+    case STATE_SPEED:
+      state.motor.running = value & 0xFF;
+      state.motor.speed = (value >> 8) & 0xFF;
+      state.motor.direction = (MotorDirection)((value >> 16) & 0xFF);
+      break;
+    case STATE_RGB:
+      state.rgb.r = (value >> 16) & 0xFF;
+      state.rgb.g = (value >> 8) & 0xFF;
+      state.rgb.b = value & 0xFF;
+      break;
+    case STATE_STEPS:   state.steps = (int32_t)value; break;
+    case STATE_VALUE:   memcpy(&state.value, &value, sizeof(value)); break;
+    case STATE_EFFECT:
+      state.fx.effect = (StripEffect)(value >> 24);
+      state.fx.r = (value >> 16) & 0xFF;
+      state.fx.g = (value >> 8) & 0xFF;
+      state.fx.b = value & 0xFF;
+      if (state.fx.effect >= STRIP_EFFECT_COUNT) return false;
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+// Text goes to the string table, everything else into the record
+static uint32_t packState(const DeviceState &state, StringTable &table, uint16_t &textOffset) {
+  textOffset = 0;
+  if (state.kind == STATE_TEXT) {
+    textOffset = table.add((const uint8_t*)state.text, strlen(state.text), true);
+    return 0;
+  }
+  return packStateValue(state);
+}
+
+static bool unpackState(const SnapshotRecord &record, const char* table, size_t tableSize, DeviceState &state) {
+  if (record.stateKind != STATE_TEXT) return unpackStateValue(record.stateKind, record.stateValue, state);
+
+  if (record.stateTextOffset >= tableSize) return false;
+  const char* text = table + record.stateTextOffset;
+  size_t length = strnlen(text, tableSize - record.stateTextOffset);
+  if (length > STATE_TEXT_MAX) return false;
+  state = DeviceState();
+  state.kind = STATE_TEXT;
+  memcpy(state.text, text, length);
+  state.text[length] = '\0';
+  return true;
+}
+
+// --- Save ---
+
+bool saveDeviceSnapshot(const char* path, uint32_t generation) {
+  if (devices.size() > 0xFFFF) return false;
+
+  StringTable table;
+  std::vector<SnapshotRecord> records;
+  records.reserve(devices.size());
+
+  for (const auto &device : devices) {
+    SnapshotRecord record = {};
+    record.idOffset = table.addString(device.id);
+    record.typeOffset = table.addShared(device.type);
+
+    uint8_t pins[255];
+    size_t pinCount = device.pins.size() < sizeof(pins) ? device.pins.size() : sizeof(pins);
+    for (size_t i = 0; i < pinCount; i++) {
+      pins[i] = device.pins[i];
+    }
+    record.pinsOffset = table.add(pins, pinCount, false);
+    record.pinCount = pinCount;
+
+    record.interface = device.interface;
+    record.direction = device.direction;
+    record.stateKind = device.state.kind;
+    record.stateValue = packState(device.state, table, record.stateTextOffset);
+    record.sampleIntervalMs = device.sampleIntervalMs;
+    record.pwmResolution = device.pwmResolution;
+    record.pwmFrequency = device.pwmFrequency;
+    record.motionProfile = device.motionProfile;
+    record.maxSpeed = device.maxSpeed;
+    record.acceleration = device.acceleration;
+    record.ledCount = device.ledCount;
+    record.position = device.position;
+    records.push_back(record);
+  }
+
+  if (table.overflowed) {
+    LOG_ERROR("Device snapshot string table exceeds 64 KiB");
+    return false;
+  }
+
+  SnapshotHeader header = {};
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version = SNAPSHOT_VERSION;
+  header.recordSize = sizeof(SnapshotRecord);
+  header.generation = generation;
+  header.deviceCount = records.size();
+  header.stringTableSize = table.bytes.size();
+
+  size_t recordBytes = records.size() * sizeof(SnapshotRecord);
+  header.checksum = fnv1a((const uint8_t*)records.data(), recordBytes);
+  header.checksum = fnv1a(table.bytes.data(), table.bytes.size(), header.checksum);
+
+  File file = SPIFFS.open(path, "w");
+  if (!file) {
+    LOG_ERROR("Unable to open file for writing: %s", path);
+    return false;
+  }
+  bool ok = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header)
+    && file.write((const uint8_t*)records.data(), recordBytes) == recordBytes
+    && file.write(table.bytes.data(), table.bytes.size()) == table.bytes.size();
+  file.close();
+  return ok;
+}
+
+// --- Load ---
+
+bool loadDeviceSnapshot(const char* path, uint32_t &generation) {
+  if (!SPIFFS.exists(path)) return false;
+
+  File file = SPIFFS.open(path, "r");
+  if (!file) {
+    LOG_ERROR("Unable to open file for reading: %s", path);
+    return false;
+  }
+
+  SnapshotHeader header;
+  if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header)
+      || memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+      || header.version != SNAPSHOT_VERSION
+      || header.recordSize != sizeof(SnapshotRecord)) {
+    LOG_ERROR("Not a device snapshot: %s", path);
+    file.close();
+    return false;
+  }
+
+  // The string table sits after the records; read it first so records can
+  // be turned into devices one at a time without buffering them all
+  size_t recordBytes = (size_t)header.deviceCount * sizeof(SnapshotRecord);
+  std::unique_ptr<char[]> table(new char[header.stringTableSize + 1]);
+  table[header.stringTableSize] = '\0';
+  if (!file.seek(sizeof(header) + recordBytes)
+      || file.read((uint8_t*)table.get(), header.stringTableSize) != header.stringTableSize
+      || !file.seek(sizeof(header))) {
+    LOG_ERROR("Truncated device snapshot: %s", path);
+    file.close();
+    return false;
+  }
+
+  devices.clear();
+  uint32_t checksum = 2166136261UL;
+  bool ok = true;
+
+  for (uint16_t i = 0; i < header.deviceCount && ok; i++) {
+    SnapshotRecord record;
+    if (file.read((uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+      ok = false;
+      break;
+    }
+    checksum = fnv1a((const uint8_t*)&record, sizeof(record), checksum);
+
+    if (record.idOffset >= header.stringTableSize
+        || record.typeOffset >= header.stringTableSize
+        || record.pinsOffset + record.pinCount > header.stringTableSize) {
+      ok = false;
+      break;
+    }
+
+    Device d;
+    d.id = table.get() + record.idOffset;
+    d.type = table.get() + record.typeOffset;
+    d.kind = parseDeviceKind(d.type);
+    d.pins.reserve(record.pinCount);
+    for (uint8_t p = 0; p < record.pinCount; p++) {
+      d.pins.push_back((uint8_t)table[record.pinsOffset + p]);
+    }
+    d.interface = (InterfaceType)record.interface;
+    d.direction = (DeviceDirection)record.direction;
+    d.sampleIntervalMs = record.sampleIntervalMs;
+    d.pwmResolution = record.pwmResolution;
+    d.pwmFrequency = record.pwmFrequency;
+    d.motionProfile = record.motionProfile;
+    d.maxSpeed = record.maxSpeed;
+    d.acceleration = record.acceleration;
+    d.ledCount = record.ledCount;
+    d.position = record.position;
+    ok = unpackState(record, table.get(), header.stringTableSize, d.state);
+
+    if (ok && devices.add(d) == INVALID_DEVICE_HANDLE) {
+      LOG_ERROR("Skipping duplicate device id: %s", d.id.c_str());
+    }
+  }
+  file.close();
+
+  checksum = fnv1a((const uint8_t*)table.get(), header.stringTableSize, checksum);
+  if (!ok || checksum != header.checksum) {
+    LOG_ERROR("Corrupt device snapshot: %s", path);
+    devices.clear();
+    return false;
+  }
+
+  generation = header.generation;
+  return true;
+}
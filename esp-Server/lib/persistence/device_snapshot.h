@@ -0,0 +1,69 @@
+#ifndef DEVICE_SNAPSHOT_H
+#define DEVICE_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "ESPControlPlatform.h"
+
+// --- Binary device snapshot ---
+//
+// The registry is stored as a fixed-layout binary file that loads without a
+// JSON parser:
+//
+//   SnapshotHeader
+//   SnapshotRecord[deviceCount]
+//   string table (NUL-terminated ids, types, state text, and pin bytes)
+//
+// Records point into the string table by offset; device types are stored
+// once and shared. A checksum over records and string table guards against
+// torn or corrupted files.
+
+#define SNAPSHOT_VERSION 1
+
+struct SnapshotHeader {
+  char magic[4];              // "DEVB"
+  uint16_t version;
+  uint16_t recordSize;        // sizeof(SnapshotRecord)
+  uint32_t generation;        // see state_journal.h
+  uint16_t deviceCount;
+  uint16_t stringTableSize;
+  uint32_t checksum;          // FNV-1a over records then string table
+};
+
+struct SnapshotRecord {
+  uint16_t idOffset;
+  uint16_t typeOffset;
+  uint16_t pinsOffset;
+  uint8_t pinCount;
+  uint8_t interface;          // InterfaceType
+  uint8_t direction;          // DeviceDirection
+  uint8_t stateKind;          // StateKind
+  uint16_t stateTextOffset;   // STATE_TEXT only
+  uint32_t stateValue;        // packed state payload
+  uint16_t sampleIntervalMs;
+  uint8_t pwmResolution;
+  uint8_t motionProfile;      // MotionProfile
+  uint32_t pwmFrequency;
+  uint16_t maxSpeed;
+  uint16_t acceleration;
+  uint16_t ledCount;
+  uint16_t reserved;          // zero
+  int32_t position;           // steppers only
+};
+
+// Packs a state of any kind but STATE_TEXT into the 32-bit payload the
+// snapshot and the state journal store
+uint32_t packStateValue(const DeviceState &state);
+
+// Rebuilds a state of the given kind from its payload. False for
+// STATE_TEXT, unknown kinds and out-of-range values.
+bool unpackStateValue(uint8_t kind, uint32_t value, DeviceState &state);
+
+// Writes every registered device to path. Returns false on any I/O error
+// or if the string table would exceed 64 KiB.
+bool saveDeviceSnapshot(const char* path, uint32_t generation);
+
+// Replaces the registry with the devices stored in path. On failure the
+// registry is left empty and false is returned.
+bool loadDeviceSnapshot(const char* path, uint32_t &generation);
+
+#endif // DEVICE_SNAPSHOT_H
@@ -0,0 +1,122 @@
+#include "persistence.h"
+#include "state_journal.h"
+#include "metrics.h"
+#include "log.h"
+
+static PersistFunction persistFn = nullptr;
+static uint32_t quietPeriod = PERSIST_QUIET_MS;
+static uint32_t maxDelay = PERSIST_MAX_DELAY_MS;
+
+static bool dirty = false;          // something is waiting to be written
+static bool snapshotDirty = false;  // config changed, journal is not enough
+static std::vector<DeviceHandle> pendingStates;
+static unsigned long firstChangeAt = 0;
+static unsigned long lastChangeAt = 0;
+static unsigned long lastFailureAt = 0;
+static bool lastSaveFailed = false;
+
+static MetricId journalMetric = INVALID_METRIC;
+static MetricId snapshotMetric = INVALID_METRIC;
+static MetricId failureMetric = INVALID_METRIC;
+
+// Wait this long before retrying a save that failed
+static const uint32_t RETRY_DELAY_MS = 5000;
+
+void initPersistence(PersistFunction saveFn, uint32_t quietMs, uint32_t maxDelayMs) {
+  persistFn = saveFn;
+  configurePersistence(quietMs, maxDelayMs);
+
+  journalMetric = registerHistogram("esp_persist_duration_us", "op", "journal");
+  snapshotMetric = registerHistogram("esp_persist_duration_us", "op", "snapshot");
+  failureMetric = registerCounter("esp_persist_failures_total");
+}
+
+void configurePersistence(uint32_t quietMs, uint32_t maxDelayMs) {
+  quietPeriod = quietMs;
+  maxDelay = maxDelayMs < quietMs ? quietMs : maxDelayMs;
+}
+
+static void touch() {
+  unsigned long now = millis();
+  if (!dirty) {
+    dirty = true;
+    firstChangeAt = now;
+  }
+  lastChangeAt = now;
+}
+
+void markDevicesDirty() {
+  snapshotDirty = true;
+  touch();
+}
+
+void markDeviceStateDirty(DeviceHandle handle) {
+  // A pending snapshot captures every state anyway
+  if (!snapshotDirty) {
+    bool queued = false;
+    for (DeviceHandle pending : pendingStates) {
+      if (pending == handle) {
+        queued = true;
+        break;
+      }
+    }
+    if (!queued) pendingStates.push_back(handle);
+  }
+  touch();
+}
+
+bool devicesDirty() {
+  return dirty;
+}
+
+bool flushDevices() {
+  if (!dirty) return true;
+  if (!persistFn) return false;
+
+  // Clear first so changes made while saving are picked up by the next flush
+  dirty = false;
+
+  bool ok = true;
+  if (!snapshotDirty && !pendingStates.empty()) {
+    unsigned long start = micros();
+    ok = appendStateJournal(pendingStates);
+    recordDuration(journalMetric, micros() - start);
+    if (ok) pendingStates.clear();
+
+    // Compact once the journal outgrows its budget, or fall back to a
+    // full snapshot if appending failed
+    if (!ok || stateJournalSize() >= STATE_JOURNAL_COMPACT_BYTES) {
+      snapshotDirty = true;
+    }
+  }
+
+  if (snapshotDirty) {
+    snapshotDirty = false;
+    unsigned long start = micros();
+    ok = persistFn();
+    recordDuration(snapshotMetric, micros() - start);
+    if (ok) pendingStates.clear();
+    else snapshotDirty = true;
+  }
+
+  lastSaveFailed = !ok;
+  if (!ok) {
+    LOG_ERROR("Deferred device save failed, will retry");
+    incrementCounter(failureMetric);
+    dirty = true;
+    lastFailureAt = millis();
+    return false;
+  }
+  return true;
+}
+
+void handlePersistence() {
+  if (!dirty) return;
+
+  unsigned long now = millis();
+  if (lastSaveFailed && now - lastFailureAt < RETRY_DELAY_MS) return;
+
+  if (now - lastChangeAt >= quietPeriod || now - firstChangeAt >= maxDelay) {
+    flushDevices();
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <Arduino.h>
+#include <vector>
+#include "ESPControlPlatform.h"
+
+// --- Write-behind persistence ---
+//
+// Request handlers only mark the device registry dirty; the actual save runs
+// from loop() once changes have been quiet for PERSIST_QUIET_MS, or at the
+// latest PERSIST_MAX_DELAY_MS after the first unsaved change, so a burst of
+// updates costs a single flash write.
+//
+// Config changes (add/delete/pins) rewrite the device snapshot. State-only
+// changes are appended to the state journal (see state_journal.h), which is
+// folded back into a snapshot once it grows past STATE_JOURNAL_COMPACT_BYTES.
+
+#ifndef PERSIST_QUIET_MS
+#define PERSIST_QUIET_MS 2000
+#endif
+
+#ifndef PERSIST_MAX_DELAY_MS
+#define PERSIST_MAX_DELAY_MS 10000
+#endif
+
+typedef bool (*PersistFunction)();
+
+// Sets the function that writes the full device snapshot to flash. It must
+// reset the state journal once the snapshot is safely written.
+void initPersistence(PersistFunction saveFn,
+                     uint32_t quietMs = PERSIST_QUIET_MS,
+                     uint32_t maxDelayMs = PERSIST_MAX_DELAY_MS);
+void configurePersistence(uint32_t quietMs, uint32_t maxDelayMs);
+
+// Records that device config changed and the snapshot must be rewritten.
+void markDevicesDirty();
+// Records that only this device's state changed.
+void markDeviceStateDirty(DeviceHandle handle);
+bool devicesDirty();
+
+// Saves immediately if there are unsaved changes. Returns false only if
+// the save itself failed; the registry then stays dirty and is retried.
+bool flushDevices();
+
+// Flushes when the quiet period or max delay has elapsed. Call from loop().
+void handlePersistence();
+
+#endif // PERSISTENCE_H
@@ -0,0 +1,208 @@
+#include "state_journal.h"
+#include "persistence.h"
+#include "device_snapshot.h"
+#include "log.h"
+#include <SPIFFS.h>
+
+static const char* JOURNAL_FILE = "/states.log";
+static const char JOURNAL_MAGIC[4] = {'S', 'J', 'N', 'L'};
+static const size_t HEADER_SIZE = sizeof(JOURNAL_MAGIC) + sizeof(uint32_t) + 1;
+
+// idLength, id, type, payload (at most a text length and text), checksum
+static const size_t MAX_RECORD_SIZE = 1 + 255 + 1 + 1 + STATE_TEXT_MAX + 1;
+
+static uint32_t journalGeneration = 0;
+
+static uint8_t checksum(const uint8_t* data, size_t length, uint8_t seed) {
+  uint8_t sum = seed;
+  for (size_t i = 0; i < length; i++) {
+    sum = (sum << 1 | sum >> 7) ^ data[i];
+  }
+  return sum;
+}
+
+static void putUint32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out[i] = value >> (8 * i);
+}
+
+static uint32_t getUint32(const uint8_t* in) {
+  return in[0] | (in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Returns the record length, or 0 if the device cannot be journaled
+static size_t encodeRecord(const Device &device, uint8_t* record) {
+  if (device.id.length() > 255) return 0;
+
+  size_t length = 0;
+  record[length++] = device.id.length();
+  memcpy(record + length, device.id.c_str(), device.id.length());
+  length += device.id.length();
+
+  const DeviceState &state = device.state;
+  if (!deviceKeepsState(device.kind)) {
+    record[length++] = JOURNAL_POSITION;
+    putUint32(record + length, (uint32_t)device.position);
+    length += 4;
+  } else if (state.kind == STATE_TEXT) {
+    record[length++] = STATE_TEXT;
+    size_t textLength = strnlen(state.text, STATE_TEXT_MAX);
+    record[length++] = textLength;
+    memcpy(record + length, state.text, textLength);
+    length += textLength;
+  } else {
+    record[length++] = state.kind;
+    putUint32(record + length, packStateValue(state));
+    length += 4;
+  }
+
+  record[length] = checksum(record, length, 0);
+  return length + 1;
+}
+
+enum RecordStatus {
+  RECORD_OK,
+  RECORD_END,          // end of file, or a record cut short by a crash
+  RECORD_CORRUPT
+};
+
+// Reads the record encodeRecord() wrote. id must hold 256 characters;
+// type is the StateKind of state, or JOURNAL_POSITION for position.
+static RecordStatus readRecord(File &file, char* id, uint8_t &type, DeviceState &state, int32_t &position) {
+  uint8_t record[MAX_RECORD_SIZE];
+
+  // idLength, id and type; the type decides the payload's length
+  if (file.read(record, 1) != 1) return RECORD_END;
+  size_t idLength = record[0];
+  size_t length = 1 + idLength + 1;
+  if (file.read(record + 1, idLength + 1) != idLength + 1) return RECORD_END;
+  uint8_t kind = record[length - 1];
+
+  size_t payload = 4;
+  if (kind == STATE_TEXT) {
+    if (file.read(record + length, 1) != 1) return RECORD_END;
+    payload = record[length++];
+    if (payload > STATE_TEXT_MAX) return RECORD_CORRUPT;
+  }
+  if (file.read(record + length, payload + 1) != payload + 1) return RECORD_END;
+  if (record[length + payload] != checksum(record, length + payload, 0)) return RECORD_CORRUPT;
+
+  memcpy(id, record + 1, idLength);
+  id[idLength] = '\0';
+  type = kind;
+  if (kind == JOURNAL_POSITION) {
+    position = (int32_t)getUint32(record + length);
+    return RECORD_OK;
+  }
+  if (kind != STATE_TEXT) {
+    return unpackStateValue(kind, getUint32(record + length), state) ? RECORD_OK : RECORD_CORRUPT;
+  }
+  state = DeviceState();
+  state.kind = STATE_TEXT;
+  memcpy(state.text, record + length, payload);
+  state.text[payload] = '\0';
+  return RECORD_OK;
+}
+
+static bool writeHeader(File &file, uint32_t generation) {
+  uint8_t header[HEADER_SIZE];
+  memcpy(header, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+  putUint32(header + sizeof(JOURNAL_MAGIC), generation);
+  header[HEADER_SIZE - 1] = STATE_JOURNAL_VERSION;
+  return file.write(header, HEADER_SIZE) == HEADER_SIZE;
+}
+
+bool resetStateJournal(uint32_t generation) {
+  File file = SPIFFS.open(JOURNAL_FILE, "w");
+  if (!file) {
+    LOG_ERROR("Unable to reset state journal");
+    return false;
+  }
+  bool ok = writeHeader(file, generation);
+  file.close();
+  journalGeneration = generation;
+  return ok;
+}
+
+bool appendStateJournal(const std::vector<DeviceHandle> &handles) {
+  if (!SPIFFS.exists(JOURNAL_FILE) && !resetStateJournal(journalGeneration)) {
+    return false;
+  }
+
+  File file = SPIFFS.open(JOURNAL_FILE, "a");
+  if (!file) {
+    LOG_ERROR("Unable to open state journal for appending");
+    return false;
+  }
+
+  bool ok = true;
+  uint8_t record[MAX_RECORD_SIZE];
+  for (DeviceHandle handle : handles) {
+    const Device* device = devices.get(handle);
+    size_t length = device ? encodeRecord(*device, record) : 0;
+    if (length == 0) continue;
+
+    ok = file.write(record, length) == length;
+    if (!ok) break;
+  }
+  file.close();
+
+  if (!ok) LOG_ERROR("Failed to append to state journal");
+  return ok;
+}
+
+size_t replayStateJournal(uint32_t generation) {
+  journalGeneration = generation;
+  if (!SPIFFS.exists(JOURNAL_FILE)) return 0;
+
+  File file = SPIFFS.open(JOURNAL_FILE, "r");
+  if (!file) return 0;
+
+  uint8_t header[HEADER_SIZE];
+  if (file.read(header, HEADER_SIZE) != HEADER_SIZE
+      || memcmp(header, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0
+      || header[HEADER_SIZE - 1] != STATE_JOURNAL_VERSION) {
+    file.close();
+    LOG_INFO("Ignoring unreadable state journal");
+    resetStateJournal(generation);
+    return 0;
+  }
+  if (getUint32(header + sizeof(JOURNAL_MAGIC)) != generation) {
+    // Left over from before the last snapshot; its states are already in it
+    file.close();
+    resetStateJournal(generation);
+    return 0;
+  }
+
+  size_t applied = 0;
+  char id[256];
+  uint8_t type;
+  DeviceState state;
+  int32_t position = 0;
+  while (true) {
+    RecordStatus status = readRecord(file, id, type, state, position);
+    if (status == RECORD_END) break;
+    if (status == RECORD_CORRUPT) {
+      // Anything appended after this would be unreachable; fold into a snapshot
+      LOG_INFO("State journal ends in a torn record");
+      markDevicesDirty();
+      break;
+    }
+
+    Device* device = devices.find(id);
+    if (!device) continue;
+    if (type == JOURNAL_POSITION) device->position = position;
+    else device->state = state;
+    applied++;
+  }
+  file.close();
+  return applied;
+}
+
+size_t stateJournalSize() {
+  if (!SPIFFS.exists(JOURNAL_FILE)) return 0;
+  File file = SPIFFS.open(JOURNAL_FILE, "r");
+  if (!file) return 0;
+  size_t size = file.size();
+  file.close();
+  return size;
+}
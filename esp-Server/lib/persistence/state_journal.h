@@ -0,0 +1,48 @@
+#ifndef STATE_JOURNAL_H
+#define STATE_JOURNAL_H
+
+#include <Arduino.h>
+#include <vector>
+#include "ESPControlPlatform.h"
+
+// --- Device state journal ---
+//
+// High-churn device states are appended to a small binary log instead of
+// rewriting the whole device snapshot. The journal is tagged with the
+// generation of the snapshot it extends; on boot it is replayed only onto
+// that snapshot, so a crash between writing a new snapshot and resetting
+// the journal can never roll states back.
+//
+// File layout (little-endian):
+//   header:  "SJNL" | uint32 generation | uint8 version
+//   record:  uint8 idLength | id bytes | uint8 type | payload | uint8 checksum
+//   type:    the StateKind, or JOURNAL_POSITION for a device that keeps no
+//            state (see deviceKeepsState), e.g. a stepper at rest
+//   payload: STATE_TEXT: uint8 length | text bytes
+//            JOURNAL_POSITION: int32 Device::position
+//            any other kind: uint32, packed as in the snapshot
+// A journal of another version is ignored and started over.
+
+#define STATE_JOURNAL_VERSION 1
+#define JOURNAL_POSITION 0xFF
+
+#ifndef STATE_JOURNAL_COMPACT_BYTES
+#define STATE_JOURNAL_COMPACT_BYTES 4096   // compact into a snapshot past this size
+#endif
+
+// Appends the current state of each device, or its position if it keeps
+// no state. Handles of devices that were removed in the meantime are
+// skipped.
+bool appendStateJournal(const std::vector<DeviceHandle> &handles);
+
+// Starts an empty journal on top of the given snapshot generation.
+bool resetStateJournal(uint32_t generation);
+
+// Applies journaled states and positions to the registry if the journal
+// belongs to the given snapshot generation; stops at the first torn or
+// corrupt record. Returns the number of records applied.
+size_t replayStateJournal(uint32_t generation);
+
+size_t stateJournalSize();
+
+#endif // STATE_JOURNAL_H
@@ -0,0 +1,197 @@
+#include "pwm.h"
+#include "ESPControlPlatform.h"
+#include "log.h"
+#include <driver/ledc.h>
+#include <vector>
+
+struct PwmChannel {
+  DeviceHandle owner;     // INVALID_DEVICE_HANDLE when free
+  int8_t pin;
+};
+
+// Settings of the timer shared by channels 2n and 2n+1
+struct PwmTimer {
+  uint32_t frequency;
+  uint8_t resolution;
+};
+
+struct PwmBinding {
+  DeviceHandle owner;
+  int8_t channel;         // -1 when unbound
+};
+
+static PwmChannel channels[PWM_CHANNELS];
+static PwmTimer timers[PWM_CHANNELS / 2];
+static bool channelsInitialized = false;
+static bool fadeInstalled = false;
+
+// Indexed by deviceHandleSlot()
+static std::vector<PwmBinding> bindings;
+
+static void initChannels() {
+  if (channelsInitialized) return;
+  for (auto &channel : channels) {
+    channel = {INVALID_DEVICE_HANDLE, -1};
+  }
+  channelsInitialized = true;
+}
+
+static bool channelUsed(int ch) {
+  return channels[ch].owner != INVALID_DEVICE_HANDLE;
+}
+
+static PwmBinding* bindingFor(DeviceHandle handle) {
+  uint16_t slot = deviceHandleSlot(handle);
+  if (slot >= bindings.size()) return nullptr;
+  PwmBinding &binding = bindings[slot];
+  return binding.owner == handle && binding.channel >= 0 ? &binding : nullptr;
+}
+
+// A free channel whose partner already runs at these settings, else the
+// first channel of a completely free pair
+static int findChannel(uint32_t frequency, uint8_t resolution) {
+  int freePair = -1;
+  for (int ch = 0; ch < PWM_CHANNELS; ch++) {
+    if (channelUsed(ch)) continue;
+    if (channelUsed(ch ^ 1)) {
+      const PwmTimer &timer = timers[ch / 2];
+      if (timer.frequency == frequency && timer.resolution == resolution) return ch;
+    } else if (freePair < 0) {
+      freePair = ch;
+    }
+  }
+  return freePair;
+}
+
+static void freeChannel(int ch) {
+  ledcWrite(ch, 0);
+  ledcDetachPin(channels[ch].pin);
+  channels[ch] = {INVALID_DEVICE_HANDLE, -1};
+}
+
+// Frees channels of devices deleted without a pwmDetach (e.g. by an import)
+static void releaseStale() {
+  for (auto &binding : bindings) {
+    if (binding.channel >= 0 && !devices.get(binding.owner)) {
+      freeChannel(binding.channel);
+      binding.channel = -1;
+    }
+  }
+}
+
+bool pwmConfigValid(uint32_t frequency, uint8_t resolution) {
+  return frequency > 0 && resolution > 0 && resolution <= PWM_MAX_RESOLUTION
+    && (uint64_t)frequency << resolution <= PWM_CLOCK_HZ;
+}
+
+bool pwmAttach(DeviceHandle handle, int pin, uint32_t frequency, uint8_t resolution) {
+  if (!pwmConfigValid(frequency, resolution)) return false;
+  initChannels();
+
+  uint16_t slot = deviceHandleSlot(handle);
+  if (slot >= bindings.size()) {
+    bindings.resize(slot + 1, PwmBinding{INVALID_DEVICE_HANDLE, -1});
+  }
+
+  // Keep the channel if nothing changed; a reused slot or new settings start over
+  PwmBinding &binding = bindings[slot];
+  if (binding.channel >= 0) {
+    const PwmTimer &timer = timers[binding.channel / 2];
+    if (binding.owner == handle && channels[binding.channel].pin == pin
+        && timer.frequency == frequency && timer.resolution == resolution) {
+      return true;
+    }
+    freeChannel(binding.channel);
+    binding.channel = -1;
+  }
+
+  int ch = findChannel(frequency, resolution);
+  if (ch < 0) {
+    releaseStale();
+    ch = findChannel(frequency, resolution);
+  }
+  if (ch < 0) {
+    LOG_ERROR("No PWM channel left for pin %d at %lu Hz / %u bits", pin, (unsigned long)frequency, resolution);
+    return false;
+  }
+
+  // Also records the channel's resolution for ledcWrite; same settings as
+  // the partner's, so the shared timer keeps running unchanged
+  if (ledcSetup(ch, frequency, resolution) == 0) {
+    LOG_ERROR("LEDC rejected %lu Hz / %u bits", (unsigned long)frequency, resolution);
+    return false;
+  }
+  timers[ch / 2] = {frequency, resolution};
+  ledcAttachPin(pin, ch);
+  ledcWrite(ch, 0);
+
+  channels[ch] = {handle, (int8_t)pin};
+  binding = {handle, (int8_t)ch};
+  LOG_DEBUG("PWM channel %d -> pin %d (%lu Hz, %u bits)", ch, pin, (unsigned long)frequency, resolution);
+  return true;
+}
+
+void pwmDetach(DeviceHandle handle) {
+  PwmBinding* binding = bindingFor(handle);
+  if (!binding) return;
+  freeChannel(binding->channel);
+  binding->channel = -1;
+}
+
+bool pwmAttached(DeviceHandle handle) {
+  return bindingFor(handle) != nullptr;
+}
+
+bool pwmWrite(DeviceHandle handle, uint32_t duty) {
+  PwmBinding* binding = bindingFor(handle);
+  if (!binding) return false;
+
+  uint32_t maxDuty = (1UL << timers[binding->channel / 2].resolution) - 1;
+  ledcWrite(binding->channel, duty < maxDuty ? duty : maxDuty);
+  return true;
+}
+
+bool pwmWriteLevel(DeviceHandle handle, uint32_t level, uint32_t range) {
+  PwmBinding* binding = bindingFor(handle);
+  if (!binding || range == 0) return false;
+
+  uint32_t maxDuty = (1UL << timers[binding->channel / 2].resolution) - 1;
+  return pwmWrite(handle, (uint64_t)level * maxDuty / range);
+}
+
+bool pwmWriteMicroseconds(DeviceHandle handle, uint32_t us) {
+  PwmBinding* binding = bindingFor(handle);
+  if (!binding) return false;
+
+  const PwmTimer &timer = timers[binding->channel / 2];
+  uint32_t periodUs = 1000000UL / timer.frequency;
+  return pwmWrite(handle, ((uint64_t)us << timer.resolution) / periodUs);
+}
+
+bool pwmFade(DeviceHandle handle, uint32_t duty, uint32_t ms) {
+  PwmBinding* binding = bindingFor(handle);
+  if (!binding) return false;
+
+  if (!fadeInstalled) {
+    ledc_fade_func_install(0);
+    fadeInstalled = true;
+  }
+
+  // Channels 0-7 are the high speed group, 8-15 the low speed group
+  ledc_mode_t mode = (ledc_mode_t)(binding->channel / 8);
+  ledc_channel_t channel = (ledc_channel_t)(binding->channel % 8);
+  uint32_t maxDuty = (1UL << timers[binding->channel / 2].resolution) - 1;
+  if (duty > maxDuty) duty = maxDuty;
+
+  return ledc_set_fade_with_time(mode, channel, duty, ms) == ESP_OK
+    && ledc_fade_start(mode, channel, LEDC_FADE_NO_WAIT) == ESP_OK;
+}
+
+size_t pwmChannelsInUse() {
+  initChannels();
+  size_t used = 0;
+  for (int ch = 0; ch < PWM_CHANNELS; ch++) {
+    if (channelUsed(ch)) used++;
+  }
+  return used;
+}
@@ -0,0 +1,66 @@
+#ifndef PWM_H
+#define PWM_H
+
+#include <Arduino.h>
+#include "DeviceHandle.h"
+
+// --- PWM channels ---
+//
+// Owns the ESP32's 16 LEDC channels. A device is given a channel when its
+// pins are set up and keeps it until it is released or deleted; bindings
+// live in a flat table indexed by the device's registry slot, so a duty
+// update is one lookup and one LEDC register write. The hardware latches a
+// new duty at the end of the current period, so any number of channels can
+// be updated back to back without glitches.
+//
+// Channels come in pairs (0-1, 2-3, ...) that share one timer and therefore
+// one frequency and resolution. The allocator fills half-used pairs whose
+// settings match before opening a new pair.
+
+#define PWM_CHANNELS 16
+
+// LEDC timers run from the 80 MHz APB clock: frequency * 2^resolution
+// must not exceed it
+#define PWM_CLOCK_HZ 80000000UL
+#define PWM_MAX_RESOLUTION 16
+
+// Defaults for devices that leave pwmFrequency / pwmResolution at 0
+#define PWM_DEFAULT_FREQUENCY 5000
+#define PWM_DEFAULT_RESOLUTION 12
+#define PWM_MOTOR_FREQUENCY 20000     // above the audible range
+#define PWM_MOTOR_RESOLUTION 10
+
+// Servos: 50 Hz frames, pulse width mapped linearly over 0-180 degrees
+#define PWM_SERVO_FREQUENCY 50
+#define PWM_SERVO_RESOLUTION 16
+#define PWM_SERVO_MIN_US 500
+#define PWM_SERVO_MAX_US 2500
+
+// True if the hardware can generate this frequency at this resolution
+bool pwmConfigValid(uint32_t frequency, uint8_t resolution);
+
+// Binds a channel to the device on pin, re-binding if the pin or settings
+// changed. False if every channel is taken or the settings are invalid.
+bool pwmAttach(DeviceHandle handle, int pin, uint32_t frequency, uint8_t resolution);
+
+// Stops the output and frees the device's channel
+void pwmDetach(DeviceHandle handle);
+
+bool pwmAttached(DeviceHandle handle);
+
+// Sets the duty cycle, clamped to the channel's resolution
+bool pwmWrite(DeviceHandle handle, uint32_t duty);
+
+// Same as pwmWrite with the duty given as level out of range
+bool pwmWriteLevel(DeviceHandle handle, uint32_t level, uint32_t range);
+
+// Servo pulse width in microseconds, on a channel attached at 50 Hz
+bool pwmWriteMicroseconds(DeviceHandle handle, uint32_t us);
+
+// Ramps to the duty in hardware over ms without involving the CPU. Do not
+// mix with pwmWrite on the same channel while a fade is running.
+bool pwmFade(DeviceHandle handle, uint32_t duty, uint32_t ms);
+
+size_t pwmChannelsInUse();
+
+#endif // PWM_H
@@ -0,0 +1,84 @@
+#include "device_json.h"
+#include "motion_planner.h"
+
+// --- Device JSON ---
+
+void deviceToJson(const Device &device, JsonObject obj) {
+  obj["id"] = device.id;
+  obj["type"] = device.type;
+  char stateText[STATE_STRING_MAX];
+  formatDeviceState(device.state, stateText, sizeof(stateText));
+  obj["state"] = stateText;
+
+  JsonArray pinsArray = obj["pins"].to<JsonArray>();
+  for (int pin : device.pins) {
+    pinsArray.add(pin);
+  }
+
+  obj["interfaceType"] = interfaceTypeName(device.interface);
+  obj["direction"] = deviceDirectionName(device.direction);
+  if (device.sampleIntervalMs) obj["sampleInterval"] = device.sampleIntervalMs;
+  if (device.pwmFrequency) obj["pwmFrequency"] = device.pwmFrequency;
+  if (device.pwmResolution) obj["pwmResolution"] = device.pwmResolution;
+  if (device.kind == STEPPER_KIND) {
+    if (device.maxSpeed) obj["maxSpeed"] = device.maxSpeed;
+    if (device.acceleration) obj["acceleration"] = device.acceleration;
+    if (device.motionProfile) obj["profile"] = motionProfileName((MotionProfile)device.motionProfile);
+    obj["position"] = device.position;
+  }
+  if (device.kind == LED_STRIP_KIND && device.ledCount) obj["ledCount"] = device.ledCount;
+}
+
+size_t writeDevicesJson(Print &out) {
+  size_t written = out.write('[');
+
+  // One small document reused for every device
+  JsonDocument doc;
+  bool first = true;
+  for (const auto& device : devices) {
+    if (!first) written += out.write(',');
+    first = false;
+
+    doc.clear();
+    deviceToJson(device, doc.to<JsonObject>());
+    written += serializeJson(doc, out);
+  }
+
+  written += out.write(']');
+  return written;
+}
+
+size_t writeDeviceChangesJson(Print &out, uint32_t since) {
+  bool full = !devices.canDiffSince(since);
+  size_t written = out.print("{\"generation\":");
+  written += out.print(devices.generation());
+  written += out.print(full ? ",\"full\":true" : ",\"full\":false");
+
+  JsonDocument doc;
+  written += out.print(",\"deleted\":[");
+  bool first = true;
+  for (size_t i = 0; !full && i < devices.deletionCount(); i++) {
+    const DeviceRegistry::Deletion &entry = devices.deletion(i);
+    if (entry.generation <= since) continue;
+    if (!first) written += out.write(',');
+    first = false;
+
+    doc.set(entry.id);
+    written += serializeJson(doc, out);
+  }
+
+  written += out.print("],\"devices\":[");
+  first = true;
+  for (const auto& device : devices) {
+    if (!full && devices.changedAt(device) <= since) continue;
+    if (!first) written += out.write(',');
+    first = false;
+
+    doc.clear();
+    deviceToJson(device, doc.to<JsonObject>());
+    written += serializeJson(doc, out);
+  }
+
+  written += out.print("]}");
+  return written;
+}
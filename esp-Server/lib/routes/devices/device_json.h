@@ -0,0 +1,24 @@
+#ifndef DEVICE_JSON_H
+#define DEVICE_JSON_H
+
+#include <ArduinoJson.h>
+#include "ESPControlPlatform.h"
+
+// --- Device JSON ---
+
+// Fills obj with the API representation of a device
+void deviceToJson(const Device &device, JsonObject obj);
+
+// Writes every registered device as a JSON array. Devices are serialized one
+// at a time, so memory use does not grow with the number of devices.
+size_t writeDevicesJson(Print &out);
+
+// Writes the changes made after generation `since`:
+//   {"generation":G,"full":false,"deleted":[ids],"devices":[changed]}
+// Deletions are listed before the devices added or changed since, so an id
+// that was deleted and re-added ends up present. When the registry can no
+// longer tell what changed (since is too old or from before a reboot) the
+// reply has "full":true and "devices" holds every device.
+size_t writeDeviceChangesJson(Print &out, uint32_t since);
+
+#endif // DEVICE_JSON_H
@@ -1,129 +1,227 @@
 #include "devices.h"
+#include "device_json.h"
+#include "http/buffered_response.h"
+#include "metrics/metrics_routes.h"
+#include "log.h"
 #include "ESPControlPlatform.h"
 #include "device_controller.h"
+#include "pwm.h"
+#include "stepper.h"
+#include "led_strip.h"
+#include "sampler.h"
+#include "persistence.h"
+#include "state_journal.h"
+#include "device_snapshot.h"
 #include <ArduinoJson.h>
 #include <SPIFFS.h>
 
-// File path in SPIFFS to store devices
-const char* DEVICES_FILE = "/devices.json";
+// File path in SPIFFS to store devices (binary snapshot, see device_snapshot.h)
+const char* DEVICES_FILE = "/devices.bin";
+// Saves are written here first and renamed over DEVICES_FILE when complete
+const char* DEVICES_TEMP_FILE = "/devices.bin.tmp";
+
+// JSON files from older firmware, migrated to DEVICES_FILE on boot
+const char* LEGACY_DEVICES_FILE = "/devices.json";
+const char* LEGACY_DEVICES_TEMP_FILE = "/devices.json.tmp";
+
+// Generation of the snapshot on flash; the state journal extends it
+static uint32_t snapshotGeneration = 0;
 
 // Persistence function prototypes
 bool saveDevicesToFlash();
 bool loadDevicesFromFlash();
+static bool importDevicesFromJson(JsonDocument &doc, uint32_t &generation);
 
 void initializeDevices() {
-  Serial.println("[DEBUG] Initializing devices from flash...");
-  if (!loadDevicesFromFlash()) {
-    Serial.println("[INFO] No devices file found, starting with an empty list.");
+  LOG_DEBUG("Initializing devices from flash...");
+  // Random base so list generations from before a reboot are not reused
+  devices.seedGeneration(esp_random() >> 1);
+  bool loaded;
+  {
+    ScopedTimer timer(registerHistogram("esp_persist_duration_us", "op", "load"));
+    loaded = loadDevicesFromFlash();
+  }
+  if (!loaded) {
+    LOG_INFO("No devices file found, starting with an empty list.");
   } else {
-    Serial.println("[INFO] Devices loaded from flash.");
+    LOG_INFO("Devices loaded from flash.");
   }
+
+  // Changes are saved from loop() by handlePersistence()
+  initPersistence(saveDevicesToFlash);
 }
 
-// Helper function to convert enums to strings
-String getInterfaceTypeString(InterfaceType interface) {
-  switch (interface) {
-    case DIGITAL_IF: return "digital";
-    case ANALOG_IF:  return "analog";
-    case PWM_IF:     return "pwm";
-    case I2C_IF:     return "i2c";
-    case SPI_IF:     return "spi";
-    default:         return "unknown";
+static void sendResult(Response &res, const DeviceOpResult &result) {
+  if (result.status == 200) {
+    res.send(result.message);
+  } else {
+    res.status(result.status).send(result.message);
   }
 }
 
-String getDeviceDirectionString(DeviceDirection direction) {
-  switch (direction) {
-    case INPUT_DEVICE:      return "input";
-    case OUTPUT_DEVICE:     return "output";
-    case BIDIRECTIONAL:     return "bidirectional";
-    default:                return "unknown";
+// In-use pins answer 409 Conflict like duplicate ids; other pin errors are 400
+static DeviceOpResult pinErrorResult(PinError error, int pin) {
+  LOG_DEBUG("Rejected pin %d: %s", pin, pinErrorMessage(error));
+  return {error == PIN_ERR_IN_USE ? 409 : 400, pinErrorMessage(error)};
+}
+
+static std::vector<int> pinsFromJson(JsonArray pins) {
+  std::vector<int> result;
+  result.reserve(pins.size());
+  for (JsonVariant v : pins) {
+    result.push_back(v.is<int>() ? v.as<int>() : -1);
   }
+  return result;
+}
+
+// Reads an optional whole-number setting, 0 when absent. False if it is
+// negative, fractional or above max, instead of letting it wrap into the
+// narrower Device field.
+template <typename T>
+static bool readSetting(JsonVariant value, uint32_t max, T &out) {
+  if (value.isNull()) {
+    out = 0;
+    return true;
+  }
+  if (!value.is<uint32_t>() || value.as<uint32_t>() > max) return false;
+  out = (T)value.as<uint32_t>();
+  return true;
+}
+
+// Reads pwmFrequency and pwmResolution; false unless both are in range and
+// an LEDC timer can run the resulting configuration
+static bool readPwmSettings(JsonObject obj, Device &d) {
+  if (!readSetting(obj["pwmFrequency"], PWM_CLOCK_HZ, d.pwmFrequency)
+      || !readSetting(obj["pwmResolution"], PWM_MAX_RESOLUTION, d.pwmResolution)) {
+    return false;
+  }
+  uint32_t frequency;
+  uint8_t resolution;
+  devicePwmSettings(d, frequency, resolution);
+  return pwmConfigValid(frequency, resolution);
+}
+
+// Reads maxSpeed, acceleration and profile; false if a number is out of range
+static bool readMotionSettings(JsonObject obj, Device &d) {
+  d.motionProfile = parseMotionProfile(obj["profile"] | "trapezoid");
+  return readSetting(obj["maxSpeed"], STEPPER_MAX_SPEED, d.maxSpeed)
+    && readSetting(obj["acceleration"], STEPPER_MAX_ACCELERATION, d.acceleration);
+}
+
+const char* deviceStateText(JsonVariant state, char* buffer, size_t size) {
+  if (state.is<const char*>()) return state.as<const char*>();
+  if (!state.is<double>() && !state.is<bool>()) return nullptr;
+  serializeJson(state, buffer, size);
+  return buffer;
+}
+
+DeviceOpResult setDeviceState(const char* id, const char* state) {
+  // Parse once here; drivers only see the typed, range-checked state
+  Device* d = devices.find(id);
+  if (!d) return {404, "Device not found"};
+
+  DeviceState parsedState;
+  if (!parseDeviceState(d->kind, state, parsedState) || !updateDeviceState(*d, parsedState)) {
+    return {400, "Invalid state update"};
+  }
+
+  devices.touch(d->handle);
+  if (deviceKeepsState(d->kind)) markDeviceStateDirty(d->handle);
+  return {200, "Device updated"};
+}
+
+DeviceOpResult setDevicePins(const char* id, JsonArray pins) {
+  if (pins.isNull()) return {400, "Missing pins array"};
+
+  Device* d = devices.find(id);
+  if (!d) return {404, "Device not found"};
+
+  std::vector<int> newPins = pinsFromJson(pins);
+  int badPin;
+  PinError error = checkDevicePins(*d, newPins, badPin);
+  if (error != PIN_ERR_NONE) return pinErrorResult(error, badPin);
+
+  releaseDevicePins(*d);
+  devices.setPins(d->handle, newPins);
+  setupDevicePins(*d);
+  devices.touch(d->handle);
+  markDevicesDirty();
+  return {200, "Device pins updated"};
 }
 
 void registerDeviceRoutes(ESPExpress &app) {
   // GET /api/devices - List all devices
-  app.get("/api/devices", [](Request &req, Response &res) {
-    JsonDocument doc;
-    JsonArray deviceArray = doc.to<JsonArray>();
-
-    for (const auto& device : devices) {
-      JsonObject deviceObj = deviceArray.add<JsonObject>();
-      
-      deviceObj["id"] = device.id;
-      deviceObj["type"] = device.type;
-      deviceObj["state"] = device.state;
-      
-      JsonArray pinsArray = deviceObj["pins"].to<JsonArray>();
-      for (int pin : device.pins) {
-        pinsArray.add(pin);
-      }
-      
-      deviceObj["interfaceType"] = getInterfaceTypeString(device.interface);
-      deviceObj["direction"] = getDeviceDirectionString(device.direction);
+  // With ?since=<generation> only the changes after that generation are sent
+  app.get("/api/devices", timedRoute("GET /api/devices", [](Request &req, Response &res) {
+    String etag = "\"" + String(devices.generation()) + "\"";
+    if (req.getHeader("If-None-Match") == etag) {
+      res.status(304).setHeader("ETag", etag).send("");
+      return;
     }
 
-    String jsonResponse;
-    serializeJson(doc, jsonResponse);
-    Serial.println("[DEBUG] GET /api/devices response JSON: " + jsonResponse);
-    res.sendJson(jsonResponse);
-  });
+    String sinceParam = req.getQuery("since");
+    char* end = nullptr;
+    uint32_t since = strtoul(sinceParam.c_str(), &end, 10);
+    bool delta = sinceParam.length() > 0;
+    if (delta && (*end != '\0' || !isDigit(sinceParam[0]))) {
+      res.status(400).send("Invalid since parameter");
+      return;
+    }
+
+    res.setHeader("ETag", etag);
+
+    // Written straight into the body; no JsonDocument holds the array
+    BufferedResponse out(res, "application/json", devices.size() * 128);
+    size_t written = delta ? writeDeviceChangesJson(out, since) : writeDevicesJson(out);
+    out.end();
+    LOG_DEBUG("GET /api/devices%s - %u bytes", delta ? " (delta)" : "", (unsigned)written);
+  }));
 
   // GET /api/device/:id - Get a single device by id
-  app.get("/api/device/:id", [](Request &req, Response &res) {
+  app.get("/api/device/:id", timedRoute("GET /api/device/:id", [](Request &req, Response &res) {
     String deviceId = req.getParam("id");
-    Serial.println("[DEBUG] GET /api/device/" + deviceId);
-
-    for (const auto& device : devices) {
-      if (device.id == deviceId) {
-        JsonDocument doc;
-        JsonObject deviceObj = doc.to<JsonObject>();
-        
-        deviceObj["id"] = device.id;
-        deviceObj["type"] = device.type;
-        deviceObj["state"] = device.state;
-        
-        JsonArray pinsArray = deviceObj["pins"].to<JsonArray>();
-        for (int pin : device.pins) {
-          pinsArray.add(pin);
-        }
-        
-        deviceObj["interfaceType"] = getInterfaceTypeString(device.interface);
-        deviceObj["direction"] = getDeviceDirectionString(device.direction);
-
-        String jsonResponse;
-        serializeJson(doc, jsonResponse);
-        res.sendJson(jsonResponse);
-        return;
-      }
+    LOG_DEBUG("GET /api/device/%s", deviceId.c_str());
+
+    const Device* device = devices.find(deviceId);
+    if (device) {
+      String jsonResponse;
+      JsonDocument doc;
+      deviceToJson(*device, doc.to<JsonObject>());
+      serializeJson(doc, jsonResponse);
+      res.sendJson(jsonResponse);
+      return;
     }
 
     res.status(404).send("Device not found");
-    Serial.println("[DEBUG] GET /api/device/" + deviceId + " - not found");
-  });
+    LOG_DEBUG("GET /api/device/%s - not found", deviceId.c_str());
+  }));
 
   // POST /api/device - Add a new device
-  app.post("/api/device", [](Request &req, Response &res) {
+  app.post("/api/device", timedRoute("POST /api/device", [](Request &req, Response &res) {
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, req.body);
     
     if (error) {
       res.status(400).send("Invalid JSON");
-      Serial.println("[DEBUG] POST /api/device - JSON parse error: " + String(error.c_str()));
+      LOG_DEBUG("POST /api/device - JSON parse error: %s", error.c_str());
       return;
     }
 
     Device d;
     d.id = doc["id"].as<String>();
     d.type = doc["type"].as<String>();
-    d.state = doc.containsKey("state") ? doc["state"].as<String>() : "unknown";
+    d.kind = parseDeviceKind(d.type);
+    char stateBuffer[STATE_STRING_MAX];
+    if (doc.containsKey("state")
+        && !parseDeviceState(d.kind, deviceStateText(doc["state"], stateBuffer, sizeof(stateBuffer)), d.state)) {
+      res.status(400).send("Invalid state");
+      LOG_DEBUG("POST /api/device - invalid state for %s", d.type.c_str());
+      return;
+    }
 
     // Parse pins
     if (doc.containsKey("pins")) {
-      JsonArray pinsJson = doc["pins"].as<JsonArray>();
-      for (JsonVariant pinVar : pinsJson) {
-        d.pins.push_back(pinVar.as<int>());
-      }
+      d.pins = pinsFromJson(doc["pins"].as<JsonArray>());
     }
 
     // Parse interface type
@@ -136,187 +234,378 @@ void registerDeviceRoutes(ESPExpress &app) {
       ? parseDeviceDirection(doc["direction"].as<String>())
       : UNKNOWN_DIRECTION;
 
-    devices.push_back(d);
-    
-    // Debug output
-    JsonDocument debugDoc;
-    JsonObject debugObj = debugDoc.to<JsonObject>();
-    debugObj["id"] = d.id;
-    debugObj["type"] = d.type;
-    debugObj["state"] = d.state;
-    
-    JsonArray debugPinsArray = debugObj["pins"].to<JsonArray>();
-    for (int pin : d.pins) {
-      debugPinsArray.add(pin);
+    // Sampling rate for input devices, see sampler.h
+    if (!readSetting(doc["sampleInterval"], SAMPLER_MAX_INTERVAL_MS, d.sampleIntervalMs)) {
+      res.status(400).send("Invalid sample interval");
+      return;
     }
-    
-    debugObj["interfaceType"] = getInterfaceTypeString(d.interface);
-    debugObj["direction"] = getDeviceDirectionString(d.direction);
 
-    String debugJson;
-    serializeJson(debugDoc, debugJson);
-    Serial.println("[DEBUG] Adding Device: " + debugJson);
-    
-    // Save to flash
-    if (saveDevicesToFlash()) {
-      res.send("Device added");
-    } else {
-      res.status(500).send("Failed to save device");
+    // PWM settings for outputs driven by an LEDC channel, see pwm.h
+    if (!readPwmSettings(doc.as<JsonObject>(), d)) {
+      res.status(400).send("Invalid PWM frequency or resolution");
+      return;
     }
-  });
 
-  // PUT /api/device/:id - Update device state or other attributes
-  app.put("/api/device/:id", [](Request &req, Response &res) {
-    String deviceId = req.getParam("id");
-    String newState = req.body;
-    Serial.println("[DEBUG] PUT /api/device/" + deviceId + " with new state: " + newState);
-    
-    bool found = false;
-    bool updateSuccess = false;
-    
-    for (auto &d : devices) {
-      if (d.id == deviceId) {
-        found = true;
-        updateSuccess = updateDeviceState(d, newState);
-        break;
-      }
+    // Motion settings for steppers, see stepper.h
+    if (!readMotionSettings(doc.as<JsonObject>(), d)) {
+      res.status(400).send("Invalid stepper speed or acceleration");
+      return;
     }
 
-    if (found && updateSuccess) {
-      if (saveDevicesToFlash())
-        res.send("Device updated");
-      else
-        res.status(500).send("Device updated but failed to save changes");
-      Serial.println("[DEBUG] Device " + deviceId + " updated successfully with state: " + newState);
+    // Strip length, see led_strip.h
+    if (!readSetting(doc["ledCount"], LED_STRIP_MAX_PIXELS, d.ledCount)) {
+      res.status(400).send("Invalid LED count");
+      return;
     }
-    else if (!found) {
-      res.status(404).send("Device not found");
-      Serial.println("[DEBUG] Device " + deviceId + " not found");
+
+    // Pins are checked against the kind, direction and interface parsed above
+    int badPin;
+    PinError pinError = checkDevicePins(d, d.pins, badPin);
+    if (pinError != PIN_ERR_NONE) {
+      sendResult(res, pinErrorResult(pinError, badPin));
+      return;
     }
-    else {
-      res.status(400).send("Invalid state update");
-      Serial.println("[DEBUG] Failed to update device " + deviceId + " state");
+
+    DeviceHandle handle = devices.add(d);
+    if (handle == INVALID_DEVICE_HANDLE) {
+      res.status(409).send("Device already exists");
+      LOG_DEBUG("POST /api/device - duplicate id: %s", d.id.c_str());
+      return;
     }
-  });
+    setupDevicePins(*devices.get(handle));
+    
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+    char deviceJson[LOG_LINE_MAX];
+    JsonDocument debugDoc;
+    deviceToJson(d, debugDoc.to<JsonObject>());
+    serializeJson(debugDoc, deviceJson, sizeof(deviceJson));
+    LOG_DEBUG("Adding Device: %s", deviceJson);
+#endif
+    
+    markDevicesDirty();
+    res.send("Device added");
+  }));
+
+  // PUT /api/device/:id - Update device state or other attributes
+  app.put("/api/device/:id", timedRoute("PUT /api/device/:id", [](Request &req, Response &res) {
+    String deviceId = req.getParam("id");
+    String newState = req.body;
+    LOG_DEBUG("PUT /api/device/%s with new state: %s", deviceId.c_str(), newState.c_str());
+    
+    DeviceOpResult result = setDeviceState(deviceId.c_str(), newState.c_str());
+    sendResult(res, result);
+    LOG_DEBUG("PUT /api/device/%s - %d %s", deviceId.c_str(), result.status, result.message);
+  }));
 
   // PUT /api/device/:id/pins - Update device pins
-  app.put("/api/device/:id/pins", [](Request &req, Response &res) {
+  app.put("/api/device/:id/pins", timedRoute("PUT /api/device/:id/pins", [](Request &req, Response &res) {
     String deviceId = req.getParam("id");
-    Serial.println("[DEBUG] PUT /api/device/" + deviceId + "/pins, body: " + req.body);
+    LOG_DEBUG("PUT /api/device/%s/pins, body: %s", deviceId.c_str(), req.body.c_str());
 
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, req.body);
     if (error) {
       res.status(400).send("Invalid JSON");
-      Serial.println("[DEBUG] PUT /api/device/" + deviceId + "/pins - JSON parse error: " + String(error.c_str()));
+      LOG_DEBUG("PUT /api/device/%s/pins - JSON parse error: %s", deviceId.c_str(), error.c_str());
       return;
     }
 
-    JsonArray pins = doc["pins"].as<JsonArray>();
-    if (pins.isNull()) {
-      res.status(400).send("Missing pins array");
-      Serial.println("[DEBUG] PUT /api/device/" + deviceId + "/pins - Missing pins array");
+    DeviceOpResult result = setDevicePins(deviceId.c_str(), doc["pins"].as<JsonArray>());
+    sendResult(res, result);
+    LOG_DEBUG("PUT /api/device/%s/pins - %d %s", deviceId.c_str(), result.status, result.message);
+  }));
+
+  // POST /api/devices/batch - Apply many state/pin updates with one flash write
+  app.post("/api/devices/batch", timedRoute("POST /api/devices/batch", [](Request &req, Response &res) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, req.body);
+    if (error) {
+      res.status(400).send("Invalid JSON");
+      LOG_DEBUG("POST /api/devices/batch - JSON parse error: %s", error.c_str());
       return;
     }
-    
-    bool found = false;
-    for (auto &d : devices) {
-      if (d.id == deviceId) {
-        found = true;
-        d.pins.clear();
-        for (JsonVariant v : pins) {
-          d.pins.push_back(v.as<int>());
-        }
-        break;
-      }
+
+    // Accept either a bare array or {"updates": [...]}
+    JsonArray updates = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["updates"].as<JsonArray>();
+    if (updates.isNull()) {
+      res.status(400).send("Missing updates array");
+      return;
     }
-    
-    if (found) {
-      if (saveDevicesToFlash())
-        res.send("Device pins updated");
-      else
-        res.status(500).send("Pins updated but failed to save changes");
-      Serial.println("[DEBUG] Device " + deviceId + " pins updated");
-    } else {
-      res.status(404).send("Device not found");
-      Serial.println("[DEBUG] Device " + deviceId + " not found for pin update");
+
+    JsonDocument resultDoc;
+    JsonArray results = resultDoc["results"].to<JsonArray>();
+    BatchStatus status = applyDeviceBatch(updates, results);
+
+    String jsonResponse;
+    serializeJson(resultDoc, jsonResponse);
+    switch (status) {
+      case BATCH_OK:          res.sendJson(jsonResponse); break;
+      case BATCH_PARTIAL:     res.status(207).sendJson(jsonResponse); break;
+      case BATCH_INVALID:     res.status(400).sendJson(jsonResponse); break;
+    }
+    LOG_DEBUG("POST /api/devices/batch - %u item(s), status %u", (unsigned)updates.size(), (unsigned)status);
+  }));
+
+  // POST /api/devices/import - Replace all devices from a JSON device list
+  // (the same format GET /api/devices returns)
+  app.post("/api/devices/import", timedRoute("POST /api/devices/import", [](Request &req, Response &res) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, req.body);
+    uint32_t generation;
+    if (error || !importDevicesFromJson(doc, generation)) {
+      res.status(400).send("Invalid device list");
+      return;
     }
-  });
+
+    setupDevicePins();
+    markDevicesDirty();
+    res.send("Imported " + String(devices.size()) + " device(s)");
+  }));
+
+  // POST /api/devices/save - Write pending changes to flash now
+  app.post("/api/devices/save", timedRoute("POST /api/devices/save", [](Request &req, Response &res) {
+    if (flushDevices())
+      res.send("Devices saved");
+    else
+      res.status(500).send("Failed to save devices");
+  }));
 
   // DELETE /api/device/:id - Delete a device
-  app.del("/api/device/:id", [](Request &req, Response &res) {
+  app.del("/api/device/:id", timedRoute("DELETE /api/device/:id", [](Request &req, Response &res) {
     String deviceId = req.getParam("id");
-    Serial.println("[DEBUG] DELETE /api/device/" + deviceId);
-    
-    auto it = std::find_if(devices.begin(), devices.end(), 
-      [&deviceId](const Device& d) { return d.id == deviceId; });
+    LOG_DEBUG("DELETE /api/device/%s", deviceId.c_str());
     
-    if (it != devices.end()) {
-      devices.erase(it);
-      
-      if (saveDevicesToFlash())
-        res.send("Device deleted");
-      else
-        res.status(500).send("Device deleted but failed to save changes");
-      
-      Serial.println("[DEBUG] Device " + deviceId + " deleted");
+    Device* device = devices.find(deviceId);
+    if (device) {
+      releaseDevicePins(*device);
+      devices.remove(deviceId);
+      markDevicesDirty();
+      res.send("Device deleted");
+      LOG_DEBUG("Device %s deleted", deviceId.c_str());
     } else {
       res.status(404).send("Device not found");
-      Serial.println("[DEBUG] Device " + deviceId + " not found for deletion");
+      LOG_DEBUG("Device %s not found for deletion", deviceId.c_str());
+    }
+  }));
+}
+
+// One validated batch entry, ready to apply
+struct BatchItem {
+  const char* id;
+  Device* device;
+  bool hasState;
+  DeviceState state;
+  bool hasPins;
+  std::vector<int> pins;
+  const char* error;
+};
+
+BatchStatus applyDeviceBatch(JsonArray updates, JsonArray results) {
+  if (updates.size() > MAX_BATCH_ITEMS) {
+    JsonObject result = results.add<JsonObject>();
+    result["ok"] = false;
+    result["error"] = "Too many items";
+    return BATCH_INVALID;
+  }
+
+  std::vector<BatchItem> items;
+  items.reserve(updates.size());
+  bool valid = true;
+  uint64_t batchPins = 0;   // pins claimed by earlier items
+
+  // Pass 1: resolve ids, parse every state and check every pin list before
+  // touching any device
+  for (JsonObject update : updates) {
+    BatchItem item = {update["id"], nullptr, false, DeviceState(), false, std::vector<int>(), nullptr};
+    JsonVariant state = update["state"];
+    JsonArray pins = update["pins"].as<JsonArray>();
+    item.hasPins = !pins.isNull();
+
+    if (!item.id) {
+      item.error = "Missing id";
+    } else if (!(item.device = devices.find(item.id))) {
+      item.error = "Device not found";
+    } else if (state.isNull() && !item.hasPins) {
+      item.error = "Nothing to update";
+    } else if (!state.isNull()) {
+      item.hasState = true;
+      char stateBuffer[STATE_STRING_MAX];
+      if (!parseDeviceState(item.device->kind, deviceStateText(state, stateBuffer, sizeof(stateBuffer)), item.state)) {
+        item.error = "Invalid state";
+      }
+    }
+
+    if (!item.error && item.hasPins) {
+      item.pins = pinsFromJson(pins);
+      int badPin;
+      PinError pinError = checkDevicePins(*item.device, item.pins, badPin, batchPins);
+      if (pinError != PIN_ERR_NONE) {
+        item.error = pinErrorMessage(pinError);
+      } else {
+        for (int pin : item.pins) batchPins |= 1ULL << pin;
+      }
+    }
+
+    if (item.error) valid = false;
+    items.push_back(item);
+  }
+
+  if (!valid) {
+    for (auto &item : items) {
+      JsonObject result = results.add<JsonObject>();
+      result["id"] = item.id;
+      result["ok"] = item.error == nullptr;
+      if (item.error) result["error"] = item.error;
     }
-  });
+    return BATCH_INVALID;
+  }
+
+  // Pass 2: apply in order
+  bool allApplied = true;
+  bool configChanged = false;
+  for (auto &item : items) {
+    if (item.hasPins) {
+      releaseDevicePins(*item.device);
+      devices.setPins(item.device->handle, item.pins);
+      setupDevicePins(*item.device);
+      configChanged = true;
+    }
+
+    bool ok = !item.hasState || updateDeviceState(*item.device, item.state);
+    if (ok && item.hasState && deviceKeepsState(item.device->kind)) markDeviceStateDirty(item.device->handle);
+    if (item.hasPins || (ok && item.hasState)) devices.touch(item.device->handle);
+    JsonObject result = results.add<JsonObject>();
+    result["id"] = item.device->id;
+    result["ok"] = ok;
+    if (!ok) {
+      result["error"] = "Invalid state update";
+      allApplied = false;
+    }
+  }
+
+  // Pin changes need a new snapshot; states alone go to the journal
+  if (configChanged) markDevicesDirty();
+  return allApplied ? BATCH_OK : BATCH_PARTIAL;
+}
+
+const char* batchStatusName(BatchStatus status) {
+  switch (status) {
+    case BATCH_OK:        return "ok";
+    case BATCH_PARTIAL:   return "partial";
+    default:              return "invalid";
+  }
 }
 
 bool saveDevicesToFlash() {
-  Serial.println("[DEBUG] Saving devices to flash...");
-  
-  File file = SPIFFS.open(DEVICES_FILE, "w");
-  if (!file) {
-    Serial.println("[ERROR] Unable to open file for writing: " + String(DEVICES_FILE));
+  LOG_DEBUG("Saving devices to flash...");
+
+  uint32_t generation = snapshotGeneration + 1;
+  if (!saveDeviceSnapshot(DEVICES_TEMP_FILE, generation)) {
+    LOG_ERROR("Failed to write %s", DEVICES_TEMP_FILE);
+    SPIFFS.remove(DEVICES_TEMP_FILE);
     return false;
   }
-  
-  JsonDocument doc;
-  JsonArray arr = doc.to<JsonArray>();
-  
-  for (const auto& device : devices) {
-    JsonObject obj = arr.add<JsonObject>();
-    
-    obj["id"] = device.id;
-    obj["type"] = device.type;
-    obj["state"] = device.state;
-    
-    JsonArray pins = obj["pins"].to<JsonArray>();
-    for (int pin : device.pins) {
-      pins.add(pin);
-    }
-    
-    obj["interfaceType"] = getInterfaceTypeString(device.interface);
-    obj["direction"] = getDeviceDirectionString(device.direction);
+
+  // SPIFFS cannot rename over an existing file. If we crash between the
+  // remove and the rename, loadDevicesFromFlash() recovers the temp file.
+  if (SPIFFS.exists(DEVICES_FILE) && !SPIFFS.remove(DEVICES_FILE)) {
+    LOG_ERROR("Unable to replace %s", DEVICES_FILE);
+    return false;
   }
-  
-  if (serializeJson(doc, file) == 0) {
-    Serial.println("[ERROR] Failed to write to file");
-    file.close();
+  if (!SPIFFS.rename(DEVICES_TEMP_FILE, DEVICES_FILE)) {
+    LOG_ERROR("Unable to rename %s", DEVICES_TEMP_FILE);
     return false;
   }
-  
-  file.close();
-  Serial.println("[INFO] Devices saved to flash");
+
+  // Every state is in the new snapshot now, so start an empty journal on it
+  snapshotGeneration = generation;
+  resetStateJournal(generation);
+  LOG_INFO("Devices saved to flash");
   return true;
 }
 
-bool loadDevicesFromFlash() {
-  Serial.println("[DEBUG] Loading devices from flash...");
-  
-  if (!SPIFFS.exists(DEVICES_FILE)) {
-    Serial.println("[INFO] Devices file not found: " + String(DEVICES_FILE));
-    return false;
+// Replaces the registry with a JSON device list: either a bare array or
+// {"generation": n, "devices": [...]}. Used for legacy files and imports.
+// Devices whose pins fail the checks are skipped. Pins are not attached:
+// the import route attaches them, and at boot setup() does once journaled
+// states and positions have been replayed.
+static bool importDevicesFromJson(JsonDocument &doc, uint32_t &generation) {
+  JsonArray arr;
+  if (doc.is<JsonArray>()) {
+    arr = doc.as<JsonArray>();
+    generation = 0;
+  } else {
+    arr = doc["devices"].as<JsonArray>();
+    generation = doc["generation"] | 0;
   }
+  if (arr.isNull()) return false;
+
+  // Everything is parsed before the registry is touched, so a list that
+  // is rejected leaves the current devices in place
+  std::vector<Device> imported;
+  imported.reserve(arr.size());
+  for (JsonObject obj : arr) {
+    Device d;
+    d.id = obj["id"].as<String>();
+    d.type = obj["type"].as<String>();
+    d.kind = parseDeviceKind(d.type);
+    // A state that no longer parses (e.g. "unknown") loads as STATE_UNKNOWN
+    char stateBuffer[STATE_STRING_MAX];
+    if (!parseDeviceState(d.kind, deviceStateText(obj["state"], stateBuffer, sizeof(stateBuffer)), d.state)) {
+      d.state = DeviceState();
+    }
+    
+    d.pins = pinsFromJson(obj["pins"].as<JsonArray>());
+
+    d.interface = parseInterfaceType(obj["interfaceType"].as<String>());
+    d.direction = parseDeviceDirection(obj["direction"].as<String>());
+    if (!readSetting(obj["sampleInterval"], SAMPLER_MAX_INTERVAL_MS, d.sampleIntervalMs)) {
+      LOG_ERROR("Device %s: invalid sampleInterval", d.id.c_str());
+      return false;
+    }
+    if (!readPwmSettings(obj, d)) {
+      LOG_ERROR("Device %s: invalid PWM settings", d.id.c_str());
+      return false;
+    }
+    if (!readMotionSettings(obj, d)) {
+      LOG_ERROR("Device %s: invalid motion settings", d.id.c_str());
+      return false;
+    }
+    if (!readSetting(obj["ledCount"], LED_STRIP_MAX_PIXELS, d.ledCount)) {
+      LOG_ERROR("Device %s: invalid ledCount", d.id.c_str());
+      return false;
+    }
+    imported.push_back(d);
+  }
+
+  for (auto &device : devices) {
+    releaseDevicePins(device);
+  }
+  devices.clear();
+
+  // Pins are checked as POST /api/device does, against the devices
+  // imported before this one
+  for (const Device &d : imported) {
+    int badPin;
+    PinError pinError = checkDevicePins(d, d.pins, badPin);
+    if (pinError != PIN_ERR_NONE) {
+      LOG_ERROR("Skipping device %s: pin %d: %s", d.id.c_str(), badPin, pinErrorMessage(pinError));
+      continue;
+    }
+
+    if (devices.add(d) == INVALID_DEVICE_HANDLE) {
+      LOG_ERROR("Skipping duplicate device id: %s", d.id.c_str());
+    }
+  }
+  return true;
+}
+
+static bool loadDevicesFromJsonFile(const char* path, uint32_t &generation) {
+  if (!SPIFFS.exists(path)) return false;
   
-  File file = SPIFFS.open(DEVICES_FILE, "r");
+  File file = SPIFFS.open(path, "r");
   if (!file) {
-    Serial.println("[ERROR] Unable to open file for reading: " + String(DEVICES_FILE));
+    LOG_ERROR("Unable to open file for reading: %s", path);
     return false;
   }
   
@@ -325,30 +614,51 @@ bool loadDevicesFromFlash() {
   file.close();
   
   if (error) {
-    Serial.println("[ERROR] Failed to parse JSON: " + String(error.c_str()));
+    LOG_ERROR("Failed to parse JSON: %s", error.c_str());
     return false;
   }
-  
-  JsonArray arr = doc.as<JsonArray>();
-  devices.clear();
-  
-  for (JsonObject obj : arr) {
-    Device d;
-    d.id = obj["id"].as<String>();
-    d.type = obj["type"].as<String>();
-    d.state = obj["state"].as<String>();
-    
-    JsonArray pins = obj["pins"].as<JsonArray>();
-    for (JsonVariant v : pins) {
-      d.pins.push_back(v.as<int>());
+  return importDevicesFromJson(doc, generation);
+}
+
+bool loadDevicesFromFlash() {
+  LOG_DEBUG("Loading devices from flash...");
+
+  bool loaded = loadDeviceSnapshot(DEVICES_FILE, snapshotGeneration);
+
+  // An interrupted save leaves only the complete temp file behind
+  if (!loaded && loadDeviceSnapshot(DEVICES_TEMP_FILE, snapshotGeneration)) {
+    LOG_INFO("Recovered devices from %s", DEVICES_TEMP_FILE);
+    SPIFFS.rename(DEVICES_TEMP_FILE, DEVICES_FILE);
+    loaded = true;
+  }
+
+  // First boot after the switch to the binary format
+  bool migrated = false;
+  if (!loaded) {
+    migrated = loadDevicesFromJsonFile(LEGACY_DEVICES_FILE, snapshotGeneration)
+      || loadDevicesFromJsonFile(LEGACY_DEVICES_TEMP_FILE, snapshotGeneration);
+    loaded = migrated;
+  }
+
+  if (!loaded) {
+    LOG_INFO("Devices file not found: %s", DEVICES_FILE);
+    return false;
+  }
+  LOG_DEBUG("Loaded %u device(s) from flash.", (unsigned)devices.size());
+
+  size_t replayed = replayStateJournal(snapshotGeneration);
+  if (replayed > 0) {
+    LOG_DEBUG("Replayed %u journaled state change(s).", (unsigned)replayed);
+  }
+
+  if (migrated) {
+    if (saveDevicesToFlash()) {
+      SPIFFS.remove(LEGACY_DEVICES_FILE);
+      SPIFFS.remove(LEGACY_DEVICES_TEMP_FILE);
+      LOG_INFO("Migrated devices from JSON to %s", DEVICES_FILE);
+    } else {
+      LOG_ERROR("Migration to %s failed, keeping JSON", DEVICES_FILE);
     }
-    
-    d.interface = parseInterfaceType(obj["interfaceType"].as<String>());
-    d.direction = parseDeviceDirection(obj["direction"].as<String>());
-    
-    devices.push_back(d);
   }
-  
-  Serial.println("[DEBUG] Loaded " + String(devices.size()) + " device(s) from flash.");
   return true;
-}
\ No newline at end of file
+}
@@ -2,7 +2,47 @@
 #define DEVICES_ROUTES_H
 
 #include "ESPExpress.h"
+#include <ArduinoJson.h>
+
+#define MAX_BATCH_ITEMS 64
+
+enum BatchStatus {
+  BATCH_OK,           // every item applied
+  BATCH_PARTIAL,      // all items valid, but some drivers rejected their state
+  BATCH_INVALID       // validation failed, nothing was applied
+};
 
 void registerDeviceRoutes(ESPExpress &app);
 
+// --- Device operations ---
+//
+// Shared by the HTTP routes and the WebSocket RPC. The result carries the
+// HTTP status the route answers with and its message body.
+struct DeviceOpResult {
+  int status;
+  const char* message;
+
+  bool ok() const { return status < 300; }
+};
+
+// Parses and applies a new state; the device is journaled, not re-snapshot
+DeviceOpResult setDeviceState(const char* id, const char* state);
+
+// Text of a JSON state value. States are strings ("on", "#ff8000"), but
+// bare numbers (90) and booleans are accepted too and formatted into
+// buffer. Null for a missing value, an object or an array.
+const char* deviceStateText(JsonVariant state, char* buffer, size_t size);
+
+// Replaces the pin list of a device
+DeviceOpResult setDevicePins(const char* id, JsonArray pins);
+
+// Applies a list of {"id", "state"?, "pins"?} updates. Every item is
+// validated before any is applied, so a bad item leaves all devices
+// untouched. One {"id", "ok", "error"?} entry per item is appended to
+// results, and the registry is marked dirty once for the whole batch.
+BatchStatus applyDeviceBatch(JsonArray updates, JsonArray results);
+
+// "ok", "partial" or "invalid"
+const char* batchStatusName(BatchStatus status);
+
 #endif // DEVICES_ROUTES_H
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "buffered_response.h"
+#include "log.h"
+#include <SPIFFS.h>
+
+BufferedResponse::BufferedResponse(Response &res, const char* contentType, size_t sizeHint)
+  : res(res), contentType(contentType), spooling(false), failed(false), ended(false) {
+  body.reserve(sizeHint < RESPONSE_RAM_LIMIT ? sizeHint : RESPONSE_RAM_LIMIT);
+}
+
+BufferedResponse::~BufferedResponse() {
+  end();
+}
+
+size_t BufferedResponse::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t BufferedResponse::write(const uint8_t* data, size_t size) {
+  if (ended || failed) return 0;
+
+  if (!spooling && body.length() + size > RESPONSE_RAM_LIMIT && !spill()) {
+    failed = true;
+    return 0;
+  }
+  if (spooling) {
+    if (spool.write(data, size) != size) failed = true;
+    return failed ? 0 : size;
+  }
+
+  body.concat((const char*)data, size);
+  return size;
+}
+
+// Moves what is buffered so far into the spool file
+bool BufferedResponse::spill() {
+  spool = SPIFFS.open(RESPONSE_SPOOL_FILE, "w");
+  if (!spool) return false;
+  if (spool.write((const uint8_t*)body.c_str(), body.length()) != body.length()) {
+    spool.close();
+    return false;
+  }
+  body = String();
+  spooling = true;
+  return true;
+}
+
+void BufferedResponse::end() {
+  if (ended) return;
+  ended = true;
+
+  if (failed) {
+    if (spooling) spool.close();
+    LOG_ERROR("Response body lost: no room in the spool file");
+    res.status(500).send("Response too large");
+    return;
+  }
+
+  res.setHeader("Content-Type", contentType);
+  if (spooling) {
+    spool.close();
+    res.sendFile(RESPONSE_SPOOL_FILE);
+  } else if (strcmp(contentType, "application/json") == 0) {
+    res.sendJson(body);
+  } else {
+    res.send(body);
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef BUFFERED_RESPONSE_H
+#define BUFFERED_RESPONSE_H
+
+#include "ESPExpress.h"
+#include <FS.h>
+
+// Bodies up to this size are built in RAM; larger ones continue in the
+// spool file
+#ifndef RESPONSE_RAM_LIMIT
+#define RESPONSE_RAM_LIMIT 8192
+#endif
+#define RESPONSE_SPOOL_FILE "/response.tmp"
+
+// Print sink for responses written piece by piece. ESPExpress sends a body
+// in one call (send(), sendJson() or sendFile()), so the writes are
+// collected and go out on end(): from a String reserved up front, or, once
+// they outgrow RESPONSE_RAM_LIMIT, from a SPIFFS spool file so a large body
+// never has to fit in the heap. Handlers run one at a time on the loop
+// task, which is what makes a single spool file enough.
+class BufferedResponse : public Print {
+public:
+  BufferedResponse(Response &res, const char* contentType, size_t sizeHint = 512);
+  ~BufferedResponse();
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t size) override;
+
+  // Sends everything written so far; later writes are ignored
+  void end();
+
+private:
+  bool spill();
+
+  Response &res;
+  const char* contentType;
+  String body;
+  File spool;
+  bool spooling;
+  bool failed;
+  bool ended;
+};
+
+#endif // BUFFERED_RESPONSE_H
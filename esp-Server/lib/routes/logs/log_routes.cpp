@@ -0,0 +1,36 @@
+#include "log_routes.h"
+#include "log.h"
+#include "http/buffered_response.h"
+#include "metrics/metrics_routes.h"
+
+void registerLogRoutes(ESPExpress &app) {
+  // GET /api/logs - Everything still in the log ring buffer, oldest first
+  app.get("/api/logs", timedRoute("GET /api/logs", [](Request &req, Response &res) {
+    uint32_t position = logOldestPosition();
+    uint32_t end = logHeadPosition();
+    bool skipPartialLine = position > 0;
+
+    BufferedResponse out(res, "text/plain", end - position);
+    char chunk[128];
+    while ((int32_t)(end - position) > 0) {
+      size_t want = end - position < sizeof(chunk) ? end - position : sizeof(chunk);
+      uint32_t expected = position;
+      size_t count = readLog(position, chunk, want);
+      if (count == 0) break;
+
+      // Text we were about to send was overwritten while streaming
+      if (position - count != expected) skipPartialLine = true;
+
+      // Never start in the middle of an overwritten line
+      size_t start = 0;
+      if (skipPartialLine) {
+        while (start < count && chunk[start] != '\n') start++;
+        if (start == count) continue;
+        start++;
+        skipPartialLine = false;
+      }
+      out.write((const uint8_t*)chunk + start, count - start);
+    }
+    out.end();
+  }));
+}
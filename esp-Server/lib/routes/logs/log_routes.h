@@ -0,0 +1,9 @@
+#ifndef LOG_ROUTES_H
+#define LOG_ROUTES_H
+
+#include "ESPExpress.h"
+
+// GET /api/logs - Recent log output as plain text
+void registerLogRoutes(ESPExpress &app);
+
+#endif // LOG_ROUTES_H
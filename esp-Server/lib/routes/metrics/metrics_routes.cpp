@@ -0,0 +1,19 @@
+#include "metrics_routes.h"
+#include "http/buffered_response.h"
+
+TimedHandler timedRoute(const char* label, TimedHandler handler) {
+  MetricId metric = registerHistogram("esp_http_request_duration_us", "route", label);
+  return [metric, handler](Request &req, Response &res) {
+    ScopedTimer timer(metric);
+    handler(req, res);
+  };
+}
+
+void registerMetricsRoutes(ESPExpress &app) {
+  // GET /api/metrics - Counters, latency histograms and heap gauges
+  app.get("/api/metrics", timedRoute("GET /api/metrics", [](Request &req, Response &res) {
+    BufferedResponse out(res, "text/plain; version=0.0.4", 4096);
+    writeMetricsText(out);
+    out.end();
+  }));
+}
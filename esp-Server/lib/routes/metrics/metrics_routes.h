@@ -0,0 +1,18 @@
+#ifndef METRICS_ROUTES_H
+#define METRICS_ROUTES_H
+
+#include <functional>
+#include "ESPExpress.h"
+#include "metrics.h"
+
+typedef std::function<void(Request &, Response &)> TimedHandler;
+
+// Wraps a route handler so every call is recorded in the
+// esp_http_request_duration_us histogram under route="<label>".
+// The label is not copied; pass a string literal.
+TimedHandler timedRoute(const char* label, TimedHandler handler);
+
+// GET /api/metrics - Prometheus text format
+void registerMetricsRoutes(ESPExpress &app);
+
+#endif // METRICS_ROUTES_H
@@ -0,0 +1,275 @@
+#include "static_assets.h"
+#include "http/buffered_response.h"
+#include "metrics.h"
+#include "log.h"
+#include <SPIFFS.h>
+#include <algorithm>
+#include <vector>
+
+struct Asset {
+  String url;           // e.g. "/index.html"
+  String file;          // stored name in SPIFFS
+  String etag;          // quoted, ready for the header
+  uint32_t size;        // stored (possibly compressed) size
+  bool gzip;
+  bool immutable;
+};
+
+struct CachedAsset {
+  size_t asset;
+  std::vector<uint8_t> data;
+  uint32_t lastUsed;
+};
+
+// Sorted by url, as the build script writes them
+static std::vector<Asset> assets;
+static String urlPrefix;
+
+static std::vector<CachedAsset> cache;
+static size_t cacheBytes = 0;
+static uint32_t useClock = 0;
+
+static MetricId requestMetric = INVALID_METRIC;
+static MetricId hitMetric = INVALID_METRIC;
+static MetricId missMetric = INVALID_METRIC;
+
+// --- Manifest ---
+
+// <url> <stored file> <etag> <stored size> <flags>
+static bool parseManifestLine(char* line, Asset &asset) {
+  char* fields[5];
+  char* save = nullptr;
+  for (int i = 0; i < 5; i++) {
+    fields[i] = strtok_r(i == 0 ? line : nullptr, " \r", &save);
+    if (!fields[i]) return false;
+  }
+
+  asset.url = fields[0];
+  asset.file = fields[1];
+  asset.etag = String("\"") + fields[2] + "\"";
+  asset.size = strtoul(fields[3], nullptr, 10);
+  asset.gzip = strchr(fields[4], 'g') != nullptr;
+  asset.immutable = strchr(fields[4], 'i') != nullptr;
+  return true;
+}
+
+static bool loadManifest(const char* path) {
+  File file = SPIFFS.open(path, "r");
+  if (!file) return false;
+
+  assets.clear();
+  char line[192];
+  while (file.available()) {
+    size_t length = file.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[length] = '\0';
+    if (length == 0) continue;
+
+    Asset asset;
+    if (parseManifestLine(line, asset)) {
+      assets.push_back(asset);
+    } else {
+      LOG_ERROR("Bad asset manifest line: %s", line);
+    }
+  }
+  file.close();
+
+  std::sort(assets.begin(), assets.end(), [](const Asset &a, const Asset &b) {
+    return strcmp(a.url.c_str(), b.url.c_str()) < 0;
+  });
+  return true;
+}
+
+static const Asset* findAsset(const char* url) {
+  auto it = std::lower_bound(assets.begin(), assets.end(), url, [](const Asset &asset, const char* key) {
+    return strcmp(asset.url.c_str(), key) < 0;
+  });
+  return it != assets.end() && it->url == url ? &*it : nullptr;
+}
+
+// Directories map to their index.html, and extensionless paths to the
+// exported page (/devices -> /devices.html)
+static const Asset* resolveAsset(String url) {
+  int query = url.indexOf('?');
+  if (query >= 0) url.remove(query);
+  if (url.length() == 0 || url.endsWith("/")) url += "index.html";
+
+  const Asset* asset = findAsset(url.c_str());
+  if (!asset && url.lastIndexOf('.') < url.lastIndexOf('/')) {
+    asset = findAsset((url + ".html").c_str());
+  }
+  return asset;
+}
+
+static const char* contentTypeFor(const String &url) {
+  static const struct {
+    const char* extension;
+    const char* type;
+  } TYPES[] = {
+    {".html", "text/html"},
+    {".js", "application/javascript"},
+    {".css", "text/css"},
+    {".json", "application/json"},
+    {".map", "application/json"},
+    {".svg", "image/svg+xml"},
+    {".png", "image/png"},
+    {".jpg", "image/jpeg"},
+    {".jpeg", "image/jpeg"},
+    {".ico", "image/x-icon"},
+    {".woff2", "font/woff2"},
+    {".woff", "font/woff"},
+    {".txt", "text/plain"},
+    {".webmanifest", "application/manifest+json"},
+  };
+  for (const auto &entry : TYPES) {
+    if (url.endsWith(entry.extension)) return entry.type;
+  }
+  return "application/octet-stream";
+}
+
+// True unless the request's Accept-Encoding rules gzip out: it must list
+// gzip, x-gzip or * with a non-zero q. No header means any coding will do.
+static bool acceptsGzip(const String &header) {
+  if (header.length() == 0) return true;
+
+  int gzip = -1, any = -1;      // not listed, refused (0) or accepted (1)
+  const char* p = header.c_str();
+  while (*p) {
+    while (*p == ' ' || *p == ',') p++;
+    const char* name = p;
+    while (*p && *p != ',' && *p != ';' && *p != ' ') p++;
+    size_t length = p - name;
+
+    int accepted = 1;
+    while (*p && *p != ',') {
+      if (*p++ != ';') continue;
+      while (*p == ' ') p++;
+      if ((*p == 'q' || *p == 'Q') && p[1] == '=') accepted = strtod(p + 2, nullptr) > 0;
+    }
+
+    if ((length == 4 && strncasecmp(name, "gzip", 4) == 0) ||
+        (length == 6 && strncasecmp(name, "x-gzip", 6) == 0)) {
+      gzip = accepted;
+    } else if (length == 1 && *name == '*') {
+      any = accepted;
+    }
+  }
+  return gzip >= 0 ? gzip == 1 : any == 1;
+}
+
+// --- RAM cache ---
+
+static CachedAsset* cachedAsset(size_t asset) {
+  for (auto &entry : cache) {
+    if (entry.asset == asset) {
+      entry.lastUsed = ++useClock;
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+// Evicts least recently used files until the new one fits
+static void cacheAsset(size_t asset, std::vector<uint8_t> &data) {
+  while (!cache.empty() && cacheBytes + data.size() > STATIC_CACHE_BYTES) {
+    auto oldest = std::min_element(cache.begin(), cache.end(), [](const CachedAsset &a, const CachedAsset &b) {
+      return a.lastUsed < b.lastUsed;
+    });
+    cacheBytes -= oldest->data.size();
+    cache.erase(oldest);
+  }
+  if (cacheBytes + data.size() > STATIC_CACHE_BYTES) return;
+
+  cacheBytes += data.size();
+  cache.push_back(CachedAsset{asset, std::vector<uint8_t>(), ++useClock});
+  cache.back().data.swap(data);
+}
+
+// --- Serving ---
+
+static void serveAsset(Request &req, Response &res, const Asset &asset) {
+  // Only the gzipped copy is in flash, so a client that refuses gzip
+  // cannot be served this file
+  if (asset.gzip) {
+    res.setHeader("Vary", "Accept-Encoding");
+    if (!acceptsGzip(req.getHeader("Accept-Encoding"))) {
+      res.status(406).send("gzip encoding required");
+      return;
+    }
+  }
+
+  res.setHeader("ETag", asset.etag);
+  res.setHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  if (req.getHeader("If-None-Match") == asset.etag) {
+    res.status(304).send("");
+    return;
+  }
+
+  size_t index = &asset - assets.data();
+  CachedAsset* cached = cachedAsset(index);
+  if (!cached && !SPIFFS.exists(asset.file)) {
+    LOG_ERROR("Asset %s missing from flash (%s)", asset.url.c_str(), asset.file.c_str());
+    res.status(500).send("Asset missing");
+    return;
+  }
+
+  if (asset.gzip) res.setHeader("Content-Encoding", "gzip");
+  const char* type = contentTypeFor(asset.url);
+
+  if (cached) {
+    incrementCounter(hitMetric);
+    BufferedResponse out(res, type, cached->data.size());
+    out.write(cached->data.data(), cached->data.size());
+    out.end();
+    return;
+  }
+  incrementCounter(missMetric);
+
+  // Large files go out straight from flash
+  if (asset.size > STATIC_CACHE_MAX_FILE) {
+    res.setHeader("Content-Type", type);
+    res.sendFile(asset.file);
+    return;
+  }
+
+  // Small ones are read once and kept for next time
+  std::vector<uint8_t> copy(asset.size);
+  File file = SPIFFS.open(asset.file, "r");
+  copy.resize(file.read(copy.data(), copy.size()));
+  file.close();
+
+  BufferedResponse out(res, type, copy.size());
+  out.write(copy.data(), copy.size());
+  out.end();
+  if (copy.size() == asset.size) cacheAsset(index, copy);
+}
+
+bool registerStaticAssets(ESPExpress &app, const char* prefix, const char* manifestPath) {
+  if (!loadManifest(manifestPath)) {
+    LOG_INFO("No asset manifest at %s", manifestPath);
+    return false;
+  }
+  LOG_INFO("Serving %u asset(s) under %s", (unsigned)assets.size(), prefix);
+
+  urlPrefix = prefix;
+  requestMetric = registerHistogram("esp_http_request_duration_us", "route", "GET static");
+  hitMetric = registerCounter("esp_static_cache_hits_total");
+  missMetric = registerCounter("esp_static_cache_misses_total");
+
+  // A middleware rather than a route so any path below the prefix matches
+  app.use([](Request &req, Response &res, std::function<void()> next) {
+    if (!req.path.startsWith(urlPrefix)) {
+      next();
+      return;
+    }
+
+    const Asset* asset = resolveAsset(req.path.substring(urlPrefix.length()));
+    if (!asset) {
+      next();
+      return;
+    }
+
+    ScopedTimer timer(requestMetric);
+    serveAsset(req, res, *asset);
+  });
+  return true;
+}
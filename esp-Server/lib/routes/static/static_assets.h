@@ -0,0 +1,28 @@
+#ifndef STATIC_ASSETS_H
+#define STATIC_ASSETS_H
+
+#include "ESPExpress.h"
+
+// --- Static assets ---
+//
+// Serves the dashboard packed by scripts/build_assets.py. The manifest maps
+// each URL to a content-hashed (and usually gzipped) file in SPIFFS; files
+// are sent with Content-Encoding: gzip, an ETag answered with 304 on
+// If-None-Match, and Cache-Control: immutable for URLs that are themselves
+// content-hashed. Large files are sent straight from flash with sendFile();
+// small ones are kept in a RAM LRU cache. Only the gzipped copy is stored,
+// so a request whose Accept-Encoding refuses gzip gets 406 for those files.
+
+#define STATIC_MANIFEST "/www/manifest.txt"
+
+#ifndef STATIC_CACHE_BYTES
+#define STATIC_CACHE_BYTES 24576      // RAM for cached files, in total
+#endif
+#define STATIC_CACHE_MAX_FILE 4096    // larger files are always sent from flash
+
+// Serves prefix/<url> for every manifest entry. Returns false, registering
+// nothing, if there is no manifest (e.g. a filesystem image from before the
+// asset build step).
+bool registerStaticAssets(ESPExpress &app, const char* prefix, const char* manifestPath = STATIC_MANIFEST);
+
+#endif // STATIC_ASSETS_H
@@ -0,0 +1,81 @@
+#include "json_arena.h"
+
+JsonArena jsonArena;
+uint8_t ArenaScope::depth = 0;
+
+// Each block is preceded by its size so reallocate() knows how much to copy
+static const size_t HEADER_SIZE = 8;
+static const size_t ALIGNMENT = 8;
+
+static size_t alignUp(size_t size) {
+  return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+void* JsonArena::allocate(size_t size) {
+  size_t block = top;
+  size_t end = block + HEADER_SIZE + alignUp(size);
+  if (end > sizeof(buffer)) {
+    failed++;
+    return nullptr;
+  }
+
+  *(uint32_t*)(buffer + block) = size;
+  top = end;
+  lastBlock = block;
+  return buffer + block + HEADER_SIZE;
+}
+
+void JsonArena::deallocate(void*) {
+  // Freed all at once by reset()
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+  if (!ptr) return allocate(newSize);
+
+  size_t block = (uint8_t*)ptr - buffer - HEADER_SIZE;
+  uint32_t &oldSize = *(uint32_t*)(buffer + block);
+
+  // The newest block can grow or shrink where it is
+  if (block == lastBlock) {
+    size_t end = block + HEADER_SIZE + alignUp(newSize);
+    if (end > sizeof(buffer)) {
+      failed++;
+      return nullptr;
+    }
+    oldSize = newSize;
+    top = end;
+    return ptr;
+  }
+
+  if (newSize <= oldSize) {
+    oldSize = newSize;
+    return ptr;
+  }
+
+  void* moved = allocate(newSize);
+  if (moved) memcpy(moved, ptr, oldSize);
+  return moved;
+}
+
+void JsonArena::reset() {
+  top = 0;
+  lastBlock = SIZE_MAX;
+}
+
+void JsonArena::rewind(size_t mark) {
+  if (mark >= top) return;
+  top = mark;
+  lastBlock = SIZE_MAX;
+}
+
+JsonDocument &parseJsonMessage(const uint8_t* payload, size_t length, JsonDocument &arenaDoc,
+                               JsonDocument &heapDoc, DeserializationError &error) {
+  size_t mark = jsonArena.used();
+  error = deserializeJson(arenaDoc, payload, length);
+  if (error != DeserializationError::NoMemory) return arenaDoc;
+
+  arenaDoc.clear();
+  jsonArena.rewind(mark);
+  error = deserializeJson(heapDoc, payload, length);
+  return heapDoc;
+}
@@ -0,0 +1,64 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <ArduinoJson.h>
+
+// --- JSON arena ---
+//
+// A bump allocator over a static buffer for the JsonDocuments built while
+// handling one WebSocket message (or one round of pushes). Nothing is freed
+// individually; the whole arena is reset once the outermost ArenaScope
+// ends, so the message path never touches the heap and cannot fragment it.
+// WebSocket events are handled one at a time on the loop task, so a single
+// arena serves every connection.
+
+#ifndef WS_JSON_ARENA_SIZE
+#define WS_JSON_ARENA_SIZE 6144
+#endif
+
+class JsonArena : public ArduinoJson::Allocator {
+public:
+  void* allocate(size_t size) override;
+  void deallocate(void* ptr) override;
+  void* reallocate(void* ptr, size_t newSize) override;
+
+  void reset();
+  size_t used() const { return top; }
+
+  // Frees everything allocated since used() returned mark. Only for blocks
+  // no document refers to any more.
+  void rewind(size_t mark);
+
+  // Allocations refused because the arena was full; the document reports
+  // them as NoMemory / overflowed()
+  uint32_t failures() const { return failed; }
+
+private:
+  size_t top = 0;
+  size_t lastBlock = SIZE_MAX;    // offset of the newest block, grown in place
+  uint32_t failed = 0;
+  alignas(8) uint8_t buffer[WS_JSON_ARENA_SIZE];
+};
+
+extern JsonArena jsonArena;
+
+// Resets jsonArena when the outermost scope ends. Declare one before any
+// document that uses the arena, so the documents are gone by then.
+class ArenaScope {
+public:
+  ArenaScope() { depth++; }
+  ~ArenaScope() { if (--depth == 0) jsonArena.reset(); }
+
+private:
+  static uint8_t depth;
+};
+
+// Parses a message into arenaDoc (which must use jsonArena), or into heapDoc
+// when it does not fit the arena; rare large messages such as big batches
+// take the heap path, and the arena space the failed attempt took is given
+// back for the reply. Returns the document holding the result, with error
+// set as deserializeJson() would. Call inside an ArenaScope.
+JsonDocument &parseJsonMessage(const uint8_t* payload, size_t length, JsonDocument &arenaDoc,
+                               JsonDocument &heapDoc, DeserializationError &error);
+
+#endif // JSON_ARENA_H
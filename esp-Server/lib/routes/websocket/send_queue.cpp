@@ -0,0 +1,159 @@
+#include "send_queue.h"
+#include "websocket.h"
+#include "metrics.h"
+#include "log.h"
+#include <vector>
+
+// Payload buffers are reused when a slot is overwritten, so a steady stream
+// of similar messages stops allocating once the queues have warmed up. A
+// buffer grown past WS_SLOT_KEEP_BYTES by a one-off large message is freed
+// after sending rather than held for the life of the slot.
+struct QueuedMessage {
+  bool binary;
+  uint16_t key;
+  std::vector<uint8_t> data;    // text is stored with its terminating NUL
+};
+
+struct SendQueue {
+  QueuedMessage slots[WS_SEND_QUEUE_DEPTH];
+  uint8_t head;
+  uint8_t count;
+  bool behind;                  // dropped or failed since last running empty
+  unsigned long behindSince;
+};
+
+static SendQueue queues[WS_MAX_CLIENTS];
+static uint8_t nextClient = 0;  // round-robin start of the next drain
+
+static MetricId sentMetric = INVALID_METRIC;
+static MetricId sendFailedMetric = INVALID_METRIC;
+static MetricId droppedMetric = INVALID_METRIC;
+static MetricId coalescedMetric = INVALID_METRIC;
+static MetricId slowClientMetric = INVALID_METRIC;
+static MetricId depthMetric = INVALID_METRIC;
+static MetricId maxDepthMetric = INVALID_METRIC;
+
+void initSendQueues() {
+  sentMetric = registerCounter("esp_ws_messages_sent_total");
+  sendFailedMetric = registerCounter("esp_ws_send_failures_total");
+  droppedMetric = registerCounter("esp_ws_messages_dropped_total");
+  coalescedMetric = registerCounter("esp_ws_messages_coalesced_total");
+  slowClientMetric = registerCounter("esp_ws_slow_clients_dropped_total");
+  depthMetric = registerGauge("esp_ws_send_queue_depth");
+  maxDepthMetric = registerGauge("esp_ws_send_queue_max_depth");
+}
+
+void resetSendQueue(uint8_t num) {
+  if (num >= WS_MAX_CLIENTS) return;
+  queues[num].head = 0;
+  queues[num].count = 0;
+  queues[num].behind = false;
+}
+
+static QueuedMessage &slotAt(SendQueue &queue, uint8_t offset) {
+  return queue.slots[(queue.head + offset) % WS_SEND_QUEUE_DEPTH];
+}
+
+static void markBehind(SendQueue &queue) {
+  if (!queue.behind) {
+    queue.behind = true;
+    queue.behindSince = millis();
+  }
+}
+
+static size_t payloadSize(const QueuedMessage &message) {
+  return message.data.size() - (message.binary ? 0 : 1);   // text NUL
+}
+
+static bool enqueue(uint8_t num, bool binary, const uint8_t* data, size_t length, bool terminate, uint16_t key) {
+  if (num >= WS_MAX_CLIENTS) return false;
+  SendQueue &queue = queues[num];
+
+  QueuedMessage* slot = nullptr;
+  if (key != WS_NO_COALESCE) {
+    for (uint8_t i = 0; i < queue.count; i++) {
+      QueuedMessage &queued = slotAt(queue, i);
+      if (queued.key == key) {
+        slot = &queued;
+        incrementCounter(coalescedMetric);
+        break;
+      }
+    }
+  }
+
+  if (!slot) {
+    if (queue.count >= WS_SEND_QUEUE_DEPTH) {
+      incrementCounter(droppedMetric);
+      markBehind(queue);
+      return false;
+    }
+    slot = &slotAt(queue, queue.count);
+    queue.count++;
+  }
+
+  slot->binary = binary;
+  slot->key = key;
+  slot->data.assign(data, data + length);
+  if (terminate) slot->data.push_back(0);
+  return true;
+}
+
+bool queueText(uint8_t num, const char* text, size_t length, uint16_t key) {
+  return enqueue(num, false, (const uint8_t*)text, length, true, key);
+}
+
+bool queueBinary(uint8_t num, const uint8_t* data, size_t length, uint16_t key) {
+  return enqueue(num, true, data, length, false, key);
+}
+
+void drainSendQueues(ESPExpress &app) {
+  unsigned long now = millis();
+  uint32_t depth = 0;
+  uint32_t maxDepth = 0;
+
+  for (uint8_t n = 0; n < WS_MAX_CLIENTS; n++) {
+    uint8_t num = (nextClient + n) % WS_MAX_CLIENTS;
+    SendQueue &queue = queues[num];
+
+    if (queue.behind && now - queue.behindSince >= WS_SLOW_CLIENT_MS) {
+      LOG_INFO("WS client %u too slow, disconnecting", num);
+      incrementCounter(slowClientMetric);
+      resetSendQueue(num);
+      app.wsDisconnect(num);
+      continue;
+    }
+
+    bool failed = false;
+    size_t bytes = 0;
+    for (uint8_t sent = 0; sent < WS_DRAIN_PER_CLIENT && queue.count > 0; sent++) {
+      QueuedMessage &message = queue.slots[queue.head];
+      bytes += payloadSize(message);
+      if (sent > 0 && bytes > WS_DRAIN_BYTES_PER_CLIENT) break;   // the rest waits for the next pass
+
+      bool ok = message.binary
+        ? app.wsSendBIN(num, message.data.data(), message.data.size())
+        : app.wsSendTXT(num, (const char*)message.data.data());
+      incrementCounter(ok ? sentMetric : sendFailedMetric);
+      if (message.data.capacity() > WS_SLOT_KEEP_BYTES) {
+        std::vector<uint8_t>().swap(message.data);
+      }
+
+      // A failed send is not retried; the library closes broken connections
+      queue.head = (queue.head + 1) % WS_SEND_QUEUE_DEPTH;
+      queue.count--;
+      if (!ok) {
+        failed = true;
+        markBehind(queue);
+        break;
+      }
+    }
+    if (queue.count == 0 && !failed) queue.behind = false;
+
+    depth += queue.count;
+    if (queue.count > maxDepth) maxDepth = queue.count;
+  }
+
+  nextClient = (nextClient + 1) % WS_MAX_CLIENTS;
+  setGauge(depthMetric, depth);
+  setGauge(maxDepthMetric, maxDepth);
+}
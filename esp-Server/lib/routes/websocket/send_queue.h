@@ -0,0 +1,46 @@
+#ifndef SEND_QUEUE_H
+#define SEND_QUEUE_H
+
+#include "ESPExpress.h"
+
+// --- Outbound queues ---
+//
+// Messages to WebSocket clients are queued per client and sent from loop()
+// by drainSendQueues(), a few per client per pass in round-robin order, so a
+// client on a slow link cannot hold up the others or the HTTP server. Each
+// pass hands a client at most WS_DRAIN_BYTES_PER_CLIENT bytes (a larger
+// message goes out alone), which bounds how long one pass can spend
+// writing to a socket.
+//
+// A message may carry a coalescing key (e.g. one per sensor stream): queuing
+// a message whose key is already waiting replaces the waiting one, so the
+// latest value wins. A message that finds the queue full and nothing to
+// replace is dropped, and a client that stays backed up (dropping, or with
+// sends failing) for WS_SLOW_CLIENT_MS is disconnected.
+
+#ifndef WS_SEND_QUEUE_DEPTH
+#define WS_SEND_QUEUE_DEPTH 16          // messages per client
+#endif
+#define WS_DRAIN_PER_CLIENT 4           // messages per client and loop pass
+#define WS_DRAIN_BYTES_PER_CLIENT 2048  // payload bytes per client and loop pass
+#define WS_SLOW_CLIENT_MS 10000
+#define WS_SLOT_KEEP_BYTES 512          // larger payload buffers are freed once sent
+
+#define WS_NO_COALESCE 0
+
+// Sets up the queue metrics. Call once before queuing anything.
+void initSendQueues();
+
+// Forgets everything queued for a client; call when it connects or leaves
+void resetSendQueue(uint8_t num);
+
+// Both return false if the message was dropped. num must be below
+// WS_MAX_CLIENTS.
+bool queueText(uint8_t num, const char* text, size_t length, uint16_t key = WS_NO_COALESCE);
+bool queueBinary(uint8_t num, const uint8_t* data, size_t length, uint16_t key = WS_NO_COALESCE);
+
+// Sends queued messages and disconnects clients that fell too far behind.
+// Call from loop().
+void drainSendQueues(ESPExpress &app);
+
+#endif // SEND_QUEUE_H
@@ -1,120 +1,785 @@
 #include <ArduinoJson.h>
 #include "websocket.h"
+#include "send_queue.h"
+#include "json_arena.h"
+#include "devices/devices.h"
+#include "devices/device_json.h"
+#include "metrics.h"
+#include "log.h"
+#include "sensors.h"
+#include "led_strip.h"
+#include <StreamString.h>
 #include <stdint.h> // For uint8_t type
 
-// Make sure ESPExpress is defined somewhere, likely in websocket.h
-// If not, you'll need to include the appropriate header file for your ESP framework
+// --- Sensor streaming ---
 
-void sendSensorUpdate(ESPExpress &app, uint8_t clientNum, const char* deviceId, const char* sensorType, float value) {
-  // Create a JSON document
-  DynamicJsonDocument doc(256);
+// One stream per device/sensor pair, shared by every client subscribed to it.
+// Subscribers are kept as a bitmask of WebSocket client numbers.
+struct SensorStream {
+  bool active;
+  String deviceId;
+  uint8_t sensorIndex;                        // SensorQuantity
+  uint32_t subscribers;                       // bit n set => client n subscribed
+  uint32_t requestedInterval[WS_MAX_CLIENTS]; // per-client requested rate (ms)
+  uint32_t intervalMs;                        // fastest rate requested by any subscriber
+  unsigned long nextSampleAt;
+};
+
+static SensorStream streams[MAX_SENSOR_STREAMS];
+
+// Clients that asked for binary telemetry, and the frame each one is
+// collecting during the current streaming pass
+static uint32_t binaryClients = 0;
+
+struct TelemetryFrame {
+  uint16_t count;
+  uint8_t data[WS_TELEMETRY_HEADER_SIZE + MAX_SENSOR_STREAMS * WS_TELEMETRY_RECORD_SIZE];
+};
+
+static TelemetryFrame telemetryFrames[WS_MAX_CLIENTS];
+
+// --- Metrics ---
+
+static MetricId messageMetric = INVALID_METRIC;
+static MetricId receivedMetric = INVALID_METRIC;
+static MetricId sentMetric = INVALID_METRIC;
+static MetricId sendFailedMetric = INVALID_METRIC;
+
+// Clients that asked for periodic metrics pushes
+static uint32_t metricsSubscribers = 0;
+static uint32_t metricsInterval[WS_MAX_CLIENTS];
+static unsigned long nextMetricsAt[WS_MAX_CLIENTS];
+
+// Coalescing key for metrics pushes; stream readings use stream index + 1
+static const uint16_t METRICS_KEY = 0xFFFF;
+
+// --- Message buffers ---
+//
+// Steady-state traffic does not touch the heap: documents live in
+// jsonArena, serialized text goes to messageBuffer, and the constant
+// payloads are built once in registerWebSocketRoutes().
+
+#define WS_MESSAGE_BUFFER_SIZE 1024
+
+static char messageBuffer[WS_MESSAGE_BUFFER_SIZE];
+static String welcomeMessage;
+static String supportedTypesJson;      // ["temperature",...]
+static StreamString metricsJson;       // keeps its capacity between pushes
+static StreamString rpcListJson;       // same, for RPC device lists
+
+// Every outgoing frame goes through here. Clients that can subscribe get it
+// through their send queue; any others are sent to directly.
+static void sendText(ESPExpress &app, uint8_t num, const char* text, size_t length, uint16_t key = WS_NO_COALESCE) {
+  if (num < WS_MAX_CLIENTS) {
+    queueText(num, text, length, key);
+    return;
+  }
+  incrementCounter(app.wsSendTXT(num, text) ? sentMetric : sendFailedMetric);
+}
+
+static void sendBinary(ESPExpress &app, uint8_t num, const uint8_t* data, size_t length) {
+  if (num < WS_MAX_CLIENTS) {
+    queueBinary(num, data, length);
+    return;
+  }
+  incrementCounter(app.wsSendBIN(num, data, length) ? sentMetric : sendFailedMetric);
+}
+
+// Reads through the sensor drivers; repeated reads of the same sensor are
+// served from their cache
+static SensorReadStatus readStreamValue(const char* deviceId, uint8_t sensorIndex, float &value) {
+  return readSensor(devices.find(deviceId), sensorIndex, value);
+}
+
+static SensorStream* findStream(const char* deviceId, int sensorIndex) {
+  for (auto &stream : streams) {
+    if (stream.active && stream.sensorIndex == sensorIndex && stream.deviceId == deviceId) {
+      return &stream;
+    }
+  }
+  return nullptr;
+}
+
+// Recompute the stream rate from its remaining subscribers
+static void refreshStreamInterval(SensorStream &stream) {
+  uint32_t interval = 0;
+  for (uint8_t num = 0; num < WS_MAX_CLIENTS; num++) {
+    if ((stream.subscribers & (1UL << num)) && (interval == 0 || stream.requestedInterval[num] < interval)) {
+      interval = stream.requestedInterval[num];
+    }
+  }
+  stream.intervalMs = interval;
+  if (stream.subscribers == 0) {
+    stream.active = false;
+    stream.deviceId = "";
+  }
+}
+
+// Serializes a reading into messageBuffer and returns its length
+static size_t buildSensorJson(const char* deviceId, const char* sensorType, float value) {
+  char valueText[16];
+  snprintf(valueText, sizeof(valueText), "%.2f", value);
+
+  ArenaScope scope;
+  JsonDocument doc(&jsonArena);
   doc["deviceId"] = deviceId;
   doc["sensor"] = sensorType;
-  doc["value"] = String(value, 2);
-  
-  // Serialize to string
-  String sensorJson;
-  serializeJson(doc, sensorJson);
-  
-  Serial.println("Sending update to client " + String(clientNum) + ": " + sensorJson);
+  doc["value"] = valueText;
+  return serializeJson(doc, messageBuffer, sizeof(messageBuffer));
+}
+
+// --- Telemetry frames ---
+
+static void putU16(uint8_t* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+}
+
+static void putU32(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out[i] = (value >> (8 * i)) & 0xFF;
+}
+
+static void appendTelemetry(uint8_t num, uint8_t streamIndex, uint8_t sensor, uint32_t timestamp, float value) {
+  TelemetryFrame &frame = telemetryFrames[num];
+  if (frame.count >= MAX_SENSOR_STREAMS) return;  // one record per stream and pass at most
+
+  uint8_t* record = frame.data + WS_TELEMETRY_HEADER_SIZE + frame.count * WS_TELEMETRY_RECORD_SIZE;
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  record[0] = streamIndex;
+  record[1] = sensor;
+  putU16(record + 2, 0);
+  putU32(record + 4, timestamp);
+  putU32(record + 8, bits);
+  frame.count++;
+}
+
+static uint16_t getU16(const uint8_t* in) {
+  return in[0] | (in[1] << 8);
+}
+
+// Sends and resets every frame that collected records
+static void flushTelemetry(ESPExpress &app) {
+  for (uint8_t num = 0; num < WS_MAX_CLIENTS; num++) {
+    TelemetryFrame &frame = telemetryFrames[num];
+    if (frame.count == 0) continue;
+
+    frame.data[0] = WS_TELEMETRY_VERSION;
+    frame.data[1] = WS_FRAME_TELEMETRY;
+    putU16(frame.data + 2, frame.count);
+    sendBinary(app, num, frame.data, WS_TELEMETRY_HEADER_SIZE + frame.count * WS_TELEMETRY_RECORD_SIZE);
+    frame.count = 0;
+  }
+}
+
+// Push one reading to every subscriber of a stream. Binary clients get it in
+// their next telemetry frame; the JSON text is only built if someone needs it.
+static void publishStream(ESPExpress &app, SensorStream &stream, float value) {
+  uint8_t streamIndex = &stream - streams;
+  uint32_t now = millis();
+  size_t jsonLength = 0;
+  for (uint8_t num = 0; num < WS_MAX_CLIENTS; num++) {
+    if (!(stream.subscribers & (1UL << num))) continue;
+
+    if (binaryClients & (1UL << num)) {
+      appendTelemetry(num, streamIndex, stream.sensorIndex, now, value);
+      continue;
+    }
+    if (jsonLength == 0) {
+      jsonLength = buildSensorJson(stream.deviceId.c_str(), sensorQuantityName(stream.sensorIndex), value);
+    }
+    sendText(app, num, messageBuffer, jsonLength, streamIndex + 1);
+  }
+}
+
+static void sendJsonMessage(ESPExpress &app, uint8_t num, JsonDocument &doc) {
+  size_t length = measureJson(doc);
+  if (length < sizeof(messageBuffer)) {
+    serializeJson(doc, messageBuffer, sizeof(messageBuffer));
+    sendText(app, num, messageBuffer, length);
+    return;
+  }
+
+  // Only large batch replies end up here
+  String json;
+  serializeJson(doc, json);
+  sendText(app, num, json.c_str(), json.length());
+}
+
+static void sendError(ESPExpress &app, uint8_t num, const char* message) {
+  ArenaScope scope;
+  JsonDocument errorDoc(&jsonArena);
+  errorDoc["error"] = message;
+  sendJsonMessage(app, num, errorDoc);
+}
+
+static void sendUnknownSensorError(ESPExpress &app, uint8_t num, const char* sensorType) {
+  char message[64];
+  snprintf(message, sizeof(message), "Unknown sensor type: %s", sensorType);
+
+  ArenaScope scope;
+  JsonDocument errorDoc(&jsonArena);
+  errorDoc["error"] = message;
+  errorDoc["supportedTypes"] = serialized(supportedTypesJson.c_str());
+  sendJsonMessage(app, num, errorDoc);
+}
+
+// Returns the stream index, or -1 if every stream slot is taken. Callers
+// check that the device is registered first.
+static int subscribeClient(uint8_t num, const char* deviceId, int sensorIndex, uint32_t interval) {
+  SensorStream* stream = findStream(deviceId, sensorIndex);
+  if (!stream) {
+    for (auto &candidate : streams) {
+      if (!candidate.active) {
+        stream = &candidate;
+        stream->active = true;
+        stream->deviceId = deviceId;
+        stream->sensorIndex = sensorIndex;
+        stream->subscribers = 0;
+        break;
+      }
+    }
+    if (!stream) return -1;
+  }
+
+  stream->subscribers |= (1UL << num);
+  stream->requestedInterval[num] = interval;
+  refreshStreamInterval(*stream);
+
+  // Deliver the first reading on the next scheduler pass
+  stream->nextSampleAt = millis();
+  return stream - streams;
+}
+
+static bool unsubscribeClient(uint8_t num, const char* deviceId, int sensorIndex) {
+  SensorStream* stream = findStream(deviceId, sensorIndex);
+  if (!stream || !(stream->subscribers & (1UL << num))) return false;
+
+  stream->subscribers &= ~(1UL << num);
+  refreshStreamInterval(*stream);
+  return true;
+}
+
+static void unsubscribeAll(uint8_t num) {
+  for (auto &stream : streams) {
+    if (stream.active && (stream.subscribers & (1UL << num))) {
+      stream.subscribers &= ~(1UL << num);
+      refreshStreamInterval(stream);
+    }
+  }
+}
+
+void sendSensorUpdate(ESPExpress &app, uint8_t clientNum, const char* deviceId, const char* sensorType, float value) {
+  size_t length = buildSensorJson(deviceId, sensorType, value);
+  LOG_DEBUG("Sending update to client %u: %s", clientNum, messageBuffer);
   // Send only to the requesting client instead of broadcasting
-  app.wsSendTXT(clientNum, sensorJson);
+  sendText(app, clientNum, messageBuffer, length);
+}
+
+void sendTemperatureUpdate(ESPExpress &app, float temperature) {
+  // Push an externally obtained reading to every temperature subscriber
+  for (auto &stream : streams) {
+    if (stream.active && stream.sensorIndex == SENSOR_TEMPERATURE) {
+      publishStream(app, stream, temperature);
+    }
+  }
+  flushTelemetry(app);
+}
+
+void handleSensorStreams(ESPExpress &app) {
+  unsigned long now = millis();
+  for (auto &stream : streams) {
+    if (!stream.active || (long)(now - stream.nextSampleAt) < 0) continue;
+
+    // A failed read skips this period; subscribers just see a gap
+    float value;
+    if (readStreamValue(stream.deviceId.c_str(), stream.sensorIndex, value) == SENSOR_OK) {
+      publishStream(app, stream, value);
+    }
+
+    // Stay on the fixed schedule; only resync if we fell more than a period behind
+    stream.nextSampleAt += stream.intervalMs;
+    if ((long)(now - stream.nextSampleAt) >= 0) {
+      stream.nextSampleAt = now + stream.intervalMs;
+    }
+  }
+  flushTelemetry(app);
+}
+
+void handleMetricsPush(ESPExpress &app) {
+  if (metricsSubscribers == 0) return;
+
+  // Serialize at most once per pass, and only if someone is due
+  unsigned long now = millis();
+  bool serialized = false;
+  for (uint8_t num = 0; num < WS_MAX_CLIENTS; num++) {
+    if (!(metricsSubscribers & (1UL << num)) || (long)(now - nextMetricsAt[num]) < 0) continue;
+
+    if (!serialized) {
+      metricsJson.remove(0);   // empties it but keeps the buffer
+      writeMetricsJson(metricsJson);
+      serialized = true;
+    }
+    sendText(app, num, metricsJson.c_str(), metricsJson.length(), METRICS_KEY);
+    nextMetricsAt[num] = now + metricsInterval[num];
+  }
+}
+
+// {"type":"metrics","interval":ms} starts pushes, interval 0 stops them
+static void handleMetricsRequest(ESPExpress &app, uint8_t num, JsonDocument &doc) {
+  long interval = doc["interval"] | METRICS_PUSH_INTERVAL_MS;
+  if (interval <= 0) {
+    metricsSubscribers &= ~(1UL << num);
+  } else {
+    if (interval < MIN_STREAM_INTERVAL_MS) interval = MIN_STREAM_INTERVAL_MS;
+    metricsSubscribers |= (1UL << num);
+    metricsInterval[num] = interval;
+    nextMetricsAt[num] = millis();
+  }
+
+  JsonDocument reply(&jsonArena);
+  reply["type"] = interval > 0 ? "metricsSubscribed" : "metricsUnsubscribed";
+  if (interval > 0) reply["interval"] = interval;
+  sendJsonMessage(app, num, reply);
+}
+
+static void handleSubscribe(ESPExpress &app, uint8_t num, JsonDocument &doc, bool subscribe) {
+  const char* deviceId = doc["deviceId"];
+  const char* sensorType = doc["sensor"];
+  if (!deviceId || !sensorType) {
+    sendError(app, num, "Missing required fields: deviceId or sensor");
+    return;
+  }
+
+  int sensorIndex = findSensorQuantity(sensorType);
+  if (sensorIndex < 0) {
+    sendUnknownSensorError(app, num, sensorType);
+    return;
+  }
+
+  JsonDocument reply(&jsonArena);
+  reply["deviceId"] = deviceId;
+  reply["sensor"] = sensorType;
+
+  if (subscribe) {
+    if (!devices.find(deviceId)) {
+      sendError(app, num, "Device not found");
+      return;
+    }
+    long interval = doc["interval"] | DEFAULT_STREAM_INTERVAL_MS;
+    if (interval < MIN_STREAM_INTERVAL_MS) interval = MIN_STREAM_INTERVAL_MS;
+
+    int streamIndex = subscribeClient(num, deviceId, sensorIndex, interval);
+    if (streamIndex < 0) {
+      sendError(app, num, "Too many active sensor streams");
+      return;
+    }
+    reply["type"] = "subscribed";
+    reply["interval"] = interval;
+    reply["stream"] = streamIndex;
+  } else {
+    if (!unsubscribeClient(num, deviceId, sensorIndex)) {
+      char message[96];
+      snprintf(message, sizeof(message), "Not subscribed to %s/%s", deviceId, sensorType);
+      sendError(app, num, message);
+      return;
+    }
+    reply["type"] = "unsubscribed";
+  }
+  sendJsonMessage(app, num, reply);
+}
+
+// {"type":"hello","format":"binary"|"json"} picks how stream readings are sent
+static void handleHello(ESPExpress &app, uint8_t num, JsonDocument &doc) {
+  const char* format = doc["format"] | "json";
+  if (strcmp(format, "binary") == 0) {
+    binaryClients |= (1UL << num);
+  } else if (strcmp(format, "json") == 0) {
+    binaryClients &= ~(1UL << num);
+  } else {
+    char message[64];
+    snprintf(message, sizeof(message), "Unknown format: %s", format);
+    sendError(app, num, message);
+    return;
+  }
+
+  JsonDocument reply(&jsonArena);
+  reply["type"] = "hello";
+  reply["format"] = format;
+  if (binaryClients & (1UL << num)) reply["version"] = WS_TELEMETRY_VERSION;
+  sendJsonMessage(app, num, reply);
+}
+
+static void handleBatch(ESPExpress &app, uint8_t num, JsonDocument &doc) {
+  JsonArray updates = doc["updates"].as<JsonArray>();
+  if (updates.isNull()) {
+    sendError(app, num, "Missing updates array");
+    return;
+  }
+
+  // Up to MAX_BATCH_ITEMS results may not fit the arena; batches are rare
+  JsonDocument reply;
+  reply["type"] = "batch";
+  JsonArray results = reply["results"].to<JsonArray>();
+  BatchStatus status = applyDeviceBatch(updates, results);
+  reply["status"] = batchStatusName(status);
+  sendJsonMessage(app, num, reply);
+}
+
+// --- RPC ---
+
+static void rpcError(JsonDocument &reply, int status, const char* message) {
+  reply["ok"] = false;
+  reply["status"] = status;
+  reply["error"] = message;
+}
+
+static void rpcResult(JsonDocument &reply, const DeviceOpResult &result) {
+  if (result.ok()) {
+    reply["result"] = result.message;
+  } else {
+    rpcError(reply, result.status, result.message);
+  }
+}
+
+// The list is streamed into the message text instead of going through a
+// document, like GET /api/devices
+static void sendRpcDeviceList(ESPExpress &app, uint8_t num, uint32_t id, JsonVariant since) {
+  rpcListJson.remove(0);
+  rpcListJson.print("{\"id\":");
+  rpcListJson.print(id);
+  rpcListJson.print(",\"ok\":true,\"result\":");
+  if (since.isNull()) {
+    writeDevicesJson(rpcListJson);
+  } else {
+    writeDeviceChangesJson(rpcListJson, since.as<uint32_t>());
+  }
+  rpcListJson.print('}');
+  sendText(app, num, rpcListJson.c_str(), rpcListJson.length());
+}
+
+static void rpcSetState(JsonDocument &reply, const char* deviceId, JsonVariant state) {
+  if (!deviceId || state.isNull()) {
+    rpcError(reply, 400, "Missing id or state");
+    return;
+  }
+
+  char stateBuffer[STATE_STRING_MAX];
+  const char* text = deviceStateText(state, stateBuffer, sizeof(stateBuffer));
+  if (!text) {
+    rpcError(reply, 400, "Invalid state update");
+    return;
+  }
+  rpcResult(reply, setDeviceState(deviceId, text));
+}
+
+static void rpcBatch(ESPExpress &app, uint8_t num, uint32_t id, JsonArray updates) {
+  JsonDocument reply;   // see handleBatch()
+  reply["id"] = id;
+  if (updates.isNull()) {
+    rpcError(reply, 400, "Missing updates array");
+  } else {
+    JsonObject result = reply["result"].to<JsonObject>();
+    BatchStatus status = applyDeviceBatch(updates, result["results"].to<JsonArray>());
+    result["status"] = batchStatusName(status);
+    if (status == BATCH_INVALID) {
+      rpcError(reply, 400, "Invalid batch");
+    } else {
+      reply["ok"] = true;
+    }
+  }
+  sendJsonMessage(app, num, reply);
+}
+
+static void rpcReadSensor(JsonDocument &reply, const char* deviceId, const char* sensorType) {
+  int quantity = sensorType ? findSensorQuantity(sensorType) : -1;
+  if (!deviceId || quantity < 0) {
+    rpcError(reply, 400, "Missing deviceId or unknown sensor");
+    return;
+  }
+
+  float value;
+  SensorReadStatus status = readStreamValue(deviceId, quantity, value);
+  if (status == SENSOR_OK) {
+    reply["result"] = value;
+  } else if (status == SENSOR_UNSUPPORTED) {
+    rpcError(reply, 404, "Sensor not available on this device");
+  } else {
+    rpcError(reply, 503, "Sensor read failed");
+  }
+}
+
+static void rpcSubscribe(JsonDocument &reply, uint8_t num, JsonObject params, bool subscribe) {
+  const char* deviceId = params["deviceId"];
+  const char* sensorType = params["sensor"];
+  int quantity = sensorType ? findSensorQuantity(sensorType) : -1;
+  if (num >= WS_MAX_CLIENTS) {
+    rpcError(reply, 403, "Client cannot subscribe");
+    return;
+  }
+  if (!deviceId || quantity < 0) {
+    rpcError(reply, 400, "Missing deviceId or unknown sensor");
+    return;
+  }
+
+  if (!subscribe) {
+    if (unsubscribeClient(num, deviceId, quantity)) {
+      reply["result"] = true;
+    } else {
+      rpcError(reply, 404, "Not subscribed");
+    }
+    return;
+  }
+
+  if (!devices.find(deviceId)) {
+    rpcError(reply, 404, "Device not found");
+    return;
+  }
+  long interval = params["interval"] | DEFAULT_STREAM_INTERVAL_MS;
+  if (interval < MIN_STREAM_INTERVAL_MS) interval = MIN_STREAM_INTERVAL_MS;
+  int streamIndex = subscribeClient(num, deviceId, quantity, interval);
+  if (streamIndex < 0) {
+    rpcError(reply, 503, "Too many active sensor streams");
+    return;
+  }
+  JsonObject result = reply["result"].to<JsonObject>();
+  result["stream"] = streamIndex;
+  result["interval"] = interval;
+}
+
+// {"id": n, "method": ..., "params": {...}}, see websocket.h
+static void handleRpc(ESPExpress &app, uint8_t num, JsonDocument &doc) {
+  JsonVariant idVar = doc["id"];
+  if (!idVar.is<uint32_t>()) {
+    sendError(app, num, "RPC requests need a numeric id");
+    return;
+  }
+  uint32_t id = idVar.as<uint32_t>();
+  const char* method = doc["method"];
+  JsonObject params = doc["params"].as<JsonObject>();
+
+  // These build their own reply
+  if (strcmp(method, "list") == 0) {
+    JsonVariant since = params["since"];
+    if (since.isNull() || since.is<uint32_t>()) {
+      sendRpcDeviceList(app, num, id, since);
+      return;
+    }
+  } else if (strcmp(method, "batch") == 0) {
+    rpcBatch(app, num, id, params["updates"].as<JsonArray>());
+    return;
+  }
+
+  JsonDocument reply(&jsonArena);
+  reply["id"] = id;
+  reply["ok"] = true;
+  const char* deviceId = params["id"];
+
+  if (strcmp(method, "list") == 0) {
+    rpcError(reply, 400, "Invalid since parameter");
+  } else if (strcmp(method, "get") == 0) {
+    const Device* device = deviceId ? devices.find(deviceId) : nullptr;
+    if (device) {
+      deviceToJson(*device, reply["result"].to<JsonObject>());
+    } else {
+      rpcError(reply, 404, "Device not found");
+    }
+  } else if (strcmp(method, "setState") == 0) {
+    rpcSetState(reply, deviceId, params["state"]);
+  } else if (strcmp(method, "setPins") == 0) {
+    if (deviceId) {
+      rpcResult(reply, setDevicePins(deviceId, params["pins"].as<JsonArray>()));
+    } else {
+      rpcError(reply, 400, "Missing id");
+    }
+  } else if (strcmp(method, "read") == 0) {
+    rpcReadSensor(reply, params["deviceId"], params["sensor"]);
+  } else if (strcmp(method, "subscribe") == 0 || strcmp(method, "unsubscribe") == 0) {
+    rpcSubscribe(reply, num, params, strcmp(method, "subscribe") == 0);
+  } else {
+    rpcError(reply, 404, "Unknown method");
+  }
+  sendJsonMessage(app, num, reply);
+}
+
+// --- LED frames ---
+
+static void handleLedFrame(ESPExpress &app, uint8_t num, const uint8_t* payload, size_t length) {
+  if (length < 3 || payload[0] != WS_TELEMETRY_VERSION
+      || (payload[1] != WS_FRAME_LED_PIXELS && payload[1] != WS_FRAME_LED_FILL)) {
+    sendError(app, num, "Unknown binary frame");
+    return;
+  }
+
+  uint8_t idLength = payload[2];
+  if (idLength > WS_LED_ID_MAX || length < 3 + idLength + 4u) {
+    sendError(app, num, "Malformed LED frame");
+    return;
+  }
+  const uint8_t* body = payload + 3 + idLength;
+  uint16_t start = getU16(body);
+  uint16_t count = getU16(body + 2);
+  size_t colourBytes = payload[1] == WS_FRAME_LED_PIXELS ? (size_t)count * 3 : 3;
+  if (length != 3 + idLength + 4u + colourBytes) {
+    sendError(app, num, "Malformed LED frame");
+    return;
+  }
+
+  char id[WS_LED_ID_MAX + 1];
+  memcpy(id, payload + 3, idLength);
+  id[idLength] = '\0';
+  Device* device = devices.find(id);
+  if (!device || device->kind != LED_STRIP_KIND || ledStripPixelCount(device->handle) == 0) {
+    sendError(app, num, "No such LED strip");
+    return;
+  }
+
+  const uint8_t* colours = body + 4;
+  bool ok = payload[1] == WS_FRAME_LED_PIXELS
+    ? ledStripSetPixels(device->handle, start, count, colours)
+    : ledStripFill(device->handle, start, count, colours[0], colours[1], colours[2]);
+  if (!ok) sendError(app, num, "Pixel range outside the strip");
 }
 
 void registerWebSocketRoutes(ESPExpress &app) {
+  messageMetric = registerHistogram("esp_ws_message_duration_us");
+  receivedMetric = registerCounter("esp_ws_messages_received_total");
+  sentMetric = registerCounter("esp_ws_messages_sent_total");
+  sendFailedMetric = registerCounter("esp_ws_send_failures_total");
+  initSendQueues();
+
+  // Constant payloads, built once instead of on every connect or error
+  {
+    ArenaScope scope;
+    JsonDocument types(&jsonArena);
+    JsonArray sensors = types.to<JsonArray>();
+    for (uint8_t i = 0; i < SENSOR_QUANTITY_COUNT; i++) {
+      sensors.add(sensorQuantityName(i));
+    }
+    serializeJson(types, supportedTypesJson);
+
+    JsonDocument welcomeDoc(&jsonArena);
+    welcomeDoc["type"] = "info";
+    welcomeDoc["message"] = "Connected to ESP32 sensor hub";
+    welcomeDoc["supportedSensors"] = serialized(supportedTypesJson.c_str());
+    serializeJson(welcomeDoc, welcomeMessage);
+  }
+
   app.ws("/ws", [&app](uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
     switch (type) {
       case WStype_CONNECTED: {
-        Serial.printf("WS client %u connected\n", num);
-        
+        LOG_INFO("WS client %u connected", num);
+        resetSendQueue(num);
+
         // Send welcome message with supported sensors
-        DynamicJsonDocument welcomeDoc(512);
-        welcomeDoc["type"] = "info";
-        welcomeDoc["message"] = "Connected to ESP32 sensor hub";
-        welcomeDoc["supportedSensors"] = JsonArray();
-        
-        // Add supported sensors to the array
-        JsonArray sensors = welcomeDoc["supportedSensors"];
-        sensors.add("temperature");
-        sensors.add("humidity");
-        sensors.add("pressure");
-        sensors.add("light");
-        
-        String welcomeJson;
-        serializeJson(welcomeDoc, welcomeJson);
-        app.wsSendTXT(num, welcomeJson);
+        sendText(app, num, welcomeMessage.c_str(), welcomeMessage.length());
         break;
       }
       case WStype_DISCONNECTED:
-        Serial.printf("WS client %u disconnected\n", num);
+        LOG_INFO("WS client %u disconnected", num);
+        if (num < WS_MAX_CLIENTS) {
+          unsubscribeAll(num);
+          metricsSubscribers &= ~(1UL << num);
+          binaryClients &= ~(1UL << num);
+          telemetryFrames[num].count = 0;
+          resetSendQueue(num);
+        }
         break;
       case WStype_TEXT: {
-        Serial.printf("WS message from %u: %s\n", num, payload);
-        
-        // Parse incoming JSON payload.
-        DynamicJsonDocument doc(256);
-        DeserializationError error = deserializeJson(doc, payload, length);
+        LOG_DEBUG("WS message from %u: %.*s", num, (int)length, (const char*)payload);
+        incrementCounter(receivedMetric);
+        ScopedTimer timer(messageMetric);
+
+        // Parse incoming JSON payload. Replies are built in the same arena,
+        // which is reset once this message is done.
+        ArenaScope arenaScope;
+        JsonDocument arenaDoc(&jsonArena);
+        JsonDocument heapDoc;
+        DeserializationError error;
+        JsonDocument &doc = parseJsonMessage(payload, length, arenaDoc, heapDoc, error);
         if (error) {
-          Serial.println("Failed to parse JSON");
-          
-          // Send error message back to client
-          DynamicJsonDocument errorDoc(128);
-          errorDoc["error"] = "Failed to parse JSON request";
-          String errorJson;
-          serializeJson(errorDoc, errorJson);
-          app.wsSendTXT(num, errorJson);
+          LOG_DEBUG("WS client %u sent invalid JSON: %s", num, error.c_str());
+          sendError(app, num, "Failed to parse JSON request");
           break;
         }
-        
+
+        // Request-id-tagged RPC; replies carry the same id
+        if (doc["method"].is<const char*>()) {
+          handleRpc(app, num, doc);
+          break;
+        }
+
+        // Subscription messages: the scheduler pushes updates from then on
+        const char* msgType = doc["type"];
+        if (msgType && (strcmp(msgType, "subscribe") == 0 || strcmp(msgType, "unsubscribe") == 0)) {
+          if (num >= WS_MAX_CLIENTS) {
+            sendError(app, num, "Client cannot subscribe");
+            break;
+          }
+          handleSubscribe(app, num, doc, strcmp(msgType, "subscribe") == 0);
+          break;
+        }
+
+        if (msgType && strcmp(msgType, "hello") == 0) {
+          if (num >= WS_MAX_CLIENTS) {
+            sendError(app, num, "Client cannot subscribe");
+            break;
+          }
+          handleHello(app, num, doc);
+          break;
+        }
+
+        if (msgType && strcmp(msgType, "metrics") == 0) {
+          if (num >= WS_MAX_CLIENTS) {
+            sendError(app, num, "Client cannot subscribe");
+            break;
+          }
+          handleMetricsRequest(app, num, doc);
+          break;
+        }
+
+        // Batched device updates, persisted once (same as POST /api/devices/batch)
+        if (msgType && strcmp(msgType, "batch") == 0) {
+          handleBatch(app, num, doc);
+          break;
+        }
+
         // Retrieve the device ID and sensor type from the JSON.
         const char* deviceId = doc["deviceId"];
         const char* sensorType = doc["sensor"];
         if (!deviceId || !sensorType) {
-          Serial.println("Missing required fields: deviceId or sensor");
-          
-          // Send error message back to client
-          DynamicJsonDocument errorDoc(128);
-          errorDoc["error"] = "Missing required fields: deviceId or sensor";
-          String errorJson;
-          serializeJson(errorDoc, errorJson);
-          app.wsSendTXT(num, errorJson);
+          LOG_DEBUG("WS client %u: missing deviceId or sensor", num);
+          sendError(app, num, "Missing required fields: deviceId or sensor");
           break;
         }
-        
-        // Simulate sensor reading based on the requested sensor type.
-        if (strcmp(sensorType, "temperature") == 0) {
-          float temperature = random(2000, 3500) / 100.0;  // Simulated temperature reading
-          sendSensorUpdate(app, num, deviceId, sensorType, temperature);
-        } else if (strcmp(sensorType, "humidity") == 0) {
-          float humidity = random(3000, 6000) / 100.0;  // Simulated humidity reading
-          sendSensorUpdate(app, num, deviceId, sensorType, humidity);
-        } else if (strcmp(sensorType, "pressure") == 0) {
-          float pressure = random(90000, 110000) / 100.0; // Simulated pressure reading in hPa
-          sendSensorUpdate(app, num, deviceId, sensorType, pressure);
-        } else if (strcmp(sensorType, "light") == 0) {
-          float light = random(0, 1000); // Simulated light reading in lux
-          sendSensorUpdate(app, num, deviceId, sensorType, light);
-        } else {
+
+        // One-shot read for clients that have not moved to subscriptions
+        int sensorIndex = findSensorQuantity(sensorType);
+        if (sensorIndex < 0) {
           // If sensor type is not recognized, send an error message.
-          DynamicJsonDocument errorDoc(128);
-          errorDoc["error"] = "Unknown sensor type: " + String(sensorType);
-          errorDoc["supportedTypes"] = JsonArray();
-          
-          // Add supported types
-          JsonArray types = errorDoc["supportedTypes"];
-          types.add("temperature");
-          types.add("humidity");
-          types.add("pressure");
-          types.add("light");
-          
-          String errorJson;
-          serializeJson(errorDoc, errorJson);
-          app.wsSendTXT(num, errorJson);
+          sendUnknownSensorError(app, num, sensorType);
+          break;
+        }
+
+        float value;
+        SensorReadStatus status = readStreamValue(deviceId, sensorIndex, value);
+        if (status == SENSOR_OK) {
+          sendSensorUpdate(app, num, deviceId, sensorType, value);
+        } else if (status == SENSOR_UNSUPPORTED) {
+          sendError(app, num, "Sensor not available on this device");
+        } else {
+          sendError(app, num, "Sensor read failed");
         }
         break;
       }
+      case WStype_BIN: {
+        incrementCounter(receivedMetric);
+        ScopedTimer timer(messageMetric);
+        handleLedFrame(app, num, payload, length);
+        break;
+      }
       default:
         break;
     }
   });
-}
\ No newline at end of file
+}
@@ -3,7 +3,74 @@
 
 #include "ESPExpress.h"
 
+// --- Sensor streaming limits ---
+#define WS_MAX_CLIENTS 8                  // client numbers that may hold subscriptions
+#define MAX_SENSOR_STREAMS 16             // distinct device/sensor pairs streamed at once
+#define MIN_STREAM_INTERVAL_MS 100
+#define DEFAULT_STREAM_INTERVAL_MS 1000
+#define METRICS_PUSH_INTERVAL_MS 5000     // default for {"type":"metrics"} pushes
+
+// --- Binary telemetry ---
+//
+// A client that sends {"type":"hello","format":"binary"} receives stream
+// readings as binary frames instead of one JSON message per reading; every
+// other message stays JSON. {"format":"json"} switches back. Each pass of
+// handleSensorStreams() packs all due readings for a client into one frame,
+// little-endian:
+//
+//   header  uint8 version, uint8 frame type (1 = telemetry), uint16 count
+//   record  uint8 stream, uint8 sensor, uint16 reserved, uint32 millis,
+//           float32 value                               (12 bytes, x count)
+//
+// stream is the "stream" index from the subscribed reply and identifies the
+// device; sensor is the index into supportedSensors from the welcome message.
+#define WS_TELEMETRY_VERSION 1
+#define WS_FRAME_TELEMETRY 1
+#define WS_TELEMETRY_HEADER_SIZE 4
+#define WS_TELEMETRY_RECORD_SIZE 12
+
+// --- Binary LED frames ---
+//
+// Clients drive LED strips with binary frames of the same version, without
+// a reply unless the frame is rejected ({"error": ...}):
+//
+//   header  uint8 version, uint8 frame type, uint8 id length, id bytes
+//   pixels  (type 2) uint16 start, uint16 count, count x uint8 r, g, b
+//   fill    (type 3) uint16 start, uint16 count, uint8 r, g, b
+//
+// Pixels are live output: they replace a running effect until the next
+// state change and are not saved. Frames arriving faster than the strip
+// can show them are merged (see led_strip.h).
+#define WS_FRAME_LED_PIXELS 2
+#define WS_FRAME_LED_FILL 3
+#define WS_LED_ID_MAX 63
+
+// --- RPC ---
+//
+// {"id": n, "method": m, "params": {...}} calls into the same device logic
+// as the HTTP routes. Every request gets exactly one reply carrying its id,
+// {"id": n, "ok": true, "result": ...} or
+// {"id": n, "ok": false, "status": <HTTP status>, "error": "..."},
+// and requests are answered in order, so clients can pipeline them.
+//
+//   list         {"since"?}                   like GET /api/devices[?since=]
+//   get          {"id"}                       like GET /api/device/:id
+//   setState     {"id", "state"}              like PUT /api/device/:id
+//   setPins      {"id", "pins"}               like PUT /api/device/:id/pins
+//   batch        {"updates"}                  like POST /api/devices/batch;
+//                                             result {"status", "results"}
+//   read         {"deviceId", "sensor"}       one sensor reading
+//   subscribe    {"deviceId", "sensor", "interval"?}   result {"stream", "interval"}
+//   unsubscribe  {"deviceId", "sensor"}
+
 void registerWebSocketRoutes(ESPExpress &app);
 void sendTemperatureUpdate(ESPExpress &app, float temperature);
 
-#endif // WEBSOCKET_H
\ No newline at end of file
+// Samples every subscribed device/sensor pair that is due and pushes the
+// reading to its subscribers. Call from loop().
+void handleSensorStreams(ESPExpress &app);
+
+// Pushes a metrics snapshot to clients that asked for one. Call from loop().
+void handleMetricsPush(ESPExpress &app);
+
+#endif // WEBSOCKET_H
@@ -0,0 +1,251 @@
+#include "adc_source.h"
+#include <atomic>
+#include <string.h>
+#ifndef ADC_SIMULATED
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#endif
+
+// Written by the loop task, read by the sampling task; each is one aligned
+// 32-bit word
+static volatile float calibrationGain = ADC_CAL_GAIN;
+static volatile float calibrationOffsetMv = ADC_CAL_OFFSET_MV;
+
+void setAdcCalibration(float gain, float offsetMv) {
+  calibrationGain = gain;
+  calibrationOffsetMv = offsetMv;
+}
+
+// Board-level trim on top of the eFuse-corrected millivolts
+static float calibratedVolts(float millivolts) {
+  millivolts = millivolts * calibrationGain + calibrationOffsetMv;
+  if (millivolts < 0) millivolts = 0;
+  return millivolts / 1000.0f;
+}
+
+// --- Simulated signal ---
+
+static uint32_t simulatedConversions = 0;
+static uint32_t noiseState = 0x2545F491;
+
+// xorshift32: cheap, and the same sequence on every run
+static uint32_t nextNoise() {
+  noiseState ^= noiseState << 13;
+  noiseState ^= noiseState >> 17;
+  noiseState ^= noiseState << 5;
+  return noiseState;
+}
+
+uint32_t simulatedAdcMillivolts(int pin) {
+  uint32_t step = simulatedConversions++ / ADC_OVERSAMPLE;
+  uint32_t phase = (step + pin * 97) % 400;
+  uint32_t wave = phase < 200 ? phase : 400 - phase;
+  return 1550 + wave + nextNoise() % 81 - 40;
+}
+
+// --- Continuous mode ---
+
+#define ADC1_CHANNELS 8
+
+// GPIO of each ADC1 channel
+static const int ADC1_PINS[ADC1_CHANNELS] = {36, 37, 38, 39, 32, 33, 34, 35};
+
+// Halving a sum at this count keeps it within 32 bits (12-bit conversions)
+#define ADC_SUM_COUNT_LIMIT (1UL << 20)
+
+// Channel masks: what the loop task asked for, what the sampling task last
+// tried to start, and what is running
+static std::atomic<uint32_t> requestedChannels(0);
+static uint32_t attemptedChannels = 0;
+static std::atomic<uint32_t> runningChannels(0);
+
+// Conversions since the last reading, per channel; sampling task only
+static uint32_t rawSums[ADC1_CHANNELS];
+static uint32_t rawCounts[ADC1_CHANNELS];
+
+// Newest continuous reading per channel, for readAdcVolts() on the loop task
+static volatile float latestVolts[ADC1_CHANNELS];
+
+static int adc1Channel(int pin) {
+  for (int channel = 0; channel < ADC1_CHANNELS; channel++) {
+    if (ADC1_PINS[channel] == pin) return channel;
+  }
+  return -1;
+}
+
+#ifndef ADC_SIMULATED
+
+static esp_adc_cal_characteristics_t adc1Characteristics;
+
+void beginAdcPin(int pin) {
+  analogReadResolution(12);
+  analogSetPinAttenuation(pin, ADC_11db);
+}
+
+uint32_t readAdcMillivolts(int pin) {
+  // Uses the per-chip characterization burned into eFuse, which corrects the
+  // ADC's offset and gain error far better than a fixed 3.3 / 4095 scale
+  return analogReadMilliVolts(pin);
+}
+
+static bool startDriver(uint32_t channels) {
+  adc_digi_init_config_t init = {};
+  init.max_store_buf_size = ADC_CONTINUOUS_BUFFER;
+  init.conv_num_each_intr = ADC_CONTINUOUS_FRAME;
+  init.adc1_chan_mask = channels;
+  if (adc_digi_initialize(&init) != ESP_OK) return false;
+
+  adc_digi_pattern_config_t pattern[ADC1_CHANNELS] = {};
+  uint32_t count = 0;
+  for (int channel = 0; channel < ADC1_CHANNELS; channel++) {
+    if (!(channels & (1UL << channel))) continue;
+    pattern[count].atten = ADC_ATTEN_DB_11;
+    pattern[count].channel = channel;
+    pattern[count].unit = 0;        // ADC1
+    pattern[count].bit_width = 12;
+    count++;
+  }
+
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = true;      // required on the ESP32
+  config.conv_limit_num = 250;
+  config.pattern_num = count;
+  config.adc_pattern = pattern;
+  config.sample_freq_hz = ADC_CONTINUOUS_RATE_HZ;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &adc1Characteristics);
+  return true;
+}
+
+static void stopDriver() {
+  adc_digi_stop();
+  adc_digi_deinitialize();
+}
+
+// Drains every finished frame without waiting for the next one
+static void readConversions() {
+  uint8_t frame[ADC_CONTINUOUS_FRAME];
+  for (;;) {
+    uint32_t length = 0;
+    esp_err_t result = adc_digi_read_bytes(frame, sizeof(frame), &length, 0);
+    // INVALID_STATE reports a full buffer; the data read is still good
+    if (result != ESP_OK && result != ESP_ERR_INVALID_STATE) break;
+
+    for (uint32_t i = 0; i + sizeof(adc_digi_output_data_t) <= length; i += sizeof(adc_digi_output_data_t)) {
+      adc_digi_output_data_t conversion;
+      memcpy(&conversion, frame + i, sizeof(conversion));
+      uint32_t channel = conversion.type1.channel;
+      if (channel >= ADC1_CHANNELS) continue;
+
+      if (rawCounts[channel] == ADC_SUM_COUNT_LIMIT) {
+        rawSums[channel] >>= 1;
+        rawCounts[channel] >>= 1;
+      }
+      rawSums[channel] += conversion.type1.data;
+      rawCounts[channel]++;
+    }
+    if (length < sizeof(frame)) break;
+  }
+}
+
+// eFuse-corrected millivolts for a fractional mean of raw counts, by
+// interpolating between the two neighbouring counts so the extra bits from
+// averaging survive the integer calibration
+static float meanMillivolts(uint32_t sum, uint32_t count) {
+  uint32_t raw = sum / count;
+  uint32_t low = esp_adc_cal_raw_to_voltage(raw, &adc1Characteristics);
+  if (raw >= 4095 || sum % count == 0) return low;
+  uint32_t high = esp_adc_cal_raw_to_voltage(raw + 1, &adc1Characteristics);
+  return low + ((float)high - low) * (sum % count) / count;
+}
+
+#else
+
+void beginAdcPin(int) {
+}
+
+uint32_t readAdcMillivolts(int pin) {
+  return simulatedAdcMillivolts(pin);
+}
+
+// The simulated signal is one-shot only
+static bool startDriver(uint32_t) {
+  return false;
+}
+
+static void stopDriver() {
+}
+
+static void readConversions() {
+}
+
+static float meanMillivolts(uint32_t sum, uint32_t count) {
+  return (float)sum / count;
+}
+
+#endif // ADC_SIMULATED
+
+bool isContinuousAdcPin(int pin) {
+  return adc1Channel(pin) >= 0;
+}
+
+void setAdcContinuousPins(const int* pins, size_t count) {
+  uint32_t channels = 0;
+  for (size_t i = 0; i < count; i++) {
+    int channel = adc1Channel(pins[i]);
+    if (channel >= 0) channels |= 1UL << channel;
+  }
+  requestedChannels.store(channels);
+}
+
+void pollAdcContinuous() {
+  uint32_t wanted = requestedChannels.load();
+  if (wanted != attemptedChannels) {
+    // Stop before the new set is running, so readAdcVolts() never returns a
+    // reading of a pin that left the set
+    if (runningChannels.load()) stopDriver();
+    runningChannels.store(0);
+    memset(rawSums, 0, sizeof(rawSums));
+    memset(rawCounts, 0, sizeof(rawCounts));
+    for (int channel = 0; channel < ADC1_CHANNELS; channel++) latestVolts[channel] = 0;
+
+    attemptedChannels = wanted;
+    if (wanted && startDriver(wanted)) runningChannels.store(wanted);
+  }
+
+  if (runningChannels.load()) readConversions();
+}
+
+bool adcContinuousActive(int pin) {
+  int channel = adc1Channel(pin);
+  return channel >= 0 && (runningChannels.load() & (1UL << channel));
+}
+
+bool takeAdcContinuousVolts(int pin, float &volts) {
+  int channel = adc1Channel(pin);
+  if (channel < 0 || rawCounts[channel] == 0) return false;
+
+  volts = calibratedVolts(meanMillivolts(rawSums[channel], rawCounts[channel]));
+  latestVolts[channel] = volts;
+  rawSums[channel] = 0;
+  rawCounts[channel] = 0;
+  return true;
+}
+
+// --- One-shot readings ---
+
+float readAdcVolts(int pin) {
+  if (adcContinuousActive(pin)) return latestVolts[adc1Channel(pin)];
+
+  uint32_t sum = 0;
+  for (int i = 0; i < ADC_OVERSAMPLE; i++) {
+    sum += readAdcMillivolts(pin);
+  }
+  return calibratedVolts((float)sum / ADC_OVERSAMPLE);
+}
@@ -0,0 +1,97 @@
+#ifndef ADC_SOURCE_H
+#define ADC_SOURCE_H
+
+#include <Arduino.h>
+
+// --- ADC acquisition ---
+//
+// Every analog read goes through here. One reading is the mean of
+// ADC_OVERSAMPLE back-to-back conversions (oversampling and decimation in
+// one step: averaging 16 conversions adds about two bits of resolution and
+// cuts the white noise by 4x). Conversions are corrected with the chip's
+// eFuse calibration, then with a board-level linear trim.
+//
+// Sampled ADC1 pins skip the back-to-back reads: the continuous mode below
+// converts them in the background and a reading averages everything since
+// the previous one.
+//
+// Build with -DADC_SIMULATED to replace the hardware with a noisy synthetic
+// signal (see simulatedAdcMillivolts()), e.g. for host tests.
+
+// Conversions averaged per reading; 1 disables oversampling
+#ifndef ADC_OVERSAMPLE
+#define ADC_OVERSAMPLE 16
+#endif
+
+// Default board-level trim applied after the eFuse calibration:
+// volts = measured * gain + offset / 1000. setAdcCalibration() replaces it.
+#ifndef ADC_CAL_GAIN
+#define ADC_CAL_GAIN 1.0f
+#endif
+#ifndef ADC_CAL_OFFSET_MV
+#define ADC_CAL_OFFSET_MV 0
+#endif
+
+// Full scale at 11 dB attenuation
+#define ADC_FULL_SCALE_MV 3300
+
+// Conversions per second across all continuous pins; 20 kHz is the lowest
+// the ESP32's digital controller runs at
+#ifndef ADC_CONTINUOUS_RATE_HZ
+#define ADC_CONTINUOUS_RATE_HZ 20000
+#endif
+
+// DMA frame and driver buffer sizes, in bytes (two per conversion)
+#define ADC_CONTINUOUS_FRAME 256
+#define ADC_CONTINUOUS_BUFFER 1024
+
+// Sets up a pin for analog input (12-bit, full 0-3.3 V range). Safe to call
+// again for a pin that is already set up.
+void beginAdcPin(int pin);
+
+// One calibrated conversion, in millivolts
+uint32_t readAdcMillivolts(int pin);
+
+// An oversampled, calibrated reading, in volts; never negative. For a pin
+// the continuous mode is converting, the newest continuous reading instead
+// (0 before the first), as a one-shot read would stall the DMA.
+float readAdcVolts(int pin);
+
+// Board-level trim for every pin, e.g. from a two-point measurement against
+// a reference meter. Takes effect from the next reading.
+void setAdcCalibration(float gain, float offsetMv);
+
+// --- Continuous mode ---
+//
+// ADC1 pins (GPIO 32-39) are converted by the ADC's digital controller at
+// ADC_CONTINUOUS_RATE_HZ, round-robin, and DMAed into the driver's buffer
+// without the CPU. The sampling task drains it into per-pin sums; each
+// reading is their calibrated mean. ADC2 pins stay on one-shot reads (the
+// WiFi driver owns ADC2), as does everything in ADC_SIMULATED builds.
+
+// True for pins the continuous mode can convert
+bool isContinuousAdcPin(int pin);
+
+// The pins to convert continuously, replacing the previous set; others are
+// ignored. Loop task. The sampling task restarts the driver on its next
+// pollAdcContinuous().
+void setAdcContinuousPins(const int* pins, size_t count);
+
+// Applies a new pin set, then moves the conversions the DMA has finished
+// into the per-pin sums. Never blocks. Sampling task only.
+void pollAdcContinuous();
+
+// True if the driver is running and converting the pin
+bool adcContinuousActive(int pin);
+
+// The calibrated mean of the pin's conversions since the last call, in
+// volts, and starts a new sum. False if none arrived. Sampling task only.
+bool takeAdcContinuousVolts(int pin, float &volts);
+
+// The synthetic signal ADC_SIMULATED builds read: a slow triangle wave
+// between 1550 and 1750 mV that moves one step per reading (ADC_OVERSAMPLE
+// conversions), plus up to +-40 mV of conversion noise from a fixed-seed
+// generator, so runs repeat.
+uint32_t simulatedAdcMillivolts(int pin);
+
+#endif // ADC_SOURCE_H
@@ -0,0 +1,244 @@
+#include "sampler.h"
+#include "spsc_ring.h"
+#include "adc_source.h"
+#include "device_controller.h"
+#include "log.h"
+#include <atomic>
+
+// One sampled device. Configuration fields are only changed by the loop task
+// while holding channelLock. The sampling task holds it just long enough to
+// copy the due channels and, after converting, to push the samples; the
+// loop task pops from the rings without it.
+struct SampleChannel {
+  bool active;
+  DeviceHandle handle;
+  int pin;
+  InterfaceType interface;
+  uint32_t intervalMs;
+  uint32_t nextSampleAt;      // sampling task only
+  SpscRing<Sample, SAMPLER_RING_SIZE> ring;
+};
+
+// A due channel as copied under the lock, converted outside it
+struct DueSample {
+  SampleChannel* channel;
+  int pin;
+  InterfaceType interface;
+  bool taken;
+  Sample sample;
+};
+
+static SampleChannel channels[SAMPLER_MAX_CHANNELS];
+static SemaphoreHandle_t channelLock = nullptr;
+static TaskHandle_t samplerTask = nullptr;
+static std::atomic<uint32_t> overruns(0);
+
+// Bumped by every resync under channelLock, so samples converted across one
+// are dropped instead of landing in a channel that now has another device
+static uint32_t channelRevision = 0;
+
+// Registry generation the channels were last built from
+static uint32_t syncedGeneration = 0;
+static bool synced = false;
+
+static bool isSampled(const Device &device) {
+  return device.direction == INPUT_DEVICE
+    && (device.interface == ANALOG_IF || device.interface == DIGITAL_IF)
+    && !device.pins.empty();
+}
+
+static uint32_t intervalFor(const Device &device) {
+  if (device.sampleIntervalMs == 0) return SAMPLER_DEFAULT_INTERVAL_MS;
+  return device.sampleIntervalMs < SAMPLER_MIN_INTERVAL_MS ? SAMPLER_MIN_INTERVAL_MS : device.sampleIntervalMs;
+}
+
+static void setupPin(const Device &device) {
+  if (device.interface == DIGITAL_IF) pinMode(device.pins[0], INPUT);
+  else beginAdcPin(device.pins[0]);
+}
+
+static SampleChannel* channelFor(DeviceHandle handle) {
+  for (auto &channel : channels) {
+    if (channel.active && channel.handle == handle) return &channel;
+  }
+  return nullptr;
+}
+
+// --- Sampling task ---
+
+// Continuous ADC pins average what the DMA delivered since their last
+// sample; the rest are read now
+static bool takeSample(DueSample &entry) {
+  if (entry.interface == DIGITAL_IF) {
+    entry.sample.value = readDigitalSensor(entry.pin);
+    return true;
+  }
+  if (adcContinuousActive(entry.pin)) return takeAdcContinuousVolts(entry.pin, entry.sample.value);
+  entry.sample.value = readAnalogSensor(entry.pin);
+  return true;
+}
+
+static void samplerLoop(void*) {
+  TickType_t lastWake = xTaskGetTickCount();
+  DueSample due[SAMPLER_MAX_CHANNELS];
+  for (;;) {
+    pollAdcContinuous();
+
+    size_t dueCount = 0;
+    xSemaphoreTake(channelLock, portMAX_DELAY);
+    uint32_t now = millis();
+    uint32_t revision = channelRevision;
+    for (auto &channel : channels) {
+      if (!channel.active || (int32_t)(now - channel.nextSampleAt) < 0) continue;
+
+      DueSample &entry = due[dueCount++];
+      entry.channel = &channel;
+      entry.pin = channel.pin;
+      entry.interface = channel.interface;
+      entry.sample.timestampMs = now;
+
+      // Keep a fixed schedule; resync only after falling a full period behind
+      channel.nextSampleAt += channel.intervalMs;
+      if ((int32_t)(now - channel.nextSampleAt) >= 0) channel.nextSampleAt = now + channel.intervalMs;
+    }
+    xSemaphoreGive(channelLock);
+
+    if (dueCount > 0) {
+      for (size_t i = 0; i < dueCount; i++) due[i].taken = takeSample(due[i]);
+
+      xSemaphoreTake(channelLock, portMAX_DELAY);
+      if (revision == channelRevision) {
+        for (size_t i = 0; i < dueCount; i++) {
+          if (!due[i].taken) continue;
+          if (!due[i].channel->ring.push(due[i].sample)) overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      xSemaphoreGive(channelLock);
+    }
+
+    vTaskDelayUntil(&lastWake, 1);   // one tick, 1 ms at the default 1 kHz tick rate
+  }
+}
+
+void startSampler() {
+  if (samplerTask) return;
+  channelLock = xSemaphoreCreateMutex();
+  handleSampler();
+  xTaskCreatePinnedToCore(samplerLoop, "sampler", SAMPLER_TASK_STACK, nullptr,
+                          SAMPLER_TASK_PRIORITY, &samplerTask, SAMPLER_CORE);
+}
+
+// --- Loop side ---
+
+// True if a sampled device was added, removed, re-pinned or given another
+// interval since the last sync. Reads the channels without the lock: only the
+// loop task changes their configuration.
+static bool channelsStale() {
+  size_t active = 0;
+  for (const auto &channel : channels) {
+    if (!channel.active) continue;
+    active++;
+    const Device* device = devices.get(channel.handle);
+    if (!device || !isSampled(*device)) return true;
+    if (channel.pin != device->pins[0] || channel.interface != device->interface) return true;
+    if (channel.intervalMs != intervalFor(*device)) return true;
+  }
+  if (active == SAMPLER_MAX_CHANNELS) return false;   // a new device would not fit anyway
+
+  for (const auto &device : devices) {
+    if (isSampled(device) && !channelFor(device.handle)) return true;
+  }
+  return false;
+}
+
+static void syncChannels() {
+  xSemaphoreTake(channelLock, portMAX_DELAY);
+  channelRevision++;
+
+  // Drop channels whose device is gone or no longer sampled; refresh the rest
+  for (auto &channel : channels) {
+    if (!channel.active) continue;
+    const Device* device = devices.get(channel.handle);
+    if (!device || !isSampled(*device)) {
+      channel.active = false;
+      continue;
+    }
+    if (channel.pin != device->pins[0] || channel.interface != device->interface) {
+      channel.ring.reset();
+      setupPin(*device);
+    }
+    channel.pin = device->pins[0];
+    channel.interface = device->interface;
+    channel.intervalMs = intervalFor(*device);
+  }
+
+  for (const auto &device : devices) {
+    if (!isSampled(device) || channelFor(device.handle)) continue;
+
+    SampleChannel* slot = nullptr;
+    for (auto &channel : channels) {
+      if (!channel.active) {
+        slot = &channel;
+        break;
+      }
+    }
+    if (!slot) {
+      LOG_ERROR("No sampler channel left for %s", device.id.c_str());
+      break;
+    }
+
+    setupPin(device);
+    slot->handle = device.handle;
+    slot->pin = device.pins[0];
+    slot->interface = device.interface;
+    slot->intervalMs = intervalFor(device);
+    slot->nextSampleAt = millis();
+    slot->ring.reset();
+    slot->active = true;
+  }
+
+  int analogPins[SAMPLER_MAX_CHANNELS];
+  size_t analogCount = 0;
+  for (const auto &channel : channels) {
+    if (channel.active && channel.interface == ANALOG_IF) analogPins[analogCount++] = channel.pin;
+  }
+  setAdcContinuousPins(analogPins, analogCount);
+
+  xSemaphoreGive(channelLock);
+}
+
+void handleSampler() {
+  if (!channelLock) return;
+
+  // The generation also moves on every state change; only a change to what
+  // is sampled is worth taking the lock for
+  if (!synced || devices.generation() != syncedGeneration) {
+    if (!synced || channelsStale()) syncChannels();
+    syncedGeneration = devices.generation();
+    synced = true;
+  }
+
+  // Keep half of each ring free so the sampling task never has to drop new
+  // samples just because nobody consumed the old ones
+  for (auto &channel : channels) {
+    if (channel.active) channel.ring.trim(SAMPLER_RING_SIZE / 2);
+  }
+}
+
+bool latestSample(DeviceHandle handle, Sample &sample) {
+  SampleChannel* channel = channelFor(handle);
+  return channel && channel->ring.peekNewest(sample);
+}
+
+size_t readSamples(DeviceHandle handle, Sample* out, size_t max) {
+  SampleChannel* channel = channelFor(handle);
+  if (!channel) return 0;
+
+  size_t count = 0;
+  while (count < max && channel->ring.pop(out[count])) count++;
+  return count;
+}
+
+uint32_t samplerOverruns() {
+  return overruns.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <Arduino.h>
+#include "ESPControlPlatform.h"
+
+// --- Sampling engine ---
+//
+// A FreeRTOS task pinned to the core that does not run loop() reads every
+// analog or digital INPUT_DEVICE at its own interval (Device::sampleIntervalMs)
+// into a per-device SPSC ring. The loop task is the only consumer: routes and
+// WebSocket streams read the rings without blocking, and network load no
+// longer shifts sample timing. Analog samples on ADC1 pins are the mean of
+// every conversion the continuous ADC made since the previous sample; other
+// analog pins get oversampled one-shot readings (see adc_source.h).
+
+#ifndef SAMPLER_MAX_CHANNELS
+#define SAMPLER_MAX_CHANNELS 16
+#endif
+
+// Samples kept per channel; must be a power of two
+#ifndef SAMPLER_RING_SIZE
+#define SAMPLER_RING_SIZE 32
+#endif
+
+#define SAMPLER_DEFAULT_INTERVAL_MS 100
+#define SAMPLER_MIN_INTERVAL_MS 5
+#define SAMPLER_MAX_INTERVAL_MS 60000   // Device::sampleIntervalMs is 16 bits
+
+#ifndef SAMPLER_CORE
+#define SAMPLER_CORE 0            // loop() runs on core 1
+#endif
+#define SAMPLER_TASK_PRIORITY 3
+#define SAMPLER_TASK_STACK 3072
+
+struct Sample {
+  uint32_t timestampMs;      // millis() when the sample was taken
+  float value;               // volts for analog inputs, 0/1 for digital
+};
+
+// Creates the sampling task. Call once from setup() after the devices are
+// loaded.
+void startSampler();
+
+// Picks up added, removed or re-pinned input devices and keeps the rings
+// from filling up when nobody reads them. Call from loop().
+void handleSampler();
+
+// The newest sample of a device, without consuming anything.
+// False if the device is not sampled or has no samples yet.
+bool latestSample(DeviceHandle handle, Sample &sample);
+
+// Removes and returns up to max of the oldest buffered samples
+size_t readSamples(DeviceHandle handle, Sample* out, size_t max);
+
+// Samples dropped because a ring was full, across all channels
+uint32_t samplerOverruns();
+
+#endif // SAMPLER_H
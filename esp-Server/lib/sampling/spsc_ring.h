@@ -0,0 +1,67 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Fixed-size single-producer/single-consumer queue. push() may only be
+// called from one task and pop()/peek()/size() from one other task; neither
+// side ever blocks or takes a lock. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscRing {
+  static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+  SpscRing() : head(0), tail(0) {}
+
+  // Producer: returns false (and drops the item) when the ring is full
+  bool push(const T &item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= Capacity) return false;
+    items[h & (Capacity - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: takes the oldest item. In IRAM, as interrupt handlers pop too.
+  bool IRAM_ATTR pop(T &item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    item = items[t & (Capacity - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer: copies the newest item without removing anything. Safe because
+  // the producer cannot reuse that slot until the consumer has popped it.
+  bool peekNewest(T &item) const {
+    uint32_t h = head.load(std::memory_order_acquire);
+    if (h == tail.load(std::memory_order_relaxed)) return false;
+    item = items[(h - 1) & (Capacity - 1)];
+    return true;
+  }
+
+  // Consumer: drops the oldest items until at most keep remain
+  void trim(size_t keep) {
+    uint32_t h = head.load(std::memory_order_acquire);
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (h - t > keep) tail.store(h - keep, std::memory_order_release);
+  }
+
+  size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  // Only while neither side is running, e.g. when a channel is reassigned
+  void reset() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  T items[Capacity];
+  std::atomic<uint32_t> head;   // written by the producer
+  std::atomic<uint32_t> tail;   // written by the consumer
+};
+
+#endif // SPSC_RING_H
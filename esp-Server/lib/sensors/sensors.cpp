@@ -0,0 +1,220 @@
+#include "sensors.h"
+#include "device_controller.h"
+#include "sampler.h"
+#include "log.h"
+#include <DHT.h>
+#include <memory>
+
+static const char* const QUANTITY_NAMES[SENSOR_QUANTITY_COUNT] = {
+  "temperature", "humidity", "pressure", "light", "voltage", "level"
+};
+
+#define QUANTITY_BIT(q) (1UL << (q))
+
+const char* sensorQuantityName(uint8_t quantity) {
+  return quantity < SENSOR_QUANTITY_COUNT ? QUANTITY_NAMES[quantity] : nullptr;
+}
+
+int findSensorQuantity(const char* name) {
+  for (int i = 0; i < SENSOR_QUANTITY_COUNT; i++) {
+    if (strcmp(name, QUANTITY_NAMES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+// A driver reads every quantity it supports in one transaction
+struct SensorDriver {
+  const char* name;
+  bool (*matches)(const Device &device);
+  uint32_t quantities;        // QUANTITY_BIT mask
+  uint32_t maxAgeMs;
+  bool (*read)(const Device &device, float values[SENSOR_QUANTITY_COUNT]);
+};
+
+// --- Simulated backend ---
+
+static bool matchesAny(const Device &) {
+  return true;
+}
+
+static bool readSimulated(const Device &, float values[SENSOR_QUANTITY_COUNT]) {
+  values[SENSOR_TEMPERATURE] = random(2000, 3500) / 100.0;    // °C
+  values[SENSOR_HUMIDITY] = random(3000, 6000) / 100.0;       // %
+  values[SENSOR_PRESSURE] = random(90000, 110000) / 100.0;    // hPa
+  values[SENSOR_LIGHT] = random(0, 1000);                     // lux
+  values[SENSOR_VOLTAGE] = random(0, 330) / 100.0;            // V
+  values[SENSOR_LEVEL] = random(0, 2);
+  return true;
+}
+
+// Max age 0: every request gets a fresh value, as before the driver layer
+static const SensorDriver SIMULATED_DRIVER = {
+  "simulated", matchesAny, 0xFFFFFFFFUL, 0, readSimulated
+};
+
+#ifndef SENSORS_SIMULATED
+
+// --- DHT ---
+
+// DHT instances bound to devices, indexed by registry slot like the servos
+struct DhtBinding {
+  DeviceHandle owner;
+  int pin;
+  uint8_t model;
+  DHT dht;
+};
+
+static std::vector<std::unique_ptr<DhtBinding>> dhtSlots;
+
+static bool matchesDht(const Device &device) {
+  return device.type.startsWith("dht") && !device.pins.empty();
+}
+
+static DHT &dhtFor(const Device &device) {
+  uint8_t model = device.type == "dht11" ? DHT11 : DHT22;
+  int pin = device.pins[0];
+  uint16_t slot = deviceHandleSlot(device.handle);
+  if (slot >= dhtSlots.size()) dhtSlots.resize(slot + 1);
+
+  std::unique_ptr<DhtBinding> &binding = dhtSlots[slot];
+  if (!binding || binding->owner != device.handle || binding->pin != pin || binding->model != model) {
+    binding.reset(new DhtBinding{device.handle, pin, model, DHT(pin, model)});
+    binding->dht.begin();
+  }
+  return binding->dht;
+}
+
+static bool readDht(const Device &device, float values[SENSOR_QUANTITY_COUNT]) {
+  DHT &dht = dhtFor(device);
+  values[SENSOR_TEMPERATURE] = dht.readTemperature();
+  values[SENSOR_HUMIDITY] = dht.readHumidity();
+  return !isnan(values[SENSOR_TEMPERATURE]) && !isnan(values[SENSOR_HUMIDITY]);
+}
+
+// --- ADC and digital inputs ---
+
+static bool matchesAnalog(const Device &device) {
+  return device.interface == ANALOG_IF && device.direction == INPUT_DEVICE && !device.pins.empty();
+}
+
+static bool matchesDigital(const Device &device) {
+  return device.interface == DIGITAL_IF && device.direction == INPUT_DEVICE && !device.pins.empty();
+}
+
+// Prefer the sampling task's reading when it is recent enough
+static bool sampledValue(const Device &device, uint32_t maxAgeMs, float &value) {
+  Sample sample;
+  if (!latestSample(device.handle, sample) || millis() - sample.timestampMs > maxAgeMs) return false;
+  value = sample.value;
+  return true;
+}
+
+static bool readAdc(const Device &device, float values[SENSOR_QUANTITY_COUNT]) {
+  float volts;
+  if (!sampledValue(device, ADC_MAX_AGE_MS, volts)) volts = readAnalogSensor(device.pins[0]);
+  values[SENSOR_VOLTAGE] = volts;
+  values[SENSOR_LIGHT] = volts * (100.0 / 3.3);
+  return true;
+}
+
+static bool readDigital(const Device &device, float values[SENSOR_QUANTITY_COUNT]) {
+  float level;
+  if (!sampledValue(device, DIGITAL_MAX_AGE_MS, level)) level = readDigitalSensor(device.pins[0]);
+  values[SENSOR_LEVEL] = level;
+  return true;
+}
+
+// First match wins
+static const SensorDriver DRIVERS[] = {
+  {"dht", matchesDht, QUANTITY_BIT(SENSOR_TEMPERATURE) | QUANTITY_BIT(SENSOR_HUMIDITY), DHT_MAX_AGE_MS, readDht},
+  {"adc", matchesAnalog, QUANTITY_BIT(SENSOR_VOLTAGE) | QUANTITY_BIT(SENSOR_LIGHT), ADC_MAX_AGE_MS, readAdc},
+  {"digital", matchesDigital, QUANTITY_BIT(SENSOR_LEVEL), DIGITAL_MAX_AGE_MS, readDigital},
+};
+
+#endif // SENSORS_SIMULATED
+
+static const SensorDriver* driverFor(const Device* device) {
+#ifndef SENSORS_SIMULATED
+  if (device) {
+    for (const auto &driver : DRIVERS) {
+      if (driver.matches(*device)) return &driver;
+    }
+  }
+  return SENSORS_SIMULATE_FALLBACK ? &SIMULATED_DRIVER : nullptr;
+#else
+  return &SIMULATED_DRIVER;
+#endif
+}
+
+// --- Reading cache ---
+
+struct CachedReading {
+  DeviceHandle owner;
+  uint8_t quantity;
+  float value;
+  uint32_t readAt;
+};
+
+static CachedReading cache[SENSOR_CACHE_SIZE];
+static bool cacheInitialized = false;
+
+static CachedReading* findCached(DeviceHandle owner, uint8_t quantity) {
+  for (auto &entry : cache) {
+    if (entry.owner == owner && entry.quantity == quantity) return &entry;
+  }
+  return nullptr;
+}
+
+static void storeCached(DeviceHandle owner, uint8_t quantity, float value, uint32_t now) {
+  CachedReading* entry = findCached(owner, quantity);
+  if (!entry) {
+    // Replace the oldest reading; unused entries are oldest of all
+    entry = &cache[0];
+    for (auto &candidate : cache) {
+      if (candidate.owner == INVALID_DEVICE_HANDLE) {
+        entry = &candidate;
+        break;
+      }
+      if (now - candidate.readAt > now - entry->readAt) entry = &candidate;
+    }
+  }
+  *entry = {owner, quantity, value, now};
+}
+
+SensorReadStatus readSensor(const Device* device, uint8_t quantity, float &value) {
+  if (quantity >= SENSOR_QUANTITY_COUNT) return SENSOR_UNSUPPORTED;
+  if (!cacheInitialized) {
+    for (auto &entry : cache) entry.owner = INVALID_DEVICE_HANDLE;
+    cacheInitialized = true;
+  }
+
+  const SensorDriver* driver = driverFor(device);
+  if (!driver || !(driver->quantities & QUANTITY_BIT(quantity))) return SENSOR_UNSUPPORTED;
+
+  float values[SENSOR_QUANTITY_COUNT];
+  if (!device) {
+    // Unregistered ids only reach the simulated backend and are not cached
+    if (!driver->read(Device(), values)) return SENSOR_FAILED;
+    value = values[quantity];
+    return SENSOR_OK;
+  }
+
+  uint32_t now = millis();
+  CachedReading* cached = findCached(device->handle, quantity);
+  if (cached && now - cached->readAt < driver->maxAgeMs) {
+    value = cached->value;
+    return SENSOR_OK;
+  }
+
+  if (!driver->read(*device, values)) {
+    LOG_ERROR("%s driver failed to read %s", driver->name, device->id.c_str());
+    return SENSOR_FAILED;
+  }
+
+  // One transaction may yield several quantities; cache all of them
+  for (uint8_t q = 0; driver->maxAgeMs > 0 && q < SENSOR_QUANTITY_COUNT; q++) {
+    if (driver->quantities & QUANTITY_BIT(q)) storeCached(device->handle, q, values[q], now);
+  }
+  value = values[quantity];
+  return SENSOR_OK;
+}
@@ -0,0 +1,67 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <Arduino.h>
+#include "ESPControlPlatform.h"
+
+// --- Sensor drivers ---
+//
+// Readings come from a driver picked by Device::type and interface:
+//   type "dht11", "dht22" or "dht"   DHT on pins[0]: temperature, humidity
+//   analog INPUT_DEVICE               ADC on pins[0]: voltage, light (% of full scale)
+//   digital INPUT_DEVICE              pins[0]: level (0/1)
+// Each reading is cached with its timestamp and served from the cache while
+// younger than the driver's max age, so a burst of requests for the same
+// sensor costs one (slow, ~250 ms for a DHT) transaction.
+//
+// Build with -DSENSORS_SIMULATED to replace every driver with simulated
+// readings, e.g. for host tests.
+
+enum SensorQuantity {
+  SENSOR_TEMPERATURE,
+  SENSOR_HUMIDITY,
+  SENSOR_PRESSURE,
+  SENSOR_LIGHT,
+  SENSOR_VOLTAGE,
+  SENSOR_LEVEL,
+  SENSOR_QUANTITY_COUNT
+};
+
+enum SensorReadStatus {
+  SENSOR_OK,
+  SENSOR_UNSUPPORTED,    // no driver provides this quantity for the device
+  SENSOR_FAILED          // the driver could not talk to the sensor
+};
+
+// Devices (or unknown ids) without a matching driver get SENSOR_UNSUPPORTED.
+// Build with -DSENSORS_SIMULATE_FALLBACK=1 to give them simulated readings
+// instead, e.g. to demo the dashboard without sensors attached.
+#ifndef SENSORS_SIMULATE_FALLBACK
+#define SENSORS_SIMULATE_FALLBACK 0
+#endif
+
+// Freshness windows; DHT sensors cannot be read more than every 2 s anyway
+#ifndef DHT_MAX_AGE_MS
+#define DHT_MAX_AGE_MS 2000
+#endif
+#ifndef ADC_MAX_AGE_MS
+#define ADC_MAX_AGE_MS 50
+#endif
+#ifndef DIGITAL_MAX_AGE_MS
+#define DIGITAL_MAX_AGE_MS 20
+#endif
+
+// Cached readings kept across all devices; the oldest is replaced first
+#define SENSOR_CACHE_SIZE 32
+
+// Name used on the wire ("temperature", ...), or nullptr
+const char* sensorQuantityName(uint8_t quantity);
+
+// Quantity for a name, or -1
+int findSensorQuantity(const char* name);
+
+// Reads one quantity, from the cache when fresh. device may be nullptr for
+// ids that are not registered (simulated fallback only).
+SensorReadStatus readSensor(const Device* device, uint8_t quantity, float &value);
+
+#endif // SENSORS_H
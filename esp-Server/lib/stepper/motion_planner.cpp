@@ -0,0 +1,96 @@
+#include "motion_planner.h"
+#include <math.h>
+#include <string.h>
+
+MotionProfile parseMotionProfile(const char* name) {
+  if (name && strcmp(name, "scurve") == 0) return PROFILE_SCURVE;
+  return PROFILE_TRAPEZOID;
+}
+
+const char* motionProfileName(MotionProfile profile) {
+  return profile == PROFILE_SCURVE ? "scurve" : "trapezoid";
+}
+
+MotionPlanner::MotionPlanner()
+  : rampLength(0), rampShift(0), cruise(0), total(0), taken(0), forward(true) {}
+
+// Capped so callers can count intervals down in a signed 32-bit value
+static uint32_t toInterval(double units) {
+  if (units >= 2147483647.0) return 0x7FFFFFFFUL;
+  return units < 1 ? 1 : (uint32_t)(units + 0.5);
+}
+
+// Seconds from standstill until step s of the ramp
+static double rampTime(MotionProfile profile, double speed, double acceleration, double s) {
+  if (profile == PROFILE_TRAPEZOID) {
+    return sqrt(2 * s / acceleration);
+  }
+
+  // v(t) = V * (3x^2 - 2x^3) with x = t / T, so the position is
+  // V * T * (x^3 - x^4 / 2); invert it by bisection
+  double duration = 1.5 * speed / acceleration;
+  double lo = 0, hi = 1;
+  for (int i = 0; i < 40; i++) {
+    double x = (lo + hi) / 2;
+    double position = speed * duration * (x * x * x - x * x * x * x / 2);
+    if (position < s) lo = x;
+    else hi = x;
+  }
+  return (lo + hi) / 2 * duration;
+}
+
+bool MotionPlanner::configure(uint32_t tickHz, uint32_t maxSpeed, uint32_t acceleration, MotionProfile profile) {
+  if (tickHz == 0 || maxSpeed == 0 || acceleration == 0) return false;
+
+  const double unitsPerSecond = (double)tickHz * (1 << MOTION_FRACTION_BITS);
+  const double speed = maxSpeed;
+  const double accel = acceleration;
+  cruise = toInterval(unitsPerSecond / speed);
+
+  // Both profiles reach full speed after the same distance for the same
+  // average acceleration: half of speed times ramp duration
+  double duration = profile == PROFILE_SCURVE ? 1.5 * speed / accel : speed / accel;
+  double distance = speed * duration / 2;
+  rampLength = distance > 0x7FFFFFFF ? 0x7FFFFFFF : (uint32_t)distance;
+
+  rampShift = 0;
+  while (((rampLength + (1UL << rampShift) - 1) >> rampShift) > MOTION_RAMP_ENTRIES) {
+    rampShift++;
+  }
+
+  uint32_t group = 1UL << rampShift;
+  for (uint32_t k = 0; k < MOTION_RAMP_ENTRIES; k++) {
+    uint32_t first = k << rampShift;
+    if (first >= rampLength) {
+      ramp[k] = cruise;
+      continue;
+    }
+    uint32_t last = first + group < rampLength ? first + group : rampLength;
+    double seconds = rampTime(profile, speed, accel, last) - rampTime(profile, speed, accel, first);
+    uint32_t interval = toInterval(seconds * unitsPerSecond / (last - first));
+    ramp[k] = interval > cruise ? interval : cruise;
+  }
+  return true;
+}
+
+void IRAM_ATTR MotionPlanner::start(int32_t steps) {
+  forward = steps >= 0;
+  total = forward ? (uint32_t)steps : 0U - (uint32_t)steps;
+  taken = 0;
+}
+
+void IRAM_ATTR MotionPlanner::stop() {
+  if (!moving()) return;
+
+  // Run the ramp back down from where it is now; a move that is already
+  // decelerating stops quickest at its planned end
+  uint32_t stopping = taken < rampLength ? taken : rampLength;
+  if (stopping < total - taken) total = taken + stopping;
+}
+
+uint32_t IRAM_ATTR MotionPlanner::nextInterval() {
+  uint32_t i = taken++;
+  uint32_t fromEnd = total - 1 - i;
+  uint32_t position = i < fromEnd ? i : fromEnd;
+  return position < rampLength ? ramp[position >> rampShift] : cruise;
+}
@@ -0,0 +1,76 @@
+#ifndef MOTION_PLANNER_H
+#define MOTION_PLANNER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Motion planner ---
+//
+// Turns a relative move into the sequence of step intervals for one motor.
+// configure() precomputes the acceleration ramp (floating point, task
+// context only); nextInterval() then costs one table lookup and no
+// division, so it can run inside the step timer interrupt. Every move starts
+// and ends at standstill, and the deceleration mirrors the acceleration.
+//
+// The planner knows nothing about pins or timers: intervals are in timer
+// ticks with MOTION_FRACTION_BITS of fraction, which the caller carries
+// over from step to step so the average rate is exact even when a step
+// falls between two ticks. That keeps it testable on a host by calling
+// nextInterval() in a loop as a simulated timer.
+
+#include <esp_attr.h>
+
+#define MOTION_FRACTION_BITS 8
+
+// Ramp table entries per planner; longer ramps are stored as averages over
+// groups of 2, 4, ... steps
+#ifndef MOTION_RAMP_ENTRIES
+#define MOTION_RAMP_ENTRIES 128
+#endif
+
+enum MotionProfile : uint8_t {
+  PROFILE_TRAPEZOID,    // constant acceleration
+  PROFILE_SCURVE        // smoothstep velocity: no jerk at either end of the ramp
+};
+
+// "trapezoid" or "scurve"; unknown names are PROFILE_TRAPEZOID
+MotionProfile parseMotionProfile(const char* name);
+const char* motionProfileName(MotionProfile profile);
+
+class MotionPlanner {
+public:
+  MotionPlanner();
+
+  // Builds the ramp for a timer running at tickHz. acceleration is the
+  // average over the ramp (S-curves peak at 1.5x). Not while moving().
+  bool configure(uint32_t tickHz, uint32_t maxSpeed, uint32_t acceleration, MotionProfile profile);
+
+  // Starts a relative move from standstill; a move of 0 steps does nothing
+  void IRAM_ATTR start(int32_t steps);
+
+  // Shortens the current move so it decelerates to a stop along the ramp
+  void IRAM_ATTR stop();
+
+  // Interval to wait before the next step, in ticks << MOTION_FRACTION_BITS.
+  // Only while moving(); the move is over after the last one.
+  uint32_t IRAM_ATTR nextInterval();
+
+  bool moving() const { return taken < total; }
+  int8_t direction() const { return forward ? 1 : -1; }
+  uint32_t stepsLeft() const { return total - taken; }
+
+  // Steps spent accelerating to full speed
+  uint32_t rampSteps() const { return rampLength; }
+
+private:
+  uint32_t ramp[MOTION_RAMP_ENTRIES];
+  uint32_t rampLength;      // steps
+  uint8_t rampShift;        // steps per entry is 1 << rampShift
+  uint32_t cruise;          // interval at full speed
+
+  uint32_t total;
+  uint32_t taken;
+  bool forward;
+};
+
+#endif // MOTION_PLANNER_H
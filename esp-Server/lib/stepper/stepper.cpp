@@ -0,0 +1,291 @@
+#include "stepper.h"
+#include "spsc_ring.h"
+#include "persistence.h"
+#include "log.h"
+#include <atomic>
+#include <esp_intr_alloc.h>
+#include <soc/gpio_struct.h>
+
+// A stop bumps the motor's epoch; queued moves from an older epoch are
+// dropped, so a move queued right after a stop is never lost
+struct QueuedMove {
+  int32_t steps;
+  uint32_t epoch;
+};
+
+// Binding fields are only changed by the loop task inside motorLock, which
+// the ISR also holds for each tick. Moves travel loop -> ISR through the
+// ring; the position travels back through an atomic.
+struct StepperMotor {
+  DeviceHandle owner;           // INVALID_DEVICE_HANDLE when free
+  int8_t stepPin;
+  int8_t dirPin;
+  int8_t enablePin;             // -1 if the driver is always enabled
+  uint32_t maxSpeed;
+  uint32_t acceleration;
+  MotionProfile profile;
+
+  MotionPlanner planner;
+  SpscRing<QueuedMove, STEPPER_QUEUE_DEPTH> moves;
+  std::atomic<uint32_t> epoch;
+  std::atomic<int32_t> position;
+
+  // ISR only
+  uint32_t seenEpoch;
+  int32_t countdown;            // ticks << MOTION_FRACTION_BITS to the pending step
+  bool pulseHigh;
+  volatile bool running;        // a step is pending; read by the loop task
+
+  // Loop task only
+  int32_t reported;
+  uint32_t reportedAt;
+  bool wasMoving;
+};
+
+static StepperMotor motors[STEPPER_MAX_MOTORS];
+static bool motorsInitialized = false;
+static portMUX_TYPE motorLock = portMUX_INITIALIZER_UNLOCKED;
+
+static hw_timer_t* stepTimer = nullptr;
+static bool timerRunning = false;
+
+static void initMotors() {
+  if (motorsInitialized) return;
+  for (auto &motor : motors) {
+    motor.owner = INVALID_DEVICE_HANDLE;
+  }
+  motorsInitialized = true;
+}
+
+static StepperMotor* motorFor(DeviceHandle handle) {
+  initMotors();
+  for (auto &motor : motors) {
+    if (motor.owner == handle) return &motor;
+  }
+  return nullptr;
+}
+
+static bool motorBusy(const StepperMotor &motor) {
+  return motor.running || motor.moves.size() > 0;
+}
+
+// --- Step interrupt ---
+
+// digitalWrite() lives in flash; the set/clear registers are safe with the
+// cache disabled. Output pins go up to 33.
+static inline void IRAM_ATTR writePin(int8_t pin, bool high) {
+  if (pin < 32) {
+    if (high) GPIO.out_w1ts = 1UL << pin;
+    else GPIO.out_w1tc = 1UL << pin;
+  } else {
+    if (high) GPIO.out1_w1ts.val = 1UL << (pin - 32);
+    else GPIO.out1_w1tc.val = 1UL << (pin - 32);
+  }
+}
+
+static void IRAM_ATTR onStepperTick() {
+  portENTER_CRITICAL_ISR(&motorLock);
+  for (auto &motor : motors) {
+    if (motor.owner == INVALID_DEVICE_HANDLE) continue;
+
+    // The pulse raised on the previous tick ends now
+    if (motor.pulseHigh) {
+      writePin(motor.stepPin, false);
+      motor.pulseHigh = false;
+    }
+
+    uint32_t epoch = motor.epoch.load(std::memory_order_acquire);
+    if (epoch != motor.seenEpoch) {
+      motor.planner.stop();
+      motor.seenEpoch = epoch;
+    }
+
+    if (!motor.running) {
+      QueuedMove move;
+      if (!motor.moves.pop(move) || move.epoch != motor.seenEpoch) continue;
+      motor.planner.start(move.steps);
+      if (!motor.planner.moving()) continue;
+
+      // Direction is set at least one tick before the first step
+      writePin(motor.dirPin, motor.planner.direction() > 0);
+      motor.countdown = motor.planner.nextInterval();
+      motor.running = true;
+      continue;
+    }
+
+    motor.countdown -= 1 << MOTION_FRACTION_BITS;
+    if (motor.countdown > 0) continue;
+
+    writePin(motor.stepPin, true);
+    motor.pulseHigh = true;
+    motor.position.fetch_add(motor.planner.direction(), std::memory_order_relaxed);
+
+    // The overshoot carries into the next interval, keeping the average exact
+    if (motor.planner.moving()) {
+      motor.countdown += motor.planner.nextInterval();
+    } else {
+      motor.running = false;
+    }
+  }
+  portEXIT_CRITICAL_ISR(&motorLock);
+}
+
+static void startTimer() {
+  if (!stepTimer) {
+    // 80 MHz APB clock / 80 = 1 MHz; the ISR is bound to the calling core,
+    // the loop core, away from the WiFi stack. An IRAM interrupt keeps
+    // running during flash writes.
+    stepTimer = timerBegin(STEPPER_TIMER, 80, true);
+    timerAttachInterruptFlag(stepTimer, onStepperTick, true, ESP_INTR_FLAG_IRAM);
+    timerAlarmWrite(stepTimer, STEPPER_TICK_US, true);
+  }
+  if (!timerRunning) {
+    timerAlarmEnable(stepTimer);
+    timerRunning = true;
+  }
+}
+
+// --- Public API ---
+
+bool stepperAttach(Device &device) {
+  if (device.pins.size() < 2) return false;
+
+  uint32_t speed = device.maxSpeed ? device.maxSpeed : STEPPER_DEFAULT_SPEED;
+  if (speed > STEPPER_MAX_SPEED) speed = STEPPER_MAX_SPEED;
+  uint32_t acceleration = device.acceleration ? device.acceleration : STEPPER_DEFAULT_ACCELERATION;
+  MotionProfile profile = (MotionProfile)device.motionProfile;
+  int8_t enablePin = device.pins.size() > 2 ? device.pins[2] : -1;
+
+  StepperMotor* motor = motorFor(device.handle);
+  if (motor && motor->stepPin == device.pins[0] && motor->dirPin == device.pins[1]
+      && motor->enablePin == enablePin && motor->maxSpeed == speed
+      && motor->acceleration == acceleration && motor->profile == profile) {
+    return true;
+  }
+  if (motor) stepperDetach(device.handle);
+
+  motor = motorFor(INVALID_DEVICE_HANDLE);
+  if (!motor) {
+    LOG_ERROR("Stepper %s: all %d motors in use", device.id.c_str(), STEPPER_MAX_MOTORS);
+    return false;
+  }
+
+  // The ISR skips free motors, so the planner can be set up outside the lock
+  if (!motor->planner.configure(STEPPER_TICK_HZ, speed, acceleration, profile)) return false;
+
+  pinMode(device.pins[0], OUTPUT);
+  pinMode(device.pins[1], OUTPUT);
+  digitalWrite(device.pins[0], LOW);
+  if (enablePin >= 0) {
+    pinMode(enablePin, OUTPUT);
+    digitalWrite(enablePin, LOW);
+  }
+
+  // Carry on from the last reported position
+  int32_t position = device.position;
+
+  portENTER_CRITICAL(&motorLock);
+  motor->stepPin = device.pins[0];
+  motor->dirPin = device.pins[1];
+  motor->enablePin = enablePin;
+  motor->maxSpeed = speed;
+  motor->acceleration = acceleration;
+  motor->profile = profile;
+  motor->moves.reset();
+  motor->epoch.store(0);
+  motor->position.store(position);
+  motor->seenEpoch = 0;
+  motor->countdown = 0;
+  motor->pulseHigh = false;
+  motor->running = false;
+  motor->reported = position;
+  motor->reportedAt = millis();
+  motor->wasMoving = false;
+  motor->owner = device.handle;
+  portEXIT_CRITICAL(&motorLock);
+
+  LOG_DEBUG("Stepper %s: step %d, dir %d, %lu steps/s, %lu steps/s^2, %s", device.id.c_str(),
+            device.pins[0], device.pins[1], (unsigned long)speed, (unsigned long)acceleration,
+            motionProfileName(profile));
+  return true;
+}
+
+void stepperDetach(DeviceHandle handle) {
+  StepperMotor* motor = motorFor(handle);
+  if (!motor) return;
+
+  portENTER_CRITICAL(&motorLock);
+  motor->owner = INVALID_DEVICE_HANDLE;
+  motor->running = false;
+  portEXIT_CRITICAL(&motorLock);
+
+  digitalWrite(motor->stepPin, LOW);
+  if (motor->enablePin >= 0) digitalWrite(motor->enablePin, HIGH);
+}
+
+bool stepperMove(DeviceHandle handle, int32_t steps) {
+  StepperMotor* motor = motorFor(handle);
+  if (!motor) return false;
+
+  if (steps == 0) {
+    if (motorBusy(*motor)) motor->epoch.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  QueuedMove move = {steps, motor->epoch.load(std::memory_order_relaxed)};
+  if (!motor->moves.push(move)) return false;
+  startTimer();
+  return true;
+}
+
+bool stepperMoving(DeviceHandle handle) {
+  StepperMotor* motor = motorFor(handle);
+  return motor && motorBusy(*motor);
+}
+
+bool stepperPosition(DeviceHandle handle, int32_t &position) {
+  StepperMotor* motor = motorFor(handle);
+  if (!motor) return false;
+  position = motor->position.load(std::memory_order_relaxed);
+  return true;
+}
+
+void handleSteppers() {
+  initMotors();
+  uint32_t now = millis();
+  bool busy = false;
+
+  for (auto &motor : motors) {
+    if (motor.owner == INVALID_DEVICE_HANDLE) continue;
+
+    bool moving = motorBusy(motor);
+    busy |= moving;
+    int32_t position = motor.position.load(std::memory_order_relaxed);
+    if (position == motor.reported && moving == motor.wasMoving) continue;
+    if (moving && now - motor.reportedAt < STEPPER_REPORT_MS) continue;
+
+    // Deleted without releaseDevicePins()
+    Device* device = devices.get(motor.owner);
+    if (!device) {
+      stepperDetach(motor.owner);
+      continue;
+    }
+
+    // Telemetry while moving; only the resting position is a change, and
+    // it goes to the state journal like one
+    device->position = position;
+    if (!moving) {
+      devices.touch(device->handle);
+      markDeviceStateDirty(device->handle);
+    }
+
+    motor.reported = position;
+    motor.reportedAt = now;
+    motor.wasMoving = moving;
+  }
+
+  if (!busy && timerRunning) {
+    timerAlarmDisable(stepTimer);
+    timerRunning = false;
+  }
+}
@@ -0,0 +1,67 @@
+#ifndef STEPPER_H
+#define STEPPER_H
+
+#include <Arduino.h>
+#include "ESPControlPlatform.h"
+#include "motion_planner.h"
+
+// --- Stepper engine ---
+//
+// Step/direction drivers (A4988, DRV8825, TMC in step mode) driven from one
+// hardware timer interrupt, never from loop(). Each tick the ISR lowers the
+// previous step pulses and raises the due ones, so the pulse width is one
+// tick and step timing jitter stays within one tick regardless of WiFi or
+// HTTP load on either core. The timer only runs while a motor has work.
+//
+// A device's pins are step, direction and optionally an active-low enable.
+// Its state is a relative move: moves queue up to STEPPER_QUEUE_DEPTH deep
+// and run back to back, each with its own acceleration ramp; "0" stops the
+// motor along its ramp and drops the queue. The absolute position is kept
+// apart from the state in Device::position: while moving it is refreshed
+// every STEPPER_REPORT_MS without touching the registry generation, so
+// telemetry does not invalidate device list caches. The resting position
+// counts as a change and is appended to the state journal.
+//
+// The ISR lives in IRAM and drives pins through the GPIO set/clear
+// registers, so steps keep coming while flash writes disable the cache.
+
+#ifndef STEPPER_MAX_MOTORS
+#define STEPPER_MAX_MOTORS 4
+#endif
+
+// Moves waiting per motor; must be a power of two
+#define STEPPER_QUEUE_DEPTH 8
+
+// Timer tick, and so the step pulse width; the step rate is at most half
+// the tick rate
+#define STEPPER_TIMER 0
+#define STEPPER_TICK_US 20
+#define STEPPER_TICK_HZ (1000000UL / STEPPER_TICK_US)
+#define STEPPER_MAX_SPEED (STEPPER_TICK_HZ / 2)
+#define STEPPER_MAX_ACCELERATION 65535     // Device::acceleration is 16 bits
+
+// Defaults for devices that leave maxSpeed / acceleration at 0
+#define STEPPER_DEFAULT_SPEED 1000          // steps/s
+#define STEPPER_DEFAULT_ACCELERATION 2000   // steps/s^2
+
+#define STEPPER_REPORT_MS 100
+
+// Binds a motor to a stepper device (re-binding after pin or setting
+// changes) and sets up its pins. False if all motors are in use.
+bool stepperAttach(Device &device);
+
+// Stops the motor at once (no ramp) and frees it
+void stepperDetach(DeviceHandle handle);
+
+// Queues a relative move; 0 requests a stop. False if the device has no
+// motor or the queue is full.
+bool stepperMove(DeviceHandle handle, int32_t steps);
+
+bool stepperMoving(DeviceHandle handle);
+bool stepperPosition(DeviceHandle handle, int32_t &position);
+
+// Reports positions into Device::position and stops the timer once every
+// motor is idle. Call from loop().
+void handleSteppers();
+
+#endif // STEPPER_H
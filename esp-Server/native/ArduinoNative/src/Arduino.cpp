@@ -0,0 +1,374 @@
+#include "Arduino.h"
+#include "ArduinoNative.h"
+#include "WiFi.h"
+#include "Wire.h"
+#include "soc/gpio_struct.h"
+#include <stdio.h>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+TwoWire Wire;
+
+// --- Clock ---
+
+static uint64_t nowMicros = 0;
+
+unsigned long millis() {
+  return (unsigned long)(uint32_t)(nowMicros / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)(uint32_t)nowMicros;
+}
+
+void delay(uint32_t ms) {
+  nowMicros += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(uint32_t us) {
+  nowMicros += us;
+}
+
+// --- Pins ---
+
+struct Pin {
+  uint8_t mode;
+  uint8_t level;
+  uint8_t input;
+  uint32_t millivolts;
+  std::vector<uint32_t> queued;
+  uint32_t analogReads;
+  int ledcChannel;
+};
+
+static Pin pins[NATIVE_PIN_COUNT];
+
+static Pin* pinAt(uint8_t pin) {
+  return pin < NATIVE_PIN_COUNT ? &pins[pin] : nullptr;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (Pin* p = pinAt(pin)) p->mode = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (Pin* p = pinAt(pin)) p->level = level ? HIGH : LOW;
+}
+
+gpio_dev_t GPIO;
+
+void nativeGpioWrite(uint8_t firstPin, uint32_t mask, bool high) {
+  for (uint8_t bit = 0; bit < 32; bit++) {
+    if (mask & (1UL << bit)) digitalWrite(firstPin + bit, high ? HIGH : LOW);
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  Pin* p = pinAt(pin);
+  if (!p) return LOW;
+  return p->mode == OUTPUT ? p->level : p->input;
+}
+
+void analogReadResolution(uint8_t bits) {
+  (void)bits;
+}
+
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation) {
+  (void)pin;
+  (void)attenuation;
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin) {
+  Pin* p = pinAt(pin);
+  if (!p) return 0;
+  p->analogReads++;
+  if (!p->queued.empty()) {
+    uint32_t millivolts = p->queued.front();
+    p->queued.erase(p->queued.begin());
+    return millivolts;
+  }
+  return p->millivolts;
+}
+
+// 12 bits over the 0-3.3 V range of 11 dB attenuation
+uint16_t analogRead(uint8_t pin) {
+  uint32_t raw = analogReadMilliVolts(pin) * 4095 / 3300;
+  return raw > 4095 ? 4095 : raw;
+}
+
+// --- LEDC ---
+
+#define NATIVE_LEDC_CHANNELS 16
+
+struct LedcChannel {
+  uint32_t frequency;
+  uint8_t resolution;
+  uint32_t duty;
+};
+
+static LedcChannel ledc[NATIVE_LEDC_CHANNELS];
+
+uint32_t ledcSetup(uint8_t channel, uint32_t frequency, uint8_t resolution) {
+  if (channel >= NATIVE_LEDC_CHANNELS || resolution == 0 || resolution > 20) return 0;
+  if ((uint64_t)frequency << resolution > 80000000ULL) return 0;
+  ledc[channel].frequency = frequency;
+  ledc[channel].resolution = resolution;
+  return frequency;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+  if (Pin* p = pinAt(pin)) p->ledcChannel = channel;
+}
+
+void ledcDetachPin(uint8_t pin) {
+  if (Pin* p = pinAt(pin)) p->ledcChannel = -1;
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+  if (channel < NATIVE_LEDC_CHANNELS) ledc[channel].duty = duty;
+}
+
+uint32_t ledcRead(uint8_t channel) {
+  return channel < NATIVE_LEDC_CHANNELS ? ledc[channel].duty : 0;
+}
+
+// analogWrite() picks its own channel on the real core; here it just
+// records the level on the pin
+void analogWrite(uint8_t pin, int value) {
+  if (Pin* p = pinAt(pin)) p->level = value > 0 ? HIGH : LOW;
+}
+
+// --- Timers ---
+
+#define NATIVE_TIMERS 4
+
+struct hw_timer_s {
+  void (*isr)(void);
+  int intrFlags;
+  uint64_t alarm;
+  bool autoreload;
+  bool enabled;
+};
+
+static hw_timer_s timers[NATIVE_TIMERS];
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp) {
+  (void)divider;
+  (void)countUp;
+  if (num >= NATIVE_TIMERS) return nullptr;
+  timers[num] = hw_timer_s();
+  return &timers[num];
+}
+
+void timerEnd(hw_timer_t* timer) {
+  if (timer) *timer = hw_timer_s();
+}
+
+void timerAttachInterruptFlag(hw_timer_t* timer, void (*isr)(void), bool edge, int intrFlags) {
+  (void)edge;
+  if (!timer) return;
+  timer->isr = isr;
+  timer->intrFlags = intrFlags;
+}
+
+void timerAttachInterrupt(hw_timer_t* timer, void (*isr)(void), bool edge) {
+  timerAttachInterruptFlag(timer, isr, edge, 0);
+}
+
+void timerDetachInterrupt(hw_timer_t* timer) {
+  if (timer) timer->isr = nullptr;
+}
+
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarm, bool autoreload) {
+  if (!timer) return;
+  timer->alarm = alarm;
+  timer->autoreload = autoreload;
+}
+
+void timerAlarmEnable(hw_timer_t* timer) {
+  if (timer) timer->enabled = true;
+}
+
+void timerAlarmDisable(hw_timer_t* timer) {
+  if (timer) timer->enabled = false;
+}
+
+bool timerAlarmEnabled(hw_timer_t* timer) {
+  return timer && timer->enabled;
+}
+
+// --- Random ---
+
+static uint32_t randomState = 1;
+
+// xorshift32: fast, and the same sequence on every host
+uint32_t esp_random() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+void randomSeed(unsigned long seed) {
+  randomState = seed ? (uint32_t)seed : 1;
+}
+
+long random(long max) {
+  return max > 0 ? (long)(esp_random() % (unsigned long)max) : 0;
+}
+
+long random(long min, long max) {
+  return min < max ? min + random(max - min) : min;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  if (inMax == inMin) return outMin;
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// --- Serial ---
+
+#define NATIVE_SERIAL_KEEP 65536
+
+static String serialText;
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+// Kept for tests to inspect, echoed to stdout when ARDUINO_NATIVE_ECHO is set
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  static const bool echo = getenv("ARDUINO_NATIVE_ECHO") != nullptr;
+  if (echo) fwrite(buffer, 1, size, stdout);
+  if (serialText.length() + size > NATIVE_SERIAL_KEEP) serialText = "";
+  serialText.concat((const char*)buffer, size);
+  return size;
+}
+
+// --- ESP ---
+
+uint32_t EspClass::getFreeHeap() {
+  size_t used = native::allocStats().bytes;
+  return used < NATIVE_HEAP_BYTES ? NATIVE_HEAP_BYTES - used : 0;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  size_t peak = native::allocStats().peakBytes;
+  return peak < NATIVE_HEAP_BYTES ? NATIVE_HEAP_BYTES - peak : 0;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+  return getFreeHeap();
+}
+
+// 240 MHz
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t)(nowMicros * 240);
+}
+
+void EspClass::restart() {
+  fprintf(stderr, "ESP.restart() called\n");
+  abort();
+}
+
+// --- Test hooks ---
+
+namespace native {
+
+void reset() {
+  nowMicros = 0;
+  for (auto &pin : pins) {
+    pin = Pin();
+    pin.ledcChannel = -1;
+  }
+  for (auto &channel : ledc) channel = LedcChannel();
+  for (auto &timer : timers) timer = hw_timer_s();
+  randomSeed(1);
+  clearSerialOutput();
+  resetDrivers();
+  resetDht();
+}
+
+void advanceMicros(uint32_t us) {
+  nowMicros += us;
+}
+
+void advanceMillis(uint32_t ms) {
+  nowMicros += (uint64_t)ms * 1000;
+}
+
+uint8_t pinModeOf(uint8_t pin) {
+  Pin* p = pinAt(pin);
+  return p ? p->mode : 0;
+}
+
+uint8_t pinLevel(uint8_t pin) {
+  Pin* p = pinAt(pin);
+  return p ? p->level : LOW;
+}
+
+void setDigitalInput(uint8_t pin, uint8_t level) {
+  if (Pin* p = pinAt(pin)) p->input = level ? HIGH : LOW;
+}
+
+void setAnalogMillivolts(uint8_t pin, uint32_t millivolts) {
+  if (Pin* p = pinAt(pin)) p->millivolts = millivolts;
+}
+
+void queueAnalogMillivolts(uint8_t pin, const uint32_t* millivolts, size_t count) {
+  if (Pin* p = pinAt(pin)) p->queued.insert(p->queued.end(), millivolts, millivolts + count);
+}
+
+uint32_t analogReadCount(uint8_t pin) {
+  Pin* p = pinAt(pin);
+  return p ? p->analogReads : 0;
+}
+
+int ledcPinChannel(uint8_t pin) {
+  Pin* p = pinAt(pin);
+  return p ? p->ledcChannel : -1;
+}
+
+uint32_t ledcFrequency(uint8_t channel) {
+  return channel < NATIVE_LEDC_CHANNELS ? ledc[channel].frequency : 0;
+}
+
+uint32_t ledcDuty(uint8_t channel) {
+  return ledcRead(channel);
+}
+
+void fireTimer(uint8_t num, uint32_t times) {
+  if (num >= NATIVE_TIMERS) return;
+  hw_timer_s &timer = timers[num];
+  while (times-- && timer.enabled && timer.isr) {
+    timer.isr();
+    if (!timer.autoreload) timer.enabled = false;
+  }
+}
+
+uint64_t timerAlarm(uint8_t num) {
+  return num < NATIVE_TIMERS ? timers[num].alarm : 0;
+}
+
+int timerInterruptFlags(uint8_t num) {
+  return num < NATIVE_TIMERS ? timers[num].intrFlags : 0;
+}
+
+const String &serialOutput() {
+  return serialText;
+}
+
+void clearSerialOutput() {
+  serialText = "";
+}
+
+} // namespace native
+
+// Pins start without an LEDC channel even before the first reset()
+static struct PinInit {
+  PinInit() {
+    for (auto &pin : pins) pin.ledcChannel = -1;
+  }
+} pinInit;
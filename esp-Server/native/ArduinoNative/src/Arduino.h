@@ -0,0 +1,188 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// --- Arduino core stand-in ---
+//
+// Just enough of the Arduino-ESP32 core for the firmware libraries to
+// compile and run on the host, in the native environment. Time is a fake
+// clock that only moves when a test advances it (or calls delay()), pins
+// are plain arrays, and FreeRTOS calls are no-ops. See ArduinoNative.h for
+// the hooks tests use to drive all of this.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "esp_attr.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_TIMEOUT 0x107
+
+// --- Time ---
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);                 // advances the fake clock
+void delayMicroseconds(uint32_t us);
+
+// --- GPIO ---
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define PULLUP 0x04
+#define INPUT_PULLUP 0x05
+#define PULLDOWN 0x08
+#define INPUT_PULLDOWN 0x09
+
+#define NATIVE_PIN_COUNT 40
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+
+// --- Analog ---
+
+typedef enum { ADC_0db, ADC_2_5db, ADC_6db, ADC_11db } adc_attenuation_t;
+
+void analogReadResolution(uint8_t bits);
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation);
+uint16_t analogRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+// --- LEDC ---
+
+uint32_t ledcSetup(uint8_t channel, uint32_t frequency, uint8_t resolution);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcDetachPin(uint8_t pin);
+void ledcWrite(uint8_t channel, uint32_t duty);
+uint32_t ledcRead(uint8_t channel);
+
+// --- Hardware timers ---
+
+typedef struct hw_timer_s hw_timer_t;
+
+hw_timer_t* timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t* timer);
+void timerAttachInterrupt(hw_timer_t* timer, void (*isr)(void), bool edge);
+void timerAttachInterruptFlag(hw_timer_t* timer, void (*isr)(void), bool edge, int intrFlags);
+void timerDetachInterrupt(hw_timer_t* timer);
+void timerAlarmWrite(hw_timer_t* timer, uint64_t alarm, bool autoreload);
+void timerAlarmEnable(hw_timer_t* timer);
+void timerAlarmDisable(hw_timer_t* timer);
+bool timerAlarmEnabled(hw_timer_t* timer);
+
+// --- Random ---
+
+// Deterministic, reseeded by native::reset()
+uint32_t esp_random();
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// --- Math ---
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+// --- FreeRTOS ---
+//
+// One thread, so locks always succeed and tasks are never started; tests
+// call the work a task would do directly.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define ARDUINO_RUNNING_CORE 1
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+
+inline TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline void vTaskDelayUntil(TickType_t* lastWake, TickType_t ticks) { *lastWake += ticks; }
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+  if (handle) *handle = nullptr;
+  return pdPASS;
+}
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { static int mutex; return &mutex; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+
+// --- Serial ---
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int availableForWrite() override { return 128; }   // one UART FIFO
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+// --- ESP ---
+
+// Heap figures come from the allocation counters (see ArduinoNative.h),
+// measured against a heap of this size
+#define NATIVE_HEAP_BYTES (320 * 1024)
+
+class EspClass {
+public:
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  uint32_t getHeapSize() { return NATIVE_HEAP_BYTES; }
+  uint32_t getCycleCount();
+  void restart();
+};
+
+extern EspClass ESP;
+
+#endif // ARDUINO_H
@@ -0,0 +1,105 @@
+#ifndef ARDUINO_NATIVE_H
+#define ARDUINO_NATIVE_H
+
+#include <Arduino.h>
+#include <vector>
+
+// --- Test hooks for the native environment ---
+//
+// Everything the stand-in core keeps in place of hardware, for tests and
+// benchmarks to set up and inspect. Firmware code never includes this.
+
+namespace native {
+
+// Clock at 0, pins floating and low, no LEDC channels, timers, RMT or ADC
+// drivers or DHT sensors, random sequence restarted and Serial output
+// cleared. The filesystem is kept; see formatFs().
+void reset();
+
+// --- Clock ---
+
+void advanceMicros(uint32_t us);
+void advanceMillis(uint32_t ms);
+
+// --- Pins ---
+
+uint8_t pinModeOf(uint8_t pin);
+uint8_t pinLevel(uint8_t pin);             // last digitalWrite()
+void setDigitalInput(uint8_t pin, uint8_t level);
+void setAnalogMillivolts(uint8_t pin, uint32_t millivolts);
+
+// Successive analogReadMilliVolts() calls return these in turn, then the
+// fixed value again
+void queueAnalogMillivolts(uint8_t pin, const uint32_t* millivolts, size_t count);
+uint32_t analogReadCount(uint8_t pin);
+
+// --- LEDC ---
+
+int ledcPinChannel(uint8_t pin);            // -1 if the pin has none
+uint32_t ledcFrequency(uint8_t channel);
+uint32_t ledcDuty(uint8_t channel);
+
+// --- RMT ---
+
+// Items the translator produced for the last rmt_write_sample()
+const std::vector<uint32_t> &rmtItems(uint8_t channel);
+uint32_t rmtWrites(uint8_t channel);
+bool rmtInstalled(uint8_t channel);
+int rmtInterruptFlags(uint8_t channel);      // as passed to rmt_driver_install()
+
+// While busy, rmt_wait_tx_done() times out as if a frame were on the wire
+void setRmtBusy(uint8_t channel, bool busy);
+
+// --- ADC continuous mode ---
+
+// ADC1 channel mask the continuous driver is running with, 0 when stopped
+uint32_t adcDigiChannels();
+
+// --- DHT ---
+
+// Puts a sensor on pin; each readTemperature()/readHumidity() is counted
+void setDht(uint8_t pin, float temperature, float humidity);
+uint32_t dhtReadCount(uint8_t pin);
+
+// --- Timers ---
+
+// Runs the ISR of an enabled timer times times, as if its alarm had fired
+void fireTimer(uint8_t num, uint32_t times = 1);
+uint64_t timerAlarm(uint8_t num);
+int timerInterruptFlags(uint8_t num);       // as passed to timerAttachInterruptFlag()
+
+// --- Serial ---
+
+const String &serialOutput();
+void clearSerialOutput();
+
+// --- Filesystem ---
+
+// SPIFFS lives in a directory on the host: $ARDUINO_NATIVE_FS, or a fresh
+// one under /tmp for each process. formatFs() empties it.
+void setFsRoot(const char* dir);
+const char* fsRoot();
+void formatFs();
+
+// --- Heap ---
+
+// Counted for every malloc/new in the process (glibc only; elsewhere all
+// stay 0). Take a snapshot before and after the code under test.
+struct AllocStats {
+  uint64_t allocations;     // malloc, calloc, realloc and new calls
+  uint64_t frees;
+  size_t bytes;             // currently allocated
+  size_t peakBytes;         // high-water mark since resetPeakBytes()
+};
+
+AllocStats allocStats();
+void resetPeakBytes();
+
+// --- Internal ---
+
+void resetDrivers();
+void resetDht();
+
+} // namespace native
+
+#endif // ARDUINO_NATIVE_H
@@ -0,0 +1,42 @@
+#include "DHT.h"
+#include "ArduinoNative.h"
+
+struct DhtPin {
+  bool present;
+  float temperature;
+  float humidity;
+  uint32_t reads;
+};
+
+static DhtPin dhtPins[NATIVE_PIN_COUNT];
+
+float DHT::readTemperature(bool fahrenheit, bool force) {
+  (void)force;
+  if (pin >= NATIVE_PIN_COUNT || !dhtPins[pin].present) return NAN;
+  dhtPins[pin].reads++;
+  float celsius = dhtPins[pin].temperature;
+  return fahrenheit ? celsius * 1.8f + 32 : celsius;
+}
+
+float DHT::readHumidity(bool force) {
+  (void)force;
+  if (pin >= NATIVE_PIN_COUNT || !dhtPins[pin].present) return NAN;
+  dhtPins[pin].reads++;
+  return dhtPins[pin].humidity;
+}
+
+namespace native {
+
+void setDht(uint8_t pin, float temperature, float humidity) {
+  if (pin < NATIVE_PIN_COUNT) dhtPins[pin] = DhtPin{true, temperature, humidity, dhtPins[pin].reads};
+}
+
+uint32_t dhtReadCount(uint8_t pin) {
+  return pin < NATIVE_PIN_COUNT ? dhtPins[pin].reads : 0;
+}
+
+void resetDht() {
+  for (auto &dht : dhtPins) dht = DhtPin();
+}
+
+} // namespace native
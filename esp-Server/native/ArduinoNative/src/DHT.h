@@ -0,0 +1,25 @@
+#ifndef DHT_H
+#define DHT_H
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT22 22
+#define DHT21 21
+#define AM2301 21
+
+// Reads what native::setDht() put on the pin; NAN until then, like a
+// sensor that does not answer
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type, uint8_t count = 6) : pin(pin), type(type) { (void)count; }
+  void begin(uint8_t usec = 55) { (void)usec; }
+  float readTemperature(bool fahrenheit = false, bool force = false);
+  float readHumidity(bool force = false);
+
+private:
+  uint8_t pin;
+  uint8_t type;
+};
+
+#endif // DHT_H
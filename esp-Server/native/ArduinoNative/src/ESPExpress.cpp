@@ -0,0 +1,250 @@
+#include "ESPExpress.h"
+#include <SPIFFS.h>
+#include <strings.h>
+
+static String fieldValue(const NativeFields &fields, const String &name, bool ignoreCase) {
+  for (const auto &field : fields) {
+    if (ignoreCase ? field.first.equalsIgnoreCase(name) : field.first == name) return field.second;
+  }
+  return String();
+}
+
+// --- Request ---
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static String urlDecode(const String &text) {
+  String decoded;
+  for (unsigned int i = 0; i < text.length(); i++) {
+    char c = text[i];
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && i + 2 < text.length() && hexValue(text[i + 1]) >= 0 && hexValue(text[i + 2]) >= 0) {
+      c = (char)(hexValue(text[i + 1]) * 16 + hexValue(text[i + 2]));
+      i += 2;
+    }
+    decoded += c;
+  }
+  return decoded;
+}
+
+Request::Request(const char* method, const String &url, const String &body)
+  : method(method), body(body) {
+  int mark = url.indexOf('?');
+  path = mark < 0 ? url : url.substring(0, mark);
+  if (mark < 0) return;
+
+  String rest = url.substring(mark + 1);
+  while (rest.length()) {
+    int amp = rest.indexOf('&');
+    String pair = amp < 0 ? rest : rest.substring(0, amp);
+    rest = amp < 0 ? String() : rest.substring(amp + 1);
+    int eq = pair.indexOf('=');
+    if (eq < 0) query.push_back({urlDecode(pair), String()});
+    else query.push_back({urlDecode(pair.substring(0, eq)), urlDecode(pair.substring(eq + 1))});
+  }
+}
+
+String Request::getParam(const String &name) const {
+  return fieldValue(params, name, false);
+}
+
+String Request::getQuery(const String &name) const {
+  return fieldValue(query, name, false);
+}
+
+String Request::getHeader(const String &name) const {
+  return fieldValue(headers, name, true);
+}
+
+bool Request::hasHeader(const String &name) const {
+  for (const auto &field : headers) {
+    if (field.first.equalsIgnoreCase(name)) return true;
+  }
+  return false;
+}
+
+void Request::setHeader(const String &name, const String &value) {
+  headers.push_back({name, value});
+}
+
+// --- Response ---
+
+Response &Response::status(int code) {
+  statusCode = code;
+  return *this;
+}
+
+Response &Response::setHeader(const String &name, const String &value) {
+  for (auto &field : headers) {
+    if (field.first.equalsIgnoreCase(name)) {
+      field.second = value;
+      return *this;
+    }
+  }
+  headers.push_back({name, value});
+  return *this;
+}
+
+void Response::send(const String &content) {
+  contentType = header("Content-Type");
+  if (contentType.isEmpty()) contentType = "text/plain";
+  body = content;
+  sent = true;
+}
+
+void Response::sendJson(const String &json) {
+  contentType = "application/json";
+  body = json;
+  sent = true;
+}
+
+void Response::sendFile(const String &path) {
+  File file = SPIFFS.open(path, "r");
+  if (!file) {
+    status(404).send("File not found");
+    return;
+  }
+  contentType = header("Content-Type");
+  body = file.readString();
+  this->file = path;
+  sent = true;
+}
+
+String Response::header(const String &name) const {
+  return fieldValue(headers, name, true);
+}
+
+// --- Routing ---
+
+// "/api/device/:id" against "/api/device/fan1"; fills params on a match
+static bool matchRoute(const String &pattern, const String &path, NativeFields &params) {
+  NativeFields found;
+  unsigned int p = 0, u = 0;
+  while (p < pattern.length() && u < path.length()) {
+    if (pattern[p] == ':') {
+      int patternEnd = pattern.indexOf('/', p);
+      int pathEnd = path.indexOf('/', u);
+      if (patternEnd < 0) patternEnd = pattern.length();
+      if (pathEnd < 0) pathEnd = path.length();
+      if ((unsigned int)pathEnd == u) return false;
+      found.push_back({pattern.substring(p + 1, patternEnd), urlDecode(path.substring(u, pathEnd))});
+      p = patternEnd;
+      u = pathEnd;
+    } else if (pattern[p++] != path[u++]) {
+      return false;
+    }
+  }
+  if (p != pattern.length() || u != path.length()) return false;
+  params = found;
+  return true;
+}
+
+bool ESPExpress::dispatch(Request &req, Response &res) {
+  for (const auto &route : routes) {
+    if (route.method == req.method && matchRoute(route.pattern, req.path, req.params)) {
+      route.handler(req, res);
+      return true;
+    }
+  }
+
+  if (req.method == "GET") {
+    for (const auto &dir : staticDirs) {
+      if (!req.path.startsWith(dir.first)) continue;
+      String file = dir.second + req.path.substring(dir.first.length());
+      if (!SPIFFS.exists(file)) continue;
+      res.sendFile(file);
+      return true;
+    }
+  }
+  return false;
+}
+
+Response ESPExpress::handle(Request &req) {
+  Response res;
+  if (corsOrigin.length()) res.setHeader("Access-Control-Allow-Origin", corsOrigin);
+
+  // Each middleware decides whether the rest of the chain runs
+  size_t index = 0;
+  std::function<void()> next = [&]() {
+    if (index < middlewares.size()) {
+      middlewares[index++](req, res, next);
+    } else if (!dispatch(req, res)) {
+      res.status(404).send("Not Found");
+    }
+  };
+  next();
+  return res;
+}
+
+Response ESPExpress::handle(const char* method, const String &url, const String &body) {
+  Request req(method, url, body);
+  return handle(req);
+}
+
+void ESPExpress::serveStatic(const String &urlPrefix, const String &directory) {
+  staticDirs.push_back({urlPrefix, directory});
+}
+
+// --- WebSocket ---
+
+void ESPExpress::ws(const String &path, WebSocketHandler handler) {
+  (void)path;
+  wsHandler = handler;
+}
+
+bool ESPExpress::wsSendTXT(uint8_t num, const char* payload) {
+  if (!wsConnected(num) || failing[num]) return false;
+  sent[num].push_back(NativeWsMessage{false, payload});
+  return true;
+}
+
+bool ESPExpress::wsSendBIN(uint8_t num, const uint8_t* payload, size_t length) {
+  if (!wsConnected(num) || failing[num]) return false;
+  sent[num].push_back(NativeWsMessage{true, std::string((const char*)payload, length)});
+  return true;
+}
+
+void ESPExpress::wsFailSends(uint8_t num, bool fail) {
+  if (num < NATIVE_WS_CLIENTS) failing[num] = fail;
+}
+
+void ESPExpress::wsDisconnect(uint8_t num) {
+  if (wsConnected(num)) wsEvent(num, WStype_DISCONNECTED);
+}
+
+void ESPExpress::wsEvent(uint8_t num, WStype_t type, const uint8_t* payload, size_t length) {
+  if (num >= NATIVE_WS_CLIENTS) return;
+  if (type == WStype_CONNECTED) {
+    connected[num] = true;
+    failing[num] = false;
+  }
+  if (type == WStype_DISCONNECTED) connected[num] = false;
+  if (!wsHandler) return;
+
+  // The WebSockets library hands out a writable, NUL-terminated copy
+  std::string copy(payload ? (const char*)payload : "", length);
+  wsHandler(num, type, (uint8_t*)&copy[0], length);
+}
+
+void ESPExpress::wsEvent(uint8_t num, const char* text) {
+  wsEvent(num, WStype_TEXT, (const uint8_t*)text, strlen(text));
+}
+
+const std::vector<NativeWsMessage> &ESPExpress::wsSent(uint8_t num) const {
+  static const std::vector<NativeWsMessage> none;
+  return num < NATIVE_WS_CLIENTS ? sent[num] : none;
+}
+
+void ESPExpress::wsClear() {
+  for (auto &messages : sent) messages.clear();
+}
+
+bool ESPExpress::wsConnected(uint8_t num) const {
+  return num < NATIVE_WS_CLIENTS && connected[num];
+}
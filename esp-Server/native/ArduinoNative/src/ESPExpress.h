@@ -0,0 +1,149 @@
+#ifndef ESP_EXPRESS_H
+#define ESP_EXPRESS_H
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// --- ESPExpress stand-in ---
+//
+// Records routes, middleware and the WebSocket handler instead of opening
+// sockets. Tests and benchmarks feed requests through handle() and
+// WebSocket events through wsEvent(), then inspect the Response or the
+// messages a client was sent.
+
+typedef enum {
+  WStype_ERROR,
+  WStype_DISCONNECTED,
+  WStype_CONNECTED,
+  WStype_TEXT,
+  WStype_BIN,
+  WStype_FRAGMENT_TEXT_START,
+  WStype_FRAGMENT_BIN_START,
+  WStype_FRAGMENT,
+  WStype_FRAGMENT_FIN,
+  WStype_PING,
+  WStype_PONG,
+} WStype_t;
+
+#define NATIVE_WS_CLIENTS 8
+
+typedef std::vector<std::pair<String, String>> NativeFields;
+
+class Request {
+public:
+  Request() {}
+  // url may carry a query string
+  Request(const char* method, const String &url, const String &body = String());
+
+  String method;
+  String path;
+  String body;
+
+  String getParam(const String &name) const;
+  String getQuery(const String &name) const;
+  String getHeader(const String &name) const;
+  bool hasHeader(const String &name) const;
+  void setHeader(const String &name, const String &value);
+
+  NativeFields params;
+  NativeFields query;
+  NativeFields headers;
+};
+
+class Response {
+public:
+  Response &status(int code);
+  Response &setHeader(const String &name, const String &value);
+  void send(const String &content);
+  void sendJson(const String &json);
+  void sendFile(const String &path);
+
+  // What was sent. A Content-Type header set before sending is the type.
+  int statusCode = 200;
+  String contentType;
+  String body;
+  NativeFields headers;
+  bool sent = false;
+  String file;                // path given to sendFile()
+
+  String header(const String &name) const;
+};
+
+typedef std::function<void(Request &, Response &)> RouteHandler;
+typedef std::function<void(Request &, Response &, std::function<void()>)> Middleware;
+typedef std::function<void(uint8_t, WStype_t, uint8_t*, size_t)> WebSocketHandler;
+
+struct NativeWsMessage {
+  bool binary;
+  std::string data;
+};
+
+class ESPExpress {
+public:
+  explicit ESPExpress(uint16_t port) : port(port) {}
+
+  void get(const String &path, RouteHandler handler) { route("GET", path, handler); }
+  void post(const String &path, RouteHandler handler) { route("POST", path, handler); }
+  void put(const String &path, RouteHandler handler) { route("PUT", path, handler); }
+  void del(const String &path, RouteHandler handler) { route("DELETE", path, handler); }
+  void options(const String &path, RouteHandler handler) { route("OPTIONS", path, handler); }
+  void use(Middleware middleware) { middlewares.push_back(middleware); }
+  void enableCORS(const String &origin) { corsOrigin = origin; }
+  void serveStatic(const String &urlPrefix, const String &directory);
+  void listen(const char* message) { (void)message; }
+
+  void ws(const String &path, WebSocketHandler handler);
+  bool wsSendTXT(uint8_t num, String &payload) { return wsSendTXT(num, payload.c_str()); }
+  bool wsSendTXT(uint8_t num, const char* payload);
+  bool wsSendBIN(uint8_t num, const uint8_t* payload, size_t length);
+  void wsDisconnect(uint8_t num);
+  void wsLoop() {}
+
+  // --- Host side ---
+
+  // Runs the middleware chain and the matching route, as the server would
+  // for one HTTP request. Unmatched requests get a 404.
+  Response handle(Request &req);
+  Response handle(const char* method, const String &url, const String &body = String());
+
+  // Delivers an event to the WebSocket handler; WStype_CONNECTED and
+  // WStype_DISCONNECTED also track whether the client is there
+  void wsEvent(uint8_t num, WStype_t type, const uint8_t* payload = nullptr, size_t length = 0);
+  void wsEvent(uint8_t num, const char* text);
+
+  // Messages sent to a client since the last wsClear()
+  const std::vector<NativeWsMessage> &wsSent(uint8_t num) const;
+  void wsClear();
+  bool wsConnected(uint8_t num) const;
+
+  // While set, sends to the client fail as on a broken connection, and
+  // nothing is recorded
+  void wsFailSends(uint8_t num, bool fail);
+
+private:
+  struct Route {
+    String method;
+    String pattern;
+    RouteHandler handler;
+  };
+
+  void route(const char* method, const String &path, RouteHandler handler) {
+    routes.push_back(Route{method, path, handler});
+  }
+  bool dispatch(Request &req, Response &res);
+
+  uint16_t port;
+  std::vector<Route> routes;
+  std::vector<Middleware> middlewares;
+  std::vector<std::pair<String, String>> staticDirs;
+  String corsOrigin;
+  WebSocketHandler wsHandler;
+  bool connected[NATIVE_WS_CLIENTS] = {};
+  std::vector<NativeWsMessage> sent[NATIVE_WS_CLIENTS];
+  bool failing[NATIVE_WS_CLIENTS] = {};
+};
+
+#endif // ESP_EXPRESS_H
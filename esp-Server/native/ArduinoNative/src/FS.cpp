@@ -0,0 +1,215 @@
+#include "FS.h"
+#include "SPIFFS.h"
+#include "ArduinoNative.h"
+#include <errno.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+fs::SPIFFSFS SPIFFS;
+
+// Size of the default SPIFFS partition of a 4 MB ESP32
+#define NATIVE_FS_BYTES 1378241
+
+namespace fs {
+
+class FileImpl {
+public:
+  FileImpl(FILE* handle, const std::string &path) : handle(handle), path(path) {
+    size_t slash = path.rfind('/');
+    name = slash == std::string::npos ? path : path.substr(slash + 1);
+  }
+  ~FileImpl() { if (handle) fclose(handle); }
+
+  FILE* handle;
+  std::string path;
+  std::string name;
+};
+
+} // namespace fs
+
+// --- Root directory ---
+
+static std::string root;
+
+static const std::string &rootDir() {
+  if (root.empty()) {
+    const char* dir = getenv("ARDUINO_NATIVE_FS");
+    char name[64];
+    if (!dir) {
+      snprintf(name, sizeof(name), "/tmp/arduino-native-fs-%d", (int)getpid());
+      dir = name;
+    }
+    native::setFsRoot(dir);
+  }
+  return root;
+}
+
+static std::string hostPath(const char* path) {
+  std::string host = rootDir();
+  if (!path || *path != '/') host += '/';
+  return host + (path ? path : "");
+}
+
+// Creates the directories leading up to path
+static void makeParents(const std::string &path) {
+  for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+    mkdir(path.substr(0, slash).c_str(), 0755);
+  }
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+  return ::remove(path);
+}
+
+static size_t usedTotal = 0;
+
+static int addSize(const char*, const struct stat* info, int type, struct FTW*) {
+  if (type == FTW_F) usedTotal += info->st_size;
+  return 0;
+}
+
+// --- File ---
+
+namespace fs {
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+  return impl ? fwrite(buffer, 1, size, impl->handle) : 0;
+}
+
+int File::available() {
+  if (!impl) return 0;
+  size_t at = position();
+  size_t end = size();
+  return end > at ? (int)(end - at) : 0;
+}
+
+int File::read() {
+  return impl ? fgetc(impl->handle) : -1;
+}
+
+int File::peek() {
+  if (!impl) return -1;
+  int c = fgetc(impl->handle);
+  if (c != EOF) ungetc(c, impl->handle);
+  return c;
+}
+
+void File::flush() {
+  if (impl) fflush(impl->handle);
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+  return impl ? fread(buffer, 1, size, impl->handle) : 0;
+}
+
+bool File::seek(uint32_t position) {
+  return impl && fseek(impl->handle, position, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+  return impl ? (size_t)ftell(impl->handle) : 0;
+}
+
+size_t File::size() const {
+  if (!impl) return 0;
+  fflush(impl->handle);
+  struct stat info;
+  return fstat(fileno(impl->handle), &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+void File::close() {
+  impl.reset();
+}
+
+const char* File::name() const {
+  return impl ? impl->name.c_str() : "";
+}
+
+const char* File::path() const {
+  return impl ? impl->path.c_str() : "";
+}
+
+// --- FS ---
+
+bool FS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+  (void)formatOnFail;
+  (void)basePath;
+  (void)maxOpenFiles;
+  (void)partitionLabel;
+  return access(rootDir().c_str(), W_OK) == 0;
+}
+
+bool FS::format() {
+  native::formatFs();
+  return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+  std::string host = hostPath(path);
+  const char* hostMode = "rb";
+  if (mode[0] == 'w') hostMode = mode[1] == '+' ? "w+b" : "wb";
+  else if (mode[0] == 'a') hostMode = mode[1] == '+' ? "a+b" : "ab";
+  else if (mode[1] == '+') hostMode = "r+b";
+
+  if (mode[0] != 'r') makeParents(host);
+  FILE* handle = fopen(host.c_str(), hostMode);
+  if (!handle) return File();
+  return File(std::make_shared<FileImpl>(handle, path));
+}
+
+bool FS::exists(const char* path) {
+  struct stat info;
+  return stat(hostPath(path).c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+bool FS::remove(const char* path) {
+  return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+  if (exists(to)) return false;
+  std::string target = hostPath(to);
+  makeParents(target);
+  return ::rename(hostPath(from).c_str(), target.c_str()) == 0;
+}
+
+size_t FS::totalBytes() {
+  return NATIVE_FS_BYTES;
+}
+
+size_t FS::usedBytes() {
+  usedTotal = 0;
+  nftw(rootDir().c_str(), addSize, 16, FTW_PHYS);
+  return usedTotal;
+}
+
+} // namespace fs
+
+// --- Test hooks ---
+
+namespace native {
+
+void setFsRoot(const char* dir) {
+  root = dir;
+  while (root.size() > 1 && root.back() == '/') root.pop_back();
+  makeParents(root + "/");
+}
+
+const char* fsRoot() {
+  return rootDir().c_str();
+}
+
+// Removes everything below the root, keeping the root itself
+void formatFs() {
+  nftw(rootDir().c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  mkdir(root.c_str(), 0755);
+}
+
+} // namespace native
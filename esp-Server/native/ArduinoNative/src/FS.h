@@ -0,0 +1,72 @@
+#ifndef FS_H
+#define FS_H
+
+#include <Arduino.h>
+#include <memory>
+
+// --- Filesystem ---
+//
+// The fs::FS / fs::File API over a directory on the host (see
+// native::setFsRoot). Paths keep their SPIFFS form ("/devices.bin") and
+// are mapped below the root. Like SPIFFS, rename() refuses to replace an
+// existing file.
+
+namespace fs {
+
+class FileImpl;
+
+class File : public Stream {
+public:
+  File() {}
+  explicit File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override;
+
+  size_t read(uint8_t* buffer, size_t size);
+  bool seek(uint32_t position);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  const char* name() const;
+  const char* path() const;
+  bool isDirectory() const { return false; }
+  File openNextFile() { return File(); }
+
+  operator bool() const { return (bool)impl; }
+
+private:
+  std::shared_ptr<FileImpl> impl;
+};
+
+class FS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/spiffs", uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = nullptr);
+  void end() {}
+  bool format();
+
+  File open(const char* path, const char* mode = "r");
+  File open(const String &path, const char* mode = "r") { return open(path.c_str(), mode); }
+  bool exists(const char* path);
+  bool exists(const String &path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String &path) { return remove(path.c_str()); }
+  bool rename(const char* from, const char* to);
+  bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+
+  size_t totalBytes();
+  size_t usedBytes();
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // FS_H
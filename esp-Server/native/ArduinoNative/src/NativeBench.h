@@ -0,0 +1,75 @@
+#ifndef NATIVE_BENCH_H
+#define NATIVE_BENCH_H
+
+#include "ArduinoNative.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+// --- Benchmarks ---
+//
+// Wall-clock timing on the host, plus the heap counters from
+// ArduinoNative.h. Absolute times say little about the ESP32; compare runs
+// of the same benchmark, and treat allocation counts and peak bytes as
+// exact.
+
+namespace native {
+
+struct BenchResult {
+  uint32_t iterations;
+  double meanUs;
+  double p50Us;
+  double p99Us;
+  double allocationsPerRun;
+  size_t peakBytes;           // above the heap in use before the first run
+};
+
+inline double nowUs() {
+  using namespace std::chrono;
+  return duration_cast<duration<double, std::micro>>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Runs fn iterations times after a few warm-up runs
+template <typename Fn>
+BenchResult bench(uint32_t iterations, Fn fn) {
+  for (uint32_t i = 0; i < 3; i++) fn();
+
+  std::vector<double> times;
+  times.reserve(iterations);
+  AllocStats before = allocStats();
+  resetPeakBytes();
+  for (uint32_t i = 0; i < iterations; i++) {
+    double start = nowUs();
+    fn();
+    times.push_back(nowUs() - start);
+  }
+  AllocStats after = allocStats();
+
+  // The times vector was reserved up front, so it adds no allocations
+  BenchResult result;
+  result.iterations = iterations;
+  double total = 0;
+  for (double t : times) total += t;
+  result.meanUs = iterations ? total / iterations : 0;
+  std::sort(times.begin(), times.end());
+  result.p50Us = iterations ? times[iterations / 2] : 0;
+  result.p99Us = iterations ? times[(size_t)(iterations * 0.99)] : 0;
+  result.allocationsPerRun = iterations ? (double)(after.allocations - before.allocations) / iterations : 0;
+  result.peakBytes = after.peakBytes > before.bytes ? after.peakBytes - before.bytes : 0;
+  return result;
+}
+
+inline void printBenchHeader(const char* title) {
+  printf("\n%s\n", title);
+  printf("  %-36s %10s %10s %10s %10s %12s\n", "case", "mean us", "p50 us", "p99 us", "allocs", "peak bytes");
+}
+
+inline void printBench(const char* name, const BenchResult &result) {
+  printf("  %-36s %10.2f %10.2f %10.2f %10.1f %12zu\n", name, result.meanUs, result.p50Us, result.p99Us,
+         result.allocationsPerRun, result.peakBytes);
+}
+
+} // namespace native
+
+#endif // NATIVE_BENCH_H
@@ -0,0 +1,39 @@
+#include "Print.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <vector>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    if (!write(*buffer++)) break;
+    written++;
+  }
+  return written;
+}
+
+size_t Print::print(long value, int base) {
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int decimals) {
+  return print(String(value, (unsigned int)decimals));
+}
+
+size_t Print::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(nullptr, 0, format, args);
+  va_end(args);
+  if (length <= 0) return 0;
+
+  std::vector<char> buffer(length + 1);
+  va_start(args, format);
+  vsnprintf(buffer.data(), buffer.size(), format, args);
+  va_end(args);
+  return write(buffer.data(), length);
+}
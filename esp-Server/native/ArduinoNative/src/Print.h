@@ -0,0 +1,46 @@
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+
+// --- Print ---
+//
+// Same overload set as the Arduino core, so code that picks print(value)
+// by type formats the same way on the host.
+
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const String &str) { return write(str.c_str(), str.length()); }
+  size_t print(const char* str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int decimals = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value) { size_t written = print(value); return written + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+#endif // PRINT_H
@@ -0,0 +1,14 @@
+#ifndef SPIFFS_H
+#define SPIFFS_H
+
+#include "FS.h"
+
+namespace fs {
+
+class SPIFFSFS : public FS {};
+
+} // namespace fs
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif // SPIFFS_H
@@ -0,0 +1,28 @@
+#include "Stream.h"
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = read();
+    if (c < 0) break;
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = read();
+    if (c < 0 || c == terminator) break;
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+String Stream::readString() {
+  String result;
+  int c;
+  while ((c = read()) >= 0) result += (char)c;
+  return result;
+}
@@ -0,0 +1,23 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "Print.h"
+
+// --- Stream ---
+//
+// Reads are non-blocking on the host: there is never more data coming than
+// what available() reports, so there is no timeout.
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  size_t readBytes(char* buffer, size_t length);
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+  size_t readBytesUntil(char terminator, char* buffer, size_t length);
+  String readString();
+};
+
+#endif // STREAM_H
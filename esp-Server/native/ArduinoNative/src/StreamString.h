@@ -0,0 +1,23 @@
+#ifndef STREAM_STRING_H
+#define STREAM_STRING_H
+
+#include <Arduino.h>
+
+// A String that can be printed into, as in the Arduino core
+class StreamString : public Stream, public String {
+public:
+  size_t write(uint8_t c) override { return concat((char)c) ? 1 : 0; }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    return concat((const char*)buffer, size) ? size : 0;
+  }
+  using Print::write;
+
+  int available() override { return length() - readAt; }
+  int read() override { return readAt < length() ? (uint8_t)charAt(readAt++) : -1; }
+  int peek() override { return readAt < length() ? (uint8_t)charAt(readAt) : -1; }
+
+private:
+  unsigned int readAt = 0;
+};
+
+#endif // STREAM_STRING_H
@@ -0,0 +1,87 @@
+#include "WString.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+static std::string formatInteger(unsigned long value, bool negative, unsigned char base) {
+  if (base < 2 || base > 36) base = 10;
+  char digits[72];
+  char* p = digits + sizeof(digits);
+  *--p = 0;
+  do {
+    unsigned digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value);
+  if (negative) *--p = '-';
+  return p;
+}
+
+static std::string formatSigned(long value, unsigned char base) {
+  // The Arduino core only prints a minus sign in base 10
+  if (base == 10 && value < 0) return formatInteger(0UL - (unsigned long)value, true, base);
+  return formatInteger((unsigned long)value, false, base);
+}
+
+static std::string formatFloat(double value, unsigned int decimals) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+  return buffer;
+}
+
+String::String(unsigned char value, unsigned char base) : s(formatInteger(value, false, base)) {}
+String::String(int value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : s(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : s(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : s(formatInteger(value, false, base)) {}
+String::String(float value, unsigned int decimals) : s(formatFloat(value, decimals)) {}
+String::String(double value, unsigned int decimals) : s(formatFloat(value, decimals)) {}
+
+bool String::equalsIgnoreCase(const String &other) const {
+  return s.size() == other.s.size() && strcasecmp(s.c_str(), other.s.c_str()) == 0;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    unsigned int swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from >= s.size()) return String();
+  if (to > s.size()) to = s.size();
+  return String(s.substr(from, to - from));
+}
+
+void String::replace(const String &find, const String &replacement) {
+  if (find.s.empty()) return;
+  size_t pos = 0;
+  while ((pos = s.find(find.s, pos)) != std::string::npos) {
+    s.replace(pos, find.s.size(), replacement.s);
+    pos += replacement.s.size();
+  }
+}
+
+void String::trim() {
+  size_t begin = 0;
+  while (begin < s.size() && isspace((unsigned char)s[begin])) begin++;
+  size_t end = s.size();
+  while (end > begin && isspace((unsigned char)s[end - 1])) end--;
+  s = s.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+  for (auto &c : s) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+  for (auto &c : s) c = toupper((unsigned char)c);
+}
+
+long String::toInt() const {
+  return atol(s.c_str());
+}
+
+float String::toFloat() const {
+  return atof(s.c_str());
+}
@@ -0,0 +1,113 @@
+#ifndef WSTRING_H
+#define WSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// --- String ---
+//
+// The subset of the Arduino String the firmware and ArduinoJson use, kept
+// on a std::string. Unlike the real one it never fails to allocate.
+
+class StringSumHelper;
+
+class String {
+public:
+  String() {}
+  String(const char* cstr) : s(cstr ? cstr : "") {}
+  String(const char* cstr, unsigned int length) : s(cstr ? std::string(cstr, length) : std::string()) {}
+  String(const std::string &str) : s(str) {}
+  explicit String(char c) : s(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned int decimals = 2);
+  explicit String(double value, unsigned int decimals = 2);
+
+  String &operator=(const char* cstr) { s = cstr ? cstr : ""; return *this; }
+
+  const char* c_str() const { return s.c_str(); }
+  unsigned int length() const { return s.size(); }
+  bool isEmpty() const { return s.empty(); }
+  bool reserve(unsigned int size) { s.reserve(size); return true; }
+
+  bool concat(const String &str) { s += str.s; return true; }
+  bool concat(const char* cstr) { if (!cstr) return false; s += cstr; return true; }
+  bool concat(const char* cstr, unsigned int length) { if (!cstr) return false; s.append(cstr, length); return true; }
+  bool concat(char c) { s += c; return true; }
+  bool concat(int value) { return concat(String(value)); }
+  bool concat(unsigned int value) { return concat(String(value)); }
+  bool concat(long value) { return concat(String(value)); }
+  bool concat(unsigned long value) { return concat(String(value)); }
+  bool concat(float value) { return concat(String(value)); }
+  bool concat(double value) { return concat(String(value)); }
+
+  template <typename T>
+  String &operator+=(const T &value) { concat(value); return *this; }
+
+  bool equals(const String &other) const { return s == other.s; }
+  bool equals(const char* cstr) const { return s == (cstr ? cstr : ""); }
+  bool equalsIgnoreCase(const String &other) const;
+  bool operator==(const String &other) const { return equals(other); }
+  bool operator==(const char* cstr) const { return equals(cstr); }
+  bool operator!=(const String &other) const { return !equals(other); }
+  bool operator!=(const char* cstr) const { return !equals(cstr); }
+  bool operator<(const String &other) const { return s < other.s; }
+  bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+  bool endsWith(const String &suffix) const {
+    return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+  }
+
+  char charAt(unsigned int index) const { return index < s.size() ? s[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index) { return s[index]; }
+
+  int indexOf(char c, unsigned int from = 0) const { return position(s.find(c, from)); }
+  int indexOf(const String &str, unsigned int from = 0) const { return position(s.find(str.s, from)); }
+  int lastIndexOf(char c) const { return position(s.rfind(c)); }
+  int lastIndexOf(const String &str) const { return position(s.rfind(str.s)); }
+  String substring(unsigned int from) const { return substring(from, s.size()); }
+  String substring(unsigned int from, unsigned int to) const;
+
+  void remove(unsigned int index) { if (index < s.size()) s.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < s.size()) s.erase(index, count); }
+  void replace(const String &find, const String &replacement);
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+
+  long toInt() const;
+  float toFloat() const;
+
+private:
+  static int position(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+  std::string s;
+};
+
+// Result of a + chain, as in the Arduino core; ArduinoJson adapts it too
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String &str) : String(str) {}
+};
+
+template <typename T>
+StringSumHelper operator+(const String &lhs, const T &rhs) {
+  StringSumHelper sum(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+inline StringSumHelper operator+(const char* lhs, const String &rhs) {
+  StringSumHelper sum{String(lhs)};
+  sum.concat(rhs);
+  return sum;
+}
+
+inline bool operator==(const char* lhs, const String &rhs) { return rhs == lhs; }
+inline bool operator!=(const char* lhs, const String &rhs) { return rhs != lhs; }
+
+#endif // WSTRING_H
@@ -0,0 +1,22 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <Arduino.h>
+
+// Always connected, on the loopback address
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+class WiFiClass {
+public:
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr) {
+    (void)ssid;
+    (void)passphrase;
+    return WL_CONNECTED;
+  }
+  wl_status_t status() { return WL_CONNECTED; }
+  String localIP() { return "127.0.0.1"; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // WIFI_H
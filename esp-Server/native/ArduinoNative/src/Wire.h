@@ -0,0 +1,25 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+// No I2C devices on the host: every transmission is NACKed
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) {
+    (void)sda;
+    (void)scl;
+    (void)frequency;
+    return true;
+  }
+  void beginTransmission(uint8_t address) { (void)address; }
+  uint8_t endTransmission(bool sendStop = true) { (void)sendStop; return 2; }
+  uint8_t requestFrom(uint8_t address, uint8_t quantity) { (void)address; (void)quantity; return 0; }
+  size_t write(uint8_t data) { (void)data; return 0; }
+  int available() { return 0; }
+  int read() { return -1; }
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
@@ -0,0 +1,115 @@
+// Counts heap use by wrapping the C allocator. glibc exports its own entry
+// points as __libc_*, so malloc and friends defined here take precedence
+// for the whole process, operator new included.
+
+#include "ArduinoNative.h"
+#include <atomic>
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+static std::atomic<uint64_t> allocations(0);
+static std::atomic<uint64_t> frees(0);
+static std::atomic<size_t> currentBytes(0);
+static std::atomic<size_t> peakBytes(0);
+
+static void* counted(void* ptr) {
+  if (!ptr) return ptr;
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  size_t now = currentBytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed)
+    + malloc_usable_size(ptr);
+  size_t peak = peakBytes.load(std::memory_order_relaxed);
+  while (now > peak && !peakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+  return ptr;
+}
+
+static void released(void* ptr) {
+  if (!ptr) return;
+  frees.fetch_add(1, std::memory_order_relaxed);
+  currentBytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+}
+
+extern "C" {
+
+void* malloc(size_t size) {
+  return counted(__libc_malloc(size));
+}
+
+void* calloc(size_t count, size_t size) {
+  return counted(__libc_calloc(count, size));
+}
+
+void* realloc(void* ptr, size_t size) {
+  released(ptr);
+  void* result = __libc_realloc(ptr, size);
+  if (!result && size) {
+    // The old block is still there
+    currentBytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+    return result;
+  }
+  return counted(result);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  return counted(__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  return counted(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  void* result = counted(__libc_memalign(alignment, size));
+  if (!result) return 12;   // ENOMEM
+  *ptr = result;
+  return 0;
+}
+
+void free(void* ptr) {
+  released(ptr);
+  __libc_free(ptr);
+}
+
+} // extern "C"
+
+namespace native {
+
+AllocStats allocStats() {
+  AllocStats stats;
+  stats.allocations = allocations.load(std::memory_order_relaxed);
+  stats.frees = frees.load(std::memory_order_relaxed);
+  stats.bytes = currentBytes.load(std::memory_order_relaxed);
+  stats.peakBytes = peakBytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void resetPeakBytes() {
+  peakBytes.store(currentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+} // namespace native
+
+#else
+
+// Sanitizers and other C libraries bring their own allocator; heap figures
+// read as zero there
+namespace native {
+
+AllocStats allocStats() {
+  return AllocStats();
+}
+
+void resetPeakBytes() {}
+
+} // namespace native
+
+#endif
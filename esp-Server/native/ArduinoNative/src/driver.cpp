@@ -0,0 +1,239 @@
+#include "driver/adc.h"
+#include "driver/ledc.h"
+#include "driver/rmt.h"
+#include "esp_adc_cal.h"
+#include "ArduinoNative.h"
+#include <vector>
+
+// --- LEDC fades ---
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags) {
+  (void)intr_alloc_flags;
+  return ESP_OK;
+}
+
+void ledc_fade_func_uninstall() {}
+
+static uint32_t fadeTarget[LEDC_SPEED_MODE_MAX * LEDC_CHANNEL_MAX];
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty,
+                                  int max_fade_time_ms) {
+  (void)max_fade_time_ms;
+  if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+  fadeTarget[speed_mode * LEDC_CHANNEL_MAX + channel] = target_duty;
+  return ESP_OK;
+}
+
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_fade_mode_t fade_mode) {
+  (void)fade_mode;
+  if (speed_mode >= LEDC_SPEED_MODE_MAX || channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+  uint8_t index = speed_mode * LEDC_CHANNEL_MAX + channel;
+  ledcWrite(index, fadeTarget[index]);
+  return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel) {
+  return ledcRead(speed_mode * LEDC_CHANNEL_MAX + channel);
+}
+
+// --- RMT ---
+
+struct RmtChannel {
+  bool configured;
+  bool installed;
+  uint8_t memBlocks;
+  int intrFlags;
+  sample_to_rmt_t translator;
+  std::vector<uint32_t> items;
+  uint32_t writes;
+  bool busy;
+};
+
+static RmtChannel rmt[RMT_CHANNEL_MAX];
+
+esp_err_t rmt_config(const rmt_config_t* rmt_param) {
+  if (!rmt_param || rmt_param->channel >= RMT_CHANNEL_MAX || rmt_param->mem_block_num == 0
+      || rmt_param->channel + rmt_param->mem_block_num > RMT_CHANNEL_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  RmtChannel &ch = rmt[rmt_param->channel];
+  ch.configured = true;
+  ch.memBlocks = rmt_param->mem_block_num;
+  return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+  (void)rx_buf_size;
+  if (channel >= RMT_CHANNEL_MAX || !rmt[channel].configured || rmt[channel].installed) return ESP_FAIL;
+  rmt[channel].installed = true;
+  rmt[channel].intrFlags = intr_alloc_flags;
+  return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+  if (channel >= RMT_CHANNEL_MAX || !rmt[channel].installed) return ESP_FAIL;
+  rmt[channel] = RmtChannel();
+  return ESP_OK;
+}
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn) {
+  if (channel >= RMT_CHANNEL_MAX || !rmt[channel].installed || !fn) return ESP_FAIL;
+  rmt[channel].translator = fn;
+  return ESP_OK;
+}
+
+// Same refill pattern as the driver: half the channel memory per call
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t* src, size_t src_size, bool wait_tx_done) {
+  (void)wait_tx_done;
+  if (channel >= RMT_CHANNEL_MAX || !rmt[channel].translator) return ESP_FAIL;
+  RmtChannel &ch = rmt[channel];
+  ch.items.clear();
+  ch.writes++;
+
+  size_t chunkItems = ch.memBlocks * RMT_MEM_ITEM_NUM / 2;
+  std::vector<rmt_item32_t> chunk(chunkItems);
+  while (src_size > 0) {
+    size_t translated = 0, count = 0;
+    ch.translator(src, chunk.data(), src_size, chunkItems, &translated, &count);
+    if (translated == 0 || translated > src_size || count > chunkItems) return ESP_FAIL;
+    for (size_t i = 0; i < count; i++) ch.items.push_back(chunk[i].val);
+    src += translated;
+    src_size -= translated;
+  }
+  return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time) {
+  (void)wait_time;
+  if (channel >= RMT_CHANNEL_MAX || !rmt[channel].installed) return ESP_FAIL;
+  return rmt[channel].busy ? ESP_ERR_TIMEOUT : ESP_OK;
+}
+
+// --- ADC continuous mode ---
+
+// GPIO of each ADC1 channel
+static const uint8_t ADC1_PINS[8] = {36, 37, 38, 39, 32, 33, 34, 35};
+
+struct AdcDigi {
+  bool initialized;
+  bool started;
+  uint32_t channels;
+  std::vector<uint8_t> pattern;
+  uint32_t rateHz;
+  unsigned long startedAt;
+  uint64_t delivered;         // conversions handed out since the start
+};
+
+static AdcDigi adcDigi;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config) {
+  if (!init_config || adcDigi.initialized || init_config->adc2_chan_mask) return ESP_ERR_INVALID_ARG;
+  adcDigi.initialized = true;
+  adcDigi.channels = init_config->adc1_chan_mask;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config) {
+  if (!adcDigi.initialized) return ESP_ERR_INVALID_STATE;
+  if (!config || config->pattern_num == 0 || config->sample_freq_hz < 20000
+      || config->conv_mode != ADC_CONV_SINGLE_UNIT_1 || config->format != ADC_DIGI_OUTPUT_FORMAT_TYPE1) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  adcDigi.pattern.clear();
+  for (uint32_t i = 0; i < config->pattern_num; i++) {
+    const adc_digi_pattern_config_t &entry = config->adc_pattern[i];
+    if (entry.unit != 0 || entry.channel >= 8 || !(adcDigi.channels & (1UL << entry.channel))) return ESP_ERR_INVALID_ARG;
+    adcDigi.pattern.push_back(entry.channel);
+  }
+  adcDigi.rateHz = config->sample_freq_hz;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_start() {
+  if (!adcDigi.initialized || adcDigi.pattern.empty()) return ESP_ERR_INVALID_STATE;
+  adcDigi.started = true;
+  adcDigi.startedAt = micros();
+  adcDigi.delivered = 0;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_stop() {
+  adcDigi.started = false;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms) {
+  (void)timeout_ms;
+  *out_length = 0;
+  if (!adcDigi.started) return ESP_ERR_INVALID_STATE;
+
+  uint64_t due = (uint64_t)(micros() - adcDigi.startedAt) * adcDigi.rateHz / 1000000 - adcDigi.delivered;
+  uint32_t count = length_max / sizeof(adc_digi_output_data_t);
+  if (due < count) count = due;
+  for (uint32_t i = 0; i < count; i++) {
+    uint8_t channel = adcDigi.pattern[adcDigi.delivered++ % adcDigi.pattern.size()];
+    uint32_t raw = analogReadMilliVolts(ADC1_PINS[channel]);
+    adc_digi_output_data_t conversion;
+    conversion.type1.data = raw > 4095 ? 4095 : raw;
+    conversion.type1.channel = channel;
+    memcpy(buf + i * sizeof(conversion), &conversion, sizeof(conversion));
+  }
+  *out_length = count * sizeof(adc_digi_output_data_t);
+  return count ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t adc_digi_deinitialize() {
+  adcDigi = AdcDigi();
+  return ESP_OK;
+}
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t* chars) {
+  chars->adc_num = adc_num;
+  chars->atten = atten;
+  chars->bit_width = bit_width;
+  chars->vref = default_vref;
+  return ESP_ADC_CAL_VAL_EFUSE_VREF;
+}
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t* chars) {
+  (void)chars;
+  return adc_reading;
+}
+
+// --- Test hooks ---
+
+namespace native {
+
+const std::vector<uint32_t> &rmtItems(uint8_t channel) {
+  static const std::vector<uint32_t> none;
+  return channel < RMT_CHANNEL_MAX ? rmt[channel].items : none;
+}
+
+uint32_t rmtWrites(uint8_t channel) {
+  return channel < RMT_CHANNEL_MAX ? rmt[channel].writes : 0;
+}
+
+bool rmtInstalled(uint8_t channel) {
+  return channel < RMT_CHANNEL_MAX && rmt[channel].installed;
+}
+
+int rmtInterruptFlags(uint8_t channel) {
+  return channel < RMT_CHANNEL_MAX ? rmt[channel].intrFlags : 0;
+}
+
+void setRmtBusy(uint8_t channel, bool busy) {
+  if (channel < RMT_CHANNEL_MAX) rmt[channel].busy = busy;
+}
+
+uint32_t adcDigiChannels() {
+  return adcDigi.started ? adcDigi.channels : 0;
+}
+
+void resetDrivers() {
+  for (auto &ch : rmt) ch = RmtChannel();
+  adcDigi = AdcDigi();
+  for (auto &target : fadeTarget) target = 0;
+}
+
+} // namespace native
@@ -0,0 +1,63 @@
+#ifndef DRIVER_ADC_H
+#define DRIVER_ADC_H
+
+#include <Arduino.h>
+
+// IDF 4.4 ADC continuous (DMA) mode, ADC1 only. Conversions accrue with the
+// fake clock at the configured rate, round-robin over the pattern, and
+// adc_digi_read_bytes() hands out the ones due so far. Each conversion's raw
+// value is the pin's analogReadMilliVolts(), so queued and fixed levels
+// work as for one-shot reads, and the native calibration (esp_adc_cal.h)
+// maps it back one millivolt per count.
+
+typedef enum { ADC_UNIT_1 = 1, ADC_UNIT_2 = 2 } adc_unit_t;
+typedef enum { ADC_ATTEN_DB_0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_11 } adc_atten_t;
+typedef enum { ADC_WIDTH_BIT_9, ADC_WIDTH_BIT_10, ADC_WIDTH_BIT_11, ADC_WIDTH_BIT_12 } adc_bits_width_t;
+typedef enum {
+  ADC_CONV_SINGLE_UNIT_1 = 1, ADC_CONV_SINGLE_UNIT_2 = 2, ADC_CONV_BOTH_UNIT = 3, ADC_CONV_ALTER_UNIT = 7
+} adc_digi_convert_mode_t;
+typedef enum { ADC_DIGI_OUTPUT_FORMAT_TYPE1, ADC_DIGI_OUTPUT_FORMAT_TYPE2 } adc_digi_output_format_t;
+
+typedef struct {
+  uint32_t max_store_buf_size;
+  uint32_t conv_num_each_intr;
+  uint32_t adc1_chan_mask;
+  uint32_t adc2_chan_mask;
+} adc_digi_init_config_t;
+
+typedef struct {
+  uint8_t atten;
+  uint8_t channel;
+  uint8_t unit;
+  uint8_t bit_width;
+} adc_digi_pattern_config_t;
+
+typedef struct {
+  bool conv_limit_en;
+  uint32_t conv_limit_num;
+  uint32_t pattern_num;
+  adc_digi_pattern_config_t* adc_pattern;
+  uint32_t sample_freq_hz;
+  adc_digi_convert_mode_t conv_mode;
+  adc_digi_output_format_t format;
+} adc_digi_configuration_t;
+
+// ESP32 DMA output: one 16-bit word per conversion
+typedef struct {
+  union {
+    struct {
+      uint16_t data : 12;
+      uint16_t channel : 4;
+    } type1;
+    uint16_t val;
+  };
+} adc_digi_output_data_t;
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* init_config);
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* config);
+esp_err_t adc_digi_start();
+esp_err_t adc_digi_stop();
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms);
+esp_err_t adc_digi_deinitialize();
+
+#endif // DRIVER_ADC_H
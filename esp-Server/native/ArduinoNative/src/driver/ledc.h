@@ -0,0 +1,26 @@
+#ifndef DRIVER_LEDC_H
+#define DRIVER_LEDC_H
+
+#include <Arduino.h>
+
+// IDF LEDC fade API on top of the Arduino channels: channel n of speed mode
+// m is Arduino channel m * 8 + n. A fade lands on its target duty at once.
+
+typedef enum { LEDC_HIGH_SPEED_MODE, LEDC_LOW_SPEED_MODE, LEDC_SPEED_MODE_MAX } ledc_mode_t;
+
+typedef enum {
+  LEDC_CHANNEL_0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3,
+  LEDC_CHANNEL_4, LEDC_CHANNEL_5, LEDC_CHANNEL_6, LEDC_CHANNEL_7,
+  LEDC_CHANNEL_MAX
+} ledc_channel_t;
+
+typedef enum { LEDC_FADE_NO_WAIT, LEDC_FADE_WAIT_DONE, LEDC_FADE_MAX } ledc_fade_mode_t;
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags);
+void ledc_fade_func_uninstall();
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty,
+                                  int max_fade_time_ms);
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_fade_mode_t fade_mode);
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel);
+
+#endif // DRIVER_LEDC_H
@@ -0,0 +1,67 @@
+#ifndef DRIVER_RMT_H
+#define DRIVER_RMT_H
+
+#include <Arduino.h>
+
+// IDF legacy RMT driver, transmit side. rmt_write_sample() runs the
+// channel's translator over the whole buffer at once, in chunks the size of
+// the channel memory, and keeps the items for native::rmtItems().
+
+typedef enum {
+  RMT_CHANNEL_0, RMT_CHANNEL_1, RMT_CHANNEL_2, RMT_CHANNEL_3,
+  RMT_CHANNEL_4, RMT_CHANNEL_5, RMT_CHANNEL_6, RMT_CHANNEL_7,
+  RMT_CHANNEL_MAX
+} rmt_channel_t;
+
+typedef int gpio_num_t;
+
+typedef enum { RMT_MODE_TX, RMT_MODE_RX, RMT_MODE_MAX } rmt_mode_t;
+typedef enum { RMT_IDLE_LEVEL_LOW, RMT_IDLE_LEVEL_HIGH, RMT_IDLE_LEVEL_MAX } rmt_idle_level_t;
+typedef enum { RMT_CARRIER_LEVEL_LOW, RMT_CARRIER_LEVEL_HIGH, RMT_CARRIER_LEVEL_MAX } rmt_carrier_level_t;
+
+typedef struct {
+  uint32_t carrier_freq_hz;
+  rmt_carrier_level_t carrier_level;
+  rmt_idle_level_t idle_level;
+  uint8_t carrier_duty_percent;
+  uint32_t loop_count;
+  bool carrier_en;
+  bool loop_en;
+  bool idle_output_en;
+} rmt_tx_config_t;
+
+typedef struct {
+  rmt_mode_t rmt_mode;
+  rmt_channel_t channel;
+  gpio_num_t gpio_num;
+  uint8_t clk_div;
+  uint8_t mem_block_num;
+  uint32_t flags;
+  rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+typedef struct {
+  union {
+    struct {
+      uint32_t duration0 : 15;
+      uint32_t level0 : 1;
+      uint32_t duration1 : 15;
+      uint32_t level1 : 1;
+    };
+    uint32_t val;
+  };
+} rmt_item32_t;
+
+#define RMT_MEM_ITEM_NUM 64
+
+typedef void (*sample_to_rmt_t)(const void* src, rmt_item32_t* dest, size_t src_size, size_t wanted_num,
+                                size_t* translated_size, size_t* item_num);
+
+esp_err_t rmt_config(const rmt_config_t* rmt_param);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel);
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn);
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t* src, size_t src_size, bool wait_tx_done);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time);
+
+#endif // DRIVER_RMT_H
@@ -0,0 +1,37 @@
+#ifndef SOC_GPIO_STRUCT_H
+#define SOC_GPIO_STRUCT_H
+
+#include <stdint.h>
+
+// --- GPIO output registers ---
+//
+// The write-1-to-set and write-1-to-clear registers that interrupt handlers
+// use instead of digitalWrite(). A write changes the same simulated pins
+// digitalWrite() does: bit n of out_w1ts/out_w1tc is GPIO n, bit n of
+// out1_w1ts.val/out1_w1tc.val is GPIO 32 + n.
+
+void nativeGpioWrite(uint8_t firstPin, uint32_t mask, bool high);
+
+template <uint8_t FirstPin, bool High>
+struct NativeGpioRegister {
+  NativeGpioRegister &operator=(uint32_t mask) {
+    nativeGpioWrite(FirstPin, mask, High);
+    return *this;
+  }
+};
+
+template <uint8_t FirstPin, bool High>
+struct NativeGpioBank {
+  NativeGpioRegister<FirstPin, High> val;
+};
+
+struct gpio_dev_t {
+  NativeGpioRegister<0, true> out_w1ts;
+  NativeGpioRegister<0, false> out_w1tc;
+  NativeGpioBank<32, true> out1_w1ts;
+  NativeGpioBank<32, false> out1_w1tc;
+};
+
+extern gpio_dev_t GPIO;
+
+#endif // SOC_GPIO_STRUCT_H
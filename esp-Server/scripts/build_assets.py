@@ -0,0 +1,91 @@
+"""Packs the dashboard's static export into data/www for the SPIFFS image.
+
+Every file of the export (../interface/out by default, or the ASSETS_SOURCE
+environment variable) is stored under a short content-hashed name, gzipped
+when that makes it smaller, and listed in data/www/manifest.txt, one line
+per file:
+
+    <url path> <stored file> <etag> <stored size> <flags>
+
+flags: g = stored gzipped, i = immutable (the URL itself is content-hashed,
+like everything under _next/static), - = neither. SPIFFS names are limited
+to 31 characters, which is why files are stored by hash rather than under
+the export's own paths; the firmware maps URLs through the manifest.
+
+Runs before `pio run -t buildfs` (see extra_scripts in platformio.ini), or
+standalone: python scripts/build_assets.py [export dir]
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import shutil
+import sys
+
+COMPRESSIBLE = {".html", ".js", ".css", ".json", ".svg", ".txt", ".map", ".ico", ".xml", ".webmanifest"}
+HASHED_NAME = re.compile(r"[-.][0-9a-f]{8,}\.[a-z0-9]+$")
+
+
+def is_immutable(url):
+    return "/_next/static/" in url or HASHED_NAME.search(url) is not None
+
+
+def build(source, target):
+    if not os.path.isdir(source):
+        print("build_assets: %s not found, skipping (build the interface first)" % source)
+        return False
+
+    shutil.rmtree(target, ignore_errors=True)
+    os.makedirs(target)
+
+    lines = []
+    for root, _, files in os.walk(source):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            url = "/" + os.path.relpath(path, source).replace(os.sep, "/")
+            if any(c.isspace() for c in url):
+                print("build_assets: skipping %s (whitespace in name)" % url)
+                continue
+
+            with open(path, "rb") as f:
+                content = f.read()
+            digest = hashlib.sha1(content).hexdigest()
+
+            data = content
+            flags = ""
+            if os.path.splitext(name)[1].lower() in COMPRESSIBLE:
+                packed = gzip.compress(content, compresslevel=9, mtime=0)
+                if len(packed) < len(content):
+                    data = packed
+                    flags += "g"
+            if is_immutable(url):
+                flags += "i"
+
+            stored = "/www/" + digest[:10] + (".gz" if "g" in flags else "")
+            with open(os.path.join(target, os.path.basename(stored)), "wb") as f:
+                f.write(data)
+            lines.append("%s %s %s %d %s" % (url, stored, digest[:16], len(data), flags or "-"))
+
+    with open(os.path.join(target, "manifest.txt"), "w", newline="\n") as f:
+        f.write("\n".join(sorted(lines)) + "\n")
+    print("build_assets: packed %d file(s) into %s" % (len(lines), target))
+    return True
+
+
+def default_source(project_dir):
+    return os.environ.get("ASSETS_SOURCE", os.path.join(project_dir, "..", "interface", "out"))
+
+
+if __name__ == "__main__":
+    project = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    src = sys.argv[1] if len(sys.argv) > 1 else default_source(project)
+    sys.exit(0 if build(src, os.path.join(project, "data", "www")) else 1)
+else:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+
+    def before_buildfs(source, target, env):
+        project = env.subst("$PROJECT_DIR")
+        build(default_source(project), os.path.join(env.subst("$PROJECT_DATA_DIR"), "www"))
+
+    env.AddPreAction("$BUILD_DIR/spiffs.bin", before_buildfs)  # noqa: F821
@@ -2,8 +2,19 @@
 #include <SPIFFS.h>
 #include "ESPExpress.h"
 #include "ESPControlPlatform.h"
+#include "persistence.h"
+#include "metrics.h"
+#include "log.h"
+#include "sampler.h"
+#include "device_controller.h"
+#include "stepper.h"
+#include "led_strip.h"
 #include "devices/devices.h"       // from lib/Routes/devices/
 #include "websocket/websocket.h"   // from lib/Routes/websocket/
+#include "websocket/send_queue.h"
+#include "metrics/metrics_routes.h"
+#include "logs/log_routes.h"
+#include "static/static_assets.h"
 
 // Replace with your WiFi credentials
 const char* ssid     = "Tenda1200";
@@ -12,6 +23,9 @@ const char* password = "78787878";
 // Create an instance of the ESPExpress server on port 80
 ESPExpress app(80);
 
+// Time spent in one pass of loop()
+static MetricId loopMetric = INVALID_METRIC;
+
 // Forward declarations for functions defined in your device routes file
 void initializeDevices();
 
@@ -36,30 +50,63 @@ void setup() {
     return;
   }
 
-  // Load previously saved devices from flash
+  // Load previously saved devices from flash, then attach them; this is
+  // the only place boot attaches pins
   initializeDevices();
+  setupDevicePins();
+
+  // Sample input devices on the other core from now on
+  startSampler();
 
   // Set up middleware, CORS, and static file serving
   app.use([](Request &req, Response &res, std::function<void()> next) {
-    Serial.print("[LOG] Request: ");
-    Serial.println(req.path);
+    LOG_DEBUG("Request: %s", req.path.c_str());
     next();
   });
   app.enableCORS("*");
-  app.serveStatic("/static", "/www");
+
+  // Packed dashboard bundle, or the raw files from older filesystem images
+  if (!registerStaticAssets(app, "/static")) {
+    app.serveStatic("/static", "/www");
+  }
 
   // Register route modules
   registerDeviceRoutes(app);
   registerWebSocketRoutes(app);  // Optional, if you have it
+  registerMetricsRoutes(app);
+  registerLogRoutes(app);
+  loopMetric = registerHistogram("esp_loop_duration_us");
 
   Serial.println("Starting server...");
   app.listen("Platform running...");
 }
 
 void loop() {
+  ScopedTimer loopTimer(loopMetric);
+
   app.wsLoop();  // Process WebSocket events
- 
-  // For demonstration: generate a random temperature value every 5 seconds.
-  // Replace this with your sensor reading if available.
 
+  // Track input device changes for the sampling task
+  handleSampler();
+
+  // Report stepper positions; the steps themselves come from a timer ISR
+  handleSteppers();
+
+  // Effects and frame pushes for LED strips, rate-limited per strip
+  handleLedStrips();
+
+  // Push sensor readings to subscribed WebSocket clients
+  handleSensorStreams(app);
+
+  // Periodic metrics snapshots for clients that asked for them
+  handleMetricsPush(app);
+
+  // Send what the above queued, a few messages per client
+  drainSendQueues(app);
+
+  // Write coalesced device changes to flash
+  handlePersistence();
+
+  // Send buffered log lines to Serial without blocking
+  handleLogDrain();
 }
@@ -2,17 +2,15 @@ const socket = new WebSocket('ws://192.168.1.106:81/ws');
 
 socket.onopen = () => {
   console.log('WebSocket connection established');
-  
 
-  // Request a temperature update every 5 seconds.
-  setInterval(() => {
-    // Send a JSON message requesting a temperature update.
-    const request = {
-      deviceId: 'humidity1',
-      sensor: 'humidity'
-    };
-    socket.send(JSON.stringify(request));
-  }, 5000);
+  // Subscribe once; the ESP32 pushes a humidity reading every 5 seconds.
+  const request = {
+    type: 'subscribe',
+    deviceId: 'humidity1',
+    sensor: 'humidity',
+    interval: 5000
+  };
+  socket.send(JSON.stringify(request));
 };
 
 socket.onmessage = (event) => {
@@ -20,8 +18,8 @@ socket.onmessage = (event) => {
   try {
     const data = JSON.parse(event.data);
     
-    // Check if the received message is a sensor update for temperature.
-    if (data.sensor === 'humidity' && data.deviceId === 'humidity1') {
+    // Check if the received message is a sensor update for humidity.
+    if (data.sensor === 'humidity' && data.deviceId === 'humidity1' && data.value !== undefined) {
       console.log('Current humidity:', data.value);
     } else {
       console.log('Received data:', data);
@@ -0,0 +1,193 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include "adc_source.h"
+
+static const uint8_t PIN = 34;
+static const int PIN_LIST[] = {PIN};
+
+void setUp() {
+  native::reset();
+  setAdcCalibration(ADC_CAL_GAIN, ADC_CAL_OFFSET_MV);
+  beginAdcPin(PIN);
+}
+
+// Leaves the continuous driver stopped for the next test
+void tearDown() {
+  setAdcContinuousPins(nullptr, 0);
+  pollAdcContinuous();
+}
+
+// The next reading's conversions, first to last
+static void queue(const uint32_t (&millivolts)[ADC_OVERSAMPLE]) {
+  native::queueAnalogMillivolts(PIN, millivolts, ADC_OVERSAMPLE);
+}
+
+// --- Oversampling ---
+
+void test_reading_is_the_mean_of_the_conversions() {
+  uint32_t conversions[ADC_OVERSAMPLE];
+  for (int i = 0; i < ADC_OVERSAMPLE; i++) conversions[i] = 1000 + i;
+  queue(conversions);
+
+  uint32_t before = native::analogReadCount(PIN);
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.0075, readAdcVolts(PIN));
+  TEST_ASSERT_EQUAL(before + ADC_OVERSAMPLE, native::analogReadCount(PIN));
+}
+
+// Averaging resolves steps finer than one millivolt
+void test_oversampling_adds_resolution() {
+  uint32_t conversions[ADC_OVERSAMPLE];
+  for (int i = 0; i < ADC_OVERSAMPLE; i++) conversions[i] = i < 4 ? 1001 : 1000;
+  queue(conversions);
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.00025, readAdcVolts(PIN));
+}
+
+// Symmetric noise around a level averages back to the level
+void test_noise_averages_out() {
+  uint32_t conversions[ADC_OVERSAMPLE];
+  for (int i = 0; i < ADC_OVERSAMPLE; i++) conversions[i] = (i & 1) ? 1240 : 1160;
+  queue(conversions);
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.2, readAdcVolts(PIN));
+}
+
+// --- Calibration ---
+
+void test_calibration_applies_gain_then_offset() {
+  native::setAnalogMillivolts(PIN, 1000);
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.0, readAdcVolts(PIN));
+
+  setAdcCalibration(1.02f, -15);
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.005, readAdcVolts(PIN));
+
+  native::setAnalogMillivolts(PIN, 3000);
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 3.045, readAdcVolts(PIN));
+}
+
+void test_calibrated_reading_is_never_negative() {
+  native::setAnalogMillivolts(PIN, 10);
+  setAdcCalibration(1.0f, -50);
+  TEST_ASSERT_EQUAL_FLOAT(0, readAdcVolts(PIN));
+}
+
+// --- Continuous mode ---
+
+static void startContinuous(const int* pins, size_t count) {
+  setAdcContinuousPins(pins, count);
+  pollAdcContinuous();
+}
+
+void test_only_adc1_pins_run_continuously() {
+  const int pins[] = {PIN, 25};   // GPIO 25 is on ADC2
+  TEST_ASSERT_TRUE(isContinuousAdcPin(PIN));
+  TEST_ASSERT_FALSE(isContinuousAdcPin(25));
+
+  startContinuous(pins, 2);
+  TEST_ASSERT_EQUAL_HEX32(1 << 6, native::adcDigiChannels());   // GPIO 34 is ADC1 channel 6
+  TEST_ASSERT_TRUE(adcContinuousActive(PIN));
+  TEST_ASSERT_FALSE(adcContinuousActive(25));
+}
+
+// A reading is the mean of every conversion since the previous one
+void test_continuous_reading_averages_the_conversions() {
+  startContinuous(PIN_LIST, 1);
+  float volts;
+  TEST_ASSERT_FALSE(takeAdcContinuousVolts(PIN, volts));
+
+  uint32_t conversions[20];
+  for (int i = 0; i < 20; i++) conversions[i] = 1000 + i;
+  native::queueAnalogMillivolts(PIN, conversions, 20);
+  native::advanceMillis(1);   // 20 conversions at 20 kHz
+  pollAdcContinuous();
+
+  TEST_ASSERT_TRUE(takeAdcContinuousVolts(PIN, volts));
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.0095, volts);
+  TEST_ASSERT_FALSE(takeAdcContinuousVolts(PIN, volts));
+}
+
+void test_pins_share_the_rate() {
+  const int pins[] = {PIN, 35};
+  startContinuous(pins, 2);
+  native::setAnalogMillivolts(PIN, 1200);
+  native::setAnalogMillivolts(35, 2400);
+  native::advanceMillis(2);
+  pollAdcContinuous();
+
+  float volts;
+  TEST_ASSERT_TRUE(takeAdcContinuousVolts(PIN, volts));
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.2, volts);
+  TEST_ASSERT_TRUE(takeAdcContinuousVolts(35, volts));
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 2.4, volts);
+  TEST_ASSERT_EQUAL(20, native::analogReadCount(35));
+}
+
+// One-shot reads of a converting pin return the newest reading and leave
+// the ADC to the DMA
+void test_one_shot_read_of_a_continuous_pin() {
+  startContinuous(PIN_LIST, 1);
+  native::setAnalogMillivolts(PIN, 1500);
+  native::advanceMillis(1);
+  pollAdcContinuous();
+  float volts;
+  TEST_ASSERT_TRUE(takeAdcContinuousVolts(PIN, volts));
+
+  uint32_t conversions = native::analogReadCount(PIN);
+  setAdcCalibration(1.0f, 10);
+  TEST_ASSERT_FLOAT_WITHIN(0.00001, 1.5, readAdcVolts(PIN));
+  TEST_ASSERT_EQUAL(conversions, native::analogReadCount(PIN));
+}
+
+void test_new_pin_set_restarts_the_driver() {
+  startContinuous(PIN_LIST, 1);
+  native::advanceMillis(1);
+  pollAdcContinuous();
+
+  const int other = 35;
+  startContinuous(&other, 1);
+  TEST_ASSERT_EQUAL_HEX32(1 << 7, native::adcDigiChannels());
+  float volts;
+  TEST_ASSERT_FALSE(takeAdcContinuousVolts(PIN, volts));   // the old sums are gone
+  TEST_ASSERT_FALSE(adcContinuousActive(PIN));
+
+  startContinuous(nullptr, 0);
+  TEST_ASSERT_EQUAL_HEX32(0, native::adcDigiChannels());
+  TEST_ASSERT_FALSE(adcContinuousActive(35));
+}
+
+// --- Simulated signal ---
+
+void test_simulated_signal_stays_in_range() {
+  for (int i = 0; i < 10000; i++) {
+    uint32_t millivolts = simulatedAdcMillivolts(PIN);
+    TEST_ASSERT_TRUE(millivolts >= 1510 && millivolts <= 1790);
+  }
+}
+
+// Readings of the simulated signal follow the wave; the noise averages out
+void test_simulated_readings_move_slowly() {
+  float previous = -1;
+  for (int reading = 0; reading < 500; reading++) {
+    uint32_t sum = 0;
+    for (int i = 0; i < ADC_OVERSAMPLE; i++) sum += simulatedAdcMillivolts(PIN);
+    float millivolts = (float)sum / ADC_OVERSAMPLE;
+    TEST_ASSERT_TRUE(millivolts >= 1530 && millivolts <= 1770);
+    if (previous >= 0) TEST_ASSERT_FLOAT_WITHIN(40, previous, millivolts);
+    previous = millivolts;
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_reading_is_the_mean_of_the_conversions);
+  RUN_TEST(test_oversampling_adds_resolution);
+  RUN_TEST(test_noise_averages_out);
+  RUN_TEST(test_calibration_applies_gain_then_offset);
+  RUN_TEST(test_calibrated_reading_is_never_negative);
+  RUN_TEST(test_only_adc1_pins_run_continuously);
+  RUN_TEST(test_continuous_reading_averages_the_conversions);
+  RUN_TEST(test_pins_share_the_rate);
+  RUN_TEST(test_one_shot_read_of_a_continuous_pin);
+  RUN_TEST(test_new_pin_set_restarts_the_driver);
+  RUN_TEST(test_simulated_signal_stays_in_range);
+  RUN_TEST(test_simulated_readings_move_slowly);
+  return UNITY_END();
+}
@@ -0,0 +1,109 @@
+#include <unity.h>
+#include <NativeBench.h>
+#include <vector>
+#include "ESPControlPlatform.h"
+
+// --- Registry benchmarks ---
+//
+// Lookups by id through the DeviceRegistry hash index against the linear
+// scan over a std::vector<Device> that it replaced, as the device count
+// grows. Run with `pio test -e native_bench`.
+
+static DeviceRegistry registry;
+static std::vector<Device> scanned;
+static std::vector<String> ids;
+
+void setUp() {}
+void tearDown() {}
+
+static Device makeDevice(size_t i) {
+  Device device;
+  device.id = "device-" + String((unsigned)i);
+  device.type = "generic";
+  device.kind = parseDeviceKind(device.type);
+  return device;
+}
+
+static void fill(size_t count) {
+  registry.clear();
+  scanned.clear();
+  ids.clear();
+  for (size_t i = 0; i < count; i++) {
+    Device device = makeDevice(i);
+    TEST_ASSERT_NOT_EQUAL(INVALID_DEVICE_HANDLE, registry.add(device));
+    scanned.push_back(device);
+    ids.push_back(device.id);
+  }
+}
+
+// How lookups by id worked before the registry
+static Device* scanFind(const char* id) {
+  for (Device &device : scanned) {
+    if (device.id == id) return &device;
+  }
+  return nullptr;
+}
+
+void test_bench_lookup_by_id() {
+  native::printBenchHeader("Lookup by id, registry vs vector scan");
+  const size_t counts[] = {10, 100, 1000};
+
+  for (size_t count : counts) {
+    char name[48];
+    fill(count);
+
+    // Every id in turn, so the scan pays its average n/2 comparisons
+    size_t next = 0;
+    snprintf(name, sizeof(name), "registry find, %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20000, [&next, count] {
+      TEST_ASSERT_NOT_NULL(registry.find(ids[next].c_str()));
+      next = (next + 1) % count;
+    }));
+
+    next = 0;
+    snprintf(name, sizeof(name), "vector scan, %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20000, [&next, count] {
+      TEST_ASSERT_NOT_NULL(scanFind(ids[next].c_str()));
+      next = (next + 1) % count;
+    }));
+
+    snprintf(name, sizeof(name), "registry miss, %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20000, [] {
+      TEST_ASSERT_NULL(registry.find("no-such-device"));
+    }));
+
+    snprintf(name, sizeof(name), "vector miss, %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20000, [] {
+      TEST_ASSERT_NULL(scanFind("no-such-device"));
+    }));
+  }
+}
+
+// Removing from the middle: a tombstone in the registry, a shift in the vector
+void test_bench_add_remove() {
+  native::printBenchHeader("Add and remove one device, 1000 devices");
+  fill(1000);
+  Device extra = makeDevice(1000);
+
+  native::printBench("registry add + remove", native::bench(5000, [&extra] {
+    registry.add(extra);
+    TEST_ASSERT_TRUE(registry.remove(extra.id));
+  }));
+
+  native::printBench("vector insert + erase (middle)", native::bench(5000, [&extra] {
+    scanned.insert(scanned.begin() + scanned.size() / 2, extra);
+    for (auto it = scanned.begin(); it != scanned.end(); ++it) {
+      if (it->id == extra.id) {
+        scanned.erase(it);
+        break;
+      }
+    }
+  }));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_lookup_by_id);
+  RUN_TEST(test_bench_add_remove);
+  return UNITY_END();
+}
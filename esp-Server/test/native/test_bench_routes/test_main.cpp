@@ -0,0 +1,145 @@
+#include <unity.h>
+#include <NativeBench.h>
+#include <SPIFFS.h>
+#include "ESPExpress.h"
+#include "ESPControlPlatform.h"
+#include "persistence.h"
+#include "devices/devices.h"
+#include "websocket/websocket.h"
+#include "websocket/send_queue.h"
+
+// --- Route benchmarks ---
+//
+// Per-route latency and heap allocations per request through the real
+// handlers, and the time a full save and load takes as the device count
+// grows. Run with `pio test -e native_bench`.
+
+void initializeDevices();
+bool saveDevicesToFlash();
+bool loadDevicesFromFlash();
+
+static ESPExpress app(80);
+
+void setUp() {}
+void tearDown() {}
+
+// n relays without pins, so only the registry and the files are measured
+static void fillDevices(size_t count) {
+  devices.clear();
+  for (size_t i = 0; i < count; i++) {
+    Device device;
+    device.id = "dev" + String((unsigned)i);
+    device.type = "relay";
+    device.kind = parseDeviceKind(device.type);
+    device.direction = OUTPUT_DEVICE;
+    devices.add(device);
+  }
+}
+
+static void expectStatus(int status, const Response &res) {
+  TEST_ASSERT_EQUAL_MESSAGE(status, res.statusCode, res.body.c_str());
+}
+
+void test_bench_device_routes() {
+  fillDevices(20);
+  native::printBenchHeader("HTTP routes, 20 devices");
+
+  native::printBench("GET /api/devices", native::bench(2000, [] {
+    expectStatus(200, app.handle("GET", "/api/devices"));
+  }));
+  native::printBench("GET /api/devices?since=", native::bench(2000, [] {
+    expectStatus(200, app.handle("GET", "/api/devices?since=" + String(devices.generation())));
+  }));
+  native::printBench("GET /api/device/:id", native::bench(2000, [] {
+    expectStatus(200, app.handle("GET", "/api/device/dev7"));
+  }));
+
+  uint32_t counter = 0;
+  native::printBench("PUT /api/device/:id", native::bench(2000, [&counter] {
+    expectStatus(200, app.handle("PUT", "/api/device/dev7", (counter++ & 1) ? "on" : "off"));
+  }));
+  native::printBench("POST + DELETE /api/device", native::bench(1000, [] {
+    expectStatus(200, app.handle("POST", "/api/device", "{\"id\":\"extra\",\"type\":\"relay\",\"direction\":\"output\"}"));
+    expectStatus(200, app.handle("DELETE", "/api/device/extra"));
+  }));
+
+  String batch = "[";
+  for (int i = 0; i < 10; i++) {
+    if (i) batch += ",";
+    batch += "{\"id\":\"dev" + String(i) + "\",\"state\":\"on\"}";
+  }
+  batch += "]";
+  native::printBench("POST /api/devices/batch (10 items)", native::bench(1000, [&batch] {
+    expectStatus(200, app.handle("POST", "/api/devices/batch", batch));
+  }));
+
+  flushDevices();
+}
+
+void test_bench_websocket_rpc() {
+  fillDevices(20);
+  app.wsEvent(0, WStype_CONNECTED);
+  drainSendQueues(app);
+  app.wsClear();
+  native::printBenchHeader("WebSocket RPC, 20 devices");
+
+  native::printBench("get", native::bench(2000, [] {
+    app.wsEvent(0, "{\"id\":1,\"method\":\"get\",\"params\":{\"id\":\"dev7\"}}");
+    drainSendQueues(app);
+    app.wsClear();
+  }));
+
+  uint32_t counter = 0;
+  native::printBench("setState", native::bench(2000, [&counter] {
+    app.wsEvent(0, (counter++ & 1) ? "{\"id\":2,\"method\":\"setState\",\"params\":{\"id\":\"dev7\",\"state\":\"on\"}}"
+                                    : "{\"id\":2,\"method\":\"setState\",\"params\":{\"id\":\"dev7\",\"state\":\"off\"}}");
+    drainSendQueues(app);
+    app.wsClear();
+  }));
+  native::printBench("list", native::bench(1000, [] {
+    app.wsEvent(0, "{\"id\":3,\"method\":\"list\",\"params\":{}}");
+    drainSendQueues(app);
+    TEST_ASSERT_FALSE(app.wsSent(0).empty());
+    app.wsClear();
+  }));
+
+  app.wsEvent(0, WStype_DISCONNECTED);
+  flushDevices();
+}
+
+void test_bench_persistence() {
+  native::printBenchHeader("Save and load, by device count");
+  const size_t counts[] = {10, 100, 1000};
+
+  for (size_t count : counts) {
+    char name[48];
+    fillDevices(count);
+
+    snprintf(name, sizeof(name), "save %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20, [] {
+      TEST_ASSERT_TRUE(saveDevicesToFlash());
+    }));
+
+    snprintf(name, sizeof(name), "load %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20, [count] {
+      devices.clear();
+      TEST_ASSERT_TRUE(loadDevicesFromFlash());
+      TEST_ASSERT_EQUAL(count, devices.size());
+    }));
+  }
+}
+
+int main() {
+  native::reset();
+  native::formatFs();
+  SPIFFS.begin(true);
+  initializeDevices();
+  registerDeviceRoutes(app);
+  registerWebSocketRoutes(app);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_device_routes);
+  RUN_TEST(test_bench_websocket_rpc);
+  RUN_TEST(test_bench_persistence);
+  return UNITY_END();
+}
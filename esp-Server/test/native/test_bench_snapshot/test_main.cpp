@@ -0,0 +1,88 @@
+#include <unity.h>
+#include <NativeBench.h>
+#include <SPIFFS.h>
+#include <StreamString.h>
+#include "ESPExpress.h"
+#include "ESPControlPlatform.h"
+#include "device_snapshot.h"
+#include "devices/devices.h"
+#include "devices/device_json.h"
+
+// --- Snapshot benchmarks ---
+//
+// Load time and peak heap of the binary snapshot against the JSON device
+// list it replaced, at 10, 100 and 1000 devices. The JSON case goes through
+// POST /api/devices/import, which parses and builds devices as the legacy
+// file load did. Run with `pio test -e native_bench`.
+
+void initializeDevices();
+
+static const char* SNAPSHOT_PATH = "/bench.bin";
+
+static ESPExpress app(80);
+
+void setUp() {}
+void tearDown() {}
+
+// Pinless devices, so the pin checks on import accept all of them
+static void fillDevices(size_t count) {
+  devices.clear();
+  for (size_t i = 0; i < count; i++) {
+    Device device;
+    device.id = "dev" + String((unsigned)i);
+    device.type = "generic";
+    device.kind = parseDeviceKind(device.type);
+    device.direction = OUTPUT_DEVICE;
+    devices.add(device);
+  }
+}
+
+static size_t fileSize(const char* path) {
+  File file = SPIFFS.open(path, "r");
+  size_t size = file ? file.size() : 0;
+  file.close();
+  return size;
+}
+
+void test_bench_snapshot_load() {
+  native::printBenchHeader("Device list load, binary snapshot vs JSON");
+  const size_t counts[] = {10, 100, 1000};
+
+  for (size_t count : counts) {
+    char name[48];
+    fillDevices(count);
+
+    TEST_ASSERT_TRUE(saveDeviceSnapshot(SNAPSHOT_PATH, 1));
+    StreamString json;
+    writeDevicesJson(json);
+    printf("  %u devices: snapshot %u bytes, JSON %u bytes\n", (unsigned)count,
+           (unsigned)fileSize(SNAPSHOT_PATH), (unsigned)json.length());
+
+    snprintf(name, sizeof(name), "snapshot load, %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20, [count] {
+      uint32_t generation;
+      TEST_ASSERT_TRUE(loadDeviceSnapshot(SNAPSHOT_PATH, generation));
+      TEST_ASSERT_EQUAL(count, devices.size());
+    }));
+
+    // The request body is a copy of the list, as the file buffer was
+    snprintf(name, sizeof(name), "JSON load, %u devices", (unsigned)count);
+    native::printBench(name, native::bench(20, [count, &json] {
+      Response res = app.handle("POST", "/api/devices/import", json);
+      TEST_ASSERT_EQUAL_MESSAGE(200, res.statusCode, res.body.c_str());
+      TEST_ASSERT_EQUAL(count, devices.size());
+    }));
+  }
+}
+
+int main() {
+  native::reset();
+  native::formatFs();
+  SPIFFS.begin(true);
+  initializeDevices();
+  registerDeviceRoutes(app);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_snapshot_load);
+  return UNITY_END();
+}
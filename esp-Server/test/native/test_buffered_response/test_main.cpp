@@ -0,0 +1,67 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <SPIFFS.h>
+#include "http/buffered_response.h"
+
+void setUp() {
+  native::formatFs();
+}
+
+void tearDown() {}
+
+// --- Sending ---
+
+void test_small_body_is_sent_from_ram() {
+  Response res;
+  {
+    BufferedResponse out(res, "text/plain; version=0.0.4");
+    out.print("a 1\n");
+    out.print("b 2\n");
+  }
+  TEST_ASSERT_TRUE(res.sent);
+  TEST_ASSERT_EQUAL_STRING("a 1\nb 2\n", res.body.c_str());
+  TEST_ASSERT_EQUAL_STRING("text/plain; version=0.0.4", res.contentType.c_str());
+  TEST_ASSERT_EQUAL_STRING("", res.file.c_str());
+  TEST_ASSERT_FALSE(SPIFFS.exists(RESPONSE_SPOOL_FILE));
+}
+
+// A body past the RAM limit continues in the spool file and is sent whole
+void test_large_body_is_spooled() {
+  Response res;
+  BufferedResponse out(res, "application/json");
+  out.print('[');
+  size_t length = 1;
+  while (length <= RESPONSE_RAM_LIMIT) {
+    length += out.print("{\"id\":\"fan\"},");
+  }
+  out.print("0]");
+  length += 2;
+  out.end();
+
+  TEST_ASSERT_EQUAL_STRING(RESPONSE_SPOOL_FILE, res.file.c_str());
+  TEST_ASSERT_EQUAL(length, res.body.length());
+  TEST_ASSERT_TRUE(res.body.startsWith("[{\"id\":\"fan\"},"));
+  TEST_ASSERT_TRUE(res.body.endsWith(",0]"));
+  TEST_ASSERT_EQUAL_STRING("application/json", res.contentType.c_str());
+}
+
+void test_writes_after_end_are_ignored() {
+  Response res;
+  BufferedResponse out(res, "text/plain");
+  out.print("done");
+  out.end();
+  TEST_ASSERT_EQUAL(0, out.print("more"));
+  out.end();
+  TEST_ASSERT_EQUAL_STRING("done", res.body.c_str());
+}
+
+int main() {
+  native::reset();
+  SPIFFS.begin(true);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_small_body_is_sent_from_ram);
+  RUN_TEST(test_large_body_is_spooled);
+  RUN_TEST(test_writes_after_end_are_ignored);
+  return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <SPIFFS.h>
+#include "ESPExpress.h"
+#include "ESPControlPlatform.h"
+#include "devices/devices.h"
+
+void initializeDevices();
+bool loadDevicesFromFlash();
+
+static ESPExpress app(80);
+
+void setUp() {
+  app.handle("POST", "/api/devices/import", "[]");
+}
+
+void tearDown() {}
+
+static void expectStatus(int status, const Response &res) {
+  TEST_ASSERT_EQUAL_MESSAGE(status, res.statusCode, res.body.c_str());
+}
+
+static void addSensor(const char* id) {
+  expectStatus(200, app.handle("POST", "/api/device",
+                               "{\"id\":\"" + String(id) + "\",\"type\":\"sensor\",\"direction\":\"input\"}"));
+}
+
+// --- Settings ---
+
+void test_sample_interval_is_range_checked() {
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"s\",\"type\":\"sensor\",\"sampleInterval\":70000}"));
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"s\",\"type\":\"sensor\",\"sampleInterval\":-5}"));
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"s\",\"type\":\"sensor\",\"sampleInterval\":2.5}"));
+  TEST_ASSERT_NULL(devices.find("s"));
+
+  expectStatus(200, app.handle("POST", "/api/device", "{\"id\":\"s\",\"type\":\"sensor\",\"sampleInterval\":250}"));
+  TEST_ASSERT_NOT_NULL(devices.find("s"));
+  TEST_ASSERT_EQUAL(250, devices.find("s")->sampleIntervalMs);
+}
+
+void test_pwm_settings_are_range_checked() {
+  // 300 bits would have wrapped to 44 in the 8-bit field
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"m\",\"type\":\"servo\",\"pwmResolution\":300}"));
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"m\",\"type\":\"servo\",\"pwmResolution\":17}"));
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"m\",\"type\":\"servo\",\"pwmFrequency\":-50}"));
+  TEST_ASSERT_NULL(devices.find("m"));
+}
+
+void test_motion_settings_are_range_checked() {
+  // 70000 would have wrapped to 4464 in the 16-bit field
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"x\",\"type\":\"stepper\",\"acceleration\":70000}"));
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"x\",\"type\":\"stepper\",\"maxSpeed\":30000}"));
+  TEST_ASSERT_NULL(devices.find("x"));
+
+  expectStatus(200, app.handle("POST", "/api/device",
+                               "{\"id\":\"x\",\"type\":\"stepper\",\"maxSpeed\":2000,\"acceleration\":60000}"));
+  TEST_ASSERT_EQUAL(60000, devices.find("x")->acceleration);
+}
+
+void test_led_count_is_range_checked() {
+  // 70000 would have wrapped to 4464 and passed the old bound
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"l\",\"type\":\"led_strip\",\"ledCount\":70000}"));
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"l\",\"type\":\"led_strip\",\"ledCount\":-1}"));
+  expectStatus(400, app.handle("POST", "/api/devices/import", "[{\"id\":\"l\",\"type\":\"led_strip\",\"ledCount\":70000}]"));
+  TEST_ASSERT_NULL(devices.find("l"));
+
+  expectStatus(200, app.handle("POST", "/api/device", "{\"id\":\"l\",\"type\":\"led_strip\",\"ledCount\":60}"));
+  TEST_ASSERT_EQUAL(60, devices.find("l")->ledCount);
+}
+
+// --- States ---
+
+void test_numeric_states_are_accepted() {
+  expectStatus(200, app.handle("POST", "/api/device",
+                               "{\"id\":\"arm\",\"type\":\"servo\",\"direction\":\"output\",\"pins\":[18],\"state\":90}"));
+  TEST_ASSERT_EQUAL(STATE_ANGLE, devices.find("arm")->state.kind);
+  TEST_ASSERT_EQUAL(90, devices.find("arm")->state.angle);
+
+  expectStatus(200, app.handle("POST", "/api/devices/batch", "[{\"id\":\"arm\",\"state\":45}]"));
+  TEST_ASSERT_EQUAL(45, devices.find("arm")->state.angle);
+
+  expectStatus(200, app.handle("POST", "/api/devices/import",
+                               "[{\"id\":\"arm\",\"type\":\"servo\",\"pins\":[18],\"state\":120}]"));
+  TEST_ASSERT_EQUAL(120, devices.find("arm")->state.angle);
+}
+
+void test_structured_states_are_rejected() {
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"arm\",\"type\":\"servo\",\"state\":{\"angle\":90}}"));
+  expectStatus(400, app.handle("POST", "/api/device", "{\"id\":\"arm\",\"type\":\"servo\",\"state\":[90]}"));
+  TEST_ASSERT_NULL(devices.find("arm"));
+}
+
+// --- Import ---
+
+void test_rejected_import_keeps_devices() {
+  addSensor("keep");
+  expectStatus(400, app.handle("POST", "/api/devices/import",
+                               "[{\"id\":\"new\",\"type\":\"sensor\",\"sampleInterval\":65536}]"));
+  TEST_ASSERT_NOT_NULL(devices.find("keep"));
+  TEST_ASSERT_NULL(devices.find("new"));
+
+  expectStatus(200, app.handle("POST", "/api/devices/import",
+                               "[{\"id\":\"new\",\"type\":\"sensor\",\"sampleInterval\":500}]"));
+  TEST_ASSERT_NULL(devices.find("keep"));
+  TEST_ASSERT_EQUAL(500, devices.find("new")->sampleIntervalMs);
+}
+
+void test_import_attaches_devices() {
+  expectStatus(200, app.handle("POST", "/api/devices/import",
+                               "[{\"id\":\"arm\",\"type\":\"servo\",\"pins\":[18],\"state\":\"90\"}]"));
+  TEST_ASSERT_TRUE(native::ledcPinChannel(18) >= 0);
+  TEST_ASSERT_EQUAL(50, native::ledcFrequency(native::ledcPinChannel(18)));
+}
+
+void test_import_skips_devices_with_bad_pins() {
+  expectStatus(200, app.handle("POST", "/api/devices/import",
+                               "[{\"id\":\"a\",\"type\":\"led\",\"direction\":\"output\",\"pins\":[4]},"
+                               "{\"id\":\"b\",\"type\":\"led\",\"direction\":\"output\",\"pins\":[4]},"
+                               "{\"id\":\"c\",\"type\":\"led\",\"direction\":\"output\",\"pins\":[34]},"
+                               "{\"id\":\"d\",\"type\":\"led\",\"direction\":\"output\",\"pins\":[\"x\"]}]"));
+  TEST_ASSERT_NOT_NULL(devices.find("a"));
+  TEST_ASSERT_NULL(devices.find("b"));   // pin taken by a
+  TEST_ASSERT_NULL(devices.find("c"));   // input-only pin
+  TEST_ASSERT_NULL(devices.find("d"));
+  TEST_ASSERT_EQUAL(OUTPUT, native::pinModeOf(4));
+}
+
+// Boot attaches pins once, in setup(), after the journal is replayed; the
+// migration import must not attach them first
+void test_legacy_migration_leaves_pins_to_setup() {
+  SPIFFS.remove("/devices.bin");
+  File file = SPIFFS.open("/devices.json", "w");
+  file.print("[{\"id\":\"arm\",\"type\":\"servo\",\"pins\":[19]}]");
+  file.close();
+
+  TEST_ASSERT_TRUE(loadDevicesFromFlash());
+  TEST_ASSERT_NOT_NULL(devices.find("arm"));
+  TEST_ASSERT_EQUAL(-1, native::ledcPinChannel(19));
+  TEST_ASSERT_FALSE(SPIFFS.exists("/devices.json"));
+}
+
+int main() {
+  native::reset();
+  native::formatFs();
+  SPIFFS.begin(true);
+  initializeDevices();
+  registerDeviceRoutes(app);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sample_interval_is_range_checked);
+  RUN_TEST(test_pwm_settings_are_range_checked);
+  RUN_TEST(test_motion_settings_are_range_checked);
+  RUN_TEST(test_led_count_is_range_checked);
+  RUN_TEST(test_numeric_states_are_accepted);
+  RUN_TEST(test_structured_states_are_rejected);
+  RUN_TEST(test_rejected_import_keeps_devices);
+  RUN_TEST(test_import_attaches_devices);
+  RUN_TEST(test_import_skips_devices_with_bad_pins);
+  RUN_TEST(test_legacy_migration_leaves_pins_to_setup);
+  return UNITY_END();
+}
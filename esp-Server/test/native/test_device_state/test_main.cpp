@@ -0,0 +1,131 @@
+#include <unity.h>
+#include "ESPControlPlatform.h"
+
+void setUp() {}
+void tearDown() {}
+
+static String roundTrip(uint8_t kind, const char* text) {
+  DeviceState state;
+  if (!parseDeviceState(kind, text, state)) return "<invalid>";
+  return formatDeviceState(state);
+}
+
+void test_switch_accepts_all_spellings() {
+  TEST_ASSERT_EQUAL_STRING("on", roundTrip(LED_KIND, "on").c_str());
+  TEST_ASSERT_EQUAL_STRING("on", roundTrip(LED_KIND, "TRUE").c_str());
+  TEST_ASSERT_EQUAL_STRING("on", roundTrip(RELAY_KIND, "1").c_str());
+  TEST_ASSERT_EQUAL_STRING("off", roundTrip(RELAY_KIND, "Off").c_str());
+  TEST_ASSERT_EQUAL_STRING("off", roundTrip(LED_KIND, "0").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(LED_KIND, "dim").c_str());
+}
+
+void test_angle_range() {
+  TEST_ASSERT_EQUAL_STRING("0", roundTrip(SERVO_KIND, "0").c_str());
+  TEST_ASSERT_EQUAL_STRING("180", roundTrip(SERVO_KIND, "180").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(SERVO_KIND, "181").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(SERVO_KIND, "-1").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(SERVO_KIND, "90deg").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(SERVO_KIND, "").c_str());
+}
+
+void test_motor_grammar() {
+  DeviceState state;
+  TEST_ASSERT_TRUE(parseDeviceState(MOTOR_KIND, "on:80:reverse", state));
+  TEST_ASSERT_EQUAL(STATE_SPEED, state.kind);
+  TEST_ASSERT_TRUE(state.motor.running);
+  TEST_ASSERT_EQUAL_UINT8(80, state.motor.speed);
+  TEST_ASSERT_EQUAL(MOTOR_REVERSE, state.motor.direction);
+  TEST_ASSERT_EQUAL_STRING("on:80:reverse", formatDeviceState(state).c_str());
+
+  TEST_ASSERT_EQUAL_STRING("off", roundTrip(MOTOR_KIND, "0").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(MOTOR_KIND, "on:101:forward").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(MOTOR_KIND, "on:50:sideways").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(MOTOR_KIND, "on::forward").c_str());
+}
+
+void test_colours_normalise_to_hex() {
+  TEST_ASSERT_EQUAL_STRING("#ff8000", roundTrip(LED_STRIP_KIND, "#FF8000").c_str());
+  TEST_ASSERT_EQUAL_STRING("#0a141e", roundTrip(LED_STRIP_KIND, "10,20,30").c_str());
+  TEST_ASSERT_EQUAL_STRING("#000000", roundTrip(LED_STRIP_KIND, "off").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(LED_STRIP_KIND, "256,0,0").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(LED_STRIP_KIND, "#ff80").c_str());
+}
+
+void test_strip_effects() {
+  DeviceState state;
+  TEST_ASSERT_TRUE(parseDeviceState(LED_STRIP_KIND, "chase:#ff0000", state));
+  TEST_ASSERT_EQUAL(STATE_EFFECT, state.kind);
+  TEST_ASSERT_EQUAL(EFFECT_CHASE, state.fx.effect);
+  TEST_ASSERT_EQUAL_UINT8(0xFF, state.fx.r);
+  TEST_ASSERT_EQUAL_UINT8(0, state.fx.g);
+
+  // Effects default to white; rainbow has no colour to show
+  TEST_ASSERT_EQUAL_STRING("breathe:#ffffff", roundTrip(LED_STRIP_KIND, "breathe").c_str());
+  TEST_ASSERT_EQUAL_STRING("rainbow", roundTrip(LED_STRIP_KIND, "Rainbow").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(LED_STRIP_KIND, "sparkle").c_str());
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(LED_STRIP_KIND, "chase:red").c_str());
+}
+
+void test_steps_are_signed() {
+  DeviceState state;
+  TEST_ASSERT_TRUE(parseDeviceState(STEPPER_KIND, "-2000", state));
+  TEST_ASSERT_EQUAL(STATE_STEPS, state.kind);
+  TEST_ASSERT_EQUAL_INT32(-2000, state.steps);
+  TEST_ASSERT_EQUAL_STRING("<invalid>", roundTrip(STEPPER_KIND, "12.5").c_str());
+}
+
+void test_generic_falls_back_from_switch_to_number_to_text() {
+  DeviceState state;
+  TEST_ASSERT_TRUE(parseDeviceState(GENERIC_KIND, "on", state));
+  TEST_ASSERT_EQUAL(STATE_SWITCH, state.kind);
+
+  TEST_ASSERT_TRUE(parseDeviceState(GENERIC_KIND, "21.5", state));
+  TEST_ASSERT_EQUAL(STATE_VALUE, state.kind);
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, state.value);
+
+  TEST_ASSERT_TRUE(parseDeviceState(SENSOR_KIND, "idle", state));
+  TEST_ASSERT_EQUAL(STATE_TEXT, state.kind);
+  TEST_ASSERT_EQUAL_STRING("idle", state.text);
+
+  // Text is capped so the state stays a fixed-size value
+  char tooLong[STATE_TEXT_MAX + 2];
+  memset(tooLong, 'x', sizeof(tooLong) - 1);
+  tooLong[sizeof(tooLong) - 1] = '\0';
+  TEST_ASSERT_FALSE(parseDeviceState(GENERIC_KIND, tooLong, state));
+}
+
+void test_null_text_is_rejected() {
+  DeviceState state;
+  TEST_ASSERT_FALSE(parseDeviceState(LED_KIND, nullptr, state));
+}
+
+void test_format_truncates_to_buffer() {
+  DeviceState state;
+  TEST_ASSERT_TRUE(parseDeviceState(MOTOR_KIND, "on:100:forward", state));
+  char buffer[6];
+  TEST_ASSERT_EQUAL(5, formatDeviceState(state, buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_STRING("on:10", buffer);
+}
+
+void test_every_state_fits_the_string_buffer() {
+  DeviceState state;
+  TEST_ASSERT_TRUE(parseDeviceState(STEPPER_KIND, "-2147483648", state));
+  TEST_ASSERT_LESS_THAN(STATE_STRING_MAX, formatDeviceState(state).length());
+  TEST_ASSERT_TRUE(parseDeviceState(LED_STRIP_KIND, "twinkle:#123456", state));
+  TEST_ASSERT_LESS_THAN(STATE_STRING_MAX, formatDeviceState(state).length());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_switch_accepts_all_spellings);
+  RUN_TEST(test_angle_range);
+  RUN_TEST(test_motor_grammar);
+  RUN_TEST(test_colours_normalise_to_hex);
+  RUN_TEST(test_strip_effects);
+  RUN_TEST(test_steps_are_signed);
+  RUN_TEST(test_generic_falls_back_from_switch_to_number_to_text);
+  RUN_TEST(test_null_text_is_rejected);
+  RUN_TEST(test_format_truncates_to_buffer);
+  RUN_TEST(test_every_state_fits_the_string_buffer);
+  return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <string>
+#include "websocket/json_arena.h"
+
+void setUp() {
+  jsonArena.reset();
+}
+
+void tearDown() {}
+
+static uint64_t heapAllocations() {
+  return native::allocStats().allocations;
+}
+
+// A batch of count updates, built before measuring
+static std::string batchMessage(size_t count) {
+  std::string message = "{\"method\":\"batch\",\"params\":[";
+  for (size_t i = 0; i < count; i++) {
+    if (i) message += ",";
+    message += "{\"id\":\"device" + std::to_string(i) + "\",\"state\":\"on\"}";
+  }
+  return message + "]}";
+}
+
+static DeserializationError parse(const std::string &message, JsonDocument &arenaDoc, JsonDocument &heapDoc,
+                                  JsonDocument* &parsed) {
+  DeserializationError error;
+  parsed = &parseJsonMessage((const uint8_t*)message.data(), message.size(), arenaDoc, heapDoc, error);
+  return error;
+}
+
+// --- Arena path ---
+
+void test_small_message_parses_without_the_heap() {
+  std::string message = "{\"method\":\"setState\",\"id\":7,\"params\":{\"id\":\"lamp\",\"state\":\"on\"}}";
+  uint32_t failures = jsonArena.failures();
+  uint64_t before = heapAllocations();
+  {
+    ArenaScope scope;
+    JsonDocument arenaDoc(&jsonArena);
+    JsonDocument heapDoc;
+    JsonDocument* parsed;
+    TEST_ASSERT_FALSE(parse(message, arenaDoc, heapDoc, parsed));
+    TEST_ASSERT_EQUAL_PTR(&arenaDoc, parsed);
+    TEST_ASSERT_EQUAL_STRING("lamp", (*parsed)["params"]["id"]);
+    TEST_ASSERT_TRUE(jsonArena.used() > 0);
+
+    // The reply is built in the same arena
+    JsonDocument reply(&jsonArena);
+    reply["id"] = 7;
+    reply["result"]["state"] = "on";
+    TEST_ASSERT_FALSE(reply.overflowed());
+  }
+  TEST_ASSERT_EQUAL(0, heapAllocations() - before);
+  TEST_ASSERT_EQUAL(failures, jsonArena.failures());
+  TEST_ASSERT_EQUAL(0, jsonArena.used());
+}
+
+void test_arena_is_reset_by_the_outermost_scope() {
+  ArenaScope outer;
+  JsonDocument doc(&jsonArena);
+  doc["a"] = "kept";
+  size_t used = jsonArena.used();
+  {
+    ArenaScope inner;
+    JsonDocument nested(&jsonArena);
+    nested["b"] = "scratch";
+  }
+  TEST_ASSERT_TRUE(jsonArena.used() >= used);
+  TEST_ASSERT_EQUAL_STRING("kept", doc["a"]);
+}
+
+// --- Heap fallback ---
+
+void test_large_message_falls_back_to_the_heap() {
+  std::string message = batchMessage(200);
+  TEST_ASSERT_TRUE(message.size() > WS_JSON_ARENA_SIZE);
+
+  uint32_t failures = jsonArena.failures();
+  uint64_t before = heapAllocations();
+  {
+    ArenaScope scope;
+    JsonDocument arenaDoc(&jsonArena);
+    JsonDocument heapDoc;
+    JsonDocument* parsed;
+    TEST_ASSERT_FALSE(parse(message, arenaDoc, heapDoc, parsed));
+    TEST_ASSERT_EQUAL_PTR(&heapDoc, parsed);
+    TEST_ASSERT_EQUAL(200, (*parsed)["params"].size());
+    TEST_ASSERT_EQUAL_STRING("device199", (*parsed)["params"][199]["id"]);
+    TEST_ASSERT_TRUE(heapAllocations() > before);
+
+    // The failed attempt's space is free again for the reply
+    TEST_ASSERT_EQUAL(0, jsonArena.used());
+    JsonDocument reply(&jsonArena);
+    reply["type"] = "batch";
+    TEST_ASSERT_FALSE(reply.overflowed());
+  }
+  TEST_ASSERT_TRUE(jsonArena.failures() > failures);
+  TEST_ASSERT_EQUAL(0, jsonArena.used());
+}
+
+// Memory held by an outer scope's documents survives the fallback
+void test_fallback_keeps_outer_documents() {
+  ArenaScope outer;
+  JsonDocument held(&jsonArena);
+  held["keep"] = "me";
+  size_t mark = jsonArena.used();
+
+  std::string message = batchMessage(200);
+  JsonDocument arenaDoc(&jsonArena);
+  JsonDocument heapDoc;
+  JsonDocument* parsed;
+  TEST_ASSERT_FALSE(parse(message, arenaDoc, heapDoc, parsed));
+  TEST_ASSERT_EQUAL_PTR(&heapDoc, parsed);
+  TEST_ASSERT_EQUAL(mark, jsonArena.used());
+  TEST_ASSERT_EQUAL_STRING("me", held["keep"]);
+}
+
+void test_invalid_json_does_not_retry() {
+  std::string message = "{\"method\":";
+  uint64_t before = heapAllocations();
+  ArenaScope scope;
+  JsonDocument arenaDoc(&jsonArena);
+  JsonDocument heapDoc;
+  JsonDocument* parsed;
+  DeserializationError error = parse(message, arenaDoc, heapDoc, parsed);
+  TEST_ASSERT_TRUE(error == DeserializationError::IncompleteInput);
+  TEST_ASSERT_EQUAL_PTR(&arenaDoc, parsed);
+  TEST_ASSERT_EQUAL(0, heapAllocations() - before);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_small_message_parses_without_the_heap);
+  RUN_TEST(test_arena_is_reset_by_the_outermost_scope);
+  RUN_TEST(test_large_message_falls_back_to_the_heap);
+  RUN_TEST(test_fallback_keeps_outer_documents);
+  RUN_TEST(test_invalid_json_does_not_retry);
+  return UNITY_END();
+}
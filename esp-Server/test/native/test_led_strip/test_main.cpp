@@ -0,0 +1,104 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <esp_intr_alloc.h>
+#include <vector>
+#include "ESPControlPlatform.h"
+#include "led_strip.h"
+#include "ws2812_encoder.h"
+
+static const uint8_t DATA_PIN = 5;
+static const uint16_t PIXELS = 4;
+static const uint32_t FRAME_INTERVAL_US = 1000000UL / LED_STRIP_MAX_FPS;
+
+static DeviceHandle handle = INVALID_DEVICE_HANDLE;
+
+void setUp() {
+  native::reset();
+  devices.clear();
+  Device device;
+  device.id = "strip";
+  device.type = "led_strip";
+  device.kind = LED_STRIP_KIND;
+  device.pins = {DATA_PIN};
+  device.ledCount = PIXELS;
+  handle = devices.add(device);
+  TEST_ASSERT_TRUE(ledStripAttach(*devices.get(handle)));
+}
+
+void tearDown() {
+  ledStripDetach(handle);
+}
+
+// The bytes of the last frame, read back from the RMT items
+static std::vector<uint8_t> sentBytes() {
+  const std::vector<uint32_t> &items = native::rmtItems(0);
+  std::vector<uint8_t> bytes(items.size() / 8);
+  for (size_t i = 0; i < items.size(); i++) {
+    bool bit = items[i] == ws2812Item(true);
+    bytes[i / 8] = bytes[i / 8] << 1 | bit;
+  }
+  return bytes;
+}
+
+void test_rmt_interrupt_is_iram() {
+  TEST_ASSERT_TRUE(native::rmtInstalled(0));
+  TEST_ASSERT_TRUE(native::rmtInterruptFlags(0) & ESP_INTR_FLAG_IRAM);
+}
+
+void test_frame_is_sent_grb() {
+  TEST_ASSERT_TRUE(ledStripFill(handle, 0, PIXELS, 0xFF, 0x00, 0x10));
+  TEST_ASSERT_TRUE(ledStripFill(handle, 3, 1, 0x01, 0x02, 0x03));
+  handleLedStrips();
+
+  std::vector<uint8_t> bytes = sentBytes();
+  TEST_ASSERT_EQUAL(PIXELS * 3, bytes.size());
+  TEST_ASSERT_EQUAL_HEX8(0x00, bytes[0]);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, bytes[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x10, bytes[2]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, bytes[9]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, bytes[10]);
+  TEST_ASSERT_EQUAL_HEX8(0x03, bytes[11]);
+
+  TEST_ASSERT_FALSE(ledStripFill(handle, 3, 2, 0, 0, 0));   // past the end
+}
+
+// Updates between two frames collapse into the next one
+void test_frames_are_rate_limited() {
+  handleLedStrips();
+  uint32_t writes = native::rmtWrites(0);
+
+  ledStripFill(handle, 0, PIXELS, 1, 1, 1);
+  ledStripFill(handle, 0, PIXELS, 2, 2, 2);
+  handleLedStrips();
+  TEST_ASSERT_EQUAL(writes, native::rmtWrites(0));
+
+  native::advanceMicros(FRAME_INTERVAL_US);
+  handleLedStrips();
+  TEST_ASSERT_EQUAL(writes + 1, native::rmtWrites(0));
+  TEST_ASSERT_EQUAL_HEX8(2, sentBytes()[0]);
+}
+
+// A frame still on the wire holds back the next one
+void test_busy_channel_defers_the_frame() {
+  handleLedStrips();
+  uint32_t writes = native::rmtWrites(0);
+
+  ledStripFill(handle, 0, PIXELS, 9, 9, 9);
+  native::advanceMicros(FRAME_INTERVAL_US);
+  native::setRmtBusy(0, true);
+  handleLedStrips();
+  TEST_ASSERT_EQUAL(writes, native::rmtWrites(0));
+
+  native::setRmtBusy(0, false);
+  handleLedStrips();
+  TEST_ASSERT_EQUAL(writes + 1, native::rmtWrites(0));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rmt_interrupt_is_iram);
+  RUN_TEST(test_frame_is_sent_grb);
+  RUN_TEST(test_frames_are_rate_limited);
+  RUN_TEST(test_busy_channel_defers_the_frame);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <StreamString.h>
+#include "metrics.h"
+
+void setUp() {
+  native::reset();
+}
+
+void tearDown() {}
+
+static bool contains(const String &text, const char* part) {
+  return text.indexOf(part) >= 0;
+}
+
+void test_registration_is_idempotent() {
+  MetricId a = registerCounter("test_requests_total", "route", "GET /a");
+  MetricId b = registerCounter("test_requests_total", "route", "GET /b");
+  TEST_ASSERT_NOT_EQUAL(INVALID_METRIC, a);
+  TEST_ASSERT_NOT_EQUAL(a, b);
+
+  // Same name and label, even from a different buffer, is the same metric
+  char copy[] = "GET /a";
+  TEST_ASSERT_EQUAL(a, registerCounter("test_requests_total", "route", copy));
+}
+
+void test_counter_table_fills_up() {
+  MetricId last = 0;
+  static char names[METRICS_MAX_COUNTERS + 1][24];
+  for (int i = 0; i <= METRICS_MAX_COUNTERS; i++) {
+    snprintf(names[i], sizeof(names[i]), "test_fill_%d", i);
+    last = registerCounter(names[i]);
+  }
+  TEST_ASSERT_EQUAL(INVALID_METRIC, last);
+
+  // Recording to an invalid id is a no-op
+  incrementCounter(INVALID_METRIC);
+  recordDuration(INVALID_METRIC, 10);
+  setGauge(INVALID_METRIC, 1);
+}
+
+void test_text_export_has_cumulative_buckets() {
+  MetricId latency = registerHistogram("test_latency_us", "op", "x");
+  recordDuration(latency, 40);       // <= 50
+  recordDuration(latency, 400);      // <= 500
+  recordDuration(latency, 200000);   // +Inf
+
+  StreamString out;
+  size_t written = writeMetricsText(out);
+  TEST_ASSERT_EQUAL(out.length(), written);
+
+  TEST_ASSERT_TRUE(contains(out, "# TYPE test_latency_us histogram\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_latency_us_bucket{op=\"x\",le=\"50\"} 1\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_latency_us_bucket{op=\"x\",le=\"250\"} 1\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_latency_us_bucket{op=\"x\",le=\"500\"} 2\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_latency_us_bucket{op=\"x\",le=\"+Inf\"} 3\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_latency_us_sum{op=\"x\"} 200440\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_latency_us_count{op=\"x\"} 3\n"));
+  TEST_ASSERT_FALSE(contains(out, "\r\n"));
+}
+
+void test_type_line_once_per_name() {
+  incrementCounter(registerCounter("test_multi_total", "k", "a"));
+  incrementCounter(registerCounter("test_multi_total", "k", "b"), 5);
+
+  StreamString out;
+  writeMetricsText(out);
+  int first = out.indexOf("# TYPE test_multi_total counter");
+  TEST_ASSERT_GREATER_OR_EQUAL(0, first);
+  TEST_ASSERT_EQUAL(-1, out.indexOf("# TYPE test_multi_total counter", first + 1));
+  TEST_ASSERT_TRUE(contains(out, "test_multi_total{k=\"b\"} 5\n"));
+}
+
+void test_label_values_are_escaped() {
+  setGauge(registerGauge("test_gauge", "path", "a\"b\\c"), 7);
+  StreamString out;
+  writeMetricsText(out);
+  TEST_ASSERT_TRUE(contains(out, "test_gauge{path=\"a\\\"b\\\\c\"} 7\n"));
+}
+
+void test_scoped_timer_records_elapsed_micros() {
+  MetricId timed = registerHistogram("test_scoped_us");
+  {
+    ScopedTimer timer(timed);
+    native::advanceMicros(300);
+  }
+  StreamString out;
+  writeMetricsText(out);
+  TEST_ASSERT_TRUE(contains(out, "test_scoped_us_bucket{le=\"250\"} 0\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_scoped_us_bucket{le=\"500\"} 1\n"));
+  TEST_ASSERT_TRUE(contains(out, "test_scoped_us_sum 300\n"));
+}
+
+void test_json_export() {
+  MetricId pushes = registerCounter("test_json_total");
+  incrementCounter(pushes, 3);
+  native::advanceMillis(1234);
+
+  StreamString out;
+  writeMetricsJson(out);
+  TEST_ASSERT_TRUE(out.startsWith("{\"type\":\"metrics\",\"uptimeMs\":1234,"));
+  TEST_ASSERT_TRUE(contains(out, "\"bucketBounds\":[50,100,250,500,1000,2500,5000,10000,25000,50000,100000]"));
+  TEST_ASSERT_TRUE(contains(out, "{\"name\":\"test_json_total\",\"value\":3}"));
+  TEST_ASSERT_TRUE(out.endsWith("]}"));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_registration_is_idempotent);
+  RUN_TEST(test_text_export_has_cumulative_buckets);
+  RUN_TEST(test_type_line_once_per_name);
+  RUN_TEST(test_label_values_are_escaped);
+  RUN_TEST(test_scoped_timer_records_elapsed_micros);
+  RUN_TEST(test_json_export);
+  RUN_TEST(test_counter_table_fills_up);
+  return UNITY_END();
+}
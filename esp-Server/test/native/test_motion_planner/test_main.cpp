@@ -0,0 +1,179 @@
+#include <unity.h>
+#include <math.h>
+#include "motion_planner.h"
+
+// The planner is driven as the step ISR drives it: one nextInterval() per
+// step. Intervals are ticks << MOTION_FRACTION_BITS of a TICK_HZ timer.
+static const uint32_t TICK_HZ = 50000;
+static const double UNITS_PER_SECOND = (double)TICK_HZ * (1 << MOTION_FRACTION_BITS);
+
+static MotionPlanner planner;
+
+void setUp() {}
+void tearDown() {}
+
+struct Run {
+  uint32_t steps;
+  double seconds;
+  uint32_t shortest;
+};
+
+// Runs the current move to its end
+static Run runMove() {
+  Run run = {0, 0, 0xFFFFFFFF};
+  while (planner.moving()) {
+    uint32_t interval = planner.nextInterval();
+    run.steps++;
+    run.seconds += interval / UNITS_PER_SECOND;
+    if (interval < run.shortest) run.shortest = interval;
+  }
+  return run;
+}
+
+static void assertWithin(double expected, double actual, double tolerance) {
+  TEST_ASSERT_TRUE_MESSAGE(fabs(actual - expected) <= expected * tolerance, "duration off the analytic profile");
+}
+
+// --- Move length ---
+
+void test_move_takes_exactly_the_requested_steps() {
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, 1000, 2000, PROFILE_TRAPEZOID));
+  const int32_t moves[] = {1, 2, 3, 250, 251, 10000};
+  for (int32_t steps : moves) {
+    planner.start(steps);
+    TEST_ASSERT_EQUAL(1, planner.direction());
+    TEST_ASSERT_EQUAL((uint32_t)steps, runMove().steps);
+  }
+
+  planner.start(-37);
+  TEST_ASSERT_EQUAL(-1, planner.direction());
+  TEST_ASSERT_EQUAL(37, runMove().steps);
+
+  planner.start(0);
+  TEST_ASSERT_FALSE(planner.moving());
+}
+
+void test_rejects_zero_settings() {
+  TEST_ASSERT_FALSE(planner.configure(0, 1000, 2000, PROFILE_TRAPEZOID));
+  TEST_ASSERT_FALSE(planner.configure(TICK_HZ, 0, 2000, PROFILE_TRAPEZOID));
+  TEST_ASSERT_FALSE(planner.configure(TICK_HZ, 1000, 0, PROFILE_SCURVE));
+}
+
+// --- Duration ---
+
+// Reaches v = V after V / A seconds and V^2 / 2A steps, then cruises
+void test_trapezoid_matches_the_analytic_duration() {
+  const double v = 1000, a = 2000, s = 5000;
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, v, a, PROFILE_TRAPEZOID));
+  TEST_ASSERT_EQUAL(250, planner.rampSteps());
+
+  planner.start(s);
+  Run run = runMove();
+  assertWithin(v / a + s / v, run.seconds, 0.01);
+  TEST_ASSERT_EQUAL((uint32_t)(UNITS_PER_SECOND / v), run.shortest);
+}
+
+// Too short to reach full speed: accelerate halfway, then decelerate
+void test_short_trapezoid_is_a_triangle() {
+  const double a = 2000, s = 200;
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, 1000, a, PROFILE_TRAPEZOID));
+
+  planner.start(s);
+  Run run = runMove();
+  assertWithin(2 * sqrt(s / a), run.seconds, 0.02);
+  TEST_ASSERT_TRUE(run.shortest > UNITS_PER_SECOND / 1000);
+}
+
+// Smoothstep velocity: the ramp takes 1.5 V / A and covers V * T / 2 steps
+void test_scurve_matches_the_analytic_duration() {
+  const double v = 1000, a = 2000, s = 5000;
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, v, a, PROFILE_SCURVE));
+  double rampSeconds = 1.5 * v / a;
+  TEST_ASSERT_EQUAL((uint32_t)(v * rampSeconds / 2), planner.rampSteps());
+
+  planner.start(s);
+  Run run = runMove();
+  assertWithin(rampSeconds + s / v, run.seconds, 0.01);
+}
+
+// Ramps longer than the table are stored as averages over step groups
+void test_long_ramp_keeps_its_duration() {
+  const double v = 20000, a = 1000, s = 600000;
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, v, a, PROFILE_TRAPEZOID));
+  TEST_ASSERT_TRUE(planner.rampSteps() > MOTION_RAMP_ENTRIES);
+
+  planner.start(s);
+  Run run = runMove();
+  TEST_ASSERT_EQUAL((uint32_t)s, run.steps);
+  assertWithin(v / a + s / v, run.seconds, 0.01);
+}
+
+// --- Stop and re-queue ---
+
+void test_stop_decelerates_along_the_ramp() {
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, 1000, 2000, PROFILE_TRAPEZOID));
+  planner.start(10000);
+
+  uint32_t accelerating[100];
+  for (uint32_t &interval : accelerating) interval = planner.nextInterval();
+  planner.stop();
+
+  // As many steps down as it took up, mirroring the ramp
+  TEST_ASSERT_EQUAL(100, planner.stepsLeft());
+  for (int i = 99; i >= 0; i--) {
+    TEST_ASSERT_EQUAL(accelerating[i], planner.nextInterval());
+  }
+  TEST_ASSERT_FALSE(planner.moving());
+
+  // Stopping again or while idle changes nothing
+  planner.stop();
+  TEST_ASSERT_FALSE(planner.moving());
+}
+
+void test_stop_near_the_end_keeps_the_remaining_steps() {
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, 1000, 2000, PROFILE_TRAPEZOID));
+  planner.start(1000);
+  for (int i = 0; i < 900; i++) planner.nextInterval();
+
+  // Already decelerating: the planned end is the quickest stop
+  planner.stop();
+  TEST_ASSERT_EQUAL(100, planner.stepsLeft());
+}
+
+void test_requeued_move_starts_from_standstill() {
+  TEST_ASSERT_TRUE(planner.configure(TICK_HZ, 1000, 2000, PROFILE_TRAPEZOID));
+  planner.start(500);
+  uint32_t first = planner.nextInterval();
+  planner.stop();
+  runMove();
+
+  planner.start(-500);
+  TEST_ASSERT_EQUAL(-1, planner.direction());
+  TEST_ASSERT_EQUAL(first, planner.nextInterval());
+  TEST_ASSERT_EQUAL(499, runMove().steps);
+}
+
+// --- Profiles ---
+
+void test_profile_names() {
+  TEST_ASSERT_EQUAL(PROFILE_SCURVE, parseMotionProfile("scurve"));
+  TEST_ASSERT_EQUAL(PROFILE_TRAPEZOID, parseMotionProfile("trapezoid"));
+  TEST_ASSERT_EQUAL(PROFILE_TRAPEZOID, parseMotionProfile("bogus"));
+  TEST_ASSERT_EQUAL(PROFILE_TRAPEZOID, parseMotionProfile(nullptr));
+  TEST_ASSERT_EQUAL_STRING("scurve", motionProfileName(PROFILE_SCURVE));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_move_takes_exactly_the_requested_steps);
+  RUN_TEST(test_rejects_zero_settings);
+  RUN_TEST(test_trapezoid_matches_the_analytic_duration);
+  RUN_TEST(test_short_trapezoid_is_a_triangle);
+  RUN_TEST(test_scurve_matches_the_analytic_duration);
+  RUN_TEST(test_long_ramp_keeps_its_duration);
+  RUN_TEST(test_stop_decelerates_along_the_ramp);
+  RUN_TEST(test_stop_near_the_end_keeps_the_remaining_steps);
+  RUN_TEST(test_requeued_move_starts_from_standstill);
+  RUN_TEST(test_profile_names);
+  return UNITY_END();
+}
@@ -0,0 +1,134 @@
+#include <unity.h>
+#include "ESPControlPlatform.h"
+
+static const DeviceHandle A = 1;
+static const DeviceHandle B = 2;
+
+void setUp() {
+  devices.clear();
+}
+
+void tearDown() {}
+
+static Device makeDevice(const char* id, DeviceKind kind, std::vector<int> pins,
+                         InterfaceType interface = DIGITAL_IF, DeviceDirection direction = OUTPUT_DEVICE) {
+  Device device;
+  device.id = id;
+  device.type = deviceKindName(kind);
+  device.kind = kind;
+  device.pins = pins;
+  device.interface = interface;
+  device.direction = direction;
+  return device;
+}
+
+// --- Capabilities ---
+
+void test_capability_table() {
+  TEST_ASSERT_EQUAL(0, pinCapabilities(20));
+  TEST_ASSERT_EQUAL(0, pinCapabilities(40));
+  TEST_ASSERT_EQUAL(0, pinCapabilities(-1));
+  TEST_ASSERT_TRUE(pinCapabilities(6) & PIN_CAP_RESERVED);
+  TEST_ASSERT_FALSE(pinCapabilities(34) & PIN_CAP_OUTPUT);
+  TEST_ASSERT_TRUE(pinCapabilities(34) & PIN_CAP_ADC1);
+  TEST_ASSERT_TRUE(pinCapabilities(25) & PIN_CAP_DAC);
+  TEST_ASSERT_TRUE(pinCapabilities(18) & PIN_CAP_LEDC);
+}
+
+// --- PinMap ---
+
+void test_check_reports_the_first_problem() {
+  PinMap map;
+  TEST_ASSERT_EQUAL(PIN_ERR_NONE, map.check(18, PIN_CAP_OUTPUT, A));
+  TEST_ASSERT_EQUAL(PIN_ERR_NO_SUCH_PIN, map.check(24, 0, A));
+  TEST_ASSERT_EQUAL(PIN_ERR_RESERVED, map.check(1, PIN_CAP_OUTPUT, A));
+  TEST_ASSERT_EQUAL(PIN_ERR_INPUT_ONLY, map.check(35, PIN_CAP_OUTPUT, A));
+  TEST_ASSERT_EQUAL(PIN_ERR_NO_ADC1, map.check(4, PIN_CAP_ADC1, A));
+}
+
+void test_claim_keeps_the_first_owner() {
+  PinMap map;
+  TEST_ASSERT_EQUAL(0, map.claim({18, 19}, A));
+  TEST_ASSERT_EQUAL(1, map.claim({19, 21}, B));
+  TEST_ASSERT_EQUAL(A, map.owner(19));
+  TEST_ASSERT_EQUAL(B, map.owner(21));
+  TEST_ASSERT_EQUAL_HEX64((1ULL << 18) | (1ULL << 19) | (1ULL << 21), map.claimed());
+
+  // Claiming again is idempotent, and out-of-range pins are skipped
+  TEST_ASSERT_EQUAL(0, map.claim({18}, A));
+  TEST_ASSERT_EQUAL(1, map.claim({64}, A));
+
+  TEST_ASSERT_EQUAL(PIN_ERR_IN_USE, map.check(19, PIN_CAP_OUTPUT, B));
+  TEST_ASSERT_EQUAL(PIN_ERR_NONE, map.check(19, PIN_CAP_OUTPUT, A));
+}
+
+void test_release_only_frees_own_pins() {
+  PinMap map;
+  map.claim({18}, A);
+  map.claim({19}, B);
+  map.release({18, 19}, A);
+  TEST_ASSERT_EQUAL(INVALID_DEVICE_HANDLE, map.owner(18));
+  TEST_ASSERT_EQUAL(B, map.owner(19));
+
+  map.clear();
+  TEST_ASSERT_EQUAL_HEX64(0, map.claimed());
+  TEST_ASSERT_EQUAL(INVALID_DEVICE_HANDLE, map.owner(19));
+}
+
+// --- Device checks ---
+
+void test_device_pin_count_and_capabilities() {
+  int badPin;
+  Device motor = makeDevice("m", MOTOR_KIND, {});
+  TEST_ASSERT_EQUAL(PIN_ERR_TOO_FEW, checkDevicePins(motor, {18, 19}, badPin));
+
+  // The enable pin needs PWM, which input-only pins cannot do
+  TEST_ASSERT_EQUAL(PIN_ERR_INPUT_ONLY, checkDevicePins(motor, {18, 19, 34}, badPin));
+  TEST_ASSERT_EQUAL(34, badPin);
+  TEST_ASSERT_EQUAL(PIN_ERR_NONE, checkDevicePins(motor, {18, 19, 21}, badPin));
+  TEST_ASSERT_EQUAL(-1, badPin);
+
+  Device sensor = makeDevice("s", SENSOR_KIND, {}, ANALOG_IF, INPUT_DEVICE);
+  TEST_ASSERT_EQUAL(PIN_ERR_NO_ADC1, checkDevicePins(sensor, {4}, badPin));
+  TEST_ASSERT_EQUAL(PIN_ERR_NONE, checkDevicePins(sensor, {34}, badPin));
+}
+
+void test_device_duplicates_and_batch_claims() {
+  int badPin;
+  Device led = makeDevice("l", LED_KIND, {});
+  TEST_ASSERT_EQUAL(PIN_ERR_DUPLICATE, checkDevicePins(led, {18, 18}, badPin));
+  TEST_ASSERT_EQUAL(18, badPin);
+  TEST_ASSERT_EQUAL(PIN_ERR_IN_USE, checkDevicePins(led, {18}, badPin, 1ULL << 18));
+}
+
+void test_registry_claims_and_frees_pins() {
+  int badPin;
+  DeviceHandle first = devices.add(makeDevice("first", LED_KIND, {18}));
+  TEST_ASSERT_NOT_EQUAL(INVALID_DEVICE_HANDLE, first);
+  TEST_ASSERT_EQUAL(first, devices.pinOwner(18));
+
+  Device second = makeDevice("second", LED_KIND, {});
+  TEST_ASSERT_EQUAL(PIN_ERR_IN_USE, checkDevicePins(second, {18}, badPin));
+
+  // A device re-checking its own pins is fine
+  TEST_ASSERT_EQUAL(PIN_ERR_NONE, checkDevicePins(*devices.get(first), {18}, badPin));
+
+  TEST_ASSERT_TRUE(devices.setPins(first, {19}));
+  TEST_ASSERT_EQUAL(INVALID_DEVICE_HANDLE, devices.pinOwner(18));
+  TEST_ASSERT_EQUAL(first, devices.pinOwner(19));
+
+  TEST_ASSERT_TRUE(devices.remove(first));
+  TEST_ASSERT_EQUAL(INVALID_DEVICE_HANDLE, devices.pinOwner(19));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_capability_table);
+  RUN_TEST(test_check_reports_the_first_problem);
+  RUN_TEST(test_claim_keeps_the_first_owner);
+  RUN_TEST(test_release_only_frees_own_pins);
+  RUN_TEST(test_device_pin_count_and_capabilities);
+  RUN_TEST(test_device_duplicates_and_batch_claims);
+  RUN_TEST(test_registry_claims_and_frees_pins);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <string.h>
+#include "ESPExpress.h"
+#include "websocket/websocket.h"
+#include "websocket/send_queue.h"
+
+static ESPExpress app(80);
+
+static const uint8_t FAST = 0;
+static const uint8_t SLOW = 1;
+
+void setUp() {
+  native::reset();
+  app.wsClear();
+  for (uint8_t num = 0; num < WS_MAX_CLIENTS; num++) {
+    resetSendQueue(num);
+    app.wsEvent(num, WStype_DISCONNECTED);
+  }
+  app.wsEvent(FAST, WStype_CONNECTED);
+  app.wsEvent(SLOW, WStype_CONNECTED);
+}
+
+void tearDown() {}
+
+static void queue(uint8_t num, const char* text, uint16_t key = WS_NO_COALESCE) {
+  TEST_ASSERT_TRUE(queueText(num, text, strlen(text), key));
+}
+
+// --- Draining ---
+
+void test_messages_are_sent_in_order() {
+  queue(FAST, "a");
+  queue(FAST, "b");
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(2, app.wsSent(FAST).size());
+  TEST_ASSERT_EQUAL_STRING("a", app.wsSent(FAST)[0].data.c_str());
+  TEST_ASSERT_EQUAL_STRING("b", app.wsSent(FAST)[1].data.c_str());
+}
+
+void test_coalesced_message_keeps_its_place() {
+  queue(FAST, "1", 7);
+  queue(FAST, "x");
+  queue(FAST, "2", 7);
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(2, app.wsSent(FAST).size());
+  TEST_ASSERT_EQUAL_STRING("2", app.wsSent(FAST)[0].data.c_str());
+}
+
+// Text of the given length, for filling the byte budget
+static const char* text(size_t length) {
+  static char buffer[WS_DRAIN_BYTES_PER_CLIENT * 2 + 1];
+  memset(buffer, 'x', length);
+  buffer[length] = 0;
+  return buffer;
+}
+
+// A pass hands each client at most its byte budget; the rest waits
+void test_pass_is_limited_to_the_byte_budget() {
+  size_t third = WS_DRAIN_BYTES_PER_CLIENT / 3 + 1;
+  queue(SLOW, text(third));
+  queue(SLOW, text(third));
+  queue(SLOW, text(third));
+  queue(FAST, "fast");
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(2, app.wsSent(SLOW).size());
+  TEST_ASSERT_EQUAL(1, app.wsSent(FAST).size());
+
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(3, app.wsSent(SLOW).size());
+}
+
+// A message larger than the budget still goes out, on its own
+void test_large_message_goes_out_alone() {
+  queue(SLOW, text(WS_DRAIN_BYTES_PER_CLIENT * 2));
+  queue(SLOW, "next");
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(1, app.wsSent(SLOW).size());
+  TEST_ASSERT_EQUAL(WS_DRAIN_BYTES_PER_CLIENT * 2, app.wsSent(SLOW)[0].data.size());
+
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(2, app.wsSent(SLOW).size());
+}
+
+// A failed send is not retried, and the others are not held up
+void test_failed_send_moves_on() {
+  app.wsFailSends(SLOW, true);
+  queue(SLOW, "lost");
+  queue(SLOW, "later");
+  queue(FAST, "fast");
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(0, app.wsSent(SLOW).size());
+  TEST_ASSERT_EQUAL(1, app.wsSent(FAST).size());
+
+  app.wsFailSends(SLOW, false);
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(1, app.wsSent(SLOW).size());
+  TEST_ASSERT_EQUAL_STRING("later", app.wsSent(SLOW)[0].data.c_str());
+}
+
+// --- Slow clients ---
+
+void test_failing_client_is_disconnected() {
+  app.wsFailSends(SLOW, true);
+  queue(SLOW, "stuck");
+  drainSendQueues(app);
+
+  native::advanceMillis(WS_SLOW_CLIENT_MS - 1);
+  queue(SLOW, "again");
+  drainSendQueues(app);
+  TEST_ASSERT_TRUE(app.wsConnected(SLOW));
+
+  native::advanceMillis(1);
+  drainSendQueues(app);
+  TEST_ASSERT_FALSE(app.wsConnected(SLOW));
+  TEST_ASSERT_TRUE(app.wsConnected(FAST));
+}
+
+// Running empty again clears the stall
+void test_recovered_client_stays_connected() {
+  app.wsFailSends(SLOW, true);
+  queue(SLOW, "lost");
+  drainSendQueues(app);
+
+  native::advanceMillis(WS_SLOW_CLIENT_MS / 2);
+  app.wsFailSends(SLOW, false);
+  queue(SLOW, "late");
+  drainSendQueues(app);
+  TEST_ASSERT_EQUAL(1, app.wsSent(SLOW).size());
+
+  native::advanceMillis(WS_SLOW_CLIENT_MS);
+  drainSendQueues(app);
+  TEST_ASSERT_TRUE(app.wsConnected(SLOW));
+}
+
+int main() {
+  initSendQueues();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_messages_are_sent_in_order);
+  RUN_TEST(test_coalesced_message_keeps_its_place);
+  RUN_TEST(test_pass_is_limited_to_the_byte_budget);
+  RUN_TEST(test_large_message_goes_out_alone);
+  RUN_TEST(test_failed_send_moves_on);
+  RUN_TEST(test_failing_client_is_disconnected);
+  RUN_TEST(test_recovered_client_stays_connected);
+  return UNITY_END();
+}
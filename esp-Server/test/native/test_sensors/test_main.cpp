@@ -0,0 +1,144 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <math.h>
+#include "ESPControlPlatform.h"
+#include "sensors.h"
+#include "adc_source.h"
+
+static const uint8_t DHT_PIN = 4;
+static const uint8_t ADC_PIN = 34;
+
+static DeviceHandle climate = INVALID_DEVICE_HANDLE;
+static DeviceHandle photocell = INVALID_DEVICE_HANDLE;
+
+static DeviceHandle addSensor(const char* id, const char* type, InterfaceType interface, uint8_t pin) {
+  Device device;
+  device.id = id;
+  device.type = type;
+  device.kind = parseDeviceKind(device.type);
+  device.interface = interface;
+  device.direction = INPUT_DEVICE;
+  device.pins = {pin};
+  return devices.add(device);
+}
+
+void setUp() {
+  // Handles are new for every test, and the clock moves past any reading
+  // an earlier test left in the cache
+  devices.clear();
+  native::advanceMillis(60000);
+  climate = addSensor("climate", "dht22", DIGITAL_IF, DHT_PIN);
+  photocell = addSensor("photocell", "sensor", ANALOG_IF, ADC_PIN);
+  native::setDht(DHT_PIN, 21.5, 40);
+  native::setAnalogMillivolts(ADC_PIN, 1650);
+}
+
+void tearDown() {}
+
+static float read(DeviceHandle handle, uint8_t quantity) {
+  float value = NAN;
+  TEST_ASSERT_EQUAL(SENSOR_OK, readSensor(devices.get(handle), quantity, value));
+  return value;
+}
+
+// --- Coalescing ---
+
+// One DHT transaction yields both quantities; the second comes from the cache
+void test_one_transaction_serves_every_quantity() {
+  uint32_t reads = native::dhtReadCount(DHT_PIN);
+  TEST_ASSERT_EQUAL_FLOAT(21.5, read(climate, SENSOR_TEMPERATURE));
+  TEST_ASSERT_EQUAL(reads + 2, native::dhtReadCount(DHT_PIN));
+
+  TEST_ASSERT_EQUAL_FLOAT(40, read(climate, SENSOR_HUMIDITY));
+  TEST_ASSERT_EQUAL(reads + 2, native::dhtReadCount(DHT_PIN));
+}
+
+void test_burst_of_requests_costs_one_read() {
+  uint32_t reads = native::dhtReadCount(DHT_PIN);
+  for (int i = 0; i < 10; i++) {
+    read(climate, SENSOR_TEMPERATURE);
+    read(climate, SENSOR_HUMIDITY);
+    native::advanceMillis(100);
+  }
+  TEST_ASSERT_EQUAL(reads + 2, native::dhtReadCount(DHT_PIN));
+}
+
+// Each device has its own entries
+void test_devices_do_not_share_readings() {
+  DeviceHandle other = addSensor("outside", "dht11", DIGITAL_IF, DHT_PIN + 1);
+  native::setDht(DHT_PIN + 1, -3, 90);
+  TEST_ASSERT_EQUAL_FLOAT(21.5, read(climate, SENSOR_TEMPERATURE));
+  TEST_ASSERT_EQUAL_FLOAT(-3, read(other, SENSOR_TEMPERATURE));
+  TEST_ASSERT_EQUAL_FLOAT(40, read(climate, SENSOR_HUMIDITY));
+}
+
+// --- Max age ---
+
+void test_reading_expires_after_max_age() {
+  read(climate, SENSOR_TEMPERATURE);
+  native::setDht(DHT_PIN, 25, 45);
+
+  native::advanceMillis(DHT_MAX_AGE_MS - 1);
+  TEST_ASSERT_EQUAL_FLOAT(21.5, read(climate, SENSOR_TEMPERATURE));
+
+  native::advanceMillis(1);
+  TEST_ASSERT_EQUAL_FLOAT(25, read(climate, SENSOR_TEMPERATURE));
+  TEST_ASSERT_EQUAL_FLOAT(45, read(climate, SENSOR_HUMIDITY));
+}
+
+// The ADC has its own, much shorter window
+void test_adc_max_age() {
+  uint32_t conversions = native::analogReadCount(ADC_PIN);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1.65, read(photocell, SENSOR_VOLTAGE));
+  TEST_ASSERT_FLOAT_WITHIN(0.1, 50, read(photocell, SENSOR_LIGHT));
+  TEST_ASSERT_EQUAL(conversions + ADC_OVERSAMPLE, native::analogReadCount(ADC_PIN));
+
+  native::setAnalogMillivolts(ADC_PIN, 3300);
+  native::advanceMillis(ADC_MAX_AGE_MS - 1);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1.65, read(photocell, SENSOR_VOLTAGE));
+  native::advanceMillis(1);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 3.3, read(photocell, SENSOR_VOLTAGE));
+  TEST_ASSERT_EQUAL(conversions + 2 * ADC_OVERSAMPLE, native::analogReadCount(ADC_PIN));
+}
+
+// --- Errors ---
+
+// A failed transaction is not cached; the next request tries again
+void test_failed_read_is_retried() {
+  native::setDht(DHT_PIN, NAN, NAN);
+  float value;
+  TEST_ASSERT_EQUAL(SENSOR_FAILED, readSensor(devices.get(climate), SENSOR_TEMPERATURE, value));
+
+  native::setDht(DHT_PIN, 19, 50);
+  TEST_ASSERT_EQUAL_FLOAT(19, read(climate, SENSOR_TEMPERATURE));
+}
+
+void test_unsupported_quantity() {
+  float value;
+  TEST_ASSERT_EQUAL(SENSOR_UNSUPPORTED, readSensor(devices.get(climate), SENSOR_VOLTAGE, value));
+  TEST_ASSERT_EQUAL(SENSOR_UNSUPPORTED, readSensor(devices.get(climate), SENSOR_QUANTITY_COUNT, value));
+}
+
+// Nothing is made up for devices no driver handles
+void test_no_driver_is_unsupported() {
+  DeviceHandle relay = addSensor("relay", "relay", DIGITAL_IF, 5);
+  devices.get(relay)->direction = OUTPUT_DEVICE;
+  float value;
+  TEST_ASSERT_EQUAL(SENSOR_UNSUPPORTED, readSensor(devices.get(relay), SENSOR_LEVEL, value));
+  TEST_ASSERT_EQUAL(SENSOR_UNSUPPORTED, readSensor(nullptr, SENSOR_TEMPERATURE, value));
+}
+
+int main() {
+  native::reset();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_one_transaction_serves_every_quantity);
+  RUN_TEST(test_burst_of_requests_costs_one_read);
+  RUN_TEST(test_devices_do_not_share_readings);
+  RUN_TEST(test_reading_expires_after_max_age);
+  RUN_TEST(test_adc_max_age);
+  RUN_TEST(test_failed_read_is_retried);
+  RUN_TEST(test_unsupported_quantity);
+  RUN_TEST(test_no_driver_is_unsupported);
+  return UNITY_END();
+}
@@ -0,0 +1,102 @@
+#include <unity.h>
+#include "spsc_ring.h"
+#include <thread>
+
+void setUp() {}
+void tearDown() {}
+
+void test_fifo_order_and_capacity() {
+  SpscRing<int, 4> ring;
+  int item;
+  TEST_ASSERT_FALSE(ring.pop(item));
+
+  for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(ring.push(i));
+  TEST_ASSERT_FALSE(ring.push(99));
+  TEST_ASSERT_EQUAL(4, ring.size());
+
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(ring.pop(item));
+    TEST_ASSERT_EQUAL(i, item);
+  }
+  TEST_ASSERT_EQUAL(0, ring.size());
+}
+
+void test_wraps_around() {
+  SpscRing<int, 4> ring;
+  int item;
+  for (int i = 0; i < 1000; i++) {
+    TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_TRUE(ring.push(i + 1));
+    TEST_ASSERT_TRUE(ring.pop(item));
+    TEST_ASSERT_EQUAL(i, item);
+    TEST_ASSERT_TRUE(ring.pop(item));
+    TEST_ASSERT_EQUAL(i + 1, item);
+  }
+}
+
+void test_peek_newest_leaves_items() {
+  SpscRing<int, 8> ring;
+  int item;
+  TEST_ASSERT_FALSE(ring.peekNewest(item));
+  ring.push(1);
+  ring.push(2);
+  TEST_ASSERT_TRUE(ring.peekNewest(item));
+  TEST_ASSERT_EQUAL(2, item);
+  TEST_ASSERT_EQUAL(2, ring.size());
+}
+
+void test_trim_drops_the_oldest() {
+  SpscRing<int, 8> ring;
+  int item;
+  for (int i = 0; i < 6; i++) ring.push(i);
+  ring.trim(2);
+  TEST_ASSERT_EQUAL(2, ring.size());
+  TEST_ASSERT_TRUE(ring.pop(item));
+  TEST_ASSERT_EQUAL(4, item);
+
+  // Trimming to more than is there changes nothing
+  ring.trim(5);
+  TEST_ASSERT_EQUAL(1, ring.size());
+
+  ring.reset();
+  TEST_ASSERT_EQUAL(0, ring.size());
+  TEST_ASSERT_FALSE(ring.pop(item));
+}
+
+// One producer and one consumer thread: every item arrives once, in order
+void test_two_threads_lose_nothing() {
+  static SpscRing<uint32_t, 64> ring;
+  const uint32_t count = 200000;
+
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < count; i++) {
+      while (!ring.push(i)) std::this_thread::yield();
+    }
+  });
+
+  uint32_t expected = 0;
+  bool ordered = true;
+  while (expected < count) {
+    uint32_t item;
+    if (!ring.pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (item != expected) ordered = false;
+    expected++;
+  }
+  producer.join();
+
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL(0, ring.size());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_order_and_capacity);
+  RUN_TEST(test_wraps_around);
+  RUN_TEST(test_peek_newest_leaves_items);
+  RUN_TEST(test_trim_drops_the_oldest);
+  RUN_TEST(test_two_threads_lose_nothing);
+  return UNITY_END();
+}
@@ -0,0 +1,231 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <SPIFFS.h>
+#include <string.h>
+#include <vector>
+#include "ESPControlPlatform.h"
+#include "persistence.h"
+#include "state_journal.h"
+
+static const char* JOURNAL_FILE = "/states.log";
+static const uint32_t GENERATION = 0x01020304;
+
+static std::vector<DeviceHandle> handles;
+
+static DeviceHandle addDevice(const char* id, const DeviceState &state) {
+  Device device;
+  device.id = id;
+  device.type = "generic";
+  device.kind = parseDeviceKind(device.type);
+  device.state = state;
+  DeviceHandle handle = devices.add(device);
+  handles.push_back(handle);
+  return handle;
+}
+
+// One device per state kind
+static void addDevices() {
+  DeviceState state;
+  state.kind = STATE_SWITCH; state.on = true;
+  addDevice("switch", state);
+
+  state = DeviceState(); state.kind = STATE_ANGLE; state.angle = 135;
+  addDevice("angle", state);
+
+  state = DeviceState(); state.kind = STATE_SPEED;
+  state.motor.running = true; state.motor.speed = 80; state.motor.direction = MOTOR_REVERSE;
+  addDevice("speed", state);
+
+  state = DeviceState(); state.kind = STATE_RGB;
+  state.rgb.r = 0xFF; state.rgb.g = 0x80; state.rgb.b = 0x01;
+  addDevice("rgb", state);
+
+  state = DeviceState(); state.kind = STATE_STEPS; state.steps = -12345;
+  addDevice("steps", state);
+
+  state = DeviceState(); state.kind = STATE_VALUE; state.value = 21.75f;
+  addDevice("value", state);
+
+  state = DeviceState(); state.kind = STATE_TEXT; strcpy(state.text, "standby");
+  addDevice("text", state);
+
+  state = DeviceState(); state.kind = STATE_EFFECT;
+  state.fx.effect = EFFECT_BREATHE; state.fx.r = 1; state.fx.g = 2; state.fx.b = 3;
+  addDevice("effect", state);
+}
+
+static std::vector<String> formattedStates() {
+  std::vector<String> states;
+  for (DeviceHandle handle : handles) states.push_back(formatDeviceState(devices.get(handle)->state));
+  return states;
+}
+
+static void forgetStates() {
+  for (DeviceHandle handle : handles) devices.get(handle)->state = DeviceState();
+}
+
+static std::vector<uint8_t> readJournal() {
+  File file = SPIFFS.open(JOURNAL_FILE, "r");
+  std::vector<uint8_t> bytes(file.size());
+  file.read(bytes.data(), bytes.size());
+  file.close();
+  return bytes;
+}
+
+static void writeJournal(const std::vector<uint8_t> &bytes) {
+  File file = SPIFFS.open(JOURNAL_FILE, "w");
+  file.write(bytes.data(), bytes.size());
+  file.close();
+}
+
+void setUp() {
+  devices.clear();
+  handles.clear();
+  addDevices();
+  TEST_ASSERT_TRUE(resetStateJournal(GENERATION));
+  flushDevices();
+}
+
+void tearDown() {}
+
+// --- Round trip ---
+
+void test_every_state_kind_round_trips() {
+  std::vector<String> expected = formattedStates();
+  TEST_ASSERT_TRUE(appendStateJournal(handles));
+
+  forgetStates();
+  TEST_ASSERT_EQUAL(handles.size(), replayStateJournal(GENERATION));
+  std::vector<String> replayed = formattedStates();
+  for (size_t i = 0; i < expected.size(); i++) {
+    TEST_ASSERT_EQUAL_STRING(expected[i].c_str(), replayed[i].c_str());
+  }
+  TEST_ASSERT_FALSE(devicesDirty());
+}
+
+void test_later_records_win() {
+  DeviceHandle angle = handles[1];
+  std::vector<DeviceHandle> one = {angle};
+  TEST_ASSERT_TRUE(appendStateJournal(one));
+  devices.get(angle)->state.angle = 10;
+  TEST_ASSERT_TRUE(appendStateJournal(one));
+
+  forgetStates();
+  TEST_ASSERT_EQUAL(2, replayStateJournal(GENERATION));
+  TEST_ASSERT_EQUAL(10, devices.get(angle)->state.angle);
+}
+
+// --- File format ---
+
+void test_header_carries_the_version() {
+  std::vector<uint8_t> bytes = readJournal();
+  TEST_ASSERT_EQUAL(9, bytes.size());
+  TEST_ASSERT_EQUAL_MEMORY("SJNL", bytes.data(), 4);
+  TEST_ASSERT_EQUAL_HEX8(0x04, bytes[4]);   // generation, little-endian
+  TEST_ASSERT_EQUAL_HEX8(0x01, bytes[7]);
+  TEST_ASSERT_EQUAL(STATE_JOURNAL_VERSION, bytes[8]);
+}
+
+// No raw DeviceState: each record is id, kind and that kind's payload
+void test_records_hold_an_explicit_payload() {
+  std::vector<DeviceHandle> text = {handles[6]};
+  TEST_ASSERT_TRUE(appendStateJournal(text));
+  std::vector<uint8_t> bytes = readJournal();
+  const uint8_t expected[] = {4, 't', 'e', 'x', 't', STATE_TEXT, 7, 's', 't', 'a', 'n', 'd', 'b', 'y'};
+  TEST_ASSERT_EQUAL(9 + sizeof(expected) + 1, bytes.size());
+  TEST_ASSERT_EQUAL_MEMORY(expected, bytes.data() + 9, sizeof(expected));
+
+  TEST_ASSERT_TRUE(resetStateJournal(GENERATION));
+  std::vector<DeviceHandle> steps = {handles[4]};
+  TEST_ASSERT_TRUE(appendStateJournal(steps));
+  bytes = readJournal();
+  const uint8_t packed[] = {5, 's', 't', 'e', 'p', 's', STATE_STEPS, 0xC7, 0xCF, 0xFF, 0xFF};   // -12345
+  TEST_ASSERT_EQUAL(9 + sizeof(packed) + 1, bytes.size());
+  TEST_ASSERT_EQUAL_MEMORY(packed, bytes.data() + 9, sizeof(packed));
+}
+
+void test_other_versions_are_ignored() {
+  TEST_ASSERT_TRUE(appendStateJournal(handles));
+  std::vector<uint8_t> bytes = readJournal();
+  bytes[8] = STATE_JOURNAL_VERSION + 1;
+  writeJournal(bytes);
+
+  forgetStates();
+  TEST_ASSERT_EQUAL(0, replayStateJournal(GENERATION));
+  TEST_ASSERT_EQUAL(STATE_UNKNOWN, devices.get(handles[0])->state.kind);
+  TEST_ASSERT_EQUAL(9, readJournal().size());   // started over
+}
+
+// A stepper keeps no state; its record holds the position instead
+void test_stepper_records_hold_the_position() {
+  Device device;
+  device.id = "axis";
+  device.type = "stepper";
+  device.kind = STEPPER_KIND;
+  device.position = -300;
+  std::vector<DeviceHandle> axis = {devices.add(device)};
+  TEST_ASSERT_TRUE(appendStateJournal(axis));
+
+  std::vector<uint8_t> bytes = readJournal();
+  const uint8_t expected[] = {4, 'a', 'x', 'i', 's', JOURNAL_POSITION, 0xD4, 0xFE, 0xFF, 0xFF};   // -300
+  TEST_ASSERT_EQUAL(9 + sizeof(expected) + 1, bytes.size());
+  TEST_ASSERT_EQUAL_MEMORY(expected, bytes.data() + 9, sizeof(expected));
+
+  devices.get(axis[0])->position = 0;
+  TEST_ASSERT_EQUAL(1, replayStateJournal(GENERATION));
+  TEST_ASSERT_EQUAL(-300, devices.get(axis[0])->position);
+  TEST_ASSERT_EQUAL(STATE_UNKNOWN, devices.get(axis[0])->state.kind);
+}
+
+void test_other_generations_are_ignored() {
+  TEST_ASSERT_TRUE(appendStateJournal(handles));
+  forgetStates();
+  TEST_ASSERT_EQUAL(0, replayStateJournal(GENERATION + 1));
+}
+
+// --- Damage ---
+
+void test_corrupt_record_stops_the_replay() {
+  std::vector<DeviceHandle> two = {handles[0], handles[1]};
+  TEST_ASSERT_TRUE(appendStateJournal(two));
+  std::vector<uint8_t> bytes = readJournal();
+  bytes[bytes.size() - 2] ^= 0xFF;   // payload of the second record
+  writeJournal(bytes);
+
+  forgetStates();
+  TEST_ASSERT_EQUAL(1, replayStateJournal(GENERATION));
+  TEST_ASSERT_TRUE(devices.get(handles[0])->state.on);
+  TEST_ASSERT_EQUAL(STATE_UNKNOWN, devices.get(handles[1])->state.kind);
+  TEST_ASSERT_TRUE(devicesDirty());
+}
+
+// A record cut short by a crash mid-append is simply the end
+void test_truncated_record_is_the_end() {
+  TEST_ASSERT_TRUE(appendStateJournal(handles));
+  std::vector<uint8_t> bytes = readJournal();
+  bytes.resize(bytes.size() - 3);
+  writeJournal(bytes);
+
+  forgetStates();
+  TEST_ASSERT_EQUAL(handles.size() - 1, replayStateJournal(GENERATION));
+  TEST_ASSERT_FALSE(devicesDirty());
+}
+
+int main() {
+  native::reset();
+  native::formatFs();
+  SPIFFS.begin(true);
+  initPersistence([] { return true; });
+
+  UNITY_BEGIN();
+  RUN_TEST(test_every_state_kind_round_trips);
+  RUN_TEST(test_later_records_win);
+  RUN_TEST(test_header_carries_the_version);
+  RUN_TEST(test_records_hold_an_explicit_payload);
+  RUN_TEST(test_stepper_records_hold_the_position);
+  RUN_TEST(test_other_versions_are_ignored);
+  RUN_TEST(test_other_generations_are_ignored);
+  RUN_TEST(test_corrupt_record_stops_the_replay);
+  RUN_TEST(test_truncated_record_is_the_end);
+  return UNITY_END();
+}
@@ -0,0 +1,97 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <SPIFFS.h>
+#include "ESPExpress.h"
+#include "static/static_assets.h"
+
+static ESPExpress app(80);
+
+void setUp() {}
+void tearDown() {}
+
+static void writeFile(const char* path, const char* content) {
+  File file = SPIFFS.open(path, "w");
+  file.print(content);
+  file.close();
+}
+
+static Response get(const char* url, const char* acceptEncoding) {
+  Request req("GET", url);
+  if (acceptEncoding) req.setHeader("Accept-Encoding", acceptEncoding);
+  return app.handle(req);
+}
+
+static void expectStatus(int status, const Response &res) {
+  TEST_ASSERT_EQUAL_MESSAGE(status, res.statusCode, res.body.c_str());
+}
+
+// --- Content coding ---
+
+void test_gzip_is_sent_when_accepted() {
+  const char* accepted[] = {"gzip, deflate, br", "br;q=1.0, gzip;q=0.8", "x-gzip", "*", "deflate, *;q=0.1"};
+  for (const char* header : accepted) {
+    Response res = get("/static/app.js", header);
+    expectStatus(200, res);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("gzip", res.header("Content-Encoding").c_str(), header);
+    TEST_ASSERT_EQUAL_STRING("Accept-Encoding", res.header("Vary").c_str());
+  }
+
+  // No header: any coding is acceptable
+  expectStatus(200, get("/static/app.js", nullptr));
+}
+
+void test_gzip_is_withheld_when_refused() {
+  const char* refused[] = {"identity", "br, deflate", "gzip;q=0", "gzip; q=0.000, br", "*;q=0", "*, gzip;q=0"};
+  for (const char* header : refused) {
+    Response res = get("/static/app.js", header);
+    TEST_ASSERT_EQUAL_MESSAGE(406, res.statusCode, header);
+    TEST_ASSERT_EQUAL_STRING("", res.header("Content-Encoding").c_str());
+    TEST_ASSERT_EQUAL_STRING("Accept-Encoding", res.header("Vary").c_str());
+  }
+}
+
+// Files stored uncompressed do not depend on the header
+void test_plain_files_ignore_accept_encoding() {
+  Response res = get("/static/robots.txt", "identity");
+  expectStatus(200, res);
+  TEST_ASSERT_EQUAL_STRING("", res.header("Content-Encoding").c_str());
+  TEST_ASSERT_EQUAL_STRING("User-agent: *", res.body.c_str());
+}
+
+// --- Sending ---
+
+// Small files go out from RAM, large ones straight from flash
+void test_large_files_are_sent_from_flash() {
+  Response res = get("/static/robots.txt", nullptr);
+  TEST_ASSERT_EQUAL_STRING("", res.file.c_str());
+  TEST_ASSERT_EQUAL_STRING("text/plain", res.contentType.c_str());
+
+  res = get("/static/big.txt", nullptr);
+  expectStatus(200, res);
+  TEST_ASSERT_EQUAL_STRING("/www/b1", res.file.c_str());
+  TEST_ASSERT_EQUAL_STRING("text/plain", res.contentType.c_str());
+  TEST_ASSERT_EQUAL(STATIC_CACHE_MAX_FILE + 1, res.body.length());
+}
+
+int main() {
+  native::reset();
+  native::formatFs();
+  SPIFFS.begin(true);
+  writeFile("/www/manifest.txt",
+            "/app.js /www/a1 abc123 4 gi\n"
+            "/robots.txt /www/r1 def456 13 -\n"
+            "/big.txt /www/b1 fed789 4097 -\n");
+  writeFile("/www/a1", "GZIP");
+  writeFile("/www/r1", "User-agent: *");
+  String big;
+  for (int i = 0; i <= STATIC_CACHE_MAX_FILE; i++) big += 'b';
+  writeFile("/www/b1", big.c_str());
+  registerStaticAssets(app, "/static");
+
+  UNITY_BEGIN();
+  RUN_TEST(test_gzip_is_sent_when_accepted);
+  RUN_TEST(test_gzip_is_withheld_when_refused);
+  RUN_TEST(test_plain_files_ignore_accept_encoding);
+  RUN_TEST(test_large_files_are_sent_from_flash);
+  return UNITY_END();
+}
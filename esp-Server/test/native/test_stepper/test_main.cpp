@@ -0,0 +1,154 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <SPIFFS.h>
+#include <esp_intr_alloc.h>
+#include "ESPControlPlatform.h"
+#include "persistence.h"
+#include "state_journal.h"
+#include "stepper.h"
+
+static const uint8_t STEP_PIN = 16;
+static const uint8_t DIR_PIN = 17;
+
+static DeviceHandle handle = INVALID_DEVICE_HANDLE;
+static uint32_t snapshotsWritten = 0;
+
+void setUp() {
+  devices.clear();
+  Device device;
+  device.id = "axis";
+  device.type = "stepper";
+  device.kind = STEPPER_KIND;
+  device.pins = {STEP_PIN, DIR_PIN};
+  device.maxSpeed = 1000;
+  device.acceleration = 2000;
+  handle = devices.add(device);
+  TEST_ASSERT_TRUE(stepperAttach(*devices.get(handle)));
+}
+
+void tearDown() {
+  stepperDetach(handle);
+  handleSteppers();   // stops the timer
+}
+
+// Fires the step timer until the motor is idle; returns the step pulses seen
+static uint32_t runUntilIdle() {
+  uint32_t pulses = 0;
+  uint8_t level = native::pinLevel(STEP_PIN);
+  for (uint32_t tick = 0; tick < 1000000 && stepperMoving(handle); tick++) {
+    native::fireTimer(STEPPER_TIMER);
+    uint8_t now = native::pinLevel(STEP_PIN);
+    if (now == HIGH && level == LOW) pulses++;
+    level = now;
+  }
+  native::fireTimer(STEPPER_TIMER);   // the last pulse ends on the next tick
+  return pulses;
+}
+
+// --- Interrupt ---
+
+void test_step_interrupt_is_iram() {
+  TEST_ASSERT_TRUE(stepperMove(handle, 1));
+  TEST_ASSERT_TRUE(native::timerInterruptFlags(STEPPER_TIMER) & ESP_INTR_FLAG_IRAM);
+  TEST_ASSERT_EQUAL(STEPPER_TICK_US, native::timerAlarm(STEPPER_TIMER));
+  runUntilIdle();
+}
+
+// The ISR drives the pins through the GPIO set/clear registers
+void test_moves_pulse_the_step_pin() {
+  TEST_ASSERT_TRUE(stepperMove(handle, 10));
+  TEST_ASSERT_EQUAL(10, runUntilIdle());
+  TEST_ASSERT_EQUAL(HIGH, native::pinLevel(DIR_PIN));
+  TEST_ASSERT_EQUAL(LOW, native::pinLevel(STEP_PIN));
+
+  TEST_ASSERT_TRUE(stepperMove(handle, -4));
+  TEST_ASSERT_EQUAL(4, runUntilIdle());
+  TEST_ASSERT_EQUAL(LOW, native::pinLevel(DIR_PIN));
+
+  int32_t position;
+  TEST_ASSERT_TRUE(stepperPosition(handle, position));
+  TEST_ASSERT_EQUAL(6, position);
+}
+
+void test_queued_moves_run_back_to_back() {
+  TEST_ASSERT_TRUE(stepperMove(handle, 5));
+  TEST_ASSERT_TRUE(stepperMove(handle, 7));
+  TEST_ASSERT_EQUAL(12, runUntilIdle());
+}
+
+// --- Position reports ---
+
+void test_position_is_telemetry_until_the_motor_rests() {
+  flushDevices();
+  Device* device = devices.get(handle);
+  DeviceState state = device->state;
+  uint32_t generation = devices.generation();
+
+  TEST_ASSERT_TRUE(stepperMove(handle, 1000));
+  for (int i = 0; i < 20000; i++) native::fireTimer(STEPPER_TIMER);
+  native::advanceMillis(STEPPER_REPORT_MS);
+  handleSteppers();
+
+  int32_t position;
+  stepperPosition(handle, position);
+  TEST_ASSERT_TRUE(position > 0 && position < 1000);
+  TEST_ASSERT_EQUAL(position, device->position);
+  TEST_ASSERT_EQUAL(generation, devices.generation());
+  TEST_ASSERT_EQUAL(state.kind, device->state.kind);
+  TEST_ASSERT_FALSE(devicesDirty());
+
+  runUntilIdle();
+  handleSteppers();
+  TEST_ASSERT_EQUAL(1000, device->position);
+  TEST_ASSERT_EQUAL(generation + 1, devices.generation());
+  TEST_ASSERT_TRUE(devicesDirty());
+}
+
+// The resting position is journaled, not written as a new snapshot
+void test_resting_position_goes_to_the_journal() {
+  TEST_ASSERT_TRUE(resetStateJournal(1));
+  flushDevices();
+  uint32_t snapshots = snapshotsWritten;
+
+  TEST_ASSERT_TRUE(stepperMove(handle, 30));
+  runUntilIdle();
+  handleSteppers();
+  TEST_ASSERT_TRUE(flushDevices());
+  TEST_ASSERT_EQUAL(snapshots, snapshotsWritten);
+
+  devices.get(handle)->position = 0;
+  TEST_ASSERT_EQUAL(1, replayStateJournal(1));
+  TEST_ASSERT_EQUAL(30, devices.get(handle)->position);
+  TEST_ASSERT_EQUAL(STATE_UNKNOWN, devices.get(handle)->state.kind);
+}
+
+void test_attach_carries_on_from_the_saved_position() {
+  stepperDetach(handle);
+  devices.get(handle)->position = -250;
+  TEST_ASSERT_TRUE(stepperAttach(*devices.get(handle)));
+
+  TEST_ASSERT_TRUE(stepperMove(handle, 50));
+  runUntilIdle();
+  int32_t position;
+  stepperPosition(handle, position);
+  TEST_ASSERT_EQUAL(-200, position);
+}
+
+int main() {
+  native::reset();
+  native::formatFs();
+  SPIFFS.begin(true);
+  initPersistence([] {
+    snapshotsWritten++;
+    return true;
+  });
+
+  UNITY_BEGIN();
+  RUN_TEST(test_step_interrupt_is_iram);
+  RUN_TEST(test_moves_pulse_the_step_pin);
+  RUN_TEST(test_queued_moves_run_back_to_back);
+  RUN_TEST(test_position_is_telemetry_until_the_motor_rests);
+  RUN_TEST(test_resting_position_goes_to_the_journal);
+  RUN_TEST(test_attach_carries_on_from_the_saved_position);
+  return UNITY_END();
+}
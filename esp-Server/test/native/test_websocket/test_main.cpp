@@ -0,0 +1,71 @@
+#include <unity.h>
+#include <ArduinoNative.h>
+#include <SPIFFS.h>
+#include "ESPExpress.h"
+#include "ESPControlPlatform.h"
+#include "devices/devices.h"
+#include "websocket/websocket.h"
+#include "websocket/send_queue.h"
+
+void initializeDevices();
+
+static ESPExpress app(80);
+
+void setUp() {
+  app.handle("POST", "/api/devices/import", "[{\"id\":\"photocell\",\"type\":\"sensor\",\"direction\":\"input\"}]");
+  app.wsEvent(0, WStype_CONNECTED);
+  drainSendQueues(app);
+  app.wsClear();
+}
+
+void tearDown() {
+  app.wsEvent(0, WStype_DISCONNECTED);
+}
+
+// Everything sent to client 0 since the last call, as one string
+static String received() {
+  drainSendQueues(app);
+  String all;
+  for (const NativeWsMessage &message : app.wsSent(0)) all += message.data.c_str();
+  app.wsClear();
+  return all;
+}
+
+// --- Subscriptions ---
+
+void test_subscribe_to_unknown_device_is_refused() {
+  app.wsEvent(0, "{\"type\":\"subscribe\",\"deviceId\":\"nope\",\"sensor\":\"light\"}");
+  String reply = received();
+  TEST_ASSERT_TRUE(reply.indexOf("Device not found") >= 0);
+  TEST_ASSERT_EQUAL(-1, reply.indexOf("\"subscribed\""));
+
+  app.wsEvent(0, "{\"id\":1,\"method\":\"subscribe\",\"params\":{\"deviceId\":\"nope\",\"sensor\":\"light\"}}");
+  reply = received();
+  TEST_ASSERT_TRUE(reply.indexOf("\"status\":404") >= 0);
+}
+
+// Refused requests take no stream slot, so real subscriptions still fit
+void test_refused_requests_leave_the_slots_free() {
+  for (int i = 0; i < MAX_SENSOR_STREAMS + 1; i++) {
+    String request = "{\"type\":\"subscribe\",\"deviceId\":\"ghost" + String(i) + "\",\"sensor\":\"light\"}";
+    app.wsEvent(0, request.c_str());
+    TEST_ASSERT_TRUE(received().indexOf("Device not found") >= 0);
+  }
+
+  app.wsEvent(0, "{\"type\":\"subscribe\",\"deviceId\":\"photocell\",\"sensor\":\"light\"}");
+  TEST_ASSERT_TRUE(received().indexOf("\"subscribed\"") >= 0);
+}
+
+int main() {
+  native::reset();
+  native::formatFs();
+  SPIFFS.begin(true);
+  initializeDevices();
+  registerDeviceRoutes(app);
+  registerWebSocketRoutes(app);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_subscribe_to_unknown_device_is_refused);
+  RUN_TEST(test_refused_requests_leave_the_slots_free);
+  return UNITY_END();
+}
@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <string.h>
+#include "ws2812_encoder.h"
+
+// WS2812B datasheet timings; every phase may be off by up to 150 ns
+static const int T0H_NS = 400, T0L_NS = 850, T1H_NS = 800, T1L_NS = 450;
+static const int TOLERANCE_NS = 150;
+
+void setUp() {}
+void tearDown() {}
+
+struct Phases {
+  int highNs;
+  int lowNs;
+};
+
+// Decodes one RMT item (duration0:15, level0:1, duration1:15, level1:1)
+static Phases decode(uint32_t item) {
+  TEST_ASSERT_TRUE_MESSAGE(item & (1UL << 15), "first phase must be high");
+  TEST_ASSERT_FALSE_MESSAGE(item & (1UL << 31), "second phase must be low");
+  Phases phases;
+  phases.highNs = (item & 0x7FFF) * WS2812_TICK_NS;
+  phases.lowNs = ((item >> 16) & 0x7FFF) * WS2812_TICK_NS;
+  return phases;
+}
+
+// Reads a bit back the way the LED does: a long high phase is a 1
+static bool decodeBit(uint32_t item) {
+  Phases phases = decode(item);
+  return phases.highNs > (T0H_NS + T1H_NS) / 2;
+}
+
+static void assertNear(int expectedNs, int actualNs) {
+  TEST_ASSERT_TRUE_MESSAGE(actualNs >= expectedNs - TOLERANCE_NS && actualNs <= expectedNs + TOLERANCE_NS,
+                           "phase outside the datasheet tolerance");
+}
+
+// --- Timing ---
+
+void test_bit_timings_within_tolerance() {
+  // 80 MHz / WS2812_RMT_CLK_DIV
+  TEST_ASSERT_EQUAL(1000 * WS2812_RMT_CLK_DIV / 80, WS2812_TICK_NS);
+
+  Phases zero = decode(ws2812Item(false));
+  assertNear(T0H_NS, zero.highNs);
+  assertNear(T0L_NS, zero.lowNs);
+
+  Phases one = decode(ws2812Item(true));
+  assertNear(T1H_NS, one.highNs);
+  assertNear(T1L_NS, one.lowNs);
+
+  // Both bits take the same time, 1.25 us +- 600 ns
+  TEST_ASSERT_EQUAL(zero.highNs + zero.lowNs, one.highNs + one.lowNs);
+  TEST_ASSERT_TRUE(zero.highNs + zero.lowNs >= 650 && zero.highNs + zero.lowNs <= 1850);
+}
+
+void test_frame_time_includes_the_latch() {
+  TEST_ASSERT_EQUAL(WS2812_RESET_US, ws2812FrameMicros(0));
+  // 30 pixels * 24 bits * 1.25 us
+  TEST_ASSERT_EQUAL(900 + WS2812_RESET_US, ws2812FrameMicros(30));
+}
+
+// --- Translation ---
+
+void test_bytes_are_sent_msb_first() {
+  const uint8_t bytes[] = {0xA5, 0x0F};
+  uint32_t items[16];
+  size_t used, count;
+  ws2812Translate(bytes, items, sizeof(bytes), 16, &used, &count);
+  TEST_ASSERT_EQUAL(2, used);
+  TEST_ASSERT_EQUAL(16, count);
+
+  for (size_t b = 0; b < sizeof(bytes); b++) {
+    uint8_t decoded = 0;
+    for (int i = 0; i < 8; i++) {
+      decoded = decoded << 1 | decodeBit(items[b * 8 + i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(bytes[b], decoded);
+  }
+  TEST_ASSERT_TRUE(decodeBit(items[0]));      // 0xA5 starts with its top bit
+  TEST_ASSERT_FALSE(decodeBit(items[8]));     // 0x0F with a 0
+}
+
+// The driver asks for at most wantedItems; only whole bytes are taken
+void test_partial_translation_stops_at_whole_bytes() {
+  const uint8_t bytes[] = {0xFF, 0x00, 0x81};
+  uint32_t items[24];
+  memset(items, 0, sizeof(items));
+  size_t used, count;
+
+  ws2812Translate(bytes, items, sizeof(bytes), 20, &used, &count);
+  TEST_ASSERT_EQUAL(2, used);
+  TEST_ASSERT_EQUAL(16, count);
+  TEST_ASSERT_EQUAL(0, items[16]);            // nothing written past the last byte
+
+  ws2812Translate(bytes, items, sizeof(bytes), 7, &used, &count);
+  TEST_ASSERT_EQUAL(0, used);
+  TEST_ASSERT_EQUAL(0, count);
+
+  // The rest of the frame on the next call
+  ws2812Translate(bytes + 2, items, 1, 32, &used, &count);
+  TEST_ASSERT_EQUAL(1, used);
+  TEST_ASSERT_EQUAL(8, count);
+  TEST_ASSERT_TRUE(decodeBit(items[0]));
+  TEST_ASSERT_FALSE(decodeBit(items[1]));
+  TEST_ASSERT_TRUE(decodeBit(items[7]));
+}
+
+void test_null_buffers_translate_nothing() {
+  uint32_t items[8];
+  size_t used = 99, count = 99;
+  ws2812Translate(nullptr, items, 3, 8, &used, &count);
+  TEST_ASSERT_EQUAL(0, used);
+  TEST_ASSERT_EQUAL(0, count);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_bit_timings_within_tolerance);
+  RUN_TEST(test_frame_time_includes_the_latch);
+  RUN_TEST(test_bytes_are_sent_msb_first);
+  RUN_TEST(test_partial_translation_stops_at_whole_bytes);
+  RUN_TEST(test_null_buffers_translate_nothing);
+  return UNITY_END();
+}
@@ -25,9 +25,14 @@ export function SensorDisplay({ device, ipAddress }: SensorDisplayProps) {
   const [isPolling, setIsPolling] = useState(false)
   const [isLoading, setIsLoading] = useState(false)
   const [lastUpdateTime, setLastUpdateTime] = useState<string | null>(null)
-  const { lastMessage, sendMessage, connected, wsEnabled } = useWebSocket(ipAddress)
+  const {
+    lastMessage,
+    sendMessage,
+    connected,
+    wsEnabled,
+    sensorData: latestReadings,
+  } = useWebSocket(ipAddress, { binary: true })
   const pollingInterval = useRef<NodeJS.Timeout | null>(null)
-  const dataRequestInterval = useRef<NodeJS.Timeout | null>(null)
   const lastRequestTime = useRef<number>(0)
   const REQUEST_THROTTLE = 2000 // 2 seconds between requests
 
@@ -59,36 +64,23 @@ export function SensorDisplay({ device, ipAddress }: SensorDisplayProps) {
   }, [device.id, device.state])
 
   useEffect(() => {
-    // Only set up WebSocket requests if the device exists, is connected, and is a sensor type
+    // Subscribe once; the ESP32 pushes readings every 5 seconds until we unsubscribe
     if (connected && wsEnabled && device && isSensorDevice(device)) {
-      // Clear any existing interval
-      if (dataRequestInterval.current) {
-        clearInterval(dataRequestInterval.current)
-      }
-
-      // Function to request data and set the next timer
-      const scheduleNextRequest = () => {
-        // Request data
-        requestSensorData()
-        lastRequestTime.current = Date.now()
-
-        // Schedule next request exactly 5 seconds later
-        dataRequestInterval.current = setTimeout(scheduleNextRequest, 5000)
-      }
-
-      // Start the cycle
-      scheduleNextRequest()
+      sendMessage({
+        type: "subscribe",
+        deviceId: device.id,
+        sensor: sensorType,
+        interval: 5000,
+      })
+      lastRequestTime.current = Date.now()
 
       return () => {
-        if (dataRequestInterval.current) {
-          clearTimeout(dataRequestInterval.current)
-          dataRequestInterval.current = null
-        }
+        sendMessage({
+          type: "unsubscribe",
+          deviceId: device.id,
+          sensor: sensorType,
+        })
       }
-    } else if (dataRequestInterval.current) {
-      // Clean up interval if conditions are no longer met
-      clearTimeout(dataRequestInterval.current)
-      dataRequestInterval.current = null
     }
   }, [connected, wsEnabled, device, sensorType])
 
@@ -111,31 +103,33 @@ export function SensorDisplay({ device, ipAddress }: SensorDisplayProps) {
           return
         }
 
-        // Handle sensor data with deduplication
-        if (data.deviceId === device.id && data.sensor === sensorType && data.value !== undefined) {
-          // Skip if this is a duplicate value
-          const valueString = String(data.value)
-          if (valueString === lastValueRef.current) {
-            return
-          }
-
-          // Update the last value reference
-          lastValueRef.current = valueString
-
-          const value = Number.parseFloat(data.value)
-          if (!isNaN(value)) {
-            setCurrentValue(value)
-            addDataPoint(value)
-            setLastUpdateTime(new Date().toLocaleTimeString())
-            setError(null) // Clear any previous errors
-          }
-        }
       } catch (e) {
         // Ignore parsing errors for non-JSON messages
       }
     }
   }, [lastMessage, device.id, sensorType, wsEnabled])
 
+  // Readings arrive as binary telemetry frames, decoded by the hook
+  const latestReading = latestReadings[`${device.id}_${sensorType}`]
+
+  useEffect(() => {
+    // Skip if this is a duplicate value
+    if (latestReading === undefined || !wsEnabled || latestReading === lastValueRef.current) {
+      return
+    }
+
+    // Update the last value reference
+    lastValueRef.current = latestReading
+
+    const value = Number.parseFloat(latestReading)
+    if (!isNaN(value)) {
+      setCurrentValue(value)
+      addDataPoint(value)
+      setLastUpdateTime(new Date().toLocaleTimeString())
+      setError(null) // Clear any previous errors
+    }
+  }, [latestReading, wsEnabled])
+
   // Fallback to polling if WebSocket is not available
   useEffect(() => {
     // Start polling if WebSocket is disabled or not connected
@@ -306,15 +300,6 @@ export function SensorDisplay({ device, ipAddress }: SensorDisplayProps) {
 
     if (connected && wsEnabled) {
       requestSensorData()
-
-      // Reset the interval timer to maintain the 5-second cycle
-      if (dataRequestInterval.current) {
-        clearTimeout(dataRequestInterval.current)
-        dataRequestInterval.current = setTimeout(() => {
-          requestSensorData()
-          lastRequestTime.current = Date.now()
-        }, 5000)
-      }
     } else {
       fetchSensorData()
     }
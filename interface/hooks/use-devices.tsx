@@ -1,6 +1,6 @@
 "use client"
 
-import { useState, useEffect, useCallback } from "react"
+import { useState, useEffect, useCallback, useRef } from "react"
 import type { DeviceType } from "@/types/device-types"
 import { apiService } from "@/services/api-service"
 import { useToast } from "@/components/ui/use-toast"
@@ -10,15 +10,32 @@ export function useDevices(ipAddress: string) {
   const [loading, setLoading] = useState(true)
   const [error, setError] = useState<string | null>(null)
   const { toast } = useToast()
+  // Device list generation we are in sync with; 0 makes the ESP32 send everything
+  const generation = useRef(0)
 
-  // Function to fetch devices from the ESP32
+  // Function to fetch devices from the ESP32. Only changes since the last
+  // fetch are transferred; the ESP32 falls back to the full list when needed.
   const fetchDevices = useCallback(async () => {
     setLoading(true)
     setError(null)
 
     try {
-      const fetchedDevices = await apiService.getDevices(ipAddress)
-      setDevices(fetchedDevices)
+      const changes = await apiService.getDeviceChanges(ipAddress, generation.current)
+      generation.current = changes.generation
+      if (changes.full) {
+        setDevices(changes.devices)
+      } else {
+        // Replace changed devices in place, drop deleted ones, append new ones
+        setDevices((prevDevices) => {
+          const changed = new Map(changes.devices.map((device) => [device.id, device]))
+          const deleted = new Set(changes.deleted)
+          const merged = prevDevices
+            .filter((device) => !deleted.has(device.id) || changed.has(device.id))
+            .map((device) => changed.get(device.id) ?? device)
+          const known = new Set(merged.map((device) => device.id))
+          return [...merged, ...changes.devices.filter((device) => !known.has(device.id))]
+        })
+      }
     } catch (err) {
       if (err instanceof Error) {
         setError(err.message)
@@ -165,8 +182,9 @@ export function useDevices(ipAddress: string) {
     [ipAddress, toast],
   )
 
-  // Fetch devices on initial render
+  // Fetch devices on initial render, and from scratch when the address changes
   useEffect(() => {
+    generation.current = 0
     fetchDevices()
   }, [fetchDevices])
 
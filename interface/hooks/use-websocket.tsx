@@ -2,7 +2,97 @@
 
 import { useState, useEffect, useRef, useCallback } from "react"
 
-export function useWebSocket(ipAddress: string) {
+// One reading from a binary telemetry frame
+export interface TelemetryRecord {
+  stream: number // "stream" index from the subscribed reply
+  sensor: number // index into the welcome message's supportedSensors
+  timestamp: number // ESP32 millis() when the reading was taken
+  value: number
+}
+
+const TELEMETRY_VERSION = 1
+const FRAME_TELEMETRY = 1
+const TELEMETRY_HEADER_SIZE = 4
+const TELEMETRY_RECORD_SIZE = 12
+
+// Decodes a binary telemetry frame (layout in esp-Server websocket.h).
+// Returns an empty list for frames of another version or type.
+export function decodeTelemetryFrame(buffer: ArrayBuffer): TelemetryRecord[] {
+  const view = new DataView(buffer)
+  if (view.byteLength < TELEMETRY_HEADER_SIZE) return []
+  if (view.getUint8(0) !== TELEMETRY_VERSION || view.getUint8(1) !== FRAME_TELEMETRY) return []
+
+  const count = Math.min(
+    view.getUint16(2, true),
+    Math.floor((view.byteLength - TELEMETRY_HEADER_SIZE) / TELEMETRY_RECORD_SIZE),
+  )
+  const records: TelemetryRecord[] = []
+  for (let i = 0; i < count; i++) {
+    const offset = TELEMETRY_HEADER_SIZE + i * TELEMETRY_RECORD_SIZE
+    records.push({
+      stream: view.getUint8(offset),
+      sensor: view.getUint8(offset + 1),
+      timestamp: view.getUint32(offset + 4, true),
+      value: view.getFloat32(offset + 8, true),
+    })
+  }
+  return records
+}
+
+const FRAME_LED_PIXELS = 2
+const FRAME_LED_FILL = 3
+
+function encodeLedHeader(type: number, deviceId: string, start: number, count: number, colourBytes: number) {
+  const id = new TextEncoder().encode(deviceId)
+  if (id.length > 63) throw new Error("Device id too long for an LED frame")
+  const bytes = new Uint8Array(3 + id.length + 4 + colourBytes)
+  const view = new DataView(bytes.buffer)
+  bytes[0] = TELEMETRY_VERSION
+  bytes[1] = type
+  bytes[2] = id.length
+  bytes.set(id, 3)
+  view.setUint16(3 + id.length, start, true)
+  view.setUint16(5 + id.length, count, true)
+  return { bytes, offset: 7 + id.length }
+}
+
+// Binary frame setting pixels from start to the r, g, b triplets in colours
+// (layout in esp-Server websocket.h); send it with sendFrame
+export function encodeLedPixels(deviceId: string, start: number, colours: ArrayLike<number>): ArrayBuffer {
+  const count = Math.floor(colours.length / 3)
+  const { bytes, offset } = encodeLedHeader(FRAME_LED_PIXELS, deviceId, start, count, count * 3)
+  for (let i = 0; i < count * 3; i++) bytes[offset + i] = colours[i]
+  return bytes.buffer
+}
+
+// Binary frame setting count pixels from start to one colour
+export function encodeLedFill(deviceId: string, start: number, count: number, r: number, g: number, b: number): ArrayBuffer {
+  const { bytes, offset } = encodeLedHeader(FRAME_LED_FILL, deviceId, start, count, 3)
+  bytes.set([r, g, b], offset)
+  return bytes.buffer
+}
+
+// A failed RPC call; status is the HTTP status the same request would get
+export class RpcError extends Error {
+  constructor(
+    message: string,
+    public status: number,
+  ) {
+    super(message)
+  }
+}
+
+interface PendingCall {
+  resolve: (result: any) => void
+  reject: (error: Error) => void
+}
+
+interface WebSocketOptions {
+  // Ask the ESP32 for binary telemetry frames instead of one JSON message per reading
+  binary?: boolean
+}
+
+export function useWebSocket(ipAddress: string, { binary = false }: WebSocketOptions = {}) {
   const [connected, setConnected] = useState(false)
   const [messages, setMessages] = useState<string[]>([])
   const [lastMessage, setLastMessage] = useState<string | null>(null)
@@ -25,6 +115,19 @@ export function useWebSocket(ipAddress: string) {
   const lastMessageTimeRef = useRef<Record<string, number>>({})
   const MESSAGE_DEDUP_WINDOW = 1000 // 1 second window to deduplicate messages
 
+  // Lookups needed to name binary telemetry records
+  const supportedSensorsRef = useRef<string[]>([])
+  const streamsRef = useRef<Record<number, { deviceId: string; sensor: string }>>({})
+
+  // RPC calls waiting for their reply, by request id
+  const nextRpcIdRef = useRef(0)
+  const pendingCallsRef = useRef<Map<number, PendingCall>>(new Map())
+
+  const rejectPendingCalls = useCallback((reason: string) => {
+    pendingCallsRef.current.forEach((call) => call.reject(new Error(reason)))
+    pendingCallsRef.current.clear()
+  }, [])
+
   // Improve the message queue system to prevent duplicate messages
   const processMessageQueue = useCallback(() => {
     if (processingQueueRef.current || messageQueueRef.current.length === 0) {
@@ -57,12 +160,34 @@ export function useWebSocket(ipAddress: string) {
     try {
       const parsedData = JSON.parse(data)
 
+      // RPC replies, matched to their call by id
+      if (typeof parsedData.id === "number" && typeof parsedData.ok === "boolean") {
+        const call = pendingCallsRef.current.get(parsedData.id)
+        if (call) {
+          pendingCallsRef.current.delete(parsedData.id)
+          if (parsedData.ok) {
+            call.resolve(parsedData.result)
+          } else {
+            call.reject(new RpcError(parsedData.error, parsedData.status))
+          }
+        }
+        return
+      }
+
       // Handle info messages
       if (parsedData.type === "info") {
+        if (Array.isArray(parsedData.supportedSensors)) {
+          supportedSensorsRef.current = parsedData.supportedSensors
+        }
         setMessages((prev) => [...prev, `Info: ${parsedData.message}`])
         return
       }
 
+      // Remember which device/sensor a stream index stands for
+      if (parsedData.type === "subscribed" && parsedData.stream !== undefined) {
+        streamsRef.current[parsedData.stream] = { deviceId: parsedData.deviceId, sensor: parsedData.sensor }
+      }
+
       // Handle sensor data with deduplication
       if (parsedData.sensor && parsedData.deviceId && parsedData.value !== undefined) {
         const messageKey = `${parsedData.deviceId}_${parsedData.sensor}_${parsedData.value}`
@@ -89,6 +214,21 @@ export function useWebSocket(ipAddress: string) {
     }
   }, [])
 
+  // Unpack a binary telemetry frame into the latest sensor readings
+  const handleTelemetry = useCallback((buffer: ArrayBuffer) => {
+    const updates: Record<string, string> = {}
+    for (const record of decodeTelemetryFrame(buffer)) {
+      const stream = streamsRef.current[record.stream]
+      const sensor = supportedSensorsRef.current[record.sensor] ?? stream?.sensor
+      if (!stream || sensor !== stream.sensor) continue
+      updates[`${stream.deviceId}_${sensor}`] = record.value.toFixed(2)
+    }
+
+    if (Object.keys(updates).length > 0) {
+      setSensorData((prev) => ({ ...prev, ...updates }))
+    }
+  }, [])
+
   // Improve the WebSocket connection with better error handling
   const connectWebSocket = useCallback(() => {
     // Don't attempt to connect if WebSocket is disabled
@@ -132,11 +272,13 @@ export function useWebSocket(ipAddress: string) {
         `Attempting to connect to WebSocket at: ${wsUrl} (Attempt ${reconnectAttemptsRef.current}/${MAX_RECONNECT_ATTEMPTS})`,
       ])
 
-      // Reset message deduplication tracking
+      // Reset message deduplication tracking and stream lookups
       lastMessageTimeRef.current = {}
+      streamsRef.current = {}
 
       // Connect to WebSocket on port 81
       const ws = new WebSocket(wsUrl)
+      ws.binaryType = "arraybuffer"
 
       ws.onopen = () => {
         // Handle successful connection
@@ -145,11 +287,22 @@ export function useWebSocket(ipAddress: string) {
         setError(null)
         reconnectAttemptsRef.current = 0 // Reset counter on successful connection
 
+        // Opt in to binary telemetry before anything else is sent
+        if (binary) {
+          ws.send(JSON.stringify({ type: "hello", format: "binary" }))
+        }
+
         // Process any queued messages
         processMessageQueue()
       }
 
       ws.onmessage = (event) => {
+        // Binary frames only ever carry telemetry
+        if (event.data instanceof ArrayBuffer) {
+          handleTelemetry(event.data)
+          return
+        }
+
         // Handle incoming messages
         setLastMessage(event.data)
         handleMessage(event.data)
@@ -158,6 +311,7 @@ export function useWebSocket(ipAddress: string) {
       ws.onclose = (event) => {
         // Handle connection close
         setConnected(false)
+        rejectPendingCalls("WebSocket connection closed")
 
         // Clear sensor polling interval
         if (sensorIntervalRef.current) {
@@ -219,7 +373,7 @@ export function useWebSocket(ipAddress: string) {
         }, 3000)
       }
     }
-  }, [ipAddress, wsEnabled, processMessageQueue, handleMessage])
+  }, [ipAddress, wsEnabled, binary, processMessageQueue, handleMessage, handleTelemetry, rejectPendingCalls])
 
   // Function to toggle WebSocket connection
   const toggleWebSocket = useCallback(() => {
@@ -300,8 +454,9 @@ export function useWebSocket(ipAddress: string) {
       // Check if we're within the throttle period for this type of message
       let shouldSend = true
 
-      // For sensor data requests, enforce strict throttling
-      if (typeof message === "object" && "sensor" in message) {
+      // For one-shot sensor data requests, enforce strict throttling.
+      // Subscribe/unsubscribe messages carry a "type" and are sent as-is.
+      if (typeof message === "object" && "sensor" in message && !("type" in message)) {
         const now = Date.now()
         const timeSinceLastSend = now - lastRequestTime.current
 
@@ -329,6 +484,31 @@ export function useWebSocket(ipAddress: string) {
     [processMessageQueue],
   )
 
+  // Call a device operation over the socket (list, get, setState, setPins,
+  // batch, read, subscribe, unsubscribe). Calls are sent right away, not
+  // through the throttled queue, so many can be in flight at once.
+  const call = useCallback(<T = any,>(method: string, params: Record<string, unknown> = {}): Promise<T> => {
+    const ws = wsRef.current
+    if (!ws || ws.readyState !== WebSocket.OPEN) {
+      return Promise.reject(new Error("WebSocket not connected"))
+    }
+
+    const id = ++nextRpcIdRef.current
+    return new Promise<T>((resolve, reject) => {
+      pendingCallsRef.current.set(id, { resolve, reject })
+      ws.send(JSON.stringify({ id, method, params }))
+    })
+  }, [])
+
+  // Send a binary frame (e.g. from encodeLedPixels) as-is. Frames sent faster
+  // than a strip can show them are merged on the ESP32.
+  const sendFrame = useCallback((frame: ArrayBuffer) => {
+    const ws = wsRef.current
+    if (!ws || ws.readyState !== WebSocket.OPEN) return false
+    ws.send(frame)
+    return true
+  }, [])
+
   // Connect to WebSocket when enabled and when IP changes
   useEffect(() => {
     if (wsEnabled) {
@@ -364,6 +544,8 @@ export function useWebSocket(ipAddress: string) {
     sendMessage,
     requestSensorData,
     sensorData, // New - provides access to the latest sensor readings
+    call,
+    sendFrame,
   }
 }
 
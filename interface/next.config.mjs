@@ -7,6 +7,10 @@ try {
 
 /** @type {import('next').NextConfig} */
 const nextConfig = {
+  // Static export, served by the ESP32 under /static (see
+  // esp-Server/scripts/build_assets.py)
+  output: 'export',
+  basePath: '/static',
   eslint: {
     ignoreDuringBuilds: true,
   },
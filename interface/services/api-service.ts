@@ -1,4 +1,4 @@
-import type { DeviceType } from "@/types/device-types"
+import type { DeviceChanges, DeviceType } from "@/types/device-types"
 
 class ApiService {
   // Helper function: returns protocol based on address.
@@ -76,6 +76,37 @@ class ApiService {
     }
   }
 
+  // Get the devices added, changed or deleted after a list generation.
+  // When the ESP32 cannot diff from that generation, full is true and
+  // devices holds the complete list.
+  async getDeviceChanges(address: string, since: number): Promise<DeviceChanges> {
+    try {
+      const url = this.buildUrl(address, `/api/devices?since=${since}`)
+      const response = await fetch(url, {
+        method: "GET",
+        headers: {
+          Accept: "application/json",
+        },
+        signal: AbortSignal.timeout(5000),
+      })
+
+      if (!response.ok) {
+        throw new Error(`Failed to fetch devices: ${response.status} ${response.statusText}`)
+      }
+
+      const data = await response.json()
+      return data
+    } catch (err) {
+      if (err instanceof Error) {
+        if (err.name === "AbortError") {
+          throw new Error("Request timed out. Please check your connection.")
+        }
+        throw err
+      }
+      throw new Error("An unknown error occurred")
+    }
+  }
+
   // Get a specific device's state
   async getDeviceState(address: string, deviceId: string): Promise<string> {
     try {
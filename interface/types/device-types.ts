@@ -7,3 +7,11 @@ export interface DeviceType {
   direction: string
 }
 
+// Reply to GET /api/devices?since=<generation>
+export interface DeviceChanges {
+  generation: number
+  full: boolean
+  deleted: string[]
+  devices: DeviceType[]
+}
+